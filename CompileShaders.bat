@@ -1,4 +1,10 @@
+REM Built-in shaders are compiled and embedded by the build.
+REM This only produces loose files for "--shader-dir shaders/bytecode" while iterating on shaders.
 if not exist "%~dp0shaders\bytecode\NUL" mkdir %~dp0shaders\bytecode\
-%VULKAN_SDK%\Bin\glslc.exe shaders/shader.vert -o %~dp0shaders\bytecode\vert.spv
-%VULKAN_SDK%\Bin\glslc.exe shaders/shader.frag -o %~dp0shaders\bytecode\frag.spv
-pause
\ No newline at end of file
+%VULKAN_SDK%\Bin\glslc.exe shaders/shader.vert -o %~dp0shaders\bytecode\shader.vert.spv
+%VULKAN_SDK%\Bin\glslc.exe shaders/shader.frag -o %~dp0shaders\bytecode\shader.frag.spv
+%VULKAN_SDK%\Bin\glslc.exe shaders/scene.vert -o %~dp0shaders\bytecode\scene.vert.spv
+%VULKAN_SDK%\Bin\glslc.exe shaders/scene.frag -o %~dp0shaders\bytecode\scene.frag.spv
+%VULKAN_SDK%\Bin\glslc.exe shaders/instanced.vert -o %~dp0shaders\bytecode\instanced.vert.spv
+%VULKAN_SDK%\Bin\glslc.exe shaders/cull.comp -o %~dp0shaders\bytecode\cull.comp.spv
+pause
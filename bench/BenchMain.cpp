@@ -0,0 +1,145 @@
+#include "vkpch.h"
+#include "BenchScenarios.h"
+
+#include "Utils/CommandLine.h"
+#include "Vulkan/ShaderRegistry.h"
+
+//Runs the headless benchmark scenarios and writes their results as JSON, e.g.
+//  vulkanSandboxBench --scenario draw_throughput --frames 500 --label abc123 --output bench.json
+//For numbers comparable across commits run the Release build on the same device,
+//with a software driver pinned through VK_ICD_FILENAMES when no GPU is at hand.
+
+static void printUsage()
+{
+	printf( "usage: vulkanSandboxBench [--scenario <name|all>] [--frames N] [--warmup N] [--width N] [--height N]\n"
+		"                          [--startup-runs N] [--pipelines N] [--compile-threads N] [--job-threads N]\n"
+		"                          [--label text] [--output file.json]\n" );
+
+	printf( "scenarios:" );
+	for( const auto& entry : GetBenchScenarios() )
+	{
+		printf( " %s", entry.name );
+	}
+	printf( "\n" );
+}
+
+int main( int argc, char** argv )
+{
+	SBenchSettings settings;
+	std::string scenarioName = "all";
+	std::string outputPath = "bench_results.json";
+	std::string label;
+
+	try
+	{
+		for( int i = 1; i < argc; ++i )
+		{
+			const std::string arg = argv[ i ];
+			const bool hasValue = ( i + 1 < argc );
+
+			if( arg == "--scenario" && hasValue )
+			{
+				scenarioName = argv[ ++i ];
+			}
+			else if( arg == "--frames" && hasValue )
+			{
+				settings.frameCount = parseCountArgument( arg, argv[ ++i ], 1 );
+			}
+			else if( arg == "--warmup" && hasValue )
+			{
+				settings.warmupFrames = parseCountArgument( arg, argv[ ++i ] );
+			}
+			else if( arg == "--width" && hasValue )
+			{
+				settings.width = parseCountArgument( arg, argv[ ++i ], 1 );
+			}
+			else if( arg == "--height" && hasValue )
+			{
+				settings.height = parseCountArgument( arg, argv[ ++i ], 1 );
+			}
+			else if( arg == "--startup-runs" && hasValue )
+			{
+				settings.startupRuns = parseCountArgument( arg, argv[ ++i ], 1 );
+			}
+			else if( arg == "--pipelines" && hasValue )
+			{
+				settings.pipelineVariants = parseCountArgument( arg, argv[ ++i ] );
+			}
+			else if( arg == "--compile-threads" && hasValue )
+			{
+				settings.compileThreads = parseCountArgument( arg, argv[ ++i ] );
+			}
+			else if( arg == "--job-threads" && hasValue )
+			{
+				settings.jobThreads = parseCountArgument( arg, argv[ ++i ] );
+			}
+			else if( arg == "--label" && hasValue )
+			{
+				//typically the commit hash, so reports of several commits can be told apart
+				label = argv[ ++i ];
+			}
+			else if( arg == "--output" && hasValue )
+			{
+				outputPath = argv[ ++i ];
+			}
+			else
+			{
+				printUsage();
+				return arg == "--help" ? 0 : 1;
+			}
+		}
+	}
+	catch( const std::invalid_argument& e )
+	{
+		printf( "%s\n", e.what() );
+		printUsage();
+		return 1;
+	}
+
+	std::vector<SBenchScenarioEntry> selected;
+	for( const auto& entry : GetBenchScenarios() )
+	{
+		if( scenarioName == "all" || scenarioName == entry.name )
+		{
+			selected.push_back( entry );
+		}
+	}
+
+	if( selected.empty() )
+	{
+		printf( "unknown scenario '%s'\n", scenarioName.c_str() );
+		printUsage();
+		return 1;
+	}
+
+	CBenchReport report;
+	report.setLabel( label );
+	report.addSetting( "frames", settings.frameCount );
+	report.addSetting( "warmupFrames", settings.warmupFrames );
+	report.addSetting( "width", settings.width );
+	report.addSetting( "height", settings.height );
+	report.addSetting( "startupRuns", settings.startupRuns );
+	report.addSetting( "pipelineVariants", settings.pipelineVariants );
+	report.addSetting( "compileThreads", settings.compileThreads );
+	report.addSetting( "jobThreads", settings.jobThreads );
+
+	try
+	{
+		for( const auto& entry : selected )
+		{
+			printf( "running %s...\n", entry.name );
+			report.addScenario( entry.run( settings, report ) );
+		}
+	}
+	catch( const std::exception& e )
+	{
+		printf( "benchmark failed: %s\n", e.what() );
+		return 1;
+	}
+
+	report.printSummary();
+	report.writeJson( outputPath );
+	printf( "wrote %s\n", outputPath.c_str() );
+
+	return 0;
+}
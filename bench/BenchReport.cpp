@@ -0,0 +1,281 @@
+#include "vkpch.h"
+#include "BenchReport.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+/////////////////////////////////////////////////
+
+//Minimal writer for the report, keys are emitted in insertion order
+class CJsonWriter
+{
+public:
+	void beginObject( const char* key = nullptr )
+	{
+		open( key, '{' );
+	}
+
+	void endObject()
+	{
+		close( '}' );
+	}
+
+	void beginArray( const char* key = nullptr )
+	{
+		open( key, '[' );
+	}
+
+	void endArray()
+	{
+		close( ']' );
+	}
+
+	void write( const char* key, const std::string& value )
+	{
+		writeKey( key );
+		writeString( value );
+	}
+
+	void write( const char* key, double value )
+	{
+		writeKey( key );
+
+		//JSON has no representation for nan or inf
+		if( !std::isfinite( value ) )
+		{
+			m_output += "null";
+			return;
+		}
+
+		//counters and timestamps are whole numbers, keep every digit of them
+		char buffer[ 32 ];
+		const bool integral = std::floor( value ) == value && std::fabs( value ) < 1e15;
+		snprintf( buffer, sizeof( buffer ), integral ? "%.0f" : "%.6g", value );
+		m_output += buffer;
+	}
+
+	inline const std::string& getOutput() const
+	{
+		return m_output;
+	}
+
+private:
+	void open( const char* key, char bracket )
+	{
+		writeKey( key );
+		m_output += bracket;
+		m_firstInScope.push_back( true );
+	}
+
+	void close( char bracket )
+	{
+		const bool empty = m_firstInScope.back();
+		m_firstInScope.pop_back();
+
+		if( !empty )
+		{
+			newLine();
+		}
+		m_output += bracket;
+	}
+
+	void writeKey( const char* key )
+	{
+		if( !m_firstInScope.empty() )
+		{
+			if( !m_firstInScope.back() )
+			{
+				m_output += ',';
+			}
+			m_firstInScope.back() = false;
+			newLine();
+		}
+
+		if( key )
+		{
+			writeString( key );
+			m_output += ": ";
+		}
+	}
+
+	void writeString( const std::string& value )
+	{
+		m_output += '"';
+		for( const char c : value )
+		{
+			switch( c )
+			{
+			case '"': m_output += "\\\""; break;
+			case '\\': m_output += "\\\\"; break;
+			case '\n': m_output += "\\n"; break;
+			case '\t': m_output += "\\t"; break;
+			default:
+				if( static_cast< unsigned char >( c ) < 0x20 )
+				{
+					char buffer[ 8 ];
+					snprintf( buffer, sizeof( buffer ), "\\u%04x", c );
+					m_output += buffer;
+				}
+				else
+				{
+					m_output += c;
+				}
+			}
+		}
+		m_output += '"';
+	}
+
+	void newLine()
+	{
+		m_output += '\n';
+		m_output.append( m_firstInScope.size(), '\t' );
+	}
+
+	std::string m_output;
+	std::vector<bool> m_firstInScope;
+};
+
+static std::string formatVersion( uint32_t version )
+{
+	return std::to_string( VK_VERSION_MAJOR( version ) ) + "." + std::to_string( VK_VERSION_MINOR( version ) ) + "." + std::to_string( VK_VERSION_PATCH( version ) );
+}
+
+static void writeStats( CJsonWriter& writer, const SSampleStats& stats )
+{
+	writer.beginObject( "stats" );
+	writer.write( "count", static_cast< double >( stats.count ) );
+	writer.write( "mean", stats.mean );
+	writer.write( "p50", stats.p50 );
+	writer.write( "p99", stats.p99 );
+	writer.write( "min", stats.min );
+	writer.write( "max", stats.max );
+	writer.endObject();
+}
+
+/////////////////////////////////////////////////
+
+SSampleStats SSampleStats::FromSamples( std::vector<double> samples )
+{
+	SSampleStats stats;
+	if( samples.empty() )
+	{
+		return stats;
+	}
+
+	std::sort( samples.begin(), samples.end() );
+
+	auto percentile = [ &samples ]( double fraction )
+	{
+		const size_t rank = static_cast< size_t >( std::ceil( fraction * samples.size() ) );
+		return samples[ std::min( std::max( rank, size_t( 1 ) ), samples.size() ) - 1 ];
+	};
+
+	stats.count = samples.size();
+	stats.mean = std::accumulate( samples.begin(), samples.end(), 0.0 ) / samples.size();
+	stats.p50 = percentile( 0.50 );
+	stats.p99 = percentile( 0.99 );
+	stats.min = samples.front();
+	stats.max = samples.back();
+	return stats;
+}
+
+/////////////////////////////////////////////////
+
+std::string CBenchReport::toJson() const
+{
+	CJsonWriter writer;
+	writer.beginObject();
+
+	writer.write( "label", m_label );
+	writer.write( "timestamp", static_cast< double >( std::time( nullptr ) ) );
+
+	writer.beginObject( "device" );
+	writer.write( "name", m_device.name );
+	writer.write( "type", m_device.type );
+	writer.write( "vendorId", m_device.vendorId );
+	writer.write( "deviceId", m_device.deviceId );
+	writer.write( "apiVersion", formatVersion( m_device.apiVersion ) );
+	//driver versions are vendor encoded, keep the raw value
+	writer.write( "driverVersion", m_device.driverVersion );
+	writer.endObject();
+
+	writer.beginObject( "settings" );
+	for( const auto& setting : m_settings )
+	{
+		writer.write( setting.first.c_str(), setting.second );
+	}
+	writer.endObject();
+
+	writer.beginArray( "scenarios" );
+	for( const SBenchScenario& scenario : m_scenarios )
+	{
+		writer.beginObject();
+		writer.write( "name", scenario.name );
+
+		if( !scenario.skippedReason.empty() )
+		{
+			writer.write( "skipped", scenario.skippedReason );
+		}
+
+		writer.beginArray( "cases" );
+		for( const SBenchCase& benchCase : scenario.cases )
+		{
+			writer.beginObject();
+			writer.write( "name", benchCase.name );
+			writer.write( "unit", benchCase.unit );
+			writeStats( writer, benchCase.stats );
+
+			writer.beginObject( "metrics" );
+			for( const auto& metric : benchCase.metrics )
+			{
+				writer.write( metric.first.c_str(), metric.second );
+			}
+			writer.endObject();
+
+			writer.endObject();
+		}
+		writer.endArray();
+
+		writer.endObject();
+	}
+	writer.endArray();
+
+	writer.endObject();
+	return writer.getOutput() + "\n";
+}
+
+void CBenchReport::writeJson( const std::string& filePath ) const
+{
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if( !file.is_open() )
+	{
+		throw std::runtime_error( "Failed to open benchmark report " + filePath );
+	}
+
+	const std::string json = toJson();
+	file.write( json.data(), static_cast< std::streamsize >( json.size() ) );
+}
+
+void CBenchReport::printSummary() const
+{
+	printf( "%s (%s), api %s\n", m_device.name.c_str(), m_device.type.c_str(), formatVersion( m_device.apiVersion ).c_str() );
+
+	for( const SBenchScenario& scenario : m_scenarios )
+	{
+		if( !scenario.skippedReason.empty() )
+		{
+			printf( "%-20s skipped: %s\n", scenario.name.c_str(), scenario.skippedReason.c_str() );
+			continue;
+		}
+
+		for( const SBenchCase& benchCase : scenario.cases )
+		{
+			const SSampleStats& stats = benchCase.stats;
+			printf( "%-20s %-24s mean %10.4f  p50 %10.4f  p99 %10.4f  max %10.4f %s (n=%zu)\n", scenario.name.c_str(), benchCase.name.c_str(),
+				stats.mean, stats.p50, stats.p99, stats.max, benchCase.unit.c_str(), stats.count );
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+//Summary of a set of samples. Percentiles use the nearest rank, so p99 of
+//fewer than 100 samples is the maximum rather than an interpolated value.
+struct SSampleStats
+{
+	size_t count = 0;
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p99 = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+
+	static SSampleStats FromSamples( std::vector<double> samples );
+};
+
+//One measured configuration of a scenario, e.g. 1000 draws per frame
+struct SBenchCase
+{
+	std::string name;
+	std::string unit = "ms";
+	SSampleStats stats;
+	//derived single values, e.g. bandwidth or counters
+	std::vector<std::pair<std::string, double>> metrics;
+};
+
+struct SBenchScenario
+{
+	std::string name;
+	std::vector<SBenchCase> cases;
+	//set instead of cases when the device cannot run the scenario
+	std::string skippedReason;
+};
+
+struct SBenchDeviceInfo
+{
+	std::string name;
+	std::string type;
+	uint32_t vendorId = 0;
+	uint32_t deviceId = 0;
+	uint32_t apiVersion = 0;
+	uint32_t driverVersion = 0;
+};
+
+//Collects the results of a benchmark run and writes them as JSON, so runs on
+//different commits can be diffed by a script.
+class CBenchReport
+{
+public:
+	inline void setLabel( const std::string& label )
+	{
+		m_label = label;
+	}
+
+	inline void setDevice( const SBenchDeviceInfo& device )
+	{
+		m_device = device;
+	}
+
+	inline bool hasDevice() const
+	{
+		return !m_device.name.empty();
+	}
+
+	inline void addSetting( const std::string& key, double value )
+	{
+		m_settings.emplace_back( key, value );
+	}
+
+	inline void addScenario( SBenchScenario scenario )
+	{
+		m_scenarios.push_back( std::move( scenario ) );
+	}
+
+	std::string toJson() const;
+	void writeJson( const std::string& filePath ) const;
+	//one line per case on stdout
+	void printSummary() const;
+
+private:
+	std::string m_label;
+	SBenchDeviceInfo m_device;
+	std::vector<std::pair<std::string, double>> m_settings;
+	std::vector<SBenchScenario> m_scenarios;
+};
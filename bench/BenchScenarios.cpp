@@ -0,0 +1,851 @@
+#include "vkpch.h"
+#include "BenchScenarios.h"
+
+#include "HeadlessVulkanApp.h"
+#include "Utils/InstanceTransforms.h"
+#include "Utils/JobSystem.h"
+#include "Utils/Timer.h"
+#include "Vulkan/PipelineCompiler.h"
+#include "Vulkan/PipelineRegistry.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+/////////////////////////////////////////////////
+
+//kept apart from the apps' caches so a benchmark run never warms or clobbers them
+const char* const BENCH_PIPELINE_CACHE_FILE = "pipeline_cache_bench.bin";
+
+const uint32_t DRAW_COUNTS[] = { 1, 10, 100, 1000, 10000 };
+const vk::DeviceSize UPLOAD_SIZES[] = { 64ull * 1024, 1024ull * 1024, 16ull * 1024 * 1024 };
+const uint32_t UPLOAD_WARMUP_ITERATIONS = 2;
+
+const double BYTES_PER_MIB = 1024.0 * 1024.0;
+
+//materials per pipeline variant in the registry case, each asks for its variant's state
+const uint32_t MATERIALS_PER_PIPELINE_VARIANT = 64;
+
+const uint32_t JOB_WARMUP_ITERATIONS = 2;
+//empty jobs per sample of the scheduling overhead cases
+const uint32_t JOB_OVERHEAD_JOB_COUNT = 65536;
+//the fixed amount of work the scaling cases split into jobs
+const uint32_t JOB_SCALING_JOB_COUNT = 512;
+const uint32_t JOB_SCALING_ITERATIONS_PER_JOB = 20000;
+//jobs in the dependency chain case, each waits for the one before
+const uint32_t JOB_CHAIN_LENGTH = 4096;
+
+//instances advanced per sample of the instance_update scenario, up to a few heavy frames' worth
+const uint32_t INSTANCE_UPDATE_COUNTS[] = { 100000, 1000000, 4000000 };
+const uint32_t INSTANCE_WARMUP_ITERATIONS = 2;
+const float INSTANCE_STEP_SECONDS = 1.0f / 60.0f;
+
+//state commands recorded per sample of the dispatch_overhead scenario, a few heavy frames' worth
+const uint32_t DISPATCH_COMMANDS_PER_SAMPLE = 300000;
+const uint32_t DISPATCH_WARMUP_ITERATIONS = 3;
+
+static CHeadlessVulkanApp::SSettings makeAppSettings( const SBenchSettings& settings )
+{
+	CHeadlessVulkanApp::SSettings appSettings;
+	appSettings.width = settings.width;
+	appSettings.height = settings.height;
+	appSettings.readbackInterval = 0;
+	appSettings.pipelineCacheFile = BENCH_PIPELINE_CACHE_FILE;
+	return appSettings;
+}
+
+static void recordDevice( CHeadlessVulkanApp& app, CBenchReport& report )
+{
+	if( report.hasDevice() )
+	{
+		return;
+	}
+
+	const vk::PhysicalDeviceProperties properties = app.getPhysicalDevice().getProperties();
+
+	SBenchDeviceInfo device;
+	device.name = std::string( properties.deviceName );
+	device.type = vk::to_string( properties.deviceType );
+	device.vendorId = properties.vendorID;
+	device.deviceId = properties.deviceID;
+	device.apiVersion = properties.apiVersion;
+	device.driverVersion = properties.driverVersion;
+	report.setDevice( device );
+}
+
+//frame times of frameCount frames, after warmupFrames that are thrown away
+static SBenchCase measureFrames( CHeadlessVulkanApp& app, const SBenchSettings& settings, const std::string& name )
+{
+	app.renderFrames( settings.warmupFrames );
+	app.clearFrameTimes();
+
+	CTimer timer;
+	app.renderFrames( settings.frameCount );
+	const double totalMilliseconds = timer.elapsedMilliseconds();
+
+	SBenchCase benchCase;
+	benchCase.name = name;
+	benchCase.stats = SSampleStats::FromSamples( app.getFrameTimes() );
+	benchCase.metrics.emplace_back( "totalMs", totalMilliseconds );
+	benchCase.metrics.emplace_back( "framesPerSecond", totalMilliseconds > 0.0 ? settings.frameCount * 1000.0 / totalMilliseconds : 0.0 );
+	return benchCase;
+}
+
+/////////////////////////////////////////////////
+
+//Full init, first frame and cleanup of the headless app. The first run starts without
+//a pipeline cache file, every later run loads the one the previous run saved.
+static SBenchScenario runStartupScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "startup";
+
+	std::filesystem::remove( BENCH_PIPELINE_CACHE_FILE );
+
+	std::vector<double> warmInitSamples;
+	std::vector<double> firstFrameSamples;
+	std::vector<std::pair<const char*, std::vector<double>>> phaseSamples;
+
+	const uint32_t runCount = std::max( settings.startupRuns, 2u );
+	for( uint32_t run = 0; run < runCount; ++run )
+	{
+		CHeadlessVulkanApp app( makeAppSettings( settings ) );
+
+		CTimer timer;
+		app.init();
+		const double initMilliseconds = timer.elapsedMilliseconds();
+
+		timer.reset();
+		app.renderFrames( 1 );
+		firstFrameSamples.push_back( timer.elapsedMilliseconds() );
+
+		recordDevice( app, report );
+
+		if( run == 0 )
+		{
+			SBenchCase coldCase;
+			coldCase.name = "init_cold";
+			coldCase.stats = SSampleStats::FromSamples( { initMilliseconds } );
+			for( const auto& phase : app.getStartupPhases() )
+			{
+				coldCase.metrics.emplace_back( std::string( phase.name ) + "Ms", phase.milliseconds );
+			}
+			scenario.cases.push_back( std::move( coldCase ) );
+		}
+		else
+		{
+			warmInitSamples.push_back( initMilliseconds );
+
+			const auto& phases = app.getStartupPhases();
+			phaseSamples.resize( phases.size() );
+			for( size_t i = 0; i < phases.size(); ++i )
+			{
+				phaseSamples[ i ].first = phases[ i ].name;
+				phaseSamples[ i ].second.push_back( phases[ i ].milliseconds );
+			}
+		}
+
+		app.cleanup();
+	}
+
+	SBenchCase warmCase;
+	warmCase.name = "init_warm";
+	warmCase.stats = SSampleStats::FromSamples( warmInitSamples );
+	scenario.cases.push_back( std::move( warmCase ) );
+
+	for( auto& phase : phaseSamples )
+	{
+		SBenchCase phaseCase;
+		phaseCase.name = std::string( "phase_" ) + phase.first;
+		phaseCase.stats = SSampleStats::FromSamples( std::move( phase.second ) );
+		scenario.cases.push_back( std::move( phaseCase ) );
+	}
+
+	SBenchCase firstFrameCase;
+	firstFrameCase.name = "first_frame";
+	firstFrameCase.stats = SSampleStats::FromSamples( firstFrameSamples );
+	scenario.cases.push_back( std::move( firstFrameCase ) );
+
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//Every variant differs in fixed function state only, so drivers that cache compiled
+//shaders by module alone will share most of the work between variants.
+static SGraphicsPipelineDesc makePipelineVariant( const CHeadlessVulkanApp& app, uint32_t variant )
+{
+	SGraphicsPipelineDesc desc;
+	desc.name = "bench variant " + std::to_string( variant );
+	desc.stages.push_back( { vk::ShaderStageFlagBits::eVertex, CShaderRegistry::Get( "shader.vert" ) } );
+	desc.stages.push_back( { vk::ShaderStageFlagBits::eFragment, CShaderRegistry::Get( "shader.frag" ) } );
+
+	desc.topology = ( variant & 0x10 ) ? vk::PrimitiveTopology::eTriangleStrip : vk::PrimitiveTopology::eTriangleList;
+
+	const vk::Extent2D extent = app.getTargetExtent();
+	desc.viewports.emplace_back( 0.0f, 0.0f, static_cast< float >( extent.width ), static_cast< float >( extent.height ), 0.0f, 1.0f );
+	desc.scissors.emplace_back( vk::Offset2D { 0, 0 }, extent );
+
+	const vk::CullModeFlagBits cullModes[] = { vk::CullModeFlagBits::eNone, vk::CullModeFlagBits::eBack, vk::CullModeFlagBits::eFront, vk::CullModeFlagBits::eFrontAndBack };
+	desc.rasterization.setPolygonMode( vk::PolygonMode::eFill );
+	desc.rasterization.setLineWidth( 1.0f );
+	desc.rasterization.setCullMode( cullModes[ variant & 0x3 ] );
+	desc.rasterization.setFrontFace( ( variant & 0x4 ) ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise );
+	//keeps variants past the combinations above distinct
+	desc.rasterization.setDepthBiasEnable( VK_TRUE );
+	desc.rasterization.setDepthBiasConstantFactor( static_cast< float >( variant >> 5 ) );
+
+	desc.multisample.setRasterizationSamples( vk::SampleCountFlagBits::e1 );
+
+	vk::PipelineColorBlendAttachmentState blendAttachment {};
+	blendAttachment.setColorWriteMask( vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA );
+	if( variant & 0x8 )
+	{
+		blendAttachment.setBlendEnable( VK_TRUE );
+		blendAttachment.setSrcColorBlendFactor( vk::BlendFactor::eSrcAlpha );
+		blendAttachment.setDstColorBlendFactor( vk::BlendFactor::eOneMinusSrcAlpha );
+		blendAttachment.setColorBlendOp( vk::BlendOp::eAdd );
+		blendAttachment.setSrcAlphaBlendFactor( vk::BlendFactor::eOne );
+		blendAttachment.setDstAlphaBlendFactor( vk::BlendFactor::eZero );
+		blendAttachment.setAlphaBlendOp( vk::BlendOp::eAdd );
+	}
+	desc.colorBlendAttachments.push_back( blendAttachment );
+
+	desc.layout = app.getPipelineLayout();
+	desc.renderPass = app.getRenderPass();
+	desc.subpass = 0;
+	return desc;
+}
+
+static SBenchCase compilePipelineVariants( CHeadlessVulkanApp& app, CPipelineCache& pipelineCache, const SBenchSettings& settings, uint32_t threadCount, const char* name )
+{
+	CPipelineCompiler compiler;
+	compiler.init( app.getDevice(), pipelineCache, threadCount );
+
+	CTimer timer;
+	for( uint32_t variant = 0; variant < settings.pipelineVariants; ++variant )
+	{
+		compiler.compileGraphicsPipeline( makePipelineVariant( app, variant ) );
+	}
+	compiler.waitIdle();
+	const double wallMilliseconds = timer.elapsedMilliseconds();
+
+	const CPipelineCompiler::SStats stats = compiler.getStats();
+
+	std::vector<double> compileSamples;
+	compileSamples.reserve( stats.records.size() );
+	for( const auto& record : stats.records )
+	{
+		compileSamples.push_back( record.compileMilliseconds );
+	}
+
+	SBenchCase benchCase;
+	benchCase.name = name;
+	benchCase.stats = SSampleStats::FromSamples( std::move( compileSamples ) );
+	benchCase.metrics.emplace_back( "wallMs", wallMilliseconds );
+	benchCase.metrics.emplace_back( "threads", compiler.getThreadCount() );
+	benchCase.metrics.emplace_back( "peakConcurrentCompiles", stats.peakConcurrentCompiles );
+	benchCase.metrics.emplace_back( "failed", stats.pipelinesFailed );
+
+	compiler.destroy();
+	return benchCase;
+}
+
+//The variants of makePipelineVariant as registry states, built from the state presets
+static SPipelineState makePipelineVariantState( const CHeadlessVulkanApp& app, uint32_t variant )
+{
+	SPipelineState state;
+	state.debugName = "bench variant " + std::to_string( variant );
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eVertex, "shader.vert" } );
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eFragment, "shader.frag" } );
+
+	state.topology = ( variant & 0x10 ) ? vk::PrimitiveTopology::eTriangleStrip : vk::PrimitiveTopology::eTriangleList;
+
+	const vk::CullModeFlagBits cullModes[] = { vk::CullModeFlagBits::eNone, vk::CullModeFlagBits::eBack, vk::CullModeFlagBits::eFront, vk::CullModeFlagBits::eFrontAndBack };
+	state.raster = SRasterState::DepthBiased( static_cast< float >( variant >> 5 ), 0.0f );
+	state.raster.cullMode = cullModes[ variant & 0x3 ];
+	state.raster.frontFace = ( variant & 0x4 ) ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise;
+
+	state.blendAttachments = { ( variant & 0x8 ) ? SBlendState::AlphaBlend() : SBlendState::Opaque() };
+
+	state.layout = app.getPipelineLayout();
+	state.renderPass = app.getRenderPass();
+	return state;
+}
+
+//Many materials that only use the pipeline variants between them, requested through the
+//registry. Only the distinct states are compiled, so the wall time should stay close to
+//that of the variants alone however many materials there are.
+static SBenchCase registerMaterials( CHeadlessVulkanApp& app, CPipelineCache& pipelineCache, const SBenchSettings& settings, const char* name )
+{
+	CPipelineCompiler compiler;
+	compiler.init( app.getDevice(), pipelineCache, settings.compileThreads );
+
+	CPipelineRegistry registry;
+	registry.init( compiler );
+
+	const uint32_t materialCount = settings.pipelineVariants * MATERIALS_PER_PIPELINE_VARIANT;
+	std::vector<double> registerSamples;
+	registerSamples.reserve( materialCount );
+
+	CTimer timer;
+	for( uint32_t material = 0; material < materialCount; ++material )
+	{
+		SPipelineState state = makePipelineVariantState( app, material % settings.pipelineVariants );
+		state.debugName = "material " + std::to_string( material );
+
+		CTimer registerTimer;
+		registry.acquire( state );
+		registerSamples.push_back( registerTimer.elapsedMilliseconds() );
+	}
+	compiler.waitIdle();
+	const double wallMilliseconds = timer.elapsedMilliseconds();
+
+	const CPipelineRegistry::SStats stats = registry.getStats();
+
+	SBenchCase benchCase;
+	benchCase.name = name;
+	benchCase.stats = SSampleStats::FromSamples( std::move( registerSamples ) );
+	benchCase.metrics.emplace_back( "wallMs", wallMilliseconds );
+	benchCase.metrics.emplace_back( "materials", materialCount );
+	benchCase.metrics.emplace_back( "uniqueStates", stats.uniqueStates );
+	benchCase.metrics.emplace_back( "pipelinesCreated", stats.pipelinesCreated );
+	benchCase.metrics.emplace_back( "hashCollisions", stats.hashCollisions );
+
+	registry.destroy();
+	compiler.destroy();
+	return benchCase;
+}
+
+//The same set of variants built serially into an empty cache, in parallel into another
+//empty cache, once more into the now warm cache, and finally requested by many materials
+//through the registry. The cache is never saved.
+static SBenchScenario runPipelineCreationScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "pipeline_creation";
+
+	CHeadlessVulkanApp app( makeAppSettings( settings ) );
+	app.init();
+	recordDevice( app, report );
+
+	std::filesystem::remove( BENCH_PIPELINE_CACHE_FILE );
+
+	CPipelineCache serialCache;
+	serialCache.init( app.getPhysicalDevice(), app.getDevice(), BENCH_PIPELINE_CACHE_FILE, app.isPipelineCreationFeedbackEnabled() );
+	scenario.cases.push_back( compilePipelineVariants( app, serialCache, settings, 1, "cold_serial" ) );
+	serialCache.destroy();
+
+	CPipelineCache parallelCache;
+	parallelCache.init( app.getPhysicalDevice(), app.getDevice(), BENCH_PIPELINE_CACHE_FILE, app.isPipelineCreationFeedbackEnabled() );
+	scenario.cases.push_back( compilePipelineVariants( app, parallelCache, settings, settings.compileThreads, "cold_parallel" ) );
+	scenario.cases.push_back( compilePipelineVariants( app, parallelCache, settings, settings.compileThreads, "warm_parallel" ) );
+
+	const CPipelineCache::SStats cacheStats = parallelCache.getStats();
+	scenario.cases.back().metrics.emplace_back( "cacheHits", cacheStats.cacheHits );
+	scenario.cases.back().metrics.emplace_back( "cacheMisses", cacheStats.cacheMisses );
+
+	scenario.cases.push_back( registerMaterials( app, parallelCache, settings, "warm_registry_materials" ) );
+	parallelCache.destroy();
+
+	app.cleanup();
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//CPU time per frame with an increasing number of draw calls of the same pipeline
+static SBenchScenario runDrawThroughputScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "draw_throughput";
+
+	CHeadlessVulkanApp app( makeAppSettings( settings ) );
+	app.init();
+	recordDevice( app, report );
+
+	for( const uint32_t drawCount : DRAW_COUNTS )
+	{
+		app.setDrawCount( drawCount );
+
+		SBenchCase benchCase = measureFrames( app, settings, "draws_" + std::to_string( drawCount ) );
+		const double meanMilliseconds = benchCase.stats.mean;
+		benchCase.metrics.emplace_back( "drawsPerSecond", meanMilliseconds > 0.0 ? drawCount * 1000.0 / meanMilliseconds : 0.0 );
+		scenario.cases.push_back( std::move( benchCase ) );
+	}
+
+	app.cleanup();
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//Staging upload into a device local buffer, timed from the copy request until its
+//timeline value has signaled
+static SBenchScenario runUploadBandwidthScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "upload_bandwidth";
+
+	CHeadlessVulkanApp app( makeAppSettings( settings ) );
+	app.init();
+	recordDevice( app, report );
+
+	CUploadService* pUploadService = app.getUploadService();
+	if( !pUploadService )
+	{
+		scenario.skippedReason = "device has no timeline semaphores";
+		app.cleanup();
+		return scenario;
+	}
+
+	const vk::Device device = app.getDevice();
+	CDeviceMemoryAllocator& allocator = app.getMemoryAllocator();
+	const uint32_t iterationCount = std::max( settings.frameCount / 10, 10u );
+
+	for( const vk::DeviceSize size : UPLOAD_SIZES )
+	{
+		vk::BufferCreateInfo createInfo( {}, size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::SharingMode::eExclusive );
+		vk::Buffer buffer = device.createBuffer( createInfo );
+		SAllocation allocation = allocator.allocateForBuffer( buffer, EMemoryUsage::GpuOnly );
+
+		std::vector<uint8_t> data( static_cast< size_t >( size ) );
+		std::iota( data.begin(), data.end(), uint8_t( 0 ) );
+
+		std::vector<double> samples;
+		for( uint32_t iteration = 0; iteration < UPLOAD_WARMUP_ITERATIONS + iterationCount; ++iteration )
+		{
+			CTimer timer;
+			const uint64_t value = pUploadService->uploadBuffer( buffer, 0, data.data(), size, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead );
+			pUploadService->flush();
+			pUploadService->wait( value );
+
+			if( iteration >= UPLOAD_WARMUP_ITERATIONS )
+			{
+				samples.push_back( timer.elapsedMilliseconds() );
+			}
+		}
+
+		//hands the uploads over to the graphics queue, as a frame consuming them would
+		app.renderFrames( 1 );
+
+		SBenchCase benchCase;
+		benchCase.name = "upload_" + std::to_string( size / 1024 ) + "KiB";
+		benchCase.stats = SSampleStats::FromSamples( std::move( samples ) );
+		benchCase.metrics.emplace_back( "bytes", static_cast< double >( size ) );
+		benchCase.metrics.emplace_back( "meanMiBPerSecond", benchCase.stats.mean > 0.0 ? ( size / BYTES_PER_MIB ) * 1000.0 / benchCase.stats.mean : 0.0 );
+		scenario.cases.push_back( std::move( benchCase ) );
+
+		device.destroyBuffer( buffer );
+		allocator.free( allocation );
+	}
+
+	const CUploadService::SStats uploadStats = pUploadService->getStats();
+	if( !scenario.cases.empty() )
+	{
+		scenario.cases.back().metrics.emplace_back( "stagingStalls", uploadStats.stagingStalls );
+	}
+
+	app.cleanup();
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//Frame time with every frame copied back and handed to the CPU, against no readback at all
+static SBenchScenario runReadbackScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "readback";
+
+	CHeadlessVulkanApp app( makeAppSettings( settings ) );
+
+	//a consumer copies the pixels out before the target is reused
+	std::vector<uint8_t> frameCopy;
+	app.setFrameCallback( [ &frameCopy ]( uint64_t, const uint8_t* pPixels, size_t size )
+	{
+		frameCopy.assign( pPixels, pPixels + size );
+	} );
+
+	app.init();
+	recordDevice( app, report );
+
+	app.setReadbackInterval( 0 );
+	scenario.cases.push_back( measureFrames( app, settings, "no_readback" ) );
+
+	app.setReadbackInterval( 1 );
+	SBenchCase readbackCase = measureFrames( app, settings, "readback_every_frame" );
+	const double frameMiB = app.getReadbackFrameSize() / BYTES_PER_MIB;
+	readbackCase.metrics.emplace_back( "frameBytes", static_cast< double >( app.getReadbackFrameSize() ) );
+	readbackCase.metrics.emplace_back( "meanMiBPerSecond", readbackCase.stats.mean > 0.0 ? frameMiB * 1000.0 / readbackCase.stats.mean : 0.0 );
+	scenario.cases.push_back( std::move( readbackCase ) );
+
+	app.cleanup();
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//stands in for real per job work, the result is kept so the loop cannot be optimized away
+static float simulateWork( uint32_t seed )
+{
+	float value = static_cast< float >( seed );
+	for( uint32_t i = 0; i < JOB_SCALING_ITERATIONS_PER_JOB; ++i )
+	{
+		value = value * 0.999f + std::sqrt( value + static_cast< float >( i ) );
+	}
+	return value;
+}
+
+//1, 2, 4, ... threads, always ending on the largest count
+static std::vector<uint32_t> getJobThreadCounts( const SBenchSettings& settings )
+{
+	const uint32_t maxThreads = settings.jobThreads > 0 ? settings.jobThreads : std::max( std::thread::hardware_concurrency(), 1u );
+
+	std::vector<uint32_t> threadCounts;
+	for( uint32_t threadCount = 1; threadCount < maxThreads; threadCount *= 2 )
+	{
+		threadCounts.push_back( threadCount );
+	}
+	threadCounts.push_back( maxThreads );
+	return threadCounts;
+}
+
+//CPU only: the cost of running an empty job, the latency of a dependency chain, and how
+//a fixed amount of work speeds up with the thread count. Samples are per iteration.
+static SBenchScenario runJobSystemScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "job_system";
+
+	const uint32_t iterationCount = std::max( settings.frameCount / 10, 10u );
+	double singleThreadMilliseconds = 0.0;
+
+	for( const uint32_t threadCount : getJobThreadCounts( settings ) )
+	{
+		CJobSystem jobSystem;
+		jobSystem.init( threadCount );
+
+		std::vector<double> overheadSamples;
+		std::vector<double> chainSamples;
+		std::vector<double> scalingSamples;
+		std::vector<float> results( JOB_SCALING_JOB_COUNT );
+
+		for( uint32_t iteration = 0; iteration < JOB_WARMUP_ITERATIONS + iterationCount; ++iteration )
+		{
+			const bool measured = ( iteration >= JOB_WARMUP_ITERATIONS );
+
+			CTimer overheadTimer;
+			CJobCounter emptyJobs;
+			for( uint32_t i = 0; i < JOB_OVERHEAD_JOB_COUNT; ++i )
+			{
+				jobSystem.run( []() {}, &emptyJobs );
+			}
+			jobSystem.wait( emptyJobs );
+			const double overheadMilliseconds = overheadTimer.elapsedMilliseconds();
+
+			//every link depends on the counter of the one before, so nothing runs in parallel
+			CTimer chainTimer;
+			std::vector<CJobCounter> chain( JOB_CHAIN_LENGTH );
+			jobSystem.run( []() {}, &chain[ 0 ] );
+			for( uint32_t i = 1; i < JOB_CHAIN_LENGTH; ++i )
+			{
+				jobSystem.run( []() {}, &chain[ i ], { &chain[ i - 1 ] } );
+			}
+			for( CJobCounter& link : chain )
+			{
+				jobSystem.wait( link );
+			}
+			const double chainMilliseconds = chainTimer.elapsedMilliseconds();
+
+			CTimer scalingTimer;
+			CJobCounter workJobs;
+			for( uint32_t i = 0; i < JOB_SCALING_JOB_COUNT; ++i )
+			{
+				jobSystem.run( [ &results, i ]() { results[ i ] = simulateWork( i ); }, &workJobs );
+			}
+			jobSystem.wait( workJobs );
+			const double scalingMilliseconds = scalingTimer.elapsedMilliseconds();
+
+			if( measured )
+			{
+				overheadSamples.push_back( overheadMilliseconds );
+				chainSamples.push_back( chainMilliseconds );
+				scalingSamples.push_back( scalingMilliseconds );
+			}
+		}
+
+		const CJobSystem::SStats stats = jobSystem.getStats();
+		jobSystem.destroy();
+
+		const std::string suffix = "_" + std::to_string( threadCount ) + "_threads";
+
+		SBenchCase overheadCase;
+		overheadCase.name = "empty_jobs" + suffix;
+		overheadCase.stats = SSampleStats::FromSamples( std::move( overheadSamples ) );
+		overheadCase.metrics.emplace_back( "jobs", JOB_OVERHEAD_JOB_COUNT );
+		overheadCase.metrics.emplace_back( "meanNsPerJob", overheadCase.stats.mean * 1e6 / JOB_OVERHEAD_JOB_COUNT );
+		scenario.cases.push_back( std::move( overheadCase ) );
+
+		SBenchCase chainCase;
+		chainCase.name = "dependency_chain" + suffix;
+		chainCase.stats = SSampleStats::FromSamples( std::move( chainSamples ) );
+		chainCase.metrics.emplace_back( "jobs", JOB_CHAIN_LENGTH );
+		chainCase.metrics.emplace_back( "meanNsPerLink", chainCase.stats.mean * 1e6 / JOB_CHAIN_LENGTH );
+		scenario.cases.push_back( std::move( chainCase ) );
+
+		SBenchCase scalingCase;
+		scalingCase.name = "work_scaling" + suffix;
+		scalingCase.stats = SSampleStats::FromSamples( std::move( scalingSamples ) );
+		if( threadCount == 1 )
+		{
+			singleThreadMilliseconds = scalingCase.stats.mean;
+		}
+		scalingCase.metrics.emplace_back( "jobs", JOB_SCALING_JOB_COUNT );
+		scalingCase.metrics.emplace_back( "speedup", scalingCase.stats.mean > 0.0 ? singleThreadMilliseconds / scalingCase.stats.mean : 0.0 );
+		scalingCase.metrics.emplace_back( "stolenPercent", stats.jobsRun > 0 ? 100.0 * stats.jobsStolen / stats.jobsRun : 0.0 );
+		scalingCase.metrics.emplace_back( "checksum", std::accumulate( results.begin(), results.end(), 0.0 ) );
+		scenario.cases.push_back( std::move( scalingCase ) );
+	}
+
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//the rows of one instance's transform, as instanced.vert reads them
+struct alignas( 16 ) SInstanceRows
+{
+	float values[ CInstanceTransforms::FLOATS_PER_INSTANCE ];
+};
+
+static SBenchCase makeInstanceCase( const std::string& name, std::vector<double>&& samples, uint32_t instanceCount, double baselineMilliseconds,
+	const std::vector<SInstanceRows>& rows )
+{
+	SBenchCase benchCase;
+	benchCase.name = name;
+	benchCase.stats = SSampleStats::FromSamples( std::move( samples ) );
+	benchCase.metrics.emplace_back( "instances", instanceCount );
+	benchCase.metrics.emplace_back( "millionInstancesPerSecond", benchCase.stats.mean > 0.0 ? instanceCount / ( benchCase.stats.mean * 1e3 ) : 0.0 );
+	benchCase.metrics.emplace_back( "meanNsPerInstance", benchCase.stats.mean * 1e6 / instanceCount );
+	//over the scalar case, which passes no baseline
+	const double speedup = baselineMilliseconds > 0.0 ? baselineMilliseconds / std::max( benchCase.stats.mean, 1e-9 ) : 1.0;
+	benchCase.metrics.emplace_back( "speedup", speedup );
+
+	//keeps the writes from being optimized away, and should roughly agree between the cases
+	double checksum = 0.0;
+	for( uint32_t i = 0; i < instanceCount; ++i )
+	{
+		checksum += rows[ i ].values[ 0 ] + rows[ i ].values[ 10 ];
+	}
+	benchCase.metrics.emplace_back( "checksum", checksum );
+	return benchCase;
+}
+
+//CPU only: advancing spinning instances and writing their transforms the way
+//CInstanceRenderer does, against the usual per object glm matrix math on an array of
+//structs. The SIMD update runs on the calling thread and then split into jobs across
+//thread counts. Samples are per update of every instance.
+static SBenchScenario runInstanceUpdateScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "instance_update";
+
+	const uint32_t iterationCount = std::max( settings.frameCount / 10, 10u );
+	const std::vector<uint32_t> threadCounts = getJobThreadCounts( settings );
+
+	for( const uint32_t instanceCount : INSTANCE_UPDATE_COUNTS )
+	{
+		std::mt19937 random( instanceCount );
+		std::uniform_real_distribution<float> position( -500.0f, 500.0f );
+		std::uniform_real_distribution<float> scale( 0.6f, 1.2f );
+		std::uniform_real_distribution<float> angle( -3.0f, 3.0f );
+
+		std::vector<CInstanceTransforms::SInstance> instances( instanceCount );
+		CInstanceTransforms transforms;
+		transforms.reserve( instanceCount );
+		for( CInstanceTransforms::SInstance& instance : instances )
+		{
+			instance.position = glm::vec3( position( random ), 0.0f, position( random ) );
+			instance.scale = scale( random );
+			instance.angle = angle( random );
+			instance.angularVelocity = angle( random );
+			transforms.add( instance );
+		}
+
+		std::vector<SInstanceRows> rows( transforms.getPaddedCount() );
+		const std::string suffix = "_" + std::to_string( instanceCount );
+
+		std::vector<double> scalarSamples;
+		for( uint32_t iteration = 0; iteration < INSTANCE_WARMUP_ITERATIONS + iterationCount; ++iteration )
+		{
+			CTimer timer;
+			for( uint32_t i = 0; i < instanceCount; ++i )
+			{
+				CInstanceTransforms::SInstance& instance = instances[ i ];
+				instance.angle = std::remainder( instance.angle + instance.angularVelocity * INSTANCE_STEP_SECONDS, glm::two_pi<float>() );
+
+				glm::mat4 model = glm::translate( glm::mat4( 1.0f ), instance.position );
+				model = glm::rotate( model, instance.angle, glm::vec3( 0.0f, 1.0f, 0.0f ) );
+				model = glm::scale( model, glm::vec3( instance.scale ) );
+
+				//glm is column major, the rows are gathered across the columns
+				float* pRows = rows[ i ].values;
+				for( uint32_t row = 0; row < 3; ++row )
+				{
+					for( uint32_t column = 0; column < 4; ++column )
+					{
+						pRows[ row * 4 + column ] = model[ column ][ row ];
+					}
+				}
+			}
+			const double milliseconds = timer.elapsedMilliseconds();
+
+			if( iteration >= INSTANCE_WARMUP_ITERATIONS )
+			{
+				scalarSamples.push_back( milliseconds );
+			}
+		}
+
+		SBenchCase scalarCase = makeInstanceCase( "scalar_glm" + suffix, std::move( scalarSamples ), instanceCount, 0.0, rows );
+		const double scalarMilliseconds = scalarCase.stats.mean;
+		scenario.cases.push_back( std::move( scalarCase ) );
+
+		float* pRows = rows.front().values;
+
+		std::vector<double> simdSamples;
+		for( uint32_t iteration = 0; iteration < INSTANCE_WARMUP_ITERATIONS + iterationCount; ++iteration )
+		{
+			CTimer timer;
+			transforms.update( INSTANCE_STEP_SECONDS, pRows );
+			const double milliseconds = timer.elapsedMilliseconds();
+
+			if( iteration >= INSTANCE_WARMUP_ITERATIONS )
+			{
+				simdSamples.push_back( milliseconds );
+			}
+		}
+		scenario.cases.push_back( makeInstanceCase( "simd" + suffix, std::move( simdSamples ), instanceCount, scalarMilliseconds, rows ) );
+
+		for( const uint32_t threadCount : threadCounts )
+		{
+			CJobSystem jobSystem;
+			jobSystem.init( threadCount );
+
+			std::vector<double> jobSamples;
+			for( uint32_t iteration = 0; iteration < INSTANCE_WARMUP_ITERATIONS + iterationCount; ++iteration )
+			{
+				CTimer timer;
+				CJobCounter updateJobs;
+				transforms.update( INSTANCE_STEP_SECONDS, pRows, jobSystem, updateJobs );
+				jobSystem.wait( updateJobs );
+				const double milliseconds = timer.elapsedMilliseconds();
+
+				if( iteration >= INSTANCE_WARMUP_ITERATIONS )
+				{
+					jobSamples.push_back( milliseconds );
+				}
+			}
+			jobSystem.destroy();
+
+			scenario.cases.push_back( makeInstanceCase( "simd_jobs" + suffix + "_" + std::to_string( threadCount ) + "_threads", std::move( jobSamples ),
+				instanceCount, scalarMilliseconds, rows ) );
+		}
+	}
+
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+//Records commandCount cheap state commands, so the time is mostly the cost of getting into
+//the driver. The same commands are recorded through both dispatchers.
+template< typename Dispatch >
+static void recordStateCommands( const vk::CommandBuffer& commandBuffer, vk::Pipeline pipeline, const vk::Rect2D& area, uint32_t commandCount, const Dispatch& dispatch )
+{
+	const vk::Viewport viewport( 0.0f, 0.0f, static_cast< float >( area.extent.width ), static_cast< float >( area.extent.height ), 0.0f, 1.0f );
+
+	for( uint32_t i = 0; i < commandCount; i += 3 )
+	{
+		commandBuffer.bindPipeline( vk::PipelineBindPoint::eGraphics, pipeline, dispatch );
+		commandBuffer.setViewport( 0, 1, &viewport, dispatch );
+		commandBuffer.setScissor( 0, 1, &area, dispatch );
+	}
+}
+
+template< typename Dispatch >
+static SBenchCase measureDispatch( CHeadlessVulkanApp& app, const SBenchSettings& settings, const std::string& name, const Dispatch& dispatch )
+{
+	const vk::Device device = app.getDevice();
+	const vk::CommandPool commandPool = device.createCommandPool( vk::CommandPoolCreateInfo( vk::CommandPoolCreateFlagBits::eTransient, app.getGraphicsQueueFamily() ) );
+	const vk::CommandBuffer commandBuffer = device.allocateCommandBuffers( vk::CommandBufferAllocateInfo( commandPool, vk::CommandBufferLevel::ePrimary, 1 ) ).front();
+	const vk::Rect2D area( vk::Offset2D { 0, 0 }, app.getTargetExtent() );
+
+	const uint32_t iterationCount = std::max( settings.frameCount / 10, 10u );
+	std::vector<double> samples;
+	samples.reserve( iterationCount );
+
+	//never submitted, the pool is reset for every sample so memory use stays flat
+	for( uint32_t iteration = 0; iteration < DISPATCH_WARMUP_ITERATIONS + iterationCount; ++iteration )
+	{
+		device.resetCommandPool( commandPool, {} );
+		commandBuffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+
+		CTimer timer;
+		recordStateCommands( commandBuffer, app.getGraphicsPipeline(), area, DISPATCH_COMMANDS_PER_SAMPLE, dispatch );
+		const double milliseconds = timer.elapsedMilliseconds();
+
+		commandBuffer.end();
+		if( iteration >= DISPATCH_WARMUP_ITERATIONS )
+		{
+			samples.push_back( milliseconds );
+		}
+	}
+
+	device.destroyCommandPool( commandPool );
+
+	SBenchCase benchCase;
+	benchCase.name = name;
+	benchCase.stats = SSampleStats::FromSamples( std::move( samples ) );
+	benchCase.metrics.emplace_back( "commands", DISPATCH_COMMANDS_PER_SAMPLE );
+	benchCase.metrics.emplace_back( "meanNsPerCommand", benchCase.stats.mean * 1e6 / DISPATCH_COMMANDS_PER_SAMPLE );
+	return benchCase;
+}
+
+//Command recording through the exports of the loader library, which are trampolines that look
+//up the device's dispatch table on every call, against the per device table of DeviceDispatch.h
+static SBenchScenario runDispatchOverheadScenario( const SBenchSettings& settings, CBenchReport& report )
+{
+	SBenchScenario scenario;
+	scenario.name = "dispatch_overhead";
+
+	CHeadlessVulkanApp app( makeAppSettings( settings ) );
+	app.init();
+	recordDevice( app, report );
+
+	SBenchCase trampolineCase = measureDispatch( app, settings, "loader_trampoline", vk::DispatchLoaderStatic() );
+	SBenchCase tableCase = measureDispatch( app, settings, "device_table", VULKAN_HPP_DEFAULT_DISPATCHER );
+	tableCase.metrics.emplace_back( "speedup", tableCase.stats.mean > 0.0 ? trampolineCase.stats.mean / tableCase.stats.mean : 0.0 );
+
+	scenario.cases.push_back( std::move( trampolineCase ) );
+	scenario.cases.push_back( std::move( tableCase ) );
+
+	app.cleanup();
+	return scenario;
+}
+
+/////////////////////////////////////////////////
+
+const std::vector<SBenchScenarioEntry>& GetBenchScenarios()
+{
+	static const std::vector<SBenchScenarioEntry> scenarios = {
+		{ "startup", runStartupScenario },
+		{ "pipeline_creation", runPipelineCreationScenario },
+		{ "draw_throughput", runDrawThroughputScenario },
+		{ "upload_bandwidth", runUploadBandwidthScenario },
+		{ "readback", runReadbackScenario },
+		{ "job_system", runJobSystemScenario },
+		{ "instance_update", runInstanceUpdateScenario },
+		{ "dispatch_overhead", runDispatchOverheadScenario }
+	};
+	return scenarios;
+}
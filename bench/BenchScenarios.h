@@ -0,0 +1,31 @@
+#pragma once
+#include "BenchReport.h"
+
+struct SBenchSettings
+{
+	//measured frames per case, after the warmup frames
+	uint32_t frameCount = 300;
+	uint32_t warmupFrames = 30;
+	//small targets keep software rasterizers from dominating the CPU side numbers
+	uint32_t width = 256;
+	uint32_t height = 256;
+	//full init/cleanup cycles of the startup scenario
+	uint32_t startupRuns = 5;
+	//distinct graphics pipelines built by the pipeline_creation scenario
+	uint32_t pipelineVariants = 32;
+	//0 uses every hardware thread but one
+	uint32_t compileThreads = 0;
+	//largest job system the job_system scenario scales up to, 0 is one thread per hardware thread
+	uint32_t jobThreads = 0;
+};
+
+using BenchScenarioFn = SBenchScenario( * )( const SBenchSettings& settings, CBenchReport& report );
+
+struct SBenchScenarioEntry
+{
+	const char* name;
+	BenchScenarioFn run;
+};
+
+//every scenario, in the order "all" runs them
+const std::vector<SBenchScenarioEntry>& GetBenchScenarios();
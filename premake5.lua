@@ -29,7 +29,8 @@ group "Dependencies"
 group ""
 
 
-project "vulkanSandbox"
+--Settings shared by the sandbox and the benchmark, both build every source under src/
+function sandboxProject()
 	kind "ConsoleApp"
 	language "C++"
 	cppdialect "C++17"
@@ -49,12 +50,17 @@ project "vulkanSandbox"
 	{
 		"src/**.h",
 		"src/**.c",
-		"src/**.cpp"
+		"src/**.cpp",
+		"shaders/**.vert",
+		"shaders/**.frag",
+		"shaders/**.comp",
+		"shaders/**.glsl"
 	}
 
 	includedirs
 	{
 		"src",
+		"%{cfg.objdir}/shaders",
 		"%{IncludePaths.spdlog}",
 		"%{IncludePaths.glfw}",
 		"%{IncludePaths.glm}",
@@ -78,11 +84,27 @@ project "vulkanSandbox"
 	defines
 	{
 		"GLFW_INCLUDE_VULKAN",
+		--Vulkan-Hpp calls go through a table loaded per device, see src/Vulkan/DeviceDispatch.h
+		"VULKAN_HPP_DISPATCH_LOADER_DYNAMIC=1",
 		"GLM_FORCE_RADIANS",
 		"GLM_FORCE_DEPTH_ZERO_TO_ONE"
 	}
 	
 	
+	--GLSL is compiled to SPIR-V words (-mfmt=num) that src/Vulkan/ShaderRegistry.cpp embeds.
+	--glslc -MD also writes a make style dependency file next to each output for the #includes it resolved,
+	--Visual Studio ignores it, so every shader also lists the shared includes as inputs.
+	filter "files:shaders/**.vert or files:shaders/**.frag or files:shaders/**.comp"
+		buildmessage "Compiling %{file.relpath}"
+		buildcommands
+		{
+			'{MKDIR} "%{cfg.objdir}/shaders"',
+			'"$(VULKAN_SDK)/Bin/glslc" -mfmt=num -MD -MF "%{cfg.objdir}/shaders/%{file.name}.d" -o "%{cfg.objdir}/shaders/%{file.name}.inl" "%{file.relpath}"'
+		}
+		buildoutputs { "%{cfg.objdir}/shaders/%{file.name}.inl" }
+		buildinputs { "shaders/Bindless.glsl", "shaders/Scene.glsl" }
+	filter {}
+	
 	filter "system:windows"
 			systemversion "latest"
 			buildoptions { "/Zc:__cplusplus" }
@@ -98,3 +120,130 @@ project "vulkanSandbox"
 		runtime "Release"
 		optimize "on"
 		defines{ "VKS_RELEASE" }
+
+	filter {}
+end
+
+
+project "vulkanSandbox"
+	sandboxProject()
+
+
+--Headless benchmark scenarios, see bench/BenchMain.cpp
+project "vulkanSandboxBench"
+	sandboxProject()
+
+	removefiles { "src/main.cpp" }
+
+	files
+	{
+		"bench/**.h",
+		"bench/**.cpp"
+	}
+
+	includedirs { "bench" }
+
+
+--Offline OBJ to .vksm converter, see src/Assets/MeshFormat.h
+project "meshConverter"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir ("binaries/" .. outputdir .. "/%{prj.name}")
+	objdir ("binaries/intermediates/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/meshConverter/**.cpp",
+		"src/Assets/MeshFormat.h"
+	}
+
+	includedirs { "src" }
+
+	filter "system:windows"
+		systemversion "latest"
+		defines { "VKS_WINDOWS" }
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+	filter {}
+
+
+--Offline PPM to .vkst converter, see src/Assets/TextureFormat.h
+project "textureConverter"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir ("binaries/" .. outputdir .. "/%{prj.name}")
+	objdir ("binaries/intermediates/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/textureConverter/**.cpp",
+		"src/Assets/TextureFormat.h"
+	}
+
+	includedirs { "src" }
+
+	filter "system:windows"
+		systemversion "latest"
+		defines { "VKS_WINDOWS" }
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+	filter {}
+
+
+--CPU only tests of the allocation strategies in src/Memory, see tests/AllocatorTests.cpp
+project "allocatorTests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir ("binaries/" .. outputdir .. "/%{prj.name}")
+	objdir ("binaries/intermediates/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tests/AllocatorTests.cpp",
+		"src/vkpch.h",
+		"src/Memory/FreeListAllocator.h",
+		"src/Memory/FreeListAllocator.cpp",
+		"src/Memory/LinearAllocator.h",
+		"src/Memory/LinearAllocator.cpp",
+		"src/Memory/RingAllocator.h",
+		"src/Memory/RingAllocator.cpp"
+	}
+
+	includedirs { "src" }
+
+	filter "system:windows"
+		systemversion "latest"
+		defines { "VKS_WINDOWS" }
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+	filter {}
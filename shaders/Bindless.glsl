@@ -0,0 +1,18 @@
+//Declarations of CBindlessTable (src/Vulkan/BindlessTable.h), the set every pipeline binds at 0.
+//Shaders declare their own push constant block with the indices they need, 128 bytes at most.
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform texture2D g_textures[];
+layout(set = 0, binding = 1) uniform sampler g_samplers[];
+
+//storage buffers as raw words, shaders that want a typed view redeclare binding 2 with their own block
+layout(set = 0, binding = 2) readonly buffer SWords
+{
+	uint words[];
+} g_buffers[];
+
+//indices that differ between invocations of one draw have to go through nonuniformEXT()
+vec4 sampleTexture(uint textureIndex, uint samplerIndex, vec2 uv)
+{
+	return texture(sampler2D(g_textures[nonuniformEXT(textureIndex)], g_samplers[nonuniformEXT(samplerIndex)]), uv);
+}
@@ -0,0 +1,46 @@
+//Buffers of CGpuScene (src/Vulkan/GpuScene.cpp), typed views of binding 2 of the bindless table.
+#extension GL_EXT_nonuniform_qualifier : require
+
+//SMeshVertex of src/Assets/MeshFormat.h, float arrays keep std430 from padding it to vec4s
+struct SVertex
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+struct SMeshLod
+{
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+	float maxDistance;
+};
+
+struct SObject
+{
+	vec4 transform[3];
+	vec4 boundingSphere;
+	vec4 color;
+	//texture id, an index into the texture table
+	uint material;
+	uint reserved[3];
+};
+
+//VkDrawIndexedIndirectCommand
+struct SDrawCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+layout(set = 0, binding = 2) readonly buffer SVertices { SVertex vertices[]; } g_vertexBuffers[];
+layout(set = 0, binding = 2) readonly buffer SMeshLods { SMeshLod lods[]; } g_lodBuffers[];
+layout(set = 0, binding = 2) readonly buffer SObjects { SObject objects[]; } g_objectBuffers[];
+layout(set = 0, binding = 2) writeonly buffer SDrawCommands { SDrawCommand commands[]; } g_drawBuffers[];
+layout(set = 0, binding = 2) buffer SDrawCount { uint count; } g_countBuffers[];
+//bindless texture slot of every texture id, written by CTextureStreamer each frame
+layout(set = 0, binding = 2) readonly buffer STextureTable { uint slots[]; } g_textureTables[];
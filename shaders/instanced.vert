@@ -0,0 +1,37 @@
+#version 450
+
+layout(push_constant) uniform SInstanceConstants
+{
+	mat4 viewProjection;
+} pc;
+
+//rows of the object to world transform, read at instance rate, see CInstanceRenderer
+layout(location = 0) in vec4 instanceRow0;
+layout(location = 1) in vec4 instanceRow1;
+layout(location = 2) in vec4 instanceRow2;
+
+layout(location = 0) out vec3 fragColor;
+
+vec4 positions[3] = vec4[] (
+	vec4(0.0, 0.5, 0.0, 1.0),
+	vec4(0.5, -0.5, 0.0, 1.0),
+	vec4(-0.5, -0.5, 0.0, 1.0)
+);
+
+vec3 colors[3] = vec3[](
+	vec3(1.0, 0.0, 0.0),
+	vec3(0.0, 1.0, 0.0),
+	vec3(0.0, 0.0, 1.0)
+);
+
+void main()
+{
+	vec4 position = positions[gl_VertexIndex];
+	vec3 worldPosition = vec3(dot(instanceRow0, position), dot(instanceRow1, position), dot(instanceRow2, position));
+	gl_Position = pc.viewProjection * vec4(worldPosition, 1.0);
+
+	//tints neighbours apart
+	uint hash = uint(gl_InstanceIndex) * 2654435761u;
+	vec3 tint = vec3((hash >> 8) & 255u, (hash >> 16) & 255u, (hash >> 24) & 255u) / 255.0;
+	fragColor = mix(colors[gl_VertexIndex], tint, 0.5);
+}
@@ -0,0 +1,35 @@
+#version 450
+#include "Bindless.glsl"
+#include "Scene.glsl"
+
+//same block as scene.vert
+layout(push_constant) uniform SDrawConstants
+{
+	mat4 viewProjection;
+	uint objectBuffer;
+	uint vertexBuffer;
+	uint textureTable;
+	uint sampler;
+} pc;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUv;
+layout(location = 2) flat in uint fragMaterial;
+
+layout(location = 0) out vec4 outColor;
+
+const uint INVALID_HANDLE = 0xFFFFFFFF;
+
+void main()
+{
+	vec3 color = fragColor;
+
+	//the table always points at something sampleable, a placeholder until the texture's tail is resident
+	if (pc.textureTable != INVALID_HANDLE)
+	{
+		uint slot = g_textureTables[pc.textureTable].slots[fragMaterial];
+		color *= sampleTexture(slot, pc.sampler, fragUv).rgb;
+	}
+
+	outColor = vec4(color, 1.0);
+}
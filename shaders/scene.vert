@@ -0,0 +1,35 @@
+#version 450
+#include "Scene.glsl"
+
+layout(push_constant) uniform SDrawConstants
+{
+	mat4 viewProjection;
+	uint objectBuffer;
+	uint vertexBuffer;
+	uint textureTable;
+	uint sampler;
+} pc;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUv;
+layout(location = 2) flat out uint fragMaterial;
+
+const vec3 LIGHT_DIRECTION = vec3(0.48, 0.8, 0.36);
+
+void main()
+{
+	//firstInstance of the indirect draw is the object, gl_VertexIndex already includes vertexOffset
+	SObject object = g_objectBuffers[pc.objectBuffer].objects[gl_InstanceIndex];
+	SVertex vertex = g_vertexBuffers[pc.vertexBuffer].vertices[gl_VertexIndex];
+	vec4 position = vec4(vertex.position[0], vertex.position[1], vertex.position[2], 1.0);
+	vec3 normal = vec3(vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+
+	vec3 worldPosition = vec3(dot(object.transform[0], position), dot(object.transform[1], position), dot(object.transform[2], position));
+	gl_Position = pc.viewProjection * vec4(worldPosition, 1.0);
+
+	//uniform scale only, the normal needs no inverse transpose
+	float diffuse = max(dot(normalize(normal), LIGHT_DIRECTION), 0.0);
+	fragColor = object.color.rgb * (0.25 + 0.75 * diffuse);
+	fragUv = vec2(vertex.uv[0], vertex.uv[1]);
+	fragMaterial = object.material;
+}
@@ -1,9 +1,22 @@
 #pragma once
+#include "Utils/JobSystem.h"
 
 class IAppBase
 {
 public:
+	virtual ~IAppBase() = default;
+
 	virtual void init() = 0;
 	virtual void run() = 0;
 	virtual void cleanup() = 0;
+
+	//started by init() on the thread that calls it, stopped by cleanup().
+	//Frame work of the app runs on it, and anything else may queue jobs too.
+	inline CJobSystem& getJobSystem()
+	{
+		return m_jobSystem;
+	}
+
+protected:
+	CJobSystem m_jobSystem;
 };
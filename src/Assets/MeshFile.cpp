@@ -0,0 +1,128 @@
+#include "vkpch.h"
+#include "MeshFile.h"
+
+#include "Utils/Log.h"
+#include "Vulkan/UploadService.h"
+
+/////////////////////////////////////////////////
+
+//record size of every section type this version knows, 0 for the ones it skips
+static uint32_t getRecordSize( EMeshSection type )
+{
+	switch( type )
+	{
+	case EMeshSection::Meshes:
+		return sizeof( SMeshRecord );
+	case EMeshSection::Vertices:
+		return sizeof( SMeshVertex );
+	case EMeshSection::Indices:
+	case EMeshSection::MeshletVertices:
+		return sizeof( uint32_t );
+	case EMeshSection::Meshlets:
+		return sizeof( SMeshletRecord );
+	case EMeshSection::MeshletTriangles:
+		return sizeof( uint8_t );
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////
+
+void CMeshFile::open( const std::string& filePath )
+{
+	close();
+
+	m_filePath = filePath;
+	m_file.open( filePath );
+
+	const uint64_t fileSize = m_file.getSize();
+	if( fileSize < sizeof( SMeshFileHeader ) )
+	{
+		throw std::runtime_error( "'" + filePath + "' is not a mesh file." );
+	}
+
+	const SMeshFileHeader* pHeader = reinterpret_cast< const SMeshFileHeader* >( m_file.getData() );
+	if( pHeader->magic != MESH_FILE_MAGIC )
+	{
+		throw std::runtime_error( "'" + filePath + "' is not a mesh file." );
+	}
+	if( pHeader->version != MESH_FILE_VERSION )
+	{
+		throw std::runtime_error( "Mesh file '" + filePath + "' is version " + std::to_string( pHeader->version ) + ", expected " +
+			std::to_string( MESH_FILE_VERSION ) + ". Convert it again." );
+	}
+	if( pHeader->fileSize != fileSize || sizeof( SMeshFileHeader ) + pHeader->sectionCount * sizeof( SMeshFileSection ) > fileSize )
+	{
+		throw std::runtime_error( "Mesh file '" + filePath + "' is cut off." );
+	}
+
+	m_sections.pData = reinterpret_cast< const SMeshFileSection* >( m_file.getData() + sizeof( SMeshFileHeader ) );
+	m_sections.count = pHeader->sectionCount;
+
+	//the only checks on the contents, after this every section is trusted to be in bounds
+	for( uint64_t i = 0; i < m_sections.count; ++i )
+	{
+		const SMeshFileSection& section = m_sections[ i ];
+		const bool inBounds = section.offset <= fileSize && section.size <= fileSize - section.offset;
+		if( !inBounds || section.offset % MESH_SECTION_ALIGNMENT != 0 || section.elementSize == 0 ||
+			section.elementCount > section.size / section.elementSize )
+		{
+			throw std::runtime_error( "Mesh file '" + filePath + "' has a broken table of contents." );
+		}
+
+		//uploads copy whole records into buffers sized for the types above
+		const uint32_t recordSize = getRecordSize( section.type );
+		if( recordSize != 0 && section.elementSize != recordSize )
+		{
+			throw std::runtime_error( "Mesh file '" + filePath + "' has a section of unexpected record size." );
+		}
+	}
+
+	VS_TRACE( "Mapped mesh file '{0}', {1} bytes in {2} sections", filePath, fileSize, m_sections.count );
+}
+
+void CMeshFile::close()
+{
+	m_file.close();
+	m_sections = SView<SMeshFileSection>();
+}
+
+const SMeshFileSection* CMeshFile::findSection( EMeshSection type ) const
+{
+	for( uint64_t i = 0; i < m_sections.count; ++i )
+	{
+		if( m_sections[ i ].type == type )
+		{
+			return &m_sections[ i ];
+		}
+	}
+	return nullptr;
+}
+
+void CMeshFile::prefetchSection( EMeshSection type, uint64_t first, uint64_t count ) const
+{
+	const SMeshFileSection& section = getSectionRange( type, first, count );
+	m_file.prefetch( section.offset + first * section.elementSize, count * section.elementSize );
+}
+
+uint64_t CMeshFile::uploadSection( EMeshSection type, uint64_t first, uint64_t count, CUploadService& uploadService, const vk::Buffer& dst,
+	vk::DeviceSize dstOffset, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess ) const
+{
+	const SMeshFileSection& section = getSectionRange( type, first, count );
+
+	//the only copy is the one into staging memory, it faults the pages in as it goes
+	const uint8_t* pSrc = m_file.getData() + section.offset + first * section.elementSize;
+	return uploadService.uploadBuffer( dst, dstOffset, pSrc, count * section.elementSize, dstStage, dstAccess );
+}
+
+/////////////////////////////////////////////////
+
+const SMeshFileSection& CMeshFile::getSectionRange( EMeshSection type, uint64_t first, uint64_t count ) const
+{
+	const SMeshFileSection* pSection = findSection( type );
+	if( !pSection || first > pSection->elementCount || count > pSection->elementCount - first )
+	{
+		throw std::runtime_error( "Mesh file '" + m_filePath + "' has no such range of records." );
+	}
+	return *pSection;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Assets/MeshFormat.h"
+#include "Utils/MappedFile.h"
+
+#include <vulkan/vulkan.hpp>
+
+class CUploadService;
+
+//A .vksm file mapped into memory. open() only checks the header and the table of contents,
+//sections are used in place: viewed through getSection() or copied from the mapping into
+//staging memory by uploadSection(). Sections, or ranges of them, that are never asked for
+//are never read from disk.
+class CMeshFile
+{
+public:
+	template<typename T>
+	struct SView
+	{
+		const T* pData = nullptr;
+		uint64_t count = 0;
+
+		inline const T& operator[]( uint64_t index ) const
+		{
+			return pData[ index ];
+		}
+	};
+
+public:
+	CMeshFile() = default;
+
+	//throws if the file is missing, cut off or of another version
+	void open( const std::string& filePath );
+	void close();
+
+	//null if the file has no such section
+	const SMeshFileSection* findSection( EMeshSection type ) const;
+
+	//empty if the file has no such section, throws if its records are not T
+	template<typename T>
+	SView<T> getSection( EMeshSection type ) const
+	{
+		const SMeshFileSection* pSection = findSection( type );
+		if( !pSection )
+		{
+			return SView<T>();
+		}
+
+		if( pSection->elementSize != sizeof( T ) )
+		{
+			throw std::runtime_error( "Mesh file '" + m_filePath + "' has a section of unexpected record size." );
+		}
+
+		return SView<T> { reinterpret_cast< const T* >( m_file.getData() + pSection->offset ), pSection->elementCount };
+	}
+
+	inline SView<SMeshRecord> getMeshes() const
+	{
+		return getSection<SMeshRecord>( EMeshSection::Meshes );
+	}
+
+	//starts reading records [first, first + count) of a section ahead of use
+	void prefetchSection( EMeshSection type, uint64_t first, uint64_t count ) const;
+
+	//queues a copy of records [first, first + count) of a section from the mapping to dst,
+	//returns the upload's timeline value
+	uint64_t uploadSection( EMeshSection type, uint64_t first, uint64_t count, CUploadService& uploadService, const vk::Buffer& dst, vk::DeviceSize dstOffset,
+		vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess ) const;
+
+	inline uint64_t getFileSize() const
+	{
+		return m_file.getSize();
+	}
+
+private:
+	const SMeshFileSection& getSectionRange( EMeshSection type, uint64_t first, uint64_t count ) const;
+
+	std::string m_filePath;
+	CMappedFile m_file;
+	SView<SMeshFileSection> m_sections;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+
+//On disk layout of .vksm mesh files, written by the meshConverter tool and mapped by CMeshFile.
+//A header and a table of contents come first, followed by the sections it lists. Every section
+//is an array of fixed size records that starts on a MESH_SECTION_ALIGNMENT boundary, so the
+//loader copies sections straight out of the mapping without parsing anything.
+//All values are little endian. Changing any struct below means bumping MESH_FILE_VERSION.
+
+constexpr uint32_t MESH_FILE_MAGIC = 0x4D534B56; //"VKSM"
+constexpr uint32_t MESH_FILE_VERSION = 1;
+
+//also a valid offset alignment for any buffer binding, so a section can be bound in place
+constexpr uint64_t MESH_SECTION_ALIGNMENT = 256;
+
+constexpr uint32_t MESH_MAX_LODS = 4;
+//fits the usual mesh shader limits
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+enum class EMeshSection : uint32_t
+{
+	//SMeshRecord
+	Meshes = 1,
+	//SMeshVertex
+	Vertices,
+	//uint32_t, relative to the mesh's firstVertex
+	Indices,
+	//SMeshletRecord
+	Meshlets,
+	//uint32_t, relative to the mesh's firstVertex
+	MeshletVertices,
+	//3 uint8_t per triangle into the meshlet's vertices, each meshlet padded to 4 bytes
+	MeshletTriangles
+};
+
+struct SMeshFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sectionCount;
+	uint32_t reserved;
+	//of the whole file, a mismatch means the file was cut off
+	uint64_t fileSize;
+};
+
+//the table of contents, sectionCount of these right after the header
+struct SMeshFileSection
+{
+	EMeshSection type;
+	uint32_t elementSize;
+	uint64_t elementCount;
+	uint64_t offset;
+	uint64_t size;
+};
+
+//same layout as SVertex in shaders/Scene.glsl, the vertex section is uploaded as is
+struct SMeshVertex
+{
+	float position[ 3 ];
+	float normal[ 3 ];
+	float uv[ 2 ];
+};
+
+struct SMeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+};
+
+struct SMeshRecord
+{
+	//object space
+	float boundsMin[ 3 ];
+	float boundsMax[ 3 ];
+	float boundingSphere[ 4 ];
+
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	//levels from the most to the least detailed
+	uint32_t lodCount;
+	uint32_t reserved;
+	SMeshLod lods[ MESH_MAX_LODS ];
+};
+
+struct SMeshletRecord
+{
+	float boundingSphere[ 4 ];
+	//normalized average of the triangle normals, and the smallest dot product of any triangle
+	//normal with it. A cutoff <= 0 means the meshlet faces every direction.
+	float coneAxis[ 3 ];
+	float coneCutoff;
+
+	uint32_t vertexOffset;
+	uint32_t triangleOffset;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+static_assert( sizeof( SMeshFileHeader ) == 24, "SMeshFileHeader has padding." );
+static_assert( sizeof( SMeshFileSection ) == 32, "SMeshFileSection has padding." );
+static_assert( sizeof( SMeshVertex ) == 32, "SMeshVertex must match SVertex in shaders/Scene.glsl." );
+static_assert( sizeof( SMeshRecord ) == 120, "SMeshRecord has padding." );
+static_assert( sizeof( SMeshletRecord ) == 48, "SMeshletRecord has padding." );
+
+inline uint64_t alignMeshSection( uint64_t offset )
+{
+	return ( offset + MESH_SECTION_ALIGNMENT - 1 ) & ~( MESH_SECTION_ALIGNMENT - 1 );
+}
@@ -0,0 +1,95 @@
+#include "vkpch.h"
+#include "TextureFile.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+void CTextureFile::open( const std::string& filePath )
+{
+	close();
+
+	m_filePath = filePath;
+	m_file.open( filePath );
+
+	const uint64_t fileSize = m_file.getSize();
+	if( fileSize < sizeof( STextureFileHeader ) )
+	{
+		throw std::runtime_error( "'" + filePath + "' is not a texture file." );
+	}
+
+	const STextureFileHeader* pHeader = reinterpret_cast< const STextureFileHeader* >( m_file.getData() );
+	if( pHeader->magic != TEXTURE_FILE_MAGIC )
+	{
+		throw std::runtime_error( "'" + filePath + "' is not a texture file." );
+	}
+	if( pHeader->version != TEXTURE_FILE_VERSION )
+	{
+		throw std::runtime_error( "Texture file '" + filePath + "' is version " + std::to_string( pHeader->version ) + ", expected " +
+			std::to_string( TEXTURE_FILE_VERSION ) + ". Convert it again." );
+	}
+	if( pHeader->fileSize != fileSize || pHeader->mipCount == 0 || pHeader->mipCount > TEXTURE_MAX_MIPS ||
+		sizeof( STextureFileHeader ) + pHeader->mipCount * sizeof( STextureFileMip ) > fileSize )
+	{
+		throw std::runtime_error( "Texture file '" + filePath + "' is cut off." );
+	}
+	if( pHeader->format != ETexturePixelFormat::Rgba8 && pHeader->format != ETexturePixelFormat::Rgb8 )
+	{
+		throw std::runtime_error( "Texture file '" + filePath + "' has an unknown pixel format." );
+	}
+
+	const STextureFileMip* pMips = reinterpret_cast< const STextureFileMip* >( m_file.getData() + sizeof( STextureFileHeader ) );
+
+	//the only checks on the contents, after this every level is trusted to be in bounds
+	const uint32_t pixelSize = getTexturePixelSize( pHeader->format );
+	for( uint32_t level = 0; level < pHeader->mipCount; ++level )
+	{
+		const STextureFileMip& mip = pMips[ level ];
+		const bool inBounds = mip.offset <= fileSize && mip.size <= fileSize - mip.offset;
+		const bool halved = mip.width == std::max( pHeader->width >> level, 1u ) && mip.height == std::max( pHeader->height >> level, 1u );
+		if( !inBounds || !halved || mip.size != static_cast< uint64_t >( mip.width ) * mip.height * pixelSize )
+		{
+			throw std::runtime_error( "Texture file '" + filePath + "' has a broken mip table." );
+		}
+	}
+
+	m_pHeader = pHeader;
+	m_pMips = pMips;
+
+	VS_TRACE( "Mapped texture file '{0}', {1}x{2} with {3} levels", filePath, pHeader->width, pHeader->height, pHeader->mipCount );
+}
+
+void CTextureFile::close()
+{
+	m_file.close();
+	m_pHeader = nullptr;
+	m_pMips = nullptr;
+}
+
+void CTextureFile::prefetchMip( uint32_t level ) const
+{
+	m_file.prefetch( m_pMips[ level ].offset, m_pMips[ level ].size );
+}
+
+void CTextureFile::decodeMip( uint32_t level, uint8_t* pDst ) const
+{
+	const STextureFileMip& mip = m_pMips[ level ];
+	const uint8_t* pSrc = m_file.getData() + mip.offset;
+
+	if( m_pHeader->format == ETexturePixelFormat::Rgba8 )
+	{
+		memcpy( pDst, pSrc, static_cast< size_t >( mip.size ) );
+		return;
+	}
+
+	const uint64_t pixelCount = static_cast< uint64_t >( mip.width ) * mip.height;
+	for( uint64_t i = 0; i < pixelCount; ++i )
+	{
+		pDst[ 0 ] = pSrc[ 0 ];
+		pDst[ 1 ] = pSrc[ 1 ];
+		pDst[ 2 ] = pSrc[ 2 ];
+		pDst[ 3 ] = 255;
+		pSrc += 3;
+		pDst += 4;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Assets/TextureFormat.h"
+#include "Utils/MappedFile.h"
+
+#include <string>
+
+//A .vkst file mapped into memory. open() only checks the header and the mip table, the pixels
+//of a level are read from disk the first time it is prefetched or decoded. Decoding only reads
+//the mapping, so any number of threads may decode levels of one file at once.
+class CTextureFile
+{
+public:
+	CTextureFile() = default;
+
+	//throws if the file is missing, cut off or of another version
+	void open( const std::string& filePath );
+	void close();
+
+	//starts reading a level ahead of decoding it
+	void prefetchMip( uint32_t level ) const;
+	//writes the level as tightly packed RGBA8 to pDst, which holds getDecodedMipSize( level ) bytes
+	void decodeMip( uint32_t level, uint8_t* pDst ) const;
+
+	inline uint64_t getDecodedMipSize( uint32_t level ) const
+	{
+		return static_cast< uint64_t >( m_pMips[ level ].width ) * m_pMips[ level ].height * 4;
+	}
+
+	inline const STextureFileHeader& getHeader() const
+	{
+		return *m_pHeader;
+	}
+
+	inline const STextureFileMip& getMip( uint32_t level ) const
+	{
+		return m_pMips[ level ];
+	}
+
+	inline bool isSrgb() const
+	{
+		return ( m_pHeader->flags & TEXTURE_FILE_SRGB ) != 0;
+	}
+
+	inline const std::string& getFilePath() const
+	{
+		return m_filePath;
+	}
+
+private:
+	std::string m_filePath;
+	CMappedFile m_file;
+	const STextureFileHeader* m_pHeader = nullptr;
+	const STextureFileMip* m_pMips = nullptr;
+};
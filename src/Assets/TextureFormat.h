@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+//On disk layout of .vkst texture files, written by the textureConverter tool and mapped by
+//CTextureFile. A header and one STextureFileMip per level come first, followed by the pixels
+//of every level, each starting on a TEXTURE_MIP_ALIGNMENT boundary. Levels run from the most
+//to the least detailed, so the mip tail sits at the end of the file and is read on its own.
+//All values are little endian. Changing any struct below means bumping TEXTURE_FILE_VERSION.
+
+constexpr uint32_t TEXTURE_FILE_MAGIC = 0x54534B56; //"VKST"
+constexpr uint32_t TEXTURE_FILE_VERSION = 1;
+
+constexpr uint64_t TEXTURE_MIP_ALIGNMENT = 256;
+
+//enough for 32768 x 32768
+constexpr uint32_t TEXTURE_MAX_MIPS = 16;
+
+enum class ETexturePixelFormat : uint32_t
+{
+	//4 bytes per pixel, uploaded as stored
+	Rgba8 = 1,
+	//3 bytes per pixel, transcoded to RGBA8 when the level is decoded, few devices sample 24 bit formats
+	Rgb8
+};
+
+enum ETextureFileFlags : uint32_t
+{
+	//the color channels are sRGB encoded, alpha is always linear
+	TEXTURE_FILE_SRGB = 1 << 0
+};
+
+struct STextureFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	ETexturePixelFormat format;
+	uint32_t flags;
+	uint32_t reserved;
+	//of the whole file, a mismatch means the file was cut off
+	uint64_t fileSize;
+};
+
+//mipCount of these right after the header
+struct STextureFileMip
+{
+	uint32_t width;
+	uint32_t height;
+	//rows are tightly packed
+	uint64_t offset;
+	uint64_t size;
+};
+
+static_assert( sizeof( STextureFileHeader ) == 40, "STextureFileHeader has padding." );
+static_assert( sizeof( STextureFileMip ) == 24, "STextureFileMip has padding." );
+
+inline uint32_t getTexturePixelSize( ETexturePixelFormat format )
+{
+	return format == ETexturePixelFormat::Rgb8 ? 3 : 4;
+}
+
+inline uint64_t alignTextureMip( uint64_t offset )
+{
+	return ( offset + TEXTURE_MIP_ALIGNMENT - 1 ) & ~( TEXTURE_MIP_ALIGNMENT - 1 );
+}
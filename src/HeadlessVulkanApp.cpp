@@ -0,0 +1,564 @@
+#include "vkpch.h"
+#include "HeadlessVulkanApp.h"
+
+#include "Utils/Log.h"
+#include "Utils/Timer.h"
+#include "Vulkan/DeviceDispatch.h"
+#include "Vulkan/VulkanUtils.h"
+
+/////////////////////////////////////////////////
+
+const uint32_t READBACK_BYTES_PER_PIXEL = 4;
+
+/////////////////////////////////////////////////
+
+CHeadlessVulkanApp::CHeadlessVulkanApp()
+	: CHeadlessVulkanApp( SSettings {} )
+{
+}
+
+CHeadlessVulkanApp::CHeadlessVulkanApp( const SSettings& settings )
+	: m_settings( settings )
+	, m_physicalDevice( nullptr )
+	, m_graphicsQueueFamily( 0 )
+	, m_readbackRegionSize( 0 )
+	, m_timelineSemaphoreEnabled( false )
+	, m_pipelineCreationFeedbackEnabled( false )
+	, m_nextFrameIndex( 0 )
+{
+	m_settings.targetCount = std::max( m_settings.targetCount, 1u );
+	m_targetExtent = vk::Extent2D { m_settings.width, m_settings.height };
+}
+
+void CHeadlessVulkanApp::init()
+{
+	CLog::Initialize();
+	m_jobSystem.init();
+	initVulkan();
+}
+
+void CHeadlessVulkanApp::run()
+{
+	CTimer timer;
+
+	renderFrames( m_settings.frameCount );
+
+	const double milliseconds = timer.elapsedMilliseconds();
+	VS_INFO( "Rendered {0} headless frames ({1}x{2}) in {3:.3f} ms, {4:.1f} frames/s.", m_settings.frameCount, m_targetExtent.width, m_targetExtent.height,
+		milliseconds, milliseconds > 0.0 ? m_settings.frameCount * 1000.0 / milliseconds : 0.0 );
+}
+
+void CHeadlessVulkanApp::renderFrames( uint64_t frameCount )
+{
+	m_frameTimes.reserve( m_frameTimes.size() + static_cast< size_t >( frameCount ) );
+
+	const uint64_t endFrameIndex = m_nextFrameIndex + frameCount;
+	for( ; m_nextFrameIndex < endFrameIndex; ++m_nextFrameIndex )
+	{
+		CTimer frameTimer;
+		renderFrame( m_nextFrameIndex );
+		m_frameTimes.push_back( frameTimer.elapsedMilliseconds() );
+	}
+
+	retireAllTargets();
+}
+
+void CHeadlessVulkanApp::cleanup()
+{
+	m_jobSystem.destroy();
+	m_device.waitIdle();
+
+	m_uploadService.destroy();
+
+	m_pipelineCache.save();
+	m_pipelineCache.destroy();
+
+	m_device.destroyBuffer( m_readbackBuffer );
+	m_memoryAllocator.free( m_readbackAllocation );
+
+	for( auto& target : m_targets )
+	{
+		m_device.destroyFence( target.fence );
+		m_device.destroyFramebuffer( target.framebuffer );
+		m_device.destroyImageView( target.imageView );
+		m_device.destroyImage( target.image );
+		m_memoryAllocator.free( target.allocation );
+	}
+
+	m_device.destroyCommandPool( m_commandPool );
+
+	m_device.destroyPipeline( m_graphicsPipeline );
+	m_device.destroyPipelineLayout( m_pipelineLayout );
+	m_device.destroyRenderPass( m_renderPass );
+
+	m_memoryAllocator.logStats();
+	m_memoryAllocator.destroy();
+
+	m_device.destroy();
+
+	if( VALIDATION_ENABLED )
+	{
+		m_instance.destroyDebugUtilsMessengerEXT( m_debugmessenger );
+	}
+
+	m_instance.destroy();
+
+	CLog::Shutdown();
+}
+
+/////////////////////////////////////////////////
+
+void CHeadlessVulkanApp::initVulkan()
+{
+	CTimer timer;
+	m_startupPhases.clear();
+
+	CTimer phaseTimer;
+	auto endPhase = [ this, &phaseTimer ]( const char* name )
+	{
+		m_startupPhases.push_back( SPhaseTiming { name, phaseTimer.elapsedMilliseconds() } );
+		phaseTimer.reset();
+	};
+
+	createInstance();
+	setupDebugMessenger();
+	endPhase( "instance" );
+
+	pickPhysicalDevice();
+	createLogicalDevice();
+	endPhase( "device" );
+
+	m_memoryAllocator.init( m_physicalDevice, m_device );
+	if( m_timelineSemaphoreEnabled )
+	{
+		m_uploadService.init( m_device, m_memoryAllocator, m_graphicsQueue, m_graphicsQueueFamily, m_graphicsQueueFamily );
+	}
+	endPhase( "memory" );
+
+	createOffscreenTargets();
+	createRenderPass();
+	createFramebuffers();
+	endPhase( "targets" );
+
+	m_pipelineCache.init( m_physicalDevice, m_device, m_settings.pipelineCacheFile, m_pipelineCreationFeedbackEnabled );
+	createGraphicsPipeline();
+	m_pipelineCache.logStats();
+	endPhase( "pipelines" );
+
+	createCommandBuffers();
+	createReadbackBuffer();
+	endPhase( "commands" );
+
+	VS_INFO( "Headless initVulkan took {0:.3f} ms.", timer.elapsedMilliseconds() );
+}
+
+void CHeadlessVulkanApp::renderFrame( uint64_t frameIndex )
+{
+	const uint32_t targetIndex = static_cast< uint32_t >( frameIndex % m_targets.size() );
+	SOffscreenTarget& target = m_targets[ targetIndex ];
+
+	//only blocks when the GPU is a full target ring behind
+	retireTarget( target );
+
+	const bool readback = m_settings.readbackInterval > 0 && ( frameIndex % m_settings.readbackInterval ) == 0;
+	recordCommandBuffer( target, targetIndex, readback );
+
+	m_device.resetFences( target.fence );
+
+	const vk::Semaphore uploadSemaphore = m_uploadService.getTimelineSemaphore();
+	const uint32_t waitCount = target.uploadWaitValue > 0 ? 1 : 0;
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo( waitCount, &target.uploadWaitValue, 0, nullptr );
+
+	vk::SubmitInfo submitInfo( waitCount, &uploadSemaphore, &target.uploadWaitStages, 1, &target.commandBuffer );
+	if( waitCount > 0 )
+	{
+		submitInfo.setPNext( &timelineSubmitInfo );
+	}
+	m_graphicsQueue.submit( submitInfo, target.fence );
+
+	target.frameIndex = frameIndex;
+	target.pending = true;
+	target.readbackPending = readback;
+}
+
+void CHeadlessVulkanApp::retireAllTargets()
+{
+	//retire in submission order so frame callbacks stay ordered
+	const size_t targetCount = m_targets.size();
+	for( size_t i = 0; i < targetCount; ++i )
+	{
+		retireTarget( m_targets[ ( m_nextFrameIndex + i ) % targetCount ] );
+	}
+}
+
+void CHeadlessVulkanApp::retireTarget( SOffscreenTarget& target )
+{
+	if( !target.pending )
+	{
+		return;
+	}
+
+	if( m_device.waitForFences( target.fence, VK_TRUE, UINT64_MAX ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "Failed to wait for offscreen frame." );
+	}
+
+	target.pending = false;
+
+	if( !target.readbackPending )
+	{
+		return;
+	}
+
+	target.readbackPending = false;
+
+	const size_t targetIndex = static_cast< size_t >( &target - m_targets.data() );
+	const vk::DeviceSize regionOffset = m_readbackRegionSize * targetIndex;
+
+	m_memoryAllocator.invalidate( m_readbackAllocation, regionOffset, m_readbackRegionSize );
+
+	if( m_frameCallback )
+	{
+		m_frameCallback( target.frameIndex, m_readbackAllocation.pMapped + regionOffset, static_cast< size_t >( m_readbackRegionSize ) );
+	}
+}
+
+/////////////////////////////////////////////////
+
+void CHeadlessVulkanApp::createInstance()
+{
+	CDeviceDispatch::InitLoader();
+
+	if( VALIDATION_ENABLED && !checkValidationLayerSupport() )
+	{
+		throw std::runtime_error( "One or more required validation layers is unavailable." );
+	}
+
+	//1.2 for timeline semaphores, older implementations still run without the upload service
+	vk::ApplicationInfo appInfo( "HeadlessVulkanApp", VK_MAKE_VERSION( 1, 0, 0 ), nullptr, 0, VK_API_VERSION_1_2 );
+
+	//no surface extensions, there is nothing to present to
+	std::vector<const char*> reqExtensions;
+	if( VALIDATION_ENABLED )
+	{
+		reqExtensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
+	}
+
+	vk::InstanceCreateInfo instanceCreateInfo( {}, &appInfo, 0, nullptr, static_cast< uint32_t >( reqExtensions.size() ), reqExtensions.data() );
+
+	vk::DebugUtilsMessengerCreateInfoEXT debugMsgrcreateInfo = getDebugMessengerCreateInfo();
+	if( VALIDATION_ENABLED )
+	{
+		instanceCreateInfo.enabledLayerCount = static_cast< uint32_t >( REQUIRED_VALIDATION_LAYERS.size() );
+		instanceCreateInfo.ppEnabledLayerNames = REQUIRED_VALIDATION_LAYERS.data();
+		instanceCreateInfo.pNext = &debugMsgrcreateInfo;
+	}
+
+	m_instance = vk::createInstance( instanceCreateInfo );
+	CDeviceDispatch::InitInstance( m_instance );
+}
+
+void CHeadlessVulkanApp::setupDebugMessenger()
+{
+	if( !VALIDATION_ENABLED )
+	{
+		return;
+	}
+
+	m_debugmessenger = m_instance.createDebugUtilsMessengerEXT( getDebugMessengerCreateInfo() );
+}
+
+void CHeadlessVulkanApp::pickPhysicalDevice()
+{
+	std::vector<vk::PhysicalDevice> availablePhysicalDevices = m_instance.enumeratePhysicalDevices();
+	if( availablePhysicalDevices.size() < 1 )
+	{
+		throw std::runtime_error( "Failed to find physical devices with vulkan support." );
+	}
+
+	//any device with a graphics queue will do, including CPU implementations
+	for( const auto& device : availablePhysicalDevices )
+	{
+		if( findGraphicsQueueFamily( device ).has_value() )
+		{
+			m_physicalDevice = device;
+			break;
+		}
+	}
+
+	if( m_physicalDevice == vk::PhysicalDevice( nullptr ) )
+	{
+		throw std::runtime_error( "Failed to find a suitable GPU" );
+	}
+
+	const vk::PhysicalDeviceProperties properties = m_physicalDevice.getProperties();
+	VS_INFO( "Headless rendering on '{0}' ({1}).", properties.deviceName, vk::to_string( properties.deviceType ) );
+}
+
+void CHeadlessVulkanApp::createLogicalDevice()
+{
+	m_graphicsQueueFamily = findGraphicsQueueFamily( m_physicalDevice ).value();
+
+	const float queuePriority = 1.0f;
+	vk::DeviceQueueCreateInfo deviceQueueCreateInfo( {}, m_graphicsQueueFamily, 1, &queuePriority );
+
+	std::vector<const char*> deviceExtensions;
+
+	m_pipelineCreationFeedbackEnabled = isDeviceExtensionSupported( m_physicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME );
+	if( m_pipelineCreationFeedbackEnabled )
+	{
+		deviceExtensions.push_back( VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME );
+	}
+
+	m_timelineSemaphoreEnabled = isTimelineSemaphoreSupported( m_physicalDevice );
+
+	vk::PhysicalDeviceVulkan12Features vulkan12Feats {};
+	vulkan12Feats.setTimelineSemaphore( VK_TRUE );
+
+	vk::PhysicalDeviceFeatures physicalDeviceFeats {};
+	vk::DeviceCreateInfo deviceCreateInfo( {}, 1, &deviceQueueCreateInfo, 0, nullptr,
+		static_cast< uint32_t >( deviceExtensions.size() ), deviceExtensions.data(), &physicalDeviceFeats );
+	if( m_timelineSemaphoreEnabled )
+	{
+		deviceCreateInfo.setPNext( &vulkan12Feats );
+	}
+
+	m_device = m_physicalDevice.createDevice( deviceCreateInfo );
+	CDeviceDispatch::InitDevice( m_device );
+	m_graphicsQueue = m_device.getQueue( m_graphicsQueueFamily, 0 );
+}
+
+void CHeadlessVulkanApp::createOffscreenTargets()
+{
+	m_targets.resize( m_settings.targetCount );
+
+	for( auto& target : m_targets )
+	{
+		vk::ImageCreateInfo imageCreateInfo {};
+		imageCreateInfo.setImageType( vk::ImageType::e2D );
+		imageCreateInfo.setFormat( m_targetFormat );
+		imageCreateInfo.setExtent( vk::Extent3D { m_targetExtent.width, m_targetExtent.height, 1 } );
+		imageCreateInfo.setMipLevels( 1 );
+		imageCreateInfo.setArrayLayers( 1 );
+		imageCreateInfo.setSamples( vk::SampleCountFlagBits::e1 );
+		imageCreateInfo.setTiling( vk::ImageTiling::eOptimal );
+		imageCreateInfo.setUsage( vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc );
+		imageCreateInfo.setSharingMode( vk::SharingMode::eExclusive );
+		imageCreateInfo.setInitialLayout( vk::ImageLayout::eUndefined );
+
+		target.image = m_device.createImage( imageCreateInfo );
+		target.allocation = m_memoryAllocator.allocateForImage( target.image, EMemoryUsage::GpuOnly );
+
+		vk::ImageViewCreateInfo viewCreateInfo {};
+		viewCreateInfo.setImage( target.image );
+		viewCreateInfo.setViewType( vk::ImageViewType::e2D );
+		viewCreateInfo.setFormat( m_targetFormat );
+		viewCreateInfo.setComponents( vk::ComponentMapping { vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity,
+			vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity } );
+		viewCreateInfo.setSubresourceRange( vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 ) );
+
+		target.imageView = m_device.createImageView( viewCreateInfo );
+
+		target.fence = m_device.createFence( vk::FenceCreateInfo {} );
+	}
+}
+
+void CHeadlessVulkanApp::createRenderPass()
+{
+	//finishes in TransferSrc so the copy to the readback buffer needs no extra transition
+	vk::AttachmentDescription colorAttachment(
+		{}, m_targetFormat, vk::SampleCountFlagBits::e1,
+		vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
+		vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferSrcOptimal
+	);
+
+	vk::AttachmentReference colorAttachmentRef( 0, vk::ImageLayout::eColorAttachmentOptimal );
+	vk::SubpassDescription subpass( {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef );
+
+	std::array<vk::SubpassDependency, 2> dependencies;
+	//previous frame's copy out of this target must finish before we clear it
+	dependencies[ 0 ] = vk::SubpassDependency( VK_SUBPASS_EXTERNAL, 0,
+		vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+		{}, vk::AccessFlagBits::eColorAttachmentWrite );
+	dependencies[ 1 ] = vk::SubpassDependency( 0, VK_SUBPASS_EXTERNAL,
+		vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer,
+		vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead );
+
+	vk::RenderPassCreateInfo renderPassCreateInfo( {}, 1, &colorAttachment, 1, &subpass, static_cast< uint32_t >( dependencies.size() ), dependencies.data() );
+	m_renderPass = m_device.createRenderPass( renderPassCreateInfo );
+
+	if( m_renderPass == vk::RenderPass( nullptr ) )
+	{
+		throw std::runtime_error( "failed to create render pass." );
+	}
+}
+
+void CHeadlessVulkanApp::createFramebuffers()
+{
+	for( auto& target : m_targets )
+	{
+		vk::FramebufferCreateInfo createInfo( {}, m_renderPass, 1, &target.imageView, m_targetExtent.width, m_targetExtent.height, 1 );
+		target.framebuffer = m_device.createFramebuffer( createInfo );
+	}
+}
+
+void CHeadlessVulkanApp::createGraphicsPipeline()
+{
+	vk::ShaderModule vertShaderModule = createShaderModule( CShaderRegistry::Get( "shader.vert" ) );
+	vk::ShaderModule fragShaderModule = createShaderModule( CShaderRegistry::Get( "shader.frag" ) );
+
+	vk::PipelineShaderStageCreateInfo shaderStages[] = {
+		vk::PipelineShaderStageCreateInfo( {}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main" ),
+		vk::PipelineShaderStageCreateInfo( {}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main" )
+	};
+
+	vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo( {}, 0, nullptr, 0, nullptr );
+	vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo( {}, vk::PrimitiveTopology::eTriangleList, false );
+
+	vk::Viewport viewport( 0.0f, 0.0f, static_cast< float >( m_targetExtent.width ), static_cast< float >( m_targetExtent.height ), 0.0f, 1.0f );
+	vk::Rect2D scissor( vk::Offset2D { 0, 0 }, m_targetExtent );
+	vk::PipelineViewportStateCreateInfo viewportStateCreateInfo( {}, 1, &viewport, 1, &scissor );
+
+	vk::PipelineRasterizationStateCreateInfo rasterStateCreateInfo {};
+	rasterStateCreateInfo.setPolygonMode( vk::PolygonMode::eFill );
+	rasterStateCreateInfo.setLineWidth( 1.0f );
+	rasterStateCreateInfo.setCullMode( vk::CullModeFlagBits::eBack );
+	rasterStateCreateInfo.setFrontFace( vk::FrontFace::eClockwise );
+
+	vk::PipelineMultisampleStateCreateInfo multiSamplingCreateInfo {};
+	multiSamplingCreateInfo.setRasterizationSamples( vk::SampleCountFlagBits::e1 );
+
+	vk::PipelineColorBlendAttachmentState colorBlendingAttachmentState {};
+	colorBlendingAttachmentState.setColorWriteMask( vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA );
+	colorBlendingAttachmentState.setBlendEnable( VK_FALSE );
+
+	vk::PipelineColorBlendStateCreateInfo colorBlendStateCreateInfo {};
+	colorBlendStateCreateInfo.setAttachmentCount( 1 );
+	colorBlendStateCreateInfo.setPAttachments( &colorBlendingAttachmentState );
+
+	m_pipelineLayout = m_device.createPipelineLayout( vk::PipelineLayoutCreateInfo {} );
+
+	vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo {};
+	graphicsPipelineCreateInfo.setStageCount( 2 );
+	graphicsPipelineCreateInfo.setPStages( shaderStages );
+	graphicsPipelineCreateInfo.setPVertexInputState( &vertexInputStateCreateInfo );
+	graphicsPipelineCreateInfo.setPInputAssemblyState( &inputAssemblyStateCreateInfo );
+	graphicsPipelineCreateInfo.setPViewportState( &viewportStateCreateInfo );
+	graphicsPipelineCreateInfo.setPRasterizationState( &rasterStateCreateInfo );
+	graphicsPipelineCreateInfo.setPMultisampleState( &multiSamplingCreateInfo );
+	graphicsPipelineCreateInfo.setPColorBlendState( &colorBlendStateCreateInfo );
+	graphicsPipelineCreateInfo.setLayout( m_pipelineLayout );
+	graphicsPipelineCreateInfo.setRenderPass( m_renderPass );
+	graphicsPipelineCreateInfo.setSubpass( 0 );
+	graphicsPipelineCreateInfo.setBasePipelineIndex( -1 );
+
+	m_graphicsPipeline = m_pipelineCache.createGraphicsPipeline( graphicsPipelineCreateInfo );
+
+	m_device.destroyShaderModule( vertShaderModule );
+	m_device.destroyShaderModule( fragShaderModule );
+}
+
+void CHeadlessVulkanApp::createCommandBuffers()
+{
+	vk::CommandPoolCreateInfo poolCreateInfo( vk::CommandPoolCreateFlagBits::eResetCommandBuffer, m_graphicsQueueFamily );
+	m_commandPool = m_device.createCommandPool( poolCreateInfo );
+
+	vk::CommandBufferAllocateInfo allocateInfo( m_commandPool, vk::CommandBufferLevel::ePrimary, static_cast< uint32_t >( m_targets.size() ) );
+	std::vector<vk::CommandBuffer> commandBuffers = m_device.allocateCommandBuffers( allocateInfo );
+
+	for( size_t i = 0; i < m_targets.size(); ++i )
+	{
+		m_targets[ i ].commandBuffer = commandBuffers[ i ];
+	}
+}
+
+void CHeadlessVulkanApp::createReadbackBuffer()
+{
+	m_readbackRegionSize = static_cast< vk::DeviceSize >( m_targetExtent.width ) * m_targetExtent.height * READBACK_BYTES_PER_PIXEL;
+
+	vk::BufferCreateInfo createInfo( {}, m_readbackRegionSize * m_targets.size(), vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive );
+	m_readbackBuffer = m_device.createBuffer( createInfo );
+
+	//cached memory is preferred for GpuToCpu, CPU reads from write combined memory are slow
+	m_readbackAllocation = m_memoryAllocator.allocateForBuffer( m_readbackBuffer, EMemoryUsage::GpuToCpu );
+}
+
+std::optional<uint32_t> CHeadlessVulkanApp::findGraphicsQueueFamily( const vk::PhysicalDevice& device )
+{
+	std::vector<vk::QueueFamilyProperties> queueFamilyProps = device.getQueueFamilyProperties();
+
+	for( uint32_t queueFamilyIndex = 0; queueFamilyIndex < queueFamilyProps.size(); ++queueFamilyIndex )
+	{
+		if( queueFamilyProps[ queueFamilyIndex ].queueFlags & vk::QueueFlagBits::eGraphics )
+		{
+			return queueFamilyIndex;
+		}
+	}
+
+	return std::nullopt;
+}
+
+bool CHeadlessVulkanApp::isTimelineSemaphoreSupported( const vk::PhysicalDevice& device )
+{
+	if( device.getProperties().apiVersion < VK_API_VERSION_1_2 )
+	{
+		return false;
+	}
+
+	auto featureChain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	return featureChain.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore;
+}
+
+vk::ShaderModule CHeadlessVulkanApp::createShaderModule( const SShaderCode& code )
+{
+	vk::ShaderModule shaderModule = m_device.createShaderModule( code.getModuleCreateInfo() );
+
+	if( shaderModule == vk::ShaderModule( nullptr ) )
+	{
+		throw std::runtime_error( "Failed to create shader module." );
+	}
+
+	return shaderModule;
+}
+
+void CHeadlessVulkanApp::recordCommandBuffer( SOffscreenTarget& target, uint32_t targetIndex, bool readback )
+{
+	vk::CommandBuffer cmd = target.commandBuffer;
+	cmd.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+
+	target.uploadWaitValue = 0;
+	target.uploadWaitStages = {};
+	if( m_timelineSemaphoreEnabled )
+	{
+		target.uploadWaitValue = m_uploadService.recordGraphicsAcquire( cmd, target.uploadWaitStages );
+	}
+
+	vk::ClearValue clearValue( vk::ClearColorValue( std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } ) );
+	vk::RenderPassBeginInfo renderPassBeginInfo( m_renderPass, target.framebuffer, vk::Rect2D( vk::Offset2D { 0, 0 }, m_targetExtent ), 1, &clearValue );
+
+	cmd.beginRenderPass( renderPassBeginInfo, vk::SubpassContents::eInline );
+	cmd.bindPipeline( vk::PipelineBindPoint::eGraphics, m_graphicsPipeline );
+	for( uint32_t i = 0; i < m_settings.drawCount; ++i )
+	{
+		cmd.draw( 3, 1, 0, 0 );
+	}
+	cmd.endRenderPass();
+
+	if( readback )
+	{
+		vk::BufferImageCopy region {};
+		region.setBufferOffset( m_readbackRegionSize * targetIndex );
+		region.setImageSubresource( vk::ImageSubresourceLayers( vk::ImageAspectFlagBits::eColor, 0, 0, 1 ) );
+		region.setImageExtent( vk::Extent3D { m_targetExtent.width, m_targetExtent.height, 1 } );
+
+		cmd.copyImageToBuffer( target.image, vk::ImageLayout::eTransferSrcOptimal, m_readbackBuffer, region );
+
+		//make the copy visible to the host once the fence signals
+		vk::BufferMemoryBarrier hostBarrier( vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, m_readbackBuffer, region.bufferOffset, m_readbackRegionSize );
+		cmd.pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, nullptr, hostBarrier, nullptr );
+	}
+
+	cmd.end();
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include "AppBase.h"
+#include "Memory/DeviceMemoryAllocator.h"
+#include "Vulkan/PipelineCache.h"
+#include "Vulkan/ShaderRegistry.h"
+#include "Vulkan/UploadService.h"
+#include <vulkan/vulkan.hpp>
+
+#include <functional>
+
+//Renders into device local offscreen images instead of a swapchain, so it
+//needs neither a window nor VK_KHR_swapchain and runs on software ICDs such as lavapipe.
+//Frames are copied into a host visible readback buffer as they retire.
+class CHeadlessVulkanApp : public IAppBase
+{
+public:
+	struct SSettings
+	{
+		uint32_t width = 1280;
+		uint32_t height = 720;
+		uint32_t frameCount = 1000;
+		//number of offscreen targets rendered round robin, bounds the frames the GPU can have in flight
+		uint32_t targetCount = 3;
+		//copy every Nth frame back to host memory, 0 disables readback
+		uint32_t readbackInterval = 1;
+		//triangles drawn per frame, each with its own draw call
+		uint32_t drawCount = 1;
+		std::string pipelineCacheFile = "pipeline_cache_headless.bin";
+	};
+
+	struct SPhaseTiming
+	{
+		const char* name;
+		double milliseconds;
+	};
+
+	//called with the pixels (RGBA8) of a frame once the GPU has finished it
+	using FrameCallback = std::function<void( uint64_t frameIndex, const uint8_t* pPixels, size_t size )>;
+
+private:
+	struct SOffscreenTarget
+	{
+		vk::Image image;
+		SAllocation allocation;
+		vk::ImageView imageView;
+		vk::Framebuffer framebuffer;
+
+		vk::CommandBuffer commandBuffer;
+		vk::Fence fence;
+
+		//timeline value of the uploads this frame consumes, 0 if none
+		uint64_t uploadWaitValue = 0;
+		vk::PipelineStageFlags uploadWaitStages;
+
+		//frame currently in flight on this target, and whether it copies to the readback buffer
+		uint64_t frameIndex = 0;
+		bool pending = false;
+		bool readbackPending = false;
+	};
+
+public:
+	CHeadlessVulkanApp();
+	explicit CHeadlessVulkanApp( const SSettings& settings );
+
+	// Inherited via IAppBase
+	virtual void init() override;
+	virtual void run() override;
+	virtual void cleanup() override;
+
+	inline void setFrameCallback( FrameCallback callback )
+	{
+		m_frameCallback = std::move( callback );
+	}
+
+	//renders frameCount more frames and waits for all of them, recording each frame's CPU time
+	void renderFrames( uint64_t frameCount );
+
+	inline void setDrawCount( uint32_t drawCount )
+	{
+		m_settings.drawCount = drawCount;
+	}
+
+	inline void setReadbackInterval( uint32_t readbackInterval )
+	{
+		m_settings.readbackInterval = readbackInterval;
+	}
+
+	//time spent in renderFrame per frame, which includes waiting for a free target
+	inline const std::vector<double>& getFrameTimes() const
+	{
+		return m_frameTimes;
+	}
+
+	inline void clearFrameTimes()
+	{
+		m_frameTimes.clear();
+	}
+
+	inline const std::vector<SPhaseTiming>& getStartupPhases() const
+	{
+		return m_startupPhases;
+	}
+
+	inline vk::PhysicalDevice getPhysicalDevice() const
+	{
+		return m_physicalDevice;
+	}
+
+	inline vk::Device getDevice() const
+	{
+		return m_device;
+	}
+
+	inline uint32_t getGraphicsQueueFamily() const
+	{
+		return m_graphicsQueueFamily;
+	}
+
+	inline vk::RenderPass getRenderPass() const
+	{
+		return m_renderPass;
+	}
+
+	inline vk::PipelineLayout getPipelineLayout() const
+	{
+		return m_pipelineLayout;
+	}
+
+	inline vk::Pipeline getGraphicsPipeline() const
+	{
+		return m_graphicsPipeline;
+	}
+
+	inline vk::Extent2D getTargetExtent() const
+	{
+		return m_targetExtent;
+	}
+
+	inline vk::DeviceSize getReadbackFrameSize() const
+	{
+		return m_readbackRegionSize;
+	}
+
+	inline bool isPipelineCreationFeedbackEnabled() const
+	{
+		return m_pipelineCreationFeedbackEnabled;
+	}
+
+	inline CDeviceMemoryAllocator& getMemoryAllocator()
+	{
+		return m_memoryAllocator;
+	}
+
+	//null when the device has no timeline semaphores
+	inline CUploadService* getUploadService()
+	{
+		return m_timelineSemaphoreEnabled ? &m_uploadService : nullptr;
+	}
+
+private:
+	void initVulkan();
+	void renderFrame( uint64_t frameIndex );
+	void retireAllTargets();
+	void retireTarget( SOffscreenTarget& target );
+
+	void createInstance();
+	void setupDebugMessenger();
+	void pickPhysicalDevice();
+	void createLogicalDevice();
+	void createOffscreenTargets();
+	void createRenderPass();
+	void createFramebuffers();
+	void createGraphicsPipeline();
+	void createCommandBuffers();
+	void createReadbackBuffer();
+
+	std::optional<uint32_t> findGraphicsQueueFamily( const vk::PhysicalDevice& device );
+	bool isTimelineSemaphoreSupported( const vk::PhysicalDevice& device );
+	vk::ShaderModule createShaderModule( const SShaderCode& code );
+
+	void recordCommandBuffer( SOffscreenTarget& target, uint32_t targetIndex, bool readback );
+
+
+	SSettings m_settings;
+	FrameCallback m_frameCallback;
+
+	vk::Instance m_instance;
+	vk::PhysicalDevice m_physicalDevice;
+	vk::Device m_device;
+	CDeviceMemoryAllocator m_memoryAllocator;
+
+	//uploads share the graphics queue, there is no presentation work to overlap with
+	CUploadService m_uploadService;
+	bool m_timelineSemaphoreEnabled;
+
+	uint32_t m_graphicsQueueFamily;
+	vk::Queue m_graphicsQueue;
+
+	const vk::Format m_targetFormat = vk::Format::eR8G8B8A8Unorm;
+	vk::Extent2D m_targetExtent;
+	std::vector<SOffscreenTarget> m_targets;
+
+	vk::RenderPass m_renderPass;
+	vk::PipelineLayout m_pipelineLayout;
+	vk::Pipeline m_graphicsPipeline;
+
+	vk::CommandPool m_commandPool;
+
+	//one region per target so a readback never waits on another target
+	vk::Buffer m_readbackBuffer;
+	SAllocation m_readbackAllocation;
+	vk::DeviceSize m_readbackRegionSize;
+
+	CPipelineCache m_pipelineCache;
+	bool m_pipelineCreationFeedbackEnabled;
+
+	uint64_t m_nextFrameIndex;
+	std::vector<double> m_frameTimes;
+	std::vector<SPhaseTiming> m_startupPhases;
+
+	vk::DebugUtilsMessengerEXT m_debugmessenger;
+
+};
@@ -1,7 +1,11 @@
 #include "vkpch.h"
 #include "HelloVulkanApp.h"
 
+#include "Profiling/CpuProfiler.h"
 #include "Utils/Log.h"
+#include "Utils/TaskGraph.h"
+#include "Vulkan/DeviceDispatch.h"
+#include "Vulkan/VulkanUtils.h"
 #include <GLFW/glfw3.h>
 
 /////////////////////////////////////////////////
@@ -9,82 +13,59 @@
 const uint32_t WINDOW_WIDTH = 1280;
 const uint32_t WINDOW_HEIGHT = 720;
 
-const std::vector<const char*> REQUIRED_VALIDATION_LAYERS = { "VK_LAYER_KHRONOS_validation" };
 const std::vector<const char*> REQUIRED_DEVICE_EXTENSIONS = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
+const char* const PIPELINE_CACHE_FILE = "pipeline_cache.bin";
 
-#ifdef VKS_DEBUG
-constexpr bool VALIDATION_ENABLED = true;
-#else
-constexpr bool VALIDATION_ENABLED = fasle;
-#endif
-
-
-/////////////////////////////////////////////////
-
-
-static std::vector<char> readFile( const std::string& fileName )
-{
-	std::ifstream file( fileName, std::ios::ate | std::ios::binary );
-
-	if( !file.is_open() )
-	{
-		throw std::runtime_error( "Failed to open file" );
-	}
-
-	size_t fileSize = static_cast< size_t >( file.tellg() );
-	std::vector<char> buffer( fileSize );
+//startup is mostly a chain of driver calls, a few helpers cover everything that can overlap
+const uint32_t MAX_STARTUP_WORKERS = 3;
 
-	file.seekg( 0 );
-	file.read( buffer.data(), fileSize );
-	file.close();
+//below this many draws the thread handoff costs more than it saves
+const size_t PARALLEL_RECORD_MIN_DRAWS = 256;
+const uint32_t RECORD_BENCHMARK_ITERATIONS = 32;
 
-	return buffer;
-}
 
+/////////////////////////////////////////////////
 
-static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallbackFn(
-	VkDebugUtilsMessageSeverityFlagBitsEXT       messageSeverity,
-	VkDebugUtilsMessageTypeFlagsEXT              messageTypes,
-	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-	void* pUserData )
+CHelloVulkanApp::CHelloVulkanApp()
+	: CHelloVulkanApp( SSettings {} )
 {
-
-	switch( messageSeverity )
-	{
-	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-		VS_TRACE( "[VULKAN][TRACE] {0}", pCallbackData->pMessage );
-		break;
-	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-		VS_INFO( "[VULKAN][INFO] {0}", pCallbackData->pMessage );
-		break;
-	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-		VS_WARN( "[VULKAN][WARNING] {0}", pCallbackData->pMessage );
-		break;
-	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-		std::cout << '\a';
-		VS_ERROR( "[VULKAN][ERROR] {0}", pCallbackData->pMessage );
-		break;
-
-	}
-	return VK_FALSE;
 }
 
-
-/////////////////////////////////////////////////
-
-CHelloVulkanApp::CHelloVulkanApp()
-	: m_pWindow( nullptr )
+CHelloVulkanApp::CHelloVulkanApp( const SSettings& settings )
+	: m_settings( settings )
+	, m_pWindow( nullptr )
 	, m_physicalDevice( nullptr )
-	, m_swapChain( nullptr )
+	, m_swapChainDirty( false )
+	, m_backbuffer( 0 )
+	, m_scenePass( 0 )
+	, m_mainPass( 0 )
+	, m_sceneEnabled( false )
+	, m_framesInFlight( std::max( settings.framesInFlight, 1u ) )
+	, m_currentFrame( 0 )
+	, m_submittedFrames( 0 )
+	, m_presentWaitEnabled( false )
+	, m_pipelineCreationFeedbackEnabled( false )
+	, m_memoryBudgetEnabled( false )
+	, m_firstFramePresented( false )
+	, m_firstScenePresented( false )
 {
 }
 
 void CHelloVulkanApp::init()
 {
+	m_startupTimer.reset();
 	CLog::Initialize();
-	initWindow();
-	initVulkan();
+
+	//startup tasks may already queue jobs, e.g. the recording benchmark
+	m_jobSystem.init( m_settings.jobThreads );
+
+	CTaskGraph startupGraph;
+	buildStartupGraph( startupGraph );
+
+	const uint32_t workerCount = std::min( std::max( std::thread::hardware_concurrency(), 1u ) - 1, MAX_STARTUP_WORKERS );
+	startupGraph.run( workerCount );
+	startupGraph.logTimings( "Startup" );
 }
 
 void CHelloVulkanApp::run()
@@ -97,33 +78,210 @@ void CHelloVulkanApp::run()
 
 void CHelloVulkanApp::cleanup()
 {
-	m_device.destroyPipeline( m_graphicsPipeline );
-	m_device.destroyPipelineLayout( m_pipelineLayout );
-	m_device.destroyRenderPass( m_renderPass );
+	//no job may touch the device anymore
+	m_textureStreamer.stopDecoding();
+	m_jobSystem.logStats();
+	m_jobSystem.destroy();
+
+	//only place we drain the GPU, every frame in flight has to retire before teardown
+	m_device->waitIdle();
+	m_deletionQueue.flushAll();
 
-	for( auto& imageView : m_swapChainImageViews )
+	m_framePacer.logStats();
+	if( !m_settings.latencyCsvFile.empty() )
 	{
-		m_device.destroyImageView( imageView );
+		m_framePacer.writeCsv( m_settings.latencyCsvFile );
 	}
 
-	m_device.destroySwapchainKHR( m_swapChain );
-	m_instance.destroySurfaceKHR( m_surface );
-	m_device.destroy();
+	m_pipelineRegistry.logStats();
+	m_pipelineRegistry.destroy();
 
-	if( VALIDATION_ENABLED )
-	{
-		m_instance.destroyDebugUtilsMessengerEXT( m_debugmessenger, nullptr, m_dld );
-	}
+	//finishes the compiles in flight so they still make it into the saved cache
+	m_pipelineCompiler.destroy();
+	m_pipelineCompiler.logStats();
+	m_pipelineCache.logStats();
+
+	m_pipelineCache.save();
+	m_pipelineCache.destroy();
+
+	m_commandRecorder.destroy();
+
+	m_profilerOverlay.destroy();
+	m_gpuProfiler.destroy();
+
+	m_frames.clear();
+
+	m_renderGraph.logStats();
+	m_renderGraph.destroy();
+
+	m_scene.logStats();
+	m_scene.destroy();
+
+	m_instanceRenderer.logStats();
+	m_instanceRenderer.destroy();
 
-	m_instance.destroy();
+	//returns its bindless slots and residency entries, so it goes before both
+	m_textureStreamer.logStats();
+	m_textureStreamer.destroy();
+
+	//after flushAll, released slots are returned through the deletion queue
+	m_bindlessTable.logStats();
+	m_bindlessTable.destroy();
+
+	m_swapChainImageViews.clear();
+	m_renderFinishedSemaphores.clear();
+	m_swapChain.reset();
+	m_surface.reset();
+
+	m_uploadService.destroy();
+
+	m_residencyManager.logStats();
+	m_residencyManager.destroy();
+
+	m_memoryAllocator.logStats();
+	m_memoryAllocator.destroy();
+
+	//last, every object made from the device or the instance is gone by now
+	m_device.reset();
+	m_debugMessenger.reset();
+	m_instance.reset();
 
 	glfwDestroyWindow( m_pWindow );
 	glfwTerminate();
+
+	CLog::Shutdown();
 }
 
 /////////////////////////////////////////////////
 
-void CHelloVulkanApp::initWindow()
+//Window and Vulkan setup as a dependency graph. GLFW window and ImGui calls stay on the
+//main thread, everything else runs as soon as its inputs exist, so the window, device
+//enumeration, shader and pipeline cache loading overlap instance and device creation.
+//Tasks only write the members they create and read those of their dependencies.
+void CHelloVulkanApp::buildStartupGraph( CTaskGraph& graph )
+{
+	using EThread = CTaskGraph::EThread;
+
+	const auto glfw = graph.addTask( "glfw", [ this ] { initGlfw(); }, {}, EThread::Main );
+	const auto window = graph.addTask( "window", [ this ] { createWindow(); }, { glfw }, EThread::Main );
+
+	const auto instance = graph.addTask( "instance", [ this ]
+	{
+		createInstance();
+		setupDebugMessenger();
+	}, { glfw } );
+
+	const auto enumerateDevices = graph.addTask( "enumerate devices", [ this ] { enumeratePhysicalDevices(); }, { instance } );
+	const auto surface = graph.addTask( "surface", [ this ] { createSurface(); }, { instance, window } );
+
+	const auto device = graph.addTask( "device", [ this ]
+	{
+		pickPhysicalDevice();
+		createLogicalDevice();
+		createFramePacer();
+		m_bindlessTable.init( m_physicalDevice, *m_device );
+	}, { enumerateDevices, surface } );
+
+	//looked up again by createGraphicsPipeline, this pays for reading overrides from disk early
+	const auto shaders = graph.addTask( "shaders", []
+	{
+		CShaderRegistry::Get( "shader.vert" );
+		CShaderRegistry::Get( "shader.frag" );
+		CShaderRegistry::Get( "scene.vert" );
+		CShaderRegistry::Get( "scene.frag" );
+		CShaderRegistry::Get( "instanced.vert" );
+		CShaderRegistry::Get( "cull.comp" );
+	} );
+	const auto cacheRead = graph.addTask( "pipeline cache read", [ this ] { m_pipelineCache.preload( PIPELINE_CACHE_FILE ); } );
+
+	const auto memory = graph.addTask( "memory", [ this ]
+	{
+		m_memoryAllocator.init( m_physicalDevice, *m_device );
+		m_residencyManager.init( m_physicalDevice, m_memoryAllocator, m_memoryBudgetEnabled );
+
+		SQueueFamilyIndices indices = findQueueFamilies( m_physicalDevice );
+		m_uploadService.init( *m_device, m_memoryAllocator, m_transferQueue, indices.transferFamily.value_or( indices.graphicsFamily.value() ), indices.graphicsFamily.value() );
+	}, { device } );
+
+	const auto swapChain = graph.addTask( "swapchain", [ this ]
+	{
+		createSwapChain();
+		createImageViews();
+		createRenderGraph();
+	}, { device } );
+
+	const auto pipelineCache = graph.addTask( "pipeline cache", [ this ]
+	{
+		m_pipelineCache.init( m_physicalDevice, *m_device, PIPELINE_CACHE_FILE, m_pipelineCreationFeedbackEnabled );
+	}, { device, cacheRead } );
+
+	//only queues the compile, frames render without the draws until it is ready
+	const auto pipelines = graph.addTask( "pipelines", [ this ]
+	{
+		m_pipelineCompiler.init( *m_device, m_pipelineCache, m_settings.pipelineCompileThreads );
+		m_pipelineRegistry.init( m_pipelineCompiler );
+		createGraphicsPipeline();
+		createScenePipeline();
+		createInstancePipeline();
+	}, { swapChain, pipelineCache, shaders } );
+
+	graph.addTask( "frame resources", [ this ] { createFrameResources(); }, { device } );
+
+	//queues the uploads, the first frame submits whatever did not overflow the staging ring before
+	const auto scene = graph.addTask( "scene", [ this ]
+	{
+		if( !m_sceneEnabled )
+		{
+			return;
+		}
+
+		CGpuScene::SSettings sceneSettings;
+		sceneSettings.objectCount = m_settings.sceneObjectCount;
+		sceneSettings.meshFile = m_settings.sceneMeshFile;
+		sceneSettings.materialCount = m_settings.sceneTextureCount;
+		m_scene.init( m_physicalDevice, *m_device, m_memoryAllocator, m_uploadService, m_bindlessTable, m_pipelineCache.getHandle(), sceneSettings );
+	}, { memory, pipelineCache } );
+
+	//only registers the textures, files are opened and decoded by jobs once frames run
+	const auto textures = graph.addTask( "textures", [ this ]
+	{
+		if( !m_sceneEnabled || m_settings.sceneTextureCount == 0 )
+		{
+			return;
+		}
+
+		m_textureStreamer.init( m_physicalDevice, *m_device, m_memoryAllocator, m_uploadService, m_bindlessTable, m_residencyManager, m_jobSystem, m_framesInFlight );
+		for( uint32_t i = 0; i < m_settings.sceneTextureCount; ++i )
+		{
+			CTextureStreamer::STextureDesc desc;
+			desc.filePath = m_settings.textureFiles.empty() ? std::string() : m_settings.textureFiles[ i % m_settings.textureFiles.size() ];
+			desc.seed = i;
+			m_sceneTextures.push_back( m_textureStreamer.addTexture( desc ) );
+		}
+	}, { memory } );
+
+	graph.addTask( "instances", [ this ]
+	{
+		if( m_settings.instanceCount == 0 )
+		{
+			return;
+		}
+
+		CInstanceRenderer::SSettings instanceSettings;
+		instanceSettings.instanceCount = m_settings.instanceCount;
+		m_instanceRenderer.init( *m_device, m_memoryAllocator, m_bindlessTable, m_framesInFlight, instanceSettings );
+	}, { memory } );
+
+	//the recording benchmark executes the graph, which may allocate its images
+	graph.addTask( "command recorder", [ this ] { createCommandRecorder(); }, { pipelines, memory } );
+
+	//the font upload submits to the graphics queue. Uploads queued by the scene and the textures submit
+	//to the transfer queue when they fill the staging ring, which is the same queue without a
+	//transfer family, so the profiler waits for them rather than submitting next to them.
+	graph.addTask( "profiler", [ this ] { createProfiler(); }, { swapChain, pipelineCache, scene, textures }, EThread::Main );
+}
+
+void CHelloVulkanApp::initGlfw()
 {
 	int success = glfwInit();
 	if( success != GLFW_TRUE )
@@ -132,55 +290,239 @@ void CHelloVulkanApp::initWindow()
 	}
 
 	glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
-	glfwWindowHint( GLFW_RESIZABLE, GLFW_FALSE );
-
-	m_pWindow = glfwCreateWindow( WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan Sandbox", nullptr, nullptr );
+	glfwWindowHint( GLFW_RESIZABLE, GLFW_TRUE );
 }
 
-void CHelloVulkanApp::initVulkan()
+void CHelloVulkanApp::createWindow()
 {
-	createInstance();
-	setupDebugMessenger();
-	createSurface();
-	pickPhysicalDevice();
-	createLogicalDevice();
-	createSwapChain();
-	createImageViews();
-	createRenderPass();
-	createGraphicsPipeline();
+	m_pWindow = glfwCreateWindow( WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan Sandbox", nullptr, nullptr );
+	if( !m_pWindow )
+	{
+		throw std::runtime_error( "Failed to create window." );
+	}
+
+	int width = 0;
+	int height = 0;
+	glfwGetFramebufferSize( m_pWindow, &width, &height );
+	m_windowFramebufferExtent = vk::Extent2D { static_cast< uint32_t >( width ), static_cast< uint32_t >( height ) };
+
+	glfwSetWindowUserPointer( m_pWindow, this );
+	glfwSetFramebufferSizeCallback( m_pWindow, framebufferResizeCallback );
 }
 
 void CHelloVulkanApp::update()
 {
+	CCpuProfiler::BeginFrame();
+
+	//minimized, nothing can be presented until the window has an area again
+	if( m_windowFramebufferExtent.width == 0 || m_windowFramebufferExtent.height == 0 )
+	{
+		glfwWaitEvents();
+		return;
+	}
+
+	{
+		VS_PROFILE_SCOPE( "frame pacing" );
+		m_framePacer.beginFrame( m_gpuProfiler.isSupported() ? m_gpuProfiler.getFrameHistory().getLatest() : 0.0f );
+	}
+
+	//input is sampled here, as late as the pacer allows
 	glfwPollEvents();
+	drawFrame();
+}
+
+void CHelloVulkanApp::drawFrame()
+{
+	SFrameData& frame = m_frames[ m_currentFrame ];
+
+	//blocks only if the GPU is still m_framesInFlight frames behind
+	{
+		VS_PROFILE_SCOPE( "wait frame fence" );
+		if( m_device->waitForFences( *frame.inFlightFence, VK_TRUE, UINT64_MAX ) != vk::Result::eSuccess )
+		{
+			throw std::runtime_error( "Failed to wait for in flight fence." );
+		}
+	}
+
+	//frames finish in submission order, nothing retired up to this slot's last frame is in use anymore
+	m_deletionQueue.flush( frame.frameNumber );
+	m_framePacer.onFrameRetired( frame.frameNumber );
+	m_residencyManager.beginFrame( m_submittedFrames + 1, frame.frameNumber );
+
+	if( m_swapChainDirty )
+	{
+		VS_PROFILE_SCOPE( "recreate swapchain" );
+		if( !recreateSwapChain() )
+		{
+			return;
+		}
+	}
+
+	uint32_t imageIndex = 0;
+	try
+	{
+		VS_PROFILE_SCOPE( "acquire image" );
+		auto acquireResult = m_device->acquireNextImageKHR( *m_swapChain, UINT64_MAX, *frame.imageAvailableSemaphore, nullptr );
+		imageIndex = acquireResult.value;
+
+		//the image is acquired and its semaphore will signal, so this frame still goes ahead
+		if( acquireResult.result == vk::Result::eSuboptimalKHR )
+		{
+			m_swapChainDirty = true;
+		}
+	}
+	catch( const vk::OutOfDateKHRError& )
+	{
+		m_swapChainDirty = true;
+		return;
+	}
+
+	//the swapchain may hand back an image that an older frame slot is still rendering to
+	if( m_imagesInFlight[ imageIndex ] && m_imagesInFlight[ imageIndex ] != *frame.inFlightFence )
+	{
+		if( m_device->waitForFences( m_imagesInFlight[ imageIndex ], VK_TRUE, UINT64_MAX ) != vk::Result::eSuccess )
+		{
+			throw std::runtime_error( "Failed to wait for image in flight fence." );
+		}
+	}
+	m_imagesInFlight[ imageIndex ] = *frame.inFlightFence;
+
+	//readiness only ever flips to true, so if it is set here this frame records the draws
+	const bool sceneReady = m_graphicsPipeline.isReady();
+
+	//simulation feeds culling, and the primary needs the culling commands and the flushed uploads
+	m_jobSystem.run( [ this ]() { updateSimulation(); }, &m_simulationJobs );
+	m_jobSystem.run( [ this, completedFrame = frame.frameNumber ]() { updateTextureStreaming( completedFrame ); }, &m_streamingJobs, { &m_simulationJobs } );
+	m_jobSystem.run( [ this, &frame ]() { recordCulling( frame ); }, &m_cullingJobs, { &m_simulationJobs } );
+	m_jobSystem.run( [ this ]()
+	{
+		//uploads queued since the last frame, e.g. by startup tasks or the streamer, so recordGraphicsAcquire picks them up
+		VS_PROFILE_SCOPE( "flush uploads" );
+		m_uploadService.flush();
+	}, &m_uploadJobs, { &m_streamingJobs } );
+
+	//writes this slot's instance buffer, which its last frame is done reading. Only the submit waits for it.
+	if( m_instanceRenderer.isInitialized() )
+	{
+		m_instanceRenderer.update( m_currentFrame, m_jobSystem, m_instanceJobs );
+	}
+
+	//meanwhile on the main thread, GLFW and ImGui only allow one
+	if( m_profilerOverlay.isInitialized() )
+	{
+		VS_PROFILE_SCOPE( "overlay update" );
+		m_profilerOverlay.update( m_gpuProfiler, &m_framePacer.getLatencyHistory(), &m_residencyManager );
+	}
+
+	m_jobSystem.run( [ this, &frame, imageIndex ]()
+	{
+		VS_PROFILE_SCOPE( "record" );
+		m_device->resetCommandPool( *frame.commandPool, {} );
+		recordCommandBuffer( frame, imageIndex );
+	}, &m_recordJobs, { &m_cullingJobs, &m_uploadJobs } );
+
+	{
+		//the main thread records draw slices too while it waits
+		VS_PROFILE_SCOPE( "wait frame jobs" );
+		for( CJobCounter* pCounter : { &m_recordJobs, &m_simulationJobs, &m_streamingJobs, &m_cullingJobs, &m_uploadJobs, &m_instanceJobs } )
+		{
+			m_jobSystem.wait( *pCounter );
+		}
+	}
+
+	//the timeline wait is only added when this frame consumes uploads
+	std::array<vk::Semaphore, 2> waitSemaphores = { *frame.imageAvailableSemaphore, m_uploadService.getTimelineSemaphore() };
+	std::array<vk::PipelineStageFlags, 2> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput, frame.uploadWaitStages };
+	std::array<uint64_t, 2> waitValues = { 0, frame.uploadWaitValue };
+	const uint32_t waitCount = frame.uploadWaitValue > 0 ? 2 : 1;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo( waitCount, waitValues.data(), 0, nullptr );
+	//the image is only acquired again once its previous present is done with the semaphore
+	const vk::Semaphore renderFinishedSemaphore = *m_renderFinishedSemaphores[ imageIndex ];
+	vk::SubmitInfo submitInfo( waitCount, waitSemaphores.data(), waitStages.data(), 1, &frame.commandBuffer, 1, &renderFinishedSemaphore );
+	submitInfo.setPNext( &timelineSubmitInfo );
+
+	{
+		VS_PROFILE_SCOPE( "submit" );
+		m_device->resetFences( *frame.inFlightFence );
+		m_graphicsQueue.submit( submitInfo, *frame.inFlightFence );
+		frame.frameNumber = ++m_submittedFrames;
+	}
+
+	vk::PresentInfoKHR presentInfo( 1, &renderFinishedSemaphore, 1, &m_swapChain.get(), &imageIndex );
+
+#if VKS_PRESENT_WAIT_AVAILABLE
+	//the frame number doubles as present id, ids only have to grow per swapchain
+	const uint64_t presentId = frame.frameNumber;
+	vk::PresentIdKHR presentIdInfo( 1, &presentId );
+	if( m_presentWaitEnabled )
+	{
+		presentInfo.setPNext( &presentIdInfo );
+	}
+#endif
+
+	bool presented = true;
+	try
+	{
+		VS_PROFILE_SCOPE( "present" );
+		//eSuboptimalKHR is still a successful present
+		if( m_presentQueue.presentKHR( presentInfo ) == vk::Result::eSuboptimalKHR )
+		{
+			m_swapChainDirty = true;
+		}
+	}
+	catch( const vk::OutOfDateKHRError& )
+	{
+		m_swapChainDirty = true;
+		presented = false;
+	}
+
+	if( presented )
+	{
+		m_framePacer.onPresent( frame.frameNumber, *m_swapChain, *frame.inFlightFence );
+	}
+
+	if( !m_firstFramePresented )
+	{
+		m_firstFramePresented = true;
+		VS_INFO( "Time to first frame: {0:.3f} ms.", m_startupTimer.elapsedMilliseconds() );
+	}
+
+	if( sceneReady && !m_firstScenePresented )
+	{
+		m_firstScenePresented = true;
+		VS_INFO( "Time to first frame with the scene: {0:.3f} ms.", m_startupTimer.elapsedMilliseconds() );
+	}
+
+	m_currentFrame = ( m_currentFrame + 1 ) % m_framesInFlight;
 }
 
 void CHelloVulkanApp::createInstance()
 {
+	CDeviceDispatch::InitLoader();
+
 	if( VALIDATION_ENABLED && !checkValidationLayerSupport() )
 	{
 		throw std::runtime_error( "One or more required validation layers is unavailable." );
 	}
 
-	vk::ApplicationInfo appInfo( "HelloVulkanApp", VK_MAKE_VERSION( 1, 0, 0 ) );
+	//1.2 for timeline semaphores
+	vk::ApplicationInfo appInfo( "HelloVulkanApp", VK_MAKE_VERSION( 1, 0, 0 ), nullptr, 0, VK_API_VERSION_1_2 );
 	std::vector<const char*> reqExtensions = getRequiredInstanceExtensions();;
 
 	vk::InstanceCreateInfo instanceCreateInfo( {}, &appInfo, 0, nullptr, static_cast< uint32_t >( reqExtensions.size() ), reqExtensions.data() );
+
+	//must outlive createInstance, it is chained into instanceCreateInfo
+	vk::DebugUtilsMessengerCreateInfoEXT debugMsgrcreateInfo = getDebugMessengerCreateInfo();
 	if( VALIDATION_ENABLED )
 	{
 		instanceCreateInfo.enabledLayerCount = static_cast< uint32_t >( REQUIRED_VALIDATION_LAYERS.size() );
 		instanceCreateInfo.ppEnabledLayerNames = REQUIRED_VALIDATION_LAYERS.data();
-
-		vk::DebugUtilsMessengerCreateInfoEXT debugMsgrcreateInfo {};
-		debugMsgrcreateInfo.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo | vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
-		debugMsgrcreateInfo.messageType = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral | vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation;
-		debugMsgrcreateInfo.pfnUserCallback = debugCallbackFn;
-
-		instanceCreateInfo.pNext = ( vk::DebugUtilsMessengerCreateInfoEXT* )( &debugMsgrcreateInfo );
+		instanceCreateInfo.pNext = &debugMsgrcreateInfo;
 	}
 
-	m_instance = vk::createInstance( instanceCreateInfo );
-	m_dld = vk::DispatchLoaderDynamic( m_instance, vkGetInstanceProcAddr );
+	m_instance = vk::createInstanceUnique( instanceCreateInfo );
+	CDeviceDispatch::InitInstance( *m_instance );
 }
 
 void CHelloVulkanApp::setupDebugMessenger()
@@ -190,36 +532,45 @@ void CHelloVulkanApp::setupDebugMessenger()
 		return;
 	}
 
-	vk::DebugUtilsMessengerCreateInfoEXT createInfo {};
-	createInfo.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo | vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
-	createInfo.messageType = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral | vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation;
-	createInfo.pfnUserCallback = debugCallbackFn;
+	vk::DebugUtilsMessengerCreateInfoEXT createInfo = getDebugMessengerCreateInfo();
 
-	m_debugmessenger = m_instance.createDebugUtilsMessengerEXT( createInfo, nullptr, m_dld );
+	m_debugMessenger = m_instance->createDebugUtilsMessengerEXTUnique( createInfo );
 }
 
 void CHelloVulkanApp::createSurface()
 {
 	VkSurfaceKHR surface;
-	if( glfwCreateWindowSurface( m_instance, m_pWindow, nullptr, &surface ) != VK_SUCCESS )
+	if( glfwCreateWindowSurface( *m_instance, m_pWindow, nullptr, &surface ) != VK_SUCCESS )
 	{
 		throw std::runtime_error( "Failed to create window surface." );
 	}
 
-	m_surface = vk::SurfaceKHR( surface );
+	m_surface = vk::UniqueSurfaceKHR( vk::SurfaceKHR( surface ), vk::ObjectDestroy<vk::Instance, VULKAN_HPP_DEFAULT_DISPATCHER_TYPE>( *m_instance ) );
 }
 
-void CHelloVulkanApp::pickPhysicalDevice()
+void CHelloVulkanApp::enumeratePhysicalDevices()
 {
-	std::vector<vk::PhysicalDevice> availablePhysicalDevices = m_instance.enumeratePhysicalDevices();
+	std::vector<vk::PhysicalDevice> availablePhysicalDevices = m_instance->enumeratePhysicalDevices();
 	if( availablePhysicalDevices.size() < 1 )
 	{
 		throw std::runtime_error( "Failed to find physical devices with vulkan support." );
 	}
 
+	m_physicalDeviceCandidates.clear();
 	for( const auto& device : availablePhysicalDevices )
 	{
-		if( isDeviceSuitable( device ) )
+		if( isDeviceSupported( device ) )
+		{
+			m_physicalDeviceCandidates.push_back( device );
+		}
+	}
+}
+
+void CHelloVulkanApp::pickPhysicalDevice()
+{
+	for( const auto& device : m_physicalDeviceCandidates )
+	{
+		if( isSurfaceSupported( device ) )
 		{
 			m_physicalDevice = device;
 			break;
@@ -236,6 +587,10 @@ void CHelloVulkanApp::createLogicalDevice()
 {
 	SQueueFamilyIndices indices = findQueueFamilies( m_physicalDevice );
 	std::set<uint32_t> uniqueQueueFamilies { indices.graphicsFamily.value() , indices.presentFamily.value() };
+	if( indices.transferFamily.has_value() )
+	{
+		uniqueQueueFamilies.insert( indices.transferFamily.value() );
+	}
 
 	const float queuePriority = 1.0f;
 	std::vector<vk::DeviceQueueCreateInfo> deviceQueueCreateInfos;
@@ -244,17 +599,68 @@ void CHelloVulkanApp::createLogicalDevice()
 		deviceQueueCreateInfos.push_back( { {}, queueFamily, 1, &queuePriority } );
 	}
 
+	std::vector<const char*> deviceExtensions = REQUIRED_DEVICE_EXTENSIONS;
+
+	vk::PhysicalDeviceVulkan12Features vulkan12Feats {};
+	vulkan12Feats.setTimelineSemaphore( VK_TRUE );
+	CBindlessTable::EnableFeatures( vulkan12Feats );
+
 	vk::PhysicalDeviceFeatures physicalDeviceFeats {};
+
+	m_sceneEnabled = ( m_settings.sceneObjectCount > 0 ) && CGpuScene::IsSupported( m_physicalDevice );
+	if( m_sceneEnabled )
+	{
+		CGpuScene::EnableFeatures( physicalDeviceFeats, vulkan12Feats );
+	}
+	else if( m_settings.sceneObjectCount > 0 )
+	{
+		VS_WARN( "The device has no indirect count draws, the GPU driven scene is left out." );
+	}
+
+	//optional, lets the pipeline cache tell hits from misses
+	m_pipelineCreationFeedbackEnabled = isDeviceExtensionSupported( m_physicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME );
+	if( m_pipelineCreationFeedbackEnabled )
+	{
+		deviceExtensions.push_back( VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME );
+	}
+
+	//optional, budgets that account for other processes, heap sizes are the fallback
+	m_memoryBudgetEnabled = CResidencyManager::IsBudgetSupported( m_physicalDevice );
+	if( m_memoryBudgetEnabled )
+	{
+		deviceExtensions.push_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+	}
+
+	//optional, lets the frame pacer see when a frame actually reached the display
+	m_presentWaitEnabled = CFramePacer::IsPresentWaitSupported( m_physicalDevice );
+#if VKS_PRESENT_WAIT_AVAILABLE
+	vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeats( VK_TRUE );
+	vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeats( VK_TRUE );
+	if( m_presentWaitEnabled )
+	{
+		deviceExtensions.push_back( VK_KHR_PRESENT_ID_EXTENSION_NAME );
+		deviceExtensions.push_back( VK_KHR_PRESENT_WAIT_EXTENSION_NAME );
+
+		presentIdFeats.setPNext( &presentWaitFeats );
+		vulkan12Feats.setPNext( &presentIdFeats );
+	}
+#endif
+
 	vk::DeviceCreateInfo deviceCreateInfo( {}, static_cast< uint32_t >( deviceQueueCreateInfos.size() ), deviceQueueCreateInfos.data(), 0, nullptr,
-		static_cast< uint32_t >( REQUIRED_DEVICE_EXTENSIONS.size() ), REQUIRED_DEVICE_EXTENSIONS.data(), &physicalDeviceFeats );
+		static_cast< uint32_t >( deviceExtensions.size() ), deviceExtensions.data(), &physicalDeviceFeats );
+	deviceCreateInfo.setPNext( &vulkan12Feats );
+
+	m_device = m_physicalDevice.createDeviceUnique( deviceCreateInfo );
+	CDeviceDispatch::InitDevice( *m_device );
 
-	m_device = m_physicalDevice.createDevice( deviceCreateInfo );
+	m_graphicsQueue = m_device->getQueue( indices.graphicsFamily.value(), 0 );
+	m_presentQueue = m_device->getQueue( indices.presentFamily.value(), 0 );
 
-	m_graphicsQueue = m_device.getQueue( indices.graphicsFamily.value(), 0 );
-	m_presentQueue = m_device.getQueue( indices.presentFamily.value(), 0 );
+	//without a dedicated family, uploads share the graphics queue
+	m_transferQueue = indices.transferFamily.has_value() ? m_device->getQueue( indices.transferFamily.value(), 0 ) : m_graphicsQueue;
 }
 
-void CHelloVulkanApp::createSwapChain()
+void CHelloVulkanApp::createSwapChain( vk::SwapchainKHR oldSwapChain )
 {
 	SSwapChainSupportDetails supportDetails = querySwapChainSupportDetails( m_physicalDevice );
 
@@ -272,7 +678,7 @@ void CHelloVulkanApp::createSwapChain()
 
 	vk::SwapchainCreateInfoKHR createInfo { };
 
-	createInfo.setSurface( m_surface );
+	createInfo.setSurface( *m_surface );
 	createInfo.setMinImageCount( imageCount );
 	createInfo.setImageFormat( surfaceFormat.format );
 	createInfo.setImageColorSpace( surfaceFormat.colorSpace );
@@ -300,21 +706,60 @@ void CHelloVulkanApp::createSwapChain()
 	createInfo.setCompositeAlpha( vk::CompositeAlphaFlagBitsKHR::eOpaque );
 	createInfo.setPresentMode( presentMode );
 	createInfo.setClipped( VK_TRUE );
-	createInfo.setOldSwapchain( nullptr );
+	//lets the driver reuse resources of the swapchain being replaced, null on first creation
+	createInfo.setOldSwapchain( oldSwapChain );
+
+	m_swapChain = m_device->createSwapchainKHRUnique( createInfo );
+	m_swapChainImages = m_device->getSwapchainImagesKHR( *m_swapChain );
+	m_swapChainImageFormat = surfaceFormat.format;
+	m_swapChainImageExtent = extent;
 
-	if( !( m_swapChain = m_device.createSwapchainKHR( createInfo ) ) )
+	m_imagesInFlight.assign( m_swapChainImages.size(), vk::Fence( nullptr ) );
+
+	m_renderFinishedSemaphores.resize( m_swapChainImages.size() );
+	for( vk::UniqueSemaphore& semaphore : m_renderFinishedSemaphores )
 	{
-		throw std::runtime_error( "Failed to create swap chain." );
+		semaphore = m_device->createSemaphoreUnique( vk::SemaphoreCreateInfo {} );
 	}
+}
 
-	m_swapChainImages = m_device.getSwapchainImagesKHR( m_swapChain );
-	m_swapChainImageFormat = surfaceFormat.format;
-	m_swapChainImageExtent = extent;
+bool CHelloVulkanApp::recreateSwapChain()
+{
+	const vk::SurfaceCapabilitiesKHR capabilities = m_physicalDevice.getSurfaceCapabilitiesKHR( *m_surface );
+	const vk::Extent2D extent = chooseSwapChainExtent( capabilities );
+	if( extent.width == 0 || extent.height == 0 )
+	{
+		return false;
+	}
+
+	m_framePacer.onSwapChainRecreated();
+
+	//frames in flight may still render to or present the old images. Everything built on them
+	//goes once the last frame submitted so far has finished, the GPU is never drained.
+	//The render pass and pipelines stay, the surface format does not change with the size.
+	vk::UniqueSwapchainKHR oldSwapChain = std::move( m_swapChain );
+	std::vector<vk::UniqueImageView> oldImageViews = std::move( m_swapChainImageViews );
+	m_swapChainImageViews.clear();
+	std::vector<vk::UniqueSemaphore> oldSemaphores = std::move( m_renderFinishedSemaphores );
+	m_renderFinishedSemaphores.clear();
+
+	createSwapChain( *oldSwapChain );
+	createImageViews();
+	m_renderGraph.resize( m_swapChainImageExtent, m_deletionQueue, m_submittedFrames );
+
+	//views first, they are made from images of the swapchain
+	m_deletionQueue.retire( m_submittedFrames, std::move( oldImageViews ) );
+	m_deletionQueue.retire( m_submittedFrames, std::move( oldSemaphores ) );
+	m_deletionQueue.retire( m_submittedFrames, std::move( oldSwapChain ) );
+
+	m_swapChainDirty = false;
+	VS_INFO( "Swapchain recreated at {0}x{1} with {2} images.", m_swapChainImageExtent.width, m_swapChainImageExtent.height, m_swapChainImages.size() );
+	return true;
 }
 
 void CHelloVulkanApp::createImageViews()
 {
-	m_swapChainImageViews.resize( m_swapChainImages.size(), vk::ImageView( nullptr ) );
+	m_swapChainImageViews.resize( m_swapChainImages.size() );
 	for( size_t i = 0; i < m_swapChainImages.size(); ++i )
 	{
 		vk::ImageViewCreateInfo createInfo {};
@@ -333,197 +778,422 @@ void CHelloVulkanApp::createImageViews()
 		createInfo.subresourceRange.setBaseArrayLayer( 0 );
 		createInfo.subresourceRange.setLayerCount( 1 );
 
-		if( !( m_swapChainImageViews[ i ] = m_device.createImageView( createInfo ) ) )
-		{
-			throw std::runtime_error( "Failed to create image view." );
-		}
-
+		m_swapChainImageViews[ i ] = m_device->createImageViewUnique( createInfo );
 	}
 }
 
-void CHelloVulkanApp::createRenderPass()
+void CHelloVulkanApp::createRenderGraph()
 {
-	vk::AttachmentDescription colorAttachment(
-		{}, m_swapChainImageFormat, vk::SampleCountFlagBits::e1,
-		vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare,
-		vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
-		vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR
-	);
+	m_renderGraph.init( *m_device, m_memoryAllocator );
+	m_renderGraph.setExtent( m_swapChainImageExtent );
 
-	vk::AttachmentReference colorAttachmentRef( 0, vk::ImageLayout::eColorAttachmentOptimal );
-	vk::SubpassDescription subpass( {}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef );
+	CRenderGraph::SImportDesc backbufferDesc;
+	backbufferDesc.format = m_swapChainImageFormat;
+	//the layout transition must wait for the acquire semaphore, which is waited on at color attachment output
+	backbufferDesc.initialStages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+	backbufferDesc.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+	m_backbuffer = m_renderGraph.importImage( "backbuffer", backbufferDesc );
 
-	vk::RenderPassCreateInfo renderPassCreateInfo( {}, 1, &colorAttachment, 1, &subpass );
-	m_renderPass = m_device.createRenderPass( renderPassCreateInfo );
+	const vk::ClearColorValue clearColor( std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } );
 
-	if( m_renderPass == vk::RenderPass( nullptr ) )
+	//the scene clears and the main pass draws on top, the graph makes them subpasses of one render pass
+	if( m_sceneEnabled )
 	{
-		throw std::runtime_error( "failed to create render pass." );
+		CRenderGraph::SImageDesc depthDesc;
+		depthDesc.format = findDepthFormat( m_physicalDevice );
+		const CRenderGraph::ResourceId depth = m_renderGraph.createImage( "depth", depthDesc );
+
+		m_scenePass = m_renderGraph.addPass( "scene", [ this ]( const CRenderGraph::SPassContext& passContext ) { recordScenePass( passContext ); } )
+			.writeColor( m_backbuffer, clearColor )
+			.writeDepth( depth, vk::ClearDepthStencilValue( 1.0f, 0 ) )
+			.getId();
 	}
+
+	m_mainPass = m_renderGraph.addPass( "main", [ this ]( const CRenderGraph::SPassContext& passContext ) { recordMainPass( passContext ); } )
+		.writeColor( m_backbuffer, m_sceneEnabled ? std::optional<vk::ClearColorValue>() : clearColor )
+		.getId();
+
+	//pipelines and the overlay are made against the render pass, so it is built right away
+	m_renderGraph.compile();
+	m_renderPass = m_renderGraph.getRenderPass( m_mainPass );
 }
 
 void CHelloVulkanApp::createGraphicsPipeline()
 {
-	auto vertShaderCode = readFile( "shaders/bytecode/vert.spv" );
-	auto fragShaderCode = readFile( "shaders/bytecode/frag.spv" );
+	SPipelineState state;
+	state.debugName = "triangle";
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eVertex, "shader.vert" } );
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eFragment, "shader.frag" } );
 
-	vk::ShaderModule vertShaderModule = createShaderModule( vertShaderCode );
-	vk::ShaderModule fragShaderModule = createShaderModule( fragShaderCode );
+	state.raster = SRasterState::CullBack( vk::FrontFace::eClockwise );
+	state.depth = SDepthState::Disabled();
+	state.blendAttachments = { SBlendState::Opaque() };
 
-	vk::PipelineShaderStageCreateInfo vertShaderStageCreateInfo( {}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main" );
-	vk::PipelineShaderStageCreateInfo fragShaderStageCreateInfo( {}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main" );
-	vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageCreateInfo, fragShaderStageCreateInfo };
+	//every pipeline shares the layout of the bindless table, so the set stays bound across pipeline changes
+	state.layout = m_bindlessTable.getPipelineLayout();
+	state.renderPass = m_renderPass;
+	state.subpass = m_renderGraph.getSubpass( m_mainPass );
 
-	vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo( {}, 0, nullptr, 0, nullptr );
-	vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo( {}, vk::PrimitiveTopology::eTriangleList, false );
+	m_graphicsPipeline = m_pipelineRegistry.acquire( state );
+}
 
-	vk::Viewport viewport( 0.0f, 0.0f, static_cast< float >( m_swapChainImageExtent.width ), static_cast< float >( m_swapChainImageExtent.height ), 0.0f, 1.0f );
-	vk::Rect2D scissor( vk::Offset2D { 0, 0 }, m_swapChainImageExtent );
-	vk::PipelineViewportStateCreateInfo viewportStateCreateInfo( {}, 1, &viewport, 1, &scissor );
+void CHelloVulkanApp::createScenePipeline()
+{
+	if( !m_sceneEnabled )
+	{
+		return;
+	}
 
-	vk::PipelineRasterizationStateCreateInfo rasterStateCreateInfo {};
-	rasterStateCreateInfo.setDepthClampEnable( VK_FALSE );
-	rasterStateCreateInfo.setRasterizerDiscardEnable( VK_FALSE );
-	rasterStateCreateInfo.setPolygonMode( vk::PolygonMode::eFill );
-	rasterStateCreateInfo.setLineWidth( 1.0f );
-	rasterStateCreateInfo.setCullMode( vk::CullModeFlagBits::eBack );
-	rasterStateCreateInfo.setFrontFace( vk::FrontFace::eClockwise );
-	rasterStateCreateInfo.setDepthBiasEnable( VK_FALSE );
+	//vertices are pulled from the bindless table, there is no vertex input
+	SPipelineState state;
+	state.debugName = "scene";
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eVertex, "scene.vert" } );
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eFragment, "scene.frag" } );
 
+	//counter clockwise from outside, the flipped projection keeps it that way on screen
+	state.raster = SRasterState::CullBack( vk::FrontFace::eCounterClockwise );
+	state.depth = SDepthState::ReadWrite( vk::CompareOp::eLess );
+	state.blendAttachments = { SBlendState::Opaque() };
+
+	state.layout = m_bindlessTable.getPipelineLayout();
+	state.renderPass = m_renderGraph.getRenderPass( m_scenePass );
+	state.subpass = m_renderGraph.getSubpass( m_scenePass );
+
+	m_scenePipeline = m_pipelineRegistry.acquire( state );
+}
+
+void CHelloVulkanApp::createInstancePipeline()
+{
+	if( m_settings.instanceCount == 0 )
+	{
+		return;
+	}
 
-	vk::PipelineMultisampleStateCreateInfo multiSamplingCreateInfo {};
-	multiSamplingCreateInfo.setSampleShadingEnable( VK_FALSE );
-	multiSamplingCreateInfo.setRasterizationSamples( vk::SampleCountFlagBits::e1 );;
+	//the triangles spin, both faces show
+	SPipelineState state;
+	state.debugName = "instanced";
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eVertex, "instanced.vert" } );
+	state.shaders.push_back( { vk::ShaderStageFlagBits::eFragment, "shader.frag" } );
+	CInstanceRenderer::GetVertexInput( state.vertexBindings, state.vertexAttributes );
 
+	state.raster = SRasterState::CullNone();
+	state.depth = SDepthState::Disabled();
+	state.blendAttachments = { SBlendState::Opaque() };
 
-	vk::PipelineColorBlendAttachmentState colorBlendingAttachmentState {};
-	colorBlendingAttachmentState.setColorWriteMask( vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA );
-	colorBlendingAttachmentState.setBlendEnable( VK_FALSE );
+	state.layout = m_bindlessTable.getPipelineLayout();
+	state.renderPass = m_renderPass;
+	state.subpass = m_renderGraph.getSubpass( m_mainPass );
 
-	vk::PipelineColorBlendStateCreateInfo colorBlendStateCreateInfo {};
-	colorBlendStateCreateInfo.setLogicOpEnable( VK_FALSE );
-	colorBlendStateCreateInfo.setLogicOp( vk::LogicOp::eCopy );
-	colorBlendStateCreateInfo.setAttachmentCount( 1 );
-	colorBlendStateCreateInfo.setPAttachments( &colorBlendingAttachmentState );
-	colorBlendStateCreateInfo.setBlendConstants( std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } );
+	m_instancePipeline = m_pipelineRegistry.acquire( state );
+}
 
-	vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eLineWidth };
-	vk::PipelineDynamicStateCreateInfo dynamicStateCreateInfo( {}, 2, dynamicStates );
+void CHelloVulkanApp::createFrameResources()
+{
+	SQueueFamilyIndices indices = findQueueFamilies( m_physicalDevice );
 
-	vk::PipelineLayoutCreateInfo piplelineLayoutCreateInfo {};
-	m_pipelineLayout = m_device.createPipelineLayout( piplelineLayoutCreateInfo );
-	if( m_pipelineLayout == vk::PipelineLayout( nullptr ) )
+	m_frames.resize( m_framesInFlight );
+	for( auto& frame : m_frames )
 	{
-		throw std::runtime_error( "Failed to create pipeline layout object." );
-	}
+		//pools are reset as a whole each frame, which is cheaper than resetting individual buffers
+		vk::CommandPoolCreateInfo poolCreateInfo( vk::CommandPoolCreateFlagBits::eTransient, indices.graphicsFamily.value() );
+		frame.commandPool = m_device->createCommandPoolUnique( poolCreateInfo );
+
+		vk::CommandBufferAllocateInfo allocateInfo( *frame.commandPool, vk::CommandBufferLevel::ePrimary, 1 );
+		frame.commandBuffer = m_device->allocateCommandBuffers( allocateInfo ).front();
+
+		vk::CommandBufferAllocateInfo secondaryAllocateInfo( *frame.commandPool, vk::CommandBufferLevel::eSecondary, 2 );
+		const std::vector<vk::CommandBuffer> secondaries = m_device->allocateCommandBuffers( secondaryAllocateInfo );
+		frame.overlayCommandBuffer = secondaries[ 0 ];
+		frame.zoneCommandBuffer = secondaries[ 1 ];
 
+		frame.cullCommandPool = m_device->createCommandPoolUnique( poolCreateInfo );
+		vk::CommandBufferAllocateInfo cullAllocateInfo( *frame.cullCommandPool, vk::CommandBufferLevel::eSecondary, 1 );
+		frame.cullCommandBuffer = m_device->allocateCommandBuffers( cullAllocateInfo ).front();
 
-	vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo {};
-	graphicsPipelineCreateInfo.setStageCount( 2 );
-	graphicsPipelineCreateInfo.setPStages( shaderStages );
+		frame.imageAvailableSemaphore = m_device->createSemaphoreUnique( vk::SemaphoreCreateInfo {} );
 
-	graphicsPipelineCreateInfo.setPVertexInputState( &vertexInputStateCreateInfo );
-	graphicsPipelineCreateInfo.setPInputAssemblyState( &inputAssemblyStateCreateInfo );
-	graphicsPipelineCreateInfo.setPViewportState( &viewportStateCreateInfo );
-	graphicsPipelineCreateInfo.setPRasterizationState( &rasterStateCreateInfo );
-	graphicsPipelineCreateInfo.setPMultisampleState( &multiSamplingCreateInfo );
-	graphicsPipelineCreateInfo.setPDepthStencilState( nullptr );
-	graphicsPipelineCreateInfo.setPColorBlendState( &colorBlendStateCreateInfo );
-	graphicsPipelineCreateInfo.setPDynamicState( nullptr );
+		//created signaled so the first wait on each frame slot returns immediately
+		frame.inFlightFence = m_device->createFenceUnique( vk::FenceCreateInfo( vk::FenceCreateFlagBits::eSignaled ) );
+	}
+
+	m_currentFrame = 0;
+}
 
-	graphicsPipelineCreateInfo.setLayout( m_pipelineLayout );
-	graphicsPipelineCreateInfo.setRenderPass( m_renderPass );
-	graphicsPipelineCreateInfo.setSubpass( 0 );
+void CHelloVulkanApp::createCommandRecorder()
+{
+	m_drawList.assign( std::max( m_settings.drawCount, 1u ), SDrawItem { 3, 1, 0, 0 } );
 
-	graphicsPipelineCreateInfo.setBasePipelineHandle( vk::Pipeline( nullptr ) );
-	graphicsPipelineCreateInfo.setBasePipelineIndex( -1 );
+	SQueueFamilyIndices indices = findQueueFamilies( m_physicalDevice );
+	m_commandRecorder.init( *m_device, indices.graphicsFamily.value(), m_framesInFlight, m_settings.recordSlices, m_jobSystem );
 
-	auto resultValue = m_device.createGraphicsPipeline( vk::PipelineCache( nullptr ), graphicsPipelineCreateInfo );
-	if( resultValue.result == vk::Result::eSuccess )
+	if( m_settings.benchmarkRecording )
 	{
-		m_graphicsPipeline = resultValue.value;
+		m_pipelineCompiler.wait( m_graphicsPipeline );
+		m_renderGraph.setImportedImage( m_backbuffer, m_swapChainImages.front(), *m_swapChainImageViews.front() );
+
+		//begins the whole render pass the graph puts the main pass in, e.g. after the scene subpass
+		CParallelCommandRecorder::SRecordContext context = getRecordContext( m_renderGraph.getFramebuffer( m_mainPass ) );
+		context.subpassCount = m_renderGraph.getSubpassCount( m_mainPass );
+		context.clearValues = m_renderGraph.getClearValues( m_mainPass );
+		m_commandRecorder.measureScaling( context, m_drawList, RECORD_BENCHMARK_ITERATIONS );
 	}
-	else
+}
+
+void CHelloVulkanApp::createFramePacer()
+{
+	CFramePacer::SSettings pacerSettings;
+	pacerSettings.policy = m_settings.presentPolicy;
+	pacerSettings.targetFps = m_settings.targetFps;
+	pacerSettings.keepRecords = !m_settings.latencyCsvFile.empty();
+
+	m_framePacer.init( *m_device, pacerSettings, m_presentWaitEnabled );
+}
+
+void CHelloVulkanApp::createProfiler()
+{
+	SQueueFamilyIndices indices = findQueueFamilies( m_physicalDevice );
+	m_gpuProfiler.init( m_physicalDevice, *m_device, indices.graphicsFamily.value(), m_framesInFlight );
+
+	if( m_settings.profilerOverlay )
 	{
-		throw std::runtime_error( "Failed to create graphics pipeline." );
+		CProfilerOverlay::SInitInfo initInfo;
+		initInfo.pWindow = m_pWindow;
+		initInfo.instance = *m_instance;
+		initInfo.physicalDevice = m_physicalDevice;
+		initInfo.device = *m_device;
+		initInfo.queueFamilyIndex = indices.graphicsFamily.value();
+		initInfo.queue = m_graphicsQueue;
+		initInfo.pipelineCache = m_pipelineCache.getHandle();
+		initInfo.renderPass = m_renderPass;
+		initInfo.subpass = m_renderGraph.getSubpass( m_mainPass );
+		initInfo.minImageCount = static_cast< uint32_t >( m_swapChainImages.size() );
+		initInfo.imageCount = static_cast< uint32_t >( m_swapChainImages.size() );
+
+		m_profilerOverlay.init( initInfo );
 	}
+}
+
+void CHelloVulkanApp::updateSimulation()
+{
+	VS_PROFILE_SCOPE( "simulation" );
 
-	m_device.destroyShaderModule( vertShaderModule );
-	m_device.destroyShaderModule( fragShaderModule );
+	if( m_scene.isInitialized() )
+	{
+		const float aspectRatio = static_cast< float >( m_swapChainImageExtent.width ) / static_cast< float >( m_swapChainImageExtent.height );
+		m_sceneCamera = m_scene.getOrbitCamera( m_startupTimer.elapsedMilliseconds() * 0.001, aspectRatio );
+	}
 }
 
-std::vector<const char*> CHelloVulkanApp::getRequiredInstanceExtensions()
+void CHelloVulkanApp::updateTextureStreaming( uint64_t completedFrame )
 {
-	uint32_t glfwExtensionCount = 0;
-	const char* const* glfwExtensions = nullptr;
-	glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+	if( !m_textureStreamer.isInitialized() )
+	{
+		return;
+	}
 
-	std::vector<const char*> reqExtensions( glfwExtensions, glfwExtensions + glfwExtensionCount );
-	if( VALIDATION_ENABLED )
+	//the uvs wrap a texture once around its sphere, so the half facing the camera shows half of its width
+	m_scene.getMaterialScreenSizes( m_sceneCamera, static_cast< float >( m_swapChainImageExtent.height ), m_materialScreenSizes );
+	for( size_t material = 0; material < m_sceneTextures.size(); ++material )
 	{
-		reqExtensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
+		m_textureStreamer.requestWidth( m_sceneTextures[ material ], static_cast< uint32_t >( m_materialScreenSizes[ material ] * 2.0f ) );
 	}
 
-	VS_WARN( "Required Extensions" );
-	for( const char* extName : reqExtensions )
+	m_textureStreamer.update( m_currentFrame, m_submittedFrames + 1, completedFrame );
+}
+
+void CHelloVulkanApp::recordCulling( SFrameData& frame )
+{
+	if( !m_scene.isInitialized() )
 	{
-		VS_TRACE( "{0}", extName );
+		return;
 	}
-	VS_WARN( "___________________" );
 
-	return reqExtensions;
+	//executed outside of any render pass, so it inherits nothing
+	vk::CommandBufferInheritanceInfo inheritanceInfo;
+	m_device->resetCommandPool( *frame.cullCommandPool, {} );
+	frame.cullCommandBuffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit, &inheritanceInfo ) );
+	m_scene.recordCulling( frame.cullCommandBuffer, m_sceneCamera );
+	frame.cullCommandBuffer.end();
 }
 
-bool CHelloVulkanApp::checkValidationLayerSupport()
+void CHelloVulkanApp::recordCommandBuffer( SFrameData& frame, uint32_t imageIndex )
 {
-	uint32_t layerCount = 0;
-	if( vk::enumerateInstanceLayerProperties( &layerCount, nullptr ) != vk::Result::eSuccess )
+	const vk::CommandBuffer& commandBuffer = frame.commandBuffer;
+	commandBuffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+
+	//picks up the timings this frame slot recorded last time, its fence has signaled by now
+	m_gpuProfiler.beginFrame( m_currentFrame, commandBuffer );
 	{
-		throw std::runtime_error( "Failed to get layer properties" );
+		CGpuZone frameZone( m_gpuProfiler, commandBuffer, "frame" );
+
+		//take ownership of everything the transfer queue finished handing over
+		frame.uploadWaitStages = {};
+		frame.uploadWaitValue = m_uploadService.recordGraphicsAcquire( commandBuffer, frame.uploadWaitStages );
+
+		if( m_scene.isInitialized() )
+		{
+			CGpuZone cullZone( m_gpuProfiler, commandBuffer, "culling" );
+			commandBuffer.executeCommands( frame.cullCommandBuffer );
+		}
+
+		//once per frame, the binding carries over into every render pass of the primary.
+		//Bound after executing the culling commands, which leave the primary's bindings undefined.
+		m_bindlessTable.bind( commandBuffer );
+
+		m_renderGraph.setImportedImage( m_backbuffer, m_swapChainImages[ imageIndex ], *m_swapChainImageViews[ imageIndex ] );
+		m_renderGraph.setPassContents( m_mainPass, shouldRecordInParallel() ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline );
+		m_renderGraph.execute( commandBuffer );
 	}
 
-	std::vector<vk::LayerProperties> availableLayerProps( layerCount );
-	if( vk::enumerateInstanceLayerProperties( &layerCount, availableLayerProps.data() ) != vk::Result::eSuccess )
+	commandBuffer.end();
+}
+
+void CHelloVulkanApp::recordScenePass( const CRenderGraph::SPassContext& passContext )
+{
+	//the draw list is only known to the GPU, the pass costs the same for any object count
+	if( !m_scene.isInitialized() || !m_scenePipeline.isReady() )
 	{
-		throw std::runtime_error( "Failed to get layer properties" );
+		return;
 	}
 
-	for( const char* reqLayerName : REQUIRED_VALIDATION_LAYERS )
+	CGpuZone passZone( m_gpuProfiler, passContext.commandBuffer, "scene pass" );
+
+	passContext.commandBuffer.bindPipeline( vk::PipelineBindPoint::eGraphics, m_scenePipeline.get() );
+	setViewportAndScissor( passContext.commandBuffer, passContext.renderArea );
+	const bool textured = m_textureStreamer.isInitialized();
+	m_scene.recordDraws( passContext.commandBuffer, m_sceneCamera, textured ? m_textureStreamer.getTextureTable( m_currentFrame ) : CBindlessTable::INVALID_HANDLE,
+		textured ? m_textureStreamer.getSampler() : CBindlessTable::INVALID_HANDLE );
+}
+
+void CHelloVulkanApp::recordMainPass( const CRenderGraph::SPassContext& passContext )
+{
+	const vk::CommandBuffer& commandBuffer = passContext.commandBuffer;
+	CParallelCommandRecorder::SRecordContext context = getRecordContext( passContext.framebuffer );
+
+	if( shouldRecordInParallel() )
 	{
-		bool layerFound = false;
+		//the primary can not write timestamps in a subpass that only takes secondaries, so the
+		//zone opens in a secondary executed before the slices and closes at the end of the overlay
+		SFrameData& frame = m_frames[ m_currentFrame ];
+		vk::CommandBufferInheritanceInfo inheritanceInfo( context.renderPass, context.subpass, context.framebuffer );
+		frame.zoneCommandBuffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit, &inheritanceInfo ) );
+		const uint32_t passZone = m_gpuProfiler.beginZone( frame.zoneCommandBuffer, "main pass" );
+		frame.zoneCommandBuffer.end();
+
+		context.firstCommands = frame.zoneCommandBuffer;
+		context.overlayCommands = recordOverlaySecondary( frame, context, passZone );
+		m_commandRecorder.recordInRenderPass( m_currentFrame, commandBuffer, context, m_drawList );
+		return;
+	}
 
-		for( const auto& availablelayerProp : availableLayerProps )
-		{
-			if( strcmp( reqLayerName, availablelayerProp.layerName ) == 0 )
-			{
-				layerFound = true;
-				break;
-			}
-		}
+	CGpuZone passZone( m_gpuProfiler, commandBuffer, "main pass" );
 
-		if( !layerFound )
+	recordInstances( commandBuffer, context.renderArea );
+
+	//still compiling, the frame is only cleared
+	if( context.pipeline )
+	{
+		commandBuffer.bindPipeline( vk::PipelineBindPoint::eGraphics, context.pipeline );
+		setViewportAndScissor( commandBuffer, context.renderArea );
+		for( const SDrawItem& draw : m_drawList )
 		{
-			return false;
+			commandBuffer.draw( draw.vertexCount, draw.instanceCount, draw.firstVertex, draw.firstInstance );
 		}
 	}
 
-	return true;
+	if( m_profilerOverlay.isInitialized() )
+	{
+		m_profilerOverlay.render( commandBuffer );
+	}
 }
 
-bool CHelloVulkanApp::isDeviceSuitable( const vk::PhysicalDevice& device )
+void CHelloVulkanApp::recordInstances( const vk::CommandBuffer& commandBuffer, const vk::Rect2D& renderArea )
 {
-	SQueueFamilyIndices indices = findQueueFamilies( device );
+	if( !m_instanceRenderer.isInitialized() || !m_instancePipeline.isReady() )
+	{
+		return;
+	}
+
+	commandBuffer.bindPipeline( vk::PipelineBindPoint::eGraphics, m_instancePipeline.get() );
+	setViewportAndScissor( commandBuffer, renderArea );
+	m_instanceRenderer.recordDraw( commandBuffer, m_currentFrame, static_cast< float >( renderArea.extent.width ) / static_cast< float >( renderArea.extent.height ) );
+}
+
+//the instances go in here as well, so they are drawn under the overlay without a secondary of their own.
+//Always recorded, it closes the main pass's GPU zone.
+vk::CommandBuffer CHelloVulkanApp::recordOverlaySecondary( SFrameData& frame, const CParallelCommandRecorder::SRecordContext& context, uint32_t passZone )
+{
+	vk::CommandBufferInheritanceInfo inheritanceInfo( context.renderPass, context.subpass, context.framebuffer );
+	vk::CommandBufferBeginInfo beginInfo( vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit, &inheritanceInfo );
+
+	frame.overlayCommandBuffer.begin( beginInfo );
+	recordInstances( frame.overlayCommandBuffer, context.renderArea );
+	if( m_profilerOverlay.isInitialized() )
+	{
+		m_profilerOverlay.render( frame.overlayCommandBuffer );
+	}
+	m_gpuProfiler.endZone( frame.overlayCommandBuffer, passZone );
+	frame.overlayCommandBuffer.end();
+
+	return frame.overlayCommandBuffer;
+}
+
+CParallelCommandRecorder::SRecordContext CHelloVulkanApp::getRecordContext( const vk::Framebuffer& framebuffer ) const
+{
+	CParallelCommandRecorder::SRecordContext context;
+	context.renderPass = m_renderPass;
+	context.subpass = m_renderGraph.getSubpass( m_mainPass );
+	context.framebuffer = framebuffer;
+	context.renderArea = m_renderGraph.getRenderArea( m_mainPass );
+	context.pipeline = m_graphicsPipeline.get();
+	context.pipelineLayout = m_bindlessTable.getPipelineLayout();
+	context.descriptorSet = m_bindlessTable.getDescriptorSet();
+
+	return context;
+}
+
+bool CHelloVulkanApp::shouldRecordInParallel() const
+{
+	return m_graphicsPipeline.isReady() && m_drawList.size() >= PARALLEL_RECORD_MIN_DRAWS;
+}
+
+std::vector<const char*> CHelloVulkanApp::getRequiredInstanceExtensions()
+{
+	uint32_t glfwExtensionCount = 0;
+	const char* const* glfwExtensions = nullptr;
+	glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+
+	std::vector<const char*> reqExtensions( glfwExtensions, glfwExtensions + glfwExtensionCount );
+	if( VALIDATION_ENABLED )
+	{
+		reqExtensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
+	}
+
+	VS_WARN( "Required Extensions" );
+	for( const char* extName : reqExtensions )
+	{
+		VS_TRACE( "{0}", extName );
+	}
+	VS_WARN( "___________________" );
+
+	return reqExtensions;
+}
 
-	const bool extensionsSupported = checkDeviceExtensionSupport( device );
+bool CHelloVulkanApp::isDeviceSupported( const vk::PhysicalDevice& device )
+{
+	return checkDeviceExtensionSupport( device ) && checkDeviceFeatureSupport( device );
+}
 
-	bool swapChainAdequate = false;
-	if( extensionsSupported )
+bool CHelloVulkanApp::isSurfaceSupported( const vk::PhysicalDevice& device )
+{
+	SQueueFamilyIndices indices = findQueueFamilies( device );
+	if( !indices.isComplete() )
 	{
-		SSwapChainSupportDetails supportDetails = querySwapChainSupportDetails( device );
-		swapChainAdequate = !supportDetails.formats.empty() && !supportDetails.presentModes.empty();
+		return false;
 	}
 
-	return  indices.isComplete() && extensionsSupported && swapChainAdequate;
+	SSwapChainSupportDetails supportDetails = querySwapChainSupportDetails( device );
+	return !supportDetails.formats.empty() && !supportDetails.presentModes.empty();
 }
 
 bool CHelloVulkanApp::checkDeviceExtensionSupport( const vk::PhysicalDevice& device )
@@ -539,27 +1209,44 @@ bool CHelloVulkanApp::checkDeviceExtensionSupport( const vk::PhysicalDevice& dev
 	return requiredExtensionProps.empty();
 }
 
+bool CHelloVulkanApp::checkDeviceFeatureSupport( const vk::PhysicalDevice& device )
+{
+	if( device.getProperties().apiVersion < VK_API_VERSION_1_2 )
+	{
+		return false;
+	}
+
+	auto featureChain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	const vk::PhysicalDeviceVulkan12Features& vulkan12Feats = featureChain.get<vk::PhysicalDeviceVulkan12Features>();
+
+	return vulkan12Feats.timelineSemaphore && CBindlessTable::IsSupported( device );
+}
+
 CHelloVulkanApp::SQueueFamilyIndices CHelloVulkanApp::findQueueFamilies( const vk::PhysicalDevice& device )
 {
 	SQueueFamilyIndices indices;
 	std::vector<vk::QueueFamilyProperties> queueFamilyProps = device.getQueueFamilyProperties();
 
+	//walk every family, the transfer only one tends to come last
 	uint32_t queueFamilyIndex = 0;
 	for( const auto& queueFamilyProp : queueFamilyProps )
 	{
-		if( device.getSurfaceSupportKHR( queueFamilyIndex, m_surface ) )
+		if( !indices.presentFamily.has_value() && device.getSurfaceSupportKHR( queueFamilyIndex, *m_surface ) )
 		{
 			indices.presentFamily = queueFamilyIndex;
 		}
 
-		if( queueFamilyProp.queueFlags & vk::QueueFlagBits::eGraphics )
+		if( !indices.graphicsFamily.has_value() && ( queueFamilyProp.queueFlags & vk::QueueFlagBits::eGraphics ) )
 		{
 			indices.graphicsFamily = queueFamilyIndex;
 		}
 
-		if( indices.isComplete() )
+		const bool transferOnly = ( queueFamilyProp.queueFlags & vk::QueueFlagBits::eTransfer ) &&
+			!( queueFamilyProp.queueFlags & ( vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute ) );
+
+		if( !indices.transferFamily.has_value() && transferOnly )
 		{
-			break;
+			indices.transferFamily = queueFamilyIndex;
 		}
 
 		++queueFamilyIndex;
@@ -572,9 +1259,9 @@ CHelloVulkanApp::SSwapChainSupportDetails CHelloVulkanApp::querySwapChainSupport
 {
 	SSwapChainSupportDetails supportDetails;
 
-	supportDetails.capabilities = device.getSurfaceCapabilitiesKHR( m_surface );
-	supportDetails.formats = device.getSurfaceFormatsKHR( m_surface );
-	supportDetails.presentModes = device.getSurfacePresentModesKHR( m_surface );
+	supportDetails.capabilities = device.getSurfaceCapabilitiesKHR( *m_surface );
+	supportDetails.formats = device.getSurfaceFormatsKHR( *m_surface );
+	supportDetails.presentModes = device.getSurfacePresentModesKHR( *m_surface );
 
 	return supportDetails;
 }
@@ -594,15 +1281,15 @@ vk::SurfaceFormatKHR CHelloVulkanApp::chooseSwapChainSurfaceFormat( const std::v
 
 vk::PresentModeKHR CHelloVulkanApp::chooseSwapChainPresentMode( const std::vector<vk::PresentModeKHR>& availableModes )
 {
-	for( const auto& mode : availableModes )
-	{
-		if( mode == vk::PresentModeKHR::eMailbox )
-		{
-			return mode;
-		}
-	}
+	return CFramePacer::ChoosePresentMode( m_settings.presentPolicy, availableModes );
+}
 
-	return vk::PresentModeKHR::eFifo;
+void CHelloVulkanApp::framebufferResizeCallback( GLFWwindow* pWindow, int width, int height )
+{
+	//called from glfwPollEvents on the main thread, between frames
+	CHelloVulkanApp* pApp = static_cast< CHelloVulkanApp* >( glfwGetWindowUserPointer( pWindow ) );
+	pApp->m_windowFramebufferExtent = vk::Extent2D { static_cast< uint32_t >( width ), static_cast< uint32_t >( height ) };
+	pApp->m_swapChainDirty = true;
 }
 
 vk::Extent2D CHelloVulkanApp::chooseSwapChainExtent( const vk::SurfaceCapabilitiesKHR& capabilities )
@@ -614,10 +1301,7 @@ vk::Extent2D CHelloVulkanApp::chooseSwapChainExtent( const vk::SurfaceCapabiliti
 	}
 	else
 	{
-		int width, height;
-		glfwGetFramebufferSize( m_pWindow, &width, &height );
-
-		vk::Extent2D actualExtent { static_cast< uint32_t >( width ), static_cast< uint32_t >( height ) };
+		vk::Extent2D actualExtent = m_windowFramebufferExtent;
 		actualExtent.width = std::clamp( actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width );
 		actualExtent.height = std::clamp( actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height );
 
@@ -625,16 +1309,3 @@ vk::Extent2D CHelloVulkanApp::chooseSwapChainExtent( const vk::SurfaceCapabiliti
 	}
 }
 
-vk::ShaderModule CHelloVulkanApp::createShaderModule( const std::vector<char>& code )
-{
-	vk::ShaderModuleCreateInfo createInfo( {}, code.size(), reinterpret_cast< const uint32_t* >( code.data() ) );
-	vk::ShaderModule shaderModule = m_device.createShaderModule( createInfo );
-
-	if( shaderModule == vk::ShaderModule( nullptr ) )
-	{
-		throw std::runtime_error( "Failed to create shader module." );
-	}
-
-	return shaderModule;
-}
-
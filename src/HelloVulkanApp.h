@@ -1,8 +1,26 @@
 #pragma once
 #include "AppBase.h"
+#include "Memory/DeviceMemoryAllocator.h"
+#include "Memory/ResidencyManager.h"
+#include "Profiling/GpuProfiler.h"
+#include "Profiling/ProfilerOverlay.h"
+#include "Vulkan/DeletionQueue.h"
+#include "Vulkan/FramePacer.h"
+#include "Vulkan/PipelineCache.h"
+#include "Vulkan/PipelineCompiler.h"
+#include "Vulkan/PipelineRegistry.h"
+#include "Vulkan/ParallelCommandRecorder.h"
+#include "Vulkan/BindlessTable.h"
+#include "Vulkan/GpuScene.h"
+#include "Vulkan/InstanceRenderer.h"
+#include "Vulkan/RenderGraph.h"
+#include "Vulkan/TextureStreamer.h"
+#include "Vulkan/UploadService.h"
+#include "Utils/Timer.h"
 #include <vulkan/vulkan.hpp>
 
 struct GLFWwindow;
+class CTaskGraph;
 
 class CHelloVulkanApp : public IAppBase
 {
@@ -11,6 +29,8 @@ private:
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		//transfer only family, usually the dedicated copy engines of a discrete GPU
+		std::optional<uint32_t> transferFamily;
 
 		bool isComplete() const
 		{
@@ -25,8 +45,65 @@ private:
 		std::vector<vk::PresentModeKHR> presentModes;
 	};
 
+	//everything one frame in flight touches, so frames never share a pool, semaphore or fence.
+	//Command buffers are freed with their pools.
+	struct SFrameData
+	{
+		vk::UniqueCommandPool commandPool;
+		vk::CommandBuffer commandBuffer;
+		//secondaries for the overlay and for opening the main pass's GPU zone when the render pass only takes secondaries
+		vk::CommandBuffer overlayCommandBuffer;
+		vk::CommandBuffer zoneCommandBuffer;
+		//secondary with the culling dispatch, its own pool lets a job record it next to the primary
+		vk::UniqueCommandPool cullCommandPool;
+		vk::CommandBuffer cullCommandBuffer;
+
+		vk::UniqueSemaphore imageAvailableSemaphore;
+		vk::UniqueFence inFlightFence;
+
+		//upload timeline value this frame's submit waits on, 0 when it consumes no uploads
+		uint64_t uploadWaitValue = 0;
+		vk::PipelineStageFlags uploadWaitStages;
+
+		//number of the frame last submitted from this slot, complete once inFlightFence signals
+		uint64_t frameNumber = 0;
+	};
+
+public:
+	struct SSettings
+	{
+		uint32_t framesInFlight = 2;
+		//draws recorded per frame, spread across recorder threads once there are enough of them
+		uint32_t drawCount = 1;
+		//0 uses one job thread per hardware thread
+		uint32_t jobThreads = 0;
+		//secondaries the draws are split into, 0 records one per job thread
+		uint32_t recordSlices = 0;
+		//log how command recording time scales with the thread count after init
+		bool benchmarkRecording = false;
+		//0 uses every hardware thread but one
+		uint32_t pipelineCompileThreads = 0;
+		bool profilerOverlay = true;
+		EPresentPolicy presentPolicy = EPresentPolicy::LowLatency;
+		//frame rate of EPresentPolicy::CappedFps
+		uint32_t targetFps = 60;
+		//every frame's input to present latency is written here on exit when set
+		std::string latencyCsvFile;
+		//objects of the GPU driven scene drawn under the triangles, 0 leaves the scene out
+		uint32_t sceneObjectCount = 0;
+		//.vksm mesh the scene objects are instances of, the procedural sphere when empty
+		std::string sceneMeshFile;
+		//textures streamed in for the scene objects, 0 draws them untextured
+		uint32_t sceneTextureCount = 0;
+		//.vkst files the scene textures cycle through, procedural patterns when empty
+		std::vector<std::string> textureFiles;
+		//triangles drawn by one instanced draw with transforms the CPU updates every frame, 0 leaves them out
+		uint32_t instanceCount = 0;
+	};
+
 public:
 	CHelloVulkanApp();
+	explicit CHelloVulkanApp( const SSettings& settings );
 
 	// Inherited via IAppBase
 	virtual void init() override;
@@ -34,26 +111,52 @@ public:
 	virtual void cleanup() override;
 
 private:
-	void initWindow();
-	void initVulkan();
+	void buildStartupGraph( CTaskGraph& graph );
 	void update();
+	void drawFrame();
+	void updateSimulation();
+	//asks for the mip levels the camera needs, then lets the streamer load them
+	void updateTextureStreaming( uint64_t completedFrame );
 
+	void initGlfw();
+	void createWindow();
 	void createInstance();
 	void setupDebugMessenger();
 	void createSurface();
+	void enumeratePhysicalDevices();
 	void pickPhysicalDevice();
 	void createLogicalDevice();
-	void createSwapChain();
+	//oldSwapChain is handed to the driver for reuse, the caller still owns it
+	void createSwapChain( vk::SwapchainKHR oldSwapChain = nullptr );
+	//returns false while the window has no area, e.g. when minimized
+	bool recreateSwapChain();
 	void createImageViews();
-	void createRenderPass();
+	void createRenderGraph();
 	void createGraphicsPipeline();
+	void createScenePipeline();
+	void createInstancePipeline();
+	void createFrameResources();
+
+	void createCommandRecorder();
+	void createFramePacer();
+	void createProfiler();
 
+	void recordCulling( SFrameData& frame );
+	void recordCommandBuffer( SFrameData& frame, uint32_t imageIndex );
+	void recordScenePass( const CRenderGraph::SPassContext& passContext );
+	void recordMainPass( const CRenderGraph::SPassContext& passContext );
+	void recordInstances( const vk::CommandBuffer& commandBuffer, const vk::Rect2D& renderArea );
+	vk::CommandBuffer recordOverlaySecondary( SFrameData& frame, const CParallelCommandRecorder::SRecordContext& context, uint32_t passZone );
+	CParallelCommandRecorder::SRecordContext getRecordContext( const vk::Framebuffer& framebuffer ) const;
+	bool shouldRecordInParallel() const;
 
 	std::vector<const char*> getRequiredInstanceExtensions();
-	bool checkValidationLayerSupport();
 
-	bool isDeviceSuitable( const vk::PhysicalDevice& device );
+	//checks that do not depend on the surface, so they can run before the window exists
+	bool isDeviceSupported( const vk::PhysicalDevice& device );
+	bool isSurfaceSupported( const vk::PhysicalDevice& device );
 	bool checkDeviceExtensionSupport( const vk::PhysicalDevice& device );
+	bool checkDeviceFeatureSupport( const vk::PhysicalDevice& device );
 	SQueueFamilyIndices  findQueueFamilies( const vk::PhysicalDevice& device );
 
 	SSwapChainSupportDetails querySwapChainSupportDetails( const vk::PhysicalDevice& device );
@@ -61,30 +164,103 @@ private:
 	vk::PresentModeKHR chooseSwapChainPresentMode( const std::vector<vk::PresentModeKHR>& availableModes );
 	vk::Extent2D chooseSwapChainExtent( const vk::SurfaceCapabilitiesKHR& capabilities );
 
-	vk::ShaderModule createShaderModule( const std::vector<char>& code );
+	static void framebufferResizeCallback( GLFWwindow* pWindow, int width, int height );
 
 
+	SSettings m_settings;
+
 	GLFWwindow* m_pWindow;
-	vk::Instance m_instance;
+	//queried on the main thread when the window is created, GLFW allows no other
+	vk::Extent2D m_windowFramebufferExtent;
+	//handles the app creates itself are owned through vk::Unique*, cleanup releases them in dependency order
+	vk::UniqueInstance m_instance;
+	std::vector<vk::PhysicalDevice> m_physicalDeviceCandidates;
 	vk::PhysicalDevice m_physicalDevice;
-	vk::Device m_device;
-	vk::SurfaceKHR m_surface;
+	vk::UniqueDevice m_device;
+	CDeviceMemoryAllocator m_memoryAllocator;
+	CResidencyManager m_residencyManager;
+	vk::UniqueSurfaceKHR m_surface;
 	
-	vk::SwapchainKHR m_swapChain;
+	vk::UniqueSwapchainKHR m_swapChain;
 	std::vector<vk::Image> m_swapChainImages;
 	vk::Format m_swapChainImageFormat;
 	vk::Extent2D m_swapChainImageExtent;
-	std::vector<vk::ImageView> m_swapChainImageViews;
+	std::vector<vk::UniqueImageView> m_swapChainImageViews;
+	//signaled by the submit that renders to each image and waited on by its present. Per image,
+	//not per frame slot, a slot's fence says nothing about when the present's wait is done.
+	std::vector<vk::UniqueSemaphore> m_renderFinishedSemaphores;
+	//set on resize, out of date or suboptimal, the swapchain is recreated at the start of the next frame
+	bool m_swapChainDirty;
 
 	vk::Queue m_graphicsQueue;
 	vk::Queue m_presentQueue;
+	vk::Queue m_transferQueue;
+
+	CUploadService m_uploadService;
 
+	CRenderGraph m_renderGraph;
+	CRenderGraph::ResourceId m_backbuffer;
+	CRenderGraph::PassId m_scenePass;
+	CRenderGraph::PassId m_mainPass;
+	//render pass of the main pass, owned by the graph
 	vk::RenderPass m_renderPass;
-	vk::PipelineLayout m_pipelineLayout;
-	vk::Pipeline m_graphicsPipeline;
+	//every sampled image, sampler and storage buffer, and the pipeline layout all pipelines share
+	CBindlessTable m_bindlessTable;
+	CPipelineHandle m_graphicsPipeline;
+
+	//culled and drawn by the GPU, only when objects are requested and the device has indirect count draws
+	bool m_sceneEnabled;
+	CGpuScene m_scene;
+	CPipelineHandle m_scenePipeline;
+	//camera of the frame being recorded
+	CGpuScene::SCamera m_sceneCamera;
+	//one texture per scene material, in material order
+	CTextureStreamer m_textureStreamer;
+	std::vector<CTextureStreamer::TextureId> m_sceneTextures;
+	std::vector<float> m_materialScreenSizes;
+
+	CInstanceRenderer m_instanceRenderer;
+	CPipelineHandle m_instancePipeline;
+
+	const uint32_t m_framesInFlight;
+	std::vector<SFrameData> m_frames;
+	//jobs of the frame being built, see drawFrame
+	CJobCounter m_simulationJobs;
+	CJobCounter m_streamingJobs;
+	CJobCounter m_instanceJobs;
+	CJobCounter m_cullingJobs;
+	CJobCounter m_uploadJobs;
+	CJobCounter m_recordJobs;
+	uint32_t m_currentFrame;
+	uint64_t m_submittedFrames;
+	//fence of the frame that last rendered to each swapchain image
+	std::vector<vk::Fence> m_imagesInFlight;
+	//objects that frames in flight may still use, keyed by frame number
+	CDeletionQueue m_deletionQueue;
+
+	std::vector<SDrawItem> m_drawList;
+	CParallelCommandRecorder m_commandRecorder;
+
+	CGpuProfiler m_gpuProfiler;
+	CProfilerOverlay m_profilerOverlay;
+
+	CFramePacer m_framePacer;
+	//VK_KHR_present_id and VK_KHR_present_wait, frames are paced on fence estimates without them
+	bool m_presentWaitEnabled;
+
+	CPipelineCache m_pipelineCache;
+	CPipelineCompiler m_pipelineCompiler;
+	CPipelineRegistry m_pipelineRegistry;
+	bool m_pipelineCreationFeedbackEnabled;
+	//VK_EXT_memory_budget, the residency manager budgets from the heap sizes without it
+	bool m_memoryBudgetEnabled;
+
+	//from init() to the first present, and to the first present that draws the scene
+	CTimer m_startupTimer;
+	bool m_firstFramePresented;
+	bool m_firstScenePresented;
 
-	vk::DispatchLoaderDynamic m_dld;
-	vk::DebugUtilsMessengerEXT m_debugmessenger;
+	vk::UniqueDebugUtilsMessengerEXT m_debugMessenger;
 
 };
 
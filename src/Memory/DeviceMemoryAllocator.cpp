@@ -0,0 +1,389 @@
+#include "vkpch.h"
+#include "DeviceMemoryAllocator.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+struct SMemoryBlock
+{
+	SMemoryBlock( vk::DeviceSize blockSize, vk::DeviceSize granularity )
+		: allocator( blockSize, granularity )
+	{
+	}
+
+	vk::DeviceMemory memory;
+	uint32_t memoryTypeIndex = 0;
+	uint8_t* pMapped = nullptr;
+	//holds exactly one resource and is released with it
+	bool dedicated = false;
+
+	CFreeListAllocator allocator;
+};
+
+/////////////////////////////////////////////////
+
+static uint32_t countBits( uint32_t value )
+{
+	uint32_t count = 0;
+	for( ; value != 0; value &= value - 1 )
+	{
+		++count;
+	}
+	return count;
+}
+
+static vk::DeviceSize alignDown( vk::DeviceSize value, vk::DeviceSize alignment )
+{
+	return alignment > 1 ? ( value / alignment ) * alignment : value;
+}
+
+static vk::DeviceSize alignUp( vk::DeviceSize value, vk::DeviceSize alignment )
+{
+	return alignment > 1 ? ( ( value + alignment - 1 ) / alignment ) * alignment : value;
+}
+
+/////////////////////////////////////////////////
+
+CDeviceMemoryAllocator::CDeviceMemoryAllocator()
+	: m_device( nullptr )
+	, m_blockSize( DEFAULT_BLOCK_SIZE )
+	, m_bufferImageGranularity( 1 )
+	, m_nonCoherentAtomSize( 1 )
+	, m_maxDeviceAllocations( 0 )
+	, m_deviceAllocationCount( 0 )
+{
+}
+
+void CDeviceMemoryAllocator::init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, vk::DeviceSize blockSize )
+{
+	m_device = device;
+	m_blockSize = blockSize;
+	m_memoryProperties = physicalDevice.getMemoryProperties();
+
+	const vk::PhysicalDeviceLimits limits = physicalDevice.getProperties().limits;
+	m_bufferImageGranularity = limits.bufferImageGranularity;
+	m_nonCoherentAtomSize = limits.nonCoherentAtomSize;
+	m_maxDeviceAllocations = limits.maxMemoryAllocationCount;
+
+	VS_INFO( "Device memory allocator: {0} MiB blocks, bufferImageGranularity {1}, at most {2} device allocations.",
+		m_blockSize / ( 1024 * 1024 ), m_bufferImageGranularity, m_maxDeviceAllocations );
+}
+
+void CDeviceMemoryAllocator::destroy()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	for( auto& blocks : m_blocks )
+	{
+		for( auto& pBlock : blocks )
+		{
+			if( !pBlock->allocator.isEmpty() )
+			{
+				VS_WARN( "Destroying a memory block with {0} live allocations.", pBlock->allocator.getStats().allocationCount );
+			}
+
+			if( pBlock->pMapped )
+			{
+				m_device.unmapMemory( pBlock->memory );
+			}
+			m_device.freeMemory( pBlock->memory );
+		}
+		blocks.clear();
+	}
+
+	m_deviceAllocationCount = 0;
+}
+
+SAllocation CDeviceMemoryAllocator::allocate( const vk::MemoryRequirements& requirements, EMemoryUsage usage, EResourceKind kind )
+{
+	std::optional<uint32_t> memoryTypeIndex = findMemoryTypeIndex( requirements.memoryTypeBits, usage );
+	if( !memoryTypeIndex.has_value() )
+	{
+		throw std::runtime_error( "No memory type satisfies the allocation." );
+	}
+
+	const uint32_t typeIndex = memoryTypeIndex.value();
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SMemoryBlock* pBlock = nullptr;
+	std::optional<uint64_t> offset;
+
+	//big resources would waste most of a shared block, give them their own
+	if( requirements.size > m_blockSize / 2 )
+	{
+		pBlock = createBlock( typeIndex, requirements.size, true );
+		offset = pBlock->allocator.allocate( requirements.size, requirements.alignment, kind );
+	}
+	else
+	{
+		for( auto& pExistingBlock : m_blocks[ typeIndex ] )
+		{
+			if( pExistingBlock->dedicated )
+			{
+				continue;
+			}
+
+			offset = pExistingBlock->allocator.allocate( requirements.size, requirements.alignment, kind );
+			if( offset.has_value() )
+			{
+				pBlock = pExistingBlock.get();
+				break;
+			}
+		}
+
+		if( !offset.has_value() )
+		{
+			pBlock = createBlock( typeIndex, m_blockSize, false );
+			offset = pBlock->allocator.allocate( requirements.size, requirements.alignment, kind );
+		}
+	}
+
+	if( !offset.has_value() )
+	{
+		throw std::runtime_error( "Failed to sub-allocate device memory." );
+	}
+
+	SAllocation allocation;
+	allocation.memory = pBlock->memory;
+	allocation.offset = offset.value();
+	allocation.size = requirements.size;
+	allocation.pMapped = pBlock->pMapped ? pBlock->pMapped + offset.value() : nullptr;
+	allocation.memoryTypeIndex = typeIndex;
+	allocation.pBlock = pBlock;
+
+	return allocation;
+}
+
+void CDeviceMemoryAllocator::free( SAllocation& allocation )
+{
+	if( !allocation.isValid() )
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SMemoryBlock* pBlock = allocation.pBlock;
+	pBlock->allocator.free( allocation.offset );
+
+	if( pBlock->allocator.isEmpty() )
+	{
+		//keep one empty shared block per type around so alloc/free churn does not hit the driver
+		const auto& blocks = m_blocks[ pBlock->memoryTypeIndex ];
+		const bool otherSharedBlockExists = std::any_of( blocks.begin(), blocks.end(),
+			[ pBlock ]( const std::unique_ptr<SMemoryBlock>& pOther ) { return pOther.get() != pBlock && !pOther->dedicated; } );
+
+		if( pBlock->dedicated || otherSharedBlockExists )
+		{
+			destroyBlock( pBlock );
+		}
+	}
+
+	allocation = SAllocation {};
+}
+
+SAllocation CDeviceMemoryAllocator::allocateForBuffer( const vk::Buffer& buffer, EMemoryUsage usage )
+{
+	SAllocation allocation = allocate( m_device.getBufferMemoryRequirements( buffer ), usage, EResourceKind::Buffer );
+	m_device.bindBufferMemory( buffer, allocation.memory, allocation.offset );
+
+	return allocation;
+}
+
+SAllocation CDeviceMemoryAllocator::allocateForImage( const vk::Image& image, EMemoryUsage usage, vk::ImageTiling tiling )
+{
+	const EResourceKind kind = ( tiling == vk::ImageTiling::eLinear ) ? EResourceKind::LinearImage : EResourceKind::OptimalImage;
+
+	SAllocation allocation = allocate( m_device.getImageMemoryRequirements( image ), usage, kind );
+	m_device.bindImageMemory( image, allocation.memory, allocation.offset );
+
+	return allocation;
+}
+
+void CDeviceMemoryAllocator::flush( const SAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size )
+{
+	if( allocation.isValid() && !isHostCoherent( allocation.memoryTypeIndex ) )
+	{
+		m_device.flushMappedMemoryRanges( getMappedRange( allocation, offset, size ) );
+	}
+}
+
+void CDeviceMemoryAllocator::invalidate( const SAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size )
+{
+	if( allocation.isValid() && !isHostCoherent( allocation.memoryTypeIndex ) )
+	{
+		m_device.invalidateMappedMemoryRanges( getMappedRange( allocation, offset, size ) );
+	}
+}
+
+std::optional<uint32_t> CDeviceMemoryAllocator::findMemoryTypeIndex( uint32_t typeBits, EMemoryUsage usage ) const
+{
+	vk::MemoryPropertyFlags requiredFlags;
+	vk::MemoryPropertyFlags preferredFlags;
+	vk::MemoryPropertyFlags unwantedFlags = vk::MemoryPropertyFlagBits::eProtected | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+
+	switch( usage )
+	{
+	case EMemoryUsage::GpuOnly:
+		preferredFlags = vk::MemoryPropertyFlagBits::eDeviceLocal;
+		unwantedFlags |= vk::MemoryPropertyFlagBits::eHostVisible;
+		break;
+	case EMemoryUsage::CpuToGpu:
+		//write combined memory, device local when the heap is host visible (ReBAR, UMA)
+		requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible;
+		preferredFlags = vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eDeviceLocal;
+		unwantedFlags |= vk::MemoryPropertyFlagBits::eHostCached;
+		break;
+	case EMemoryUsage::GpuToCpu:
+		requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible;
+		preferredFlags = vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent;
+		break;
+	}
+
+	std::optional<uint32_t> bestTypeIndex;
+	int bestScore = std::numeric_limits<int>::min();
+
+	for( uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i )
+	{
+		const vk::MemoryPropertyFlags flags = m_memoryProperties.memoryTypes[ i ].propertyFlags;
+		if( !( typeBits & ( 1u << i ) ) || ( flags & requiredFlags ) != requiredFlags )
+		{
+			continue;
+		}
+
+		const int score = static_cast< int >( countBits( static_cast< uint32_t >( flags & preferredFlags ) ) )
+			- static_cast< int >( countBits( static_cast< uint32_t >( flags & unwantedFlags ) ) );
+
+		if( score > bestScore )
+		{
+			bestScore = score;
+			bestTypeIndex = i;
+		}
+	}
+
+	return bestTypeIndex;
+}
+
+bool CDeviceMemoryAllocator::isHostCoherent( uint32_t memoryTypeIndex ) const
+{
+	return static_cast< bool >( m_memoryProperties.memoryTypes[ memoryTypeIndex ].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent );
+}
+
+CDeviceMemoryAllocator::SStats CDeviceMemoryAllocator::getStats() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SStats stats;
+	stats.deviceAllocationCount = m_deviceAllocationCount;
+
+	for( const auto& blocks : m_blocks )
+	{
+		for( const auto& pBlock : blocks )
+		{
+			const CFreeListAllocator::SStats blockStats = pBlock->allocator.getStats();
+
+			stats.allocationCount += blockStats.allocationCount;
+			stats.blockBytes += blockStats.size;
+			stats.usedBytes += blockStats.usedBytes;
+			stats.freeBytes += blockStats.freeBytes;
+			stats.largestFreeRange = std::max<vk::DeviceSize>( stats.largestFreeRange, blockStats.largestFreeRange );
+		}
+	}
+
+	if( stats.freeBytes > 0 )
+	{
+		stats.fragmentation = 1.0 - static_cast< double >( stats.largestFreeRange ) / static_cast< double >( stats.freeBytes );
+	}
+
+	return stats;
+}
+
+CDeviceMemoryAllocator::SHeapUsage CDeviceMemoryAllocator::getHeapUsage( uint32_t heapIndex ) const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SHeapUsage usage;
+	for( uint32_t typeIndex = 0; typeIndex < m_memoryProperties.memoryTypeCount; ++typeIndex )
+	{
+		if( m_memoryProperties.memoryTypes[ typeIndex ].heapIndex != heapIndex )
+		{
+			continue;
+		}
+
+		for( const auto& pBlock : m_blocks[ typeIndex ] )
+		{
+			const CFreeListAllocator::SStats blockStats = pBlock->allocator.getStats();
+			usage.blockBytes += blockStats.size;
+			usage.usedBytes += blockStats.usedBytes;
+		}
+	}
+	return usage;
+}
+
+void CDeviceMemoryAllocator::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Device memory: {0} allocations in {1} device allocations", stats.allocationCount, stats.deviceAllocationCount );
+	VS_INFO( "    in use        : {0} / {1} bytes", stats.usedBytes, stats.blockBytes );
+	VS_INFO( "    largest free  : {0} bytes", stats.largestFreeRange );
+	VS_INFO( "    fragmentation : {0:.1f}%", stats.fragmentation * 100.0 );
+}
+
+/////////////////////////////////////////////////
+
+SMemoryBlock* CDeviceMemoryAllocator::createBlock( uint32_t memoryTypeIndex, vk::DeviceSize size, bool dedicated )
+{
+	if( m_maxDeviceAllocations != 0 && m_deviceAllocationCount >= m_maxDeviceAllocations )
+	{
+		throw std::runtime_error( "Exceeded maxMemoryAllocationCount." );
+	}
+
+	auto pBlock = std::make_unique<SMemoryBlock>( size, m_bufferImageGranularity );
+	pBlock->memoryTypeIndex = memoryTypeIndex;
+	pBlock->dedicated = dedicated;
+	pBlock->memory = m_device.allocateMemory( vk::MemoryAllocateInfo( size, memoryTypeIndex ) );
+
+	if( m_memoryProperties.memoryTypes[ memoryTypeIndex ].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible )
+	{
+		pBlock->pMapped = static_cast< uint8_t* >( m_device.mapMemory( pBlock->memory, 0, VK_WHOLE_SIZE ) );
+	}
+
+	++m_deviceAllocationCount;
+
+	m_blocks[ memoryTypeIndex ].push_back( std::move( pBlock ) );
+	return m_blocks[ memoryTypeIndex ].back().get();
+}
+
+void CDeviceMemoryAllocator::destroyBlock( SMemoryBlock* pBlock )
+{
+	auto& blocks = m_blocks[ pBlock->memoryTypeIndex ];
+	auto it = std::find_if( blocks.begin(), blocks.end(), [ pBlock ]( const std::unique_ptr<SMemoryBlock>& pOther ) { return pOther.get() == pBlock; } );
+
+	if( pBlock->pMapped )
+	{
+		m_device.unmapMemory( pBlock->memory );
+	}
+	m_device.freeMemory( pBlock->memory );
+
+	--m_deviceAllocationCount;
+	blocks.erase( it );
+}
+
+vk::MappedMemoryRange CDeviceMemoryAllocator::getMappedRange( const SAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size ) const
+{
+	const vk::DeviceSize blockSize = allocation.pBlock->allocator.getSize();
+
+	if( size == VK_WHOLE_SIZE )
+	{
+		size = allocation.size - offset;
+	}
+
+	//ranges on non coherent memory must be multiples of nonCoherentAtomSize
+	const vk::DeviceSize begin = alignDown( allocation.offset + offset, m_nonCoherentAtomSize );
+	const vk::DeviceSize end = std::min( alignUp( allocation.offset + offset + size, m_nonCoherentAtomSize ), blockSize );
+
+	return vk::MappedMemoryRange( allocation.memory, begin, end - begin );
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "FreeListAllocator.h"
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+
+enum class EMemoryUsage
+{
+	//device local, never touched by the CPU
+	GpuOnly,
+	//written by the CPU every frame or for uploads, read by the GPU
+	CpuToGpu,
+	//written by the GPU, read back by the CPU
+	GpuToCpu
+};
+
+struct SMemoryBlock;
+
+struct SAllocation
+{
+	vk::DeviceMemory memory;
+	vk::DeviceSize offset = 0;
+	vk::DeviceSize size = 0;
+	//null unless the memory type is host visible
+	uint8_t* pMapped = nullptr;
+	uint32_t memoryTypeIndex = 0;
+	SMemoryBlock* pBlock = nullptr;
+
+	inline bool isValid() const
+	{
+		return pBlock != nullptr;
+	}
+};
+
+//Carves buffers and images out of large VkDeviceMemory blocks, one list of blocks per
+//memory type, instead of calling vkAllocateMemory for every resource. Host visible
+//blocks are persistently mapped. Thread safe.
+class CDeviceMemoryAllocator
+{
+public:
+	static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+	struct SStats
+	{
+		uint32_t deviceAllocationCount = 0;
+		uint32_t allocationCount = 0;
+		vk::DeviceSize blockBytes = 0;
+		vk::DeviceSize usedBytes = 0;
+		vk::DeviceSize largestFreeRange = 0;
+		vk::DeviceSize freeBytes = 0;
+		double fragmentation = 0.0;
+	};
+
+	//blocks this allocator holds in one memory heap, and how much of them is sub-allocated
+	struct SHeapUsage
+	{
+		vk::DeviceSize blockBytes = 0;
+		vk::DeviceSize usedBytes = 0;
+	};
+
+public:
+	CDeviceMemoryAllocator();
+
+	void init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, vk::DeviceSize blockSize = DEFAULT_BLOCK_SIZE );
+	void destroy();
+
+	SAllocation allocate( const vk::MemoryRequirements& requirements, EMemoryUsage usage, EResourceKind kind );
+	void free( SAllocation& allocation );
+
+	//allocate and bind in one go
+	SAllocation allocateForBuffer( const vk::Buffer& buffer, EMemoryUsage usage );
+	SAllocation allocateForImage( const vk::Image& image, EMemoryUsage usage, vk::ImageTiling tiling = vk::ImageTiling::eOptimal );
+
+	//no-ops for host coherent memory
+	void flush( const SAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE );
+	void invalidate( const SAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE );
+
+	std::optional<uint32_t> findMemoryTypeIndex( uint32_t typeBits, EMemoryUsage usage ) const;
+	bool isHostCoherent( uint32_t memoryTypeIndex ) const;
+
+	SStats getStats() const;
+	SHeapUsage getHeapUsage( uint32_t heapIndex ) const;
+	void logStats() const;
+
+	inline const vk::PhysicalDeviceMemoryProperties& getMemoryProperties() const
+	{
+		return m_memoryProperties;
+	}
+
+private:
+	SMemoryBlock* createBlock( uint32_t memoryTypeIndex, vk::DeviceSize size, bool dedicated );
+	void destroyBlock( SMemoryBlock* pBlock );
+	vk::MappedMemoryRange getMappedRange( const SAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size ) const;
+
+	vk::Device m_device;
+	vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+	vk::DeviceSize m_blockSize;
+	vk::DeviceSize m_bufferImageGranularity;
+	vk::DeviceSize m_nonCoherentAtomSize;
+	uint32_t m_maxDeviceAllocations;
+
+	mutable std::mutex m_mutex;
+	std::vector<std::unique_ptr<SMemoryBlock>> m_blocks[ VK_MAX_MEMORY_TYPES ];
+	uint32_t m_deviceAllocationCount;
+};
@@ -0,0 +1,66 @@
+#include "vkpch.h"
+#include "FrameLinearBuffer.h"
+
+/////////////////////////////////////////////////
+
+CFrameLinearBuffer::CFrameLinearBuffer()
+	: m_device( nullptr )
+	, m_pAllocator( nullptr )
+	, m_bytesPerFrame( 0 )
+	, m_frameIndex( 0 )
+{
+}
+
+void CFrameLinearBuffer::init( const vk::Device& device, CDeviceMemoryAllocator& allocator, vk::DeviceSize bytesPerFrame, uint32_t framesInFlight, vk::BufferUsageFlags usage )
+{
+	m_device = device;
+	m_pAllocator = &allocator;
+	m_bytesPerFrame = bytesPerFrame;
+
+	framesInFlight = std::max( framesInFlight, 1u );
+
+	vk::BufferCreateInfo createInfo( {}, bytesPerFrame * framesInFlight, usage, vk::SharingMode::eExclusive );
+	m_buffer = m_device.createBuffer( createInfo );
+	m_allocation = m_pAllocator->allocateForBuffer( m_buffer, EMemoryUsage::CpuToGpu );
+
+	m_frameAllocators.assign( framesInFlight, CLinearAllocator( bytesPerFrame ) );
+	m_frameIndex = 0;
+}
+
+void CFrameLinearBuffer::destroy()
+{
+	if( m_buffer )
+	{
+		m_device.destroyBuffer( m_buffer );
+		m_pAllocator->free( m_allocation );
+		m_buffer = nullptr;
+	}
+	m_frameAllocators.clear();
+}
+
+void CFrameLinearBuffer::beginFrame( uint32_t frameIndex )
+{
+	m_frameIndex = frameIndex % static_cast< uint32_t >( m_frameAllocators.size() );
+	m_frameAllocators[ m_frameIndex ].reset();
+}
+
+std::optional<CFrameLinearBuffer::SSlice> CFrameLinearBuffer::allocate( vk::DeviceSize size, vk::DeviceSize alignment )
+{
+	std::optional<uint64_t> offset = m_frameAllocators[ m_frameIndex ].allocate( size, alignment );
+	if( !offset.has_value() )
+	{
+		return std::nullopt;
+	}
+
+	const vk::DeviceSize bufferOffset = m_bytesPerFrame * m_frameIndex + offset.value();
+	return SSlice { m_buffer, bufferOffset, m_allocation.pMapped + bufferOffset };
+}
+
+void CFrameLinearBuffer::flush()
+{
+	const vk::DeviceSize usedBytes = m_frameAllocators[ m_frameIndex ].getUsedBytes();
+	if( usedBytes > 0 )
+	{
+		m_pAllocator->flush( m_allocation, m_bytesPerFrame * m_frameIndex, usedBytes );
+	}
+}
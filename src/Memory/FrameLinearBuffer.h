@@ -0,0 +1,45 @@
+#pragma once
+#include "DeviceMemoryAllocator.h"
+#include "LinearAllocator.h"
+
+//Persistently mapped host visible buffer split into one region per frame in flight.
+//Each region is a linear allocator that is reset when its frame slot comes around
+//again, so small per-frame data (uniforms, instance data) costs a pointer bump.
+class CFrameLinearBuffer
+{
+public:
+	struct SSlice
+	{
+		vk::Buffer buffer;
+		vk::DeviceSize offset;
+		uint8_t* pMapped;
+	};
+
+public:
+	CFrameLinearBuffer();
+
+	void init( const vk::Device& device, CDeviceMemoryAllocator& allocator, vk::DeviceSize bytesPerFrame, uint32_t framesInFlight, vk::BufferUsageFlags usage );
+	void destroy();
+
+	//the GPU must have retired the previous use of frameIndex
+	void beginFrame( uint32_t frameIndex );
+	std::optional<SSlice> allocate( vk::DeviceSize size, vk::DeviceSize alignment );
+	//flushes what was written this frame, no-op on coherent memory
+	void flush();
+
+	inline vk::Buffer getBuffer() const
+	{
+		return m_buffer;
+	}
+
+private:
+	vk::Device m_device;
+	CDeviceMemoryAllocator* m_pAllocator;
+
+	vk::Buffer m_buffer;
+	SAllocation m_allocation;
+
+	vk::DeviceSize m_bytesPerFrame;
+	uint32_t m_frameIndex;
+	std::vector<CLinearAllocator> m_frameAllocators;
+};
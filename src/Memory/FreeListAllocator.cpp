@@ -0,0 +1,191 @@
+#include "vkpch.h"
+#include "FreeListAllocator.h"
+
+/////////////////////////////////////////////////
+
+static uint64_t alignUp( uint64_t value, uint64_t alignment )
+{
+	return alignment > 1 ? ( ( value + alignment - 1 ) / alignment ) * alignment : value;
+}
+
+/////////////////////////////////////////////////
+
+CFreeListAllocator::CFreeListAllocator( uint64_t size, uint64_t granularity )
+	: m_size( size )
+	, m_granularity( std::max<uint64_t>( granularity, 1 ) )
+	, m_usedBytes( 0 )
+	, m_allocationCount( 0 )
+{
+	m_ranges.emplace( 0, SRange { size, EResourceKind::Free } );
+}
+
+std::optional<uint64_t> CFreeListAllocator::allocate( uint64_t size, uint64_t alignment, EResourceKind kind )
+{
+	if( size == 0 || kind == EResourceKind::Free )
+	{
+		return std::nullopt;
+	}
+
+	RangeMap::iterator bestRange = m_ranges.end();
+	uint64_t bestOffset = 0;
+
+	for( auto it = m_ranges.begin(); it != m_ranges.end(); ++it )
+	{
+		const uint64_t rangeStart = it->first;
+		const uint64_t rangeSize = it->second.size;
+
+		if( it->second.kind != EResourceKind::Free || rangeSize < size )
+		{
+			continue;
+		}
+
+		//best fit, an equal or smaller range has already been found
+		if( bestRange != m_ranges.end() && bestRange->second.size <= rangeSize )
+		{
+			continue;
+		}
+
+		uint64_t offset = alignUp( rangeStart, alignment );
+
+		//free ranges are always coalesced, so neighbours are allocations
+		if( it != m_ranges.begin() )
+		{
+			auto prev = std::prev( it );
+			if( hasGranularityConflict( prev->second.kind, kind ) && isOnSamePage( prev->first + prev->second.size, offset ) )
+			{
+				offset = alignUp( offset, m_granularity );
+			}
+		}
+
+		const uint64_t rangeEnd = rangeStart + rangeSize;
+		if( offset + size > rangeEnd )
+		{
+			continue;
+		}
+
+		auto next = std::next( it );
+		if( next != m_ranges.end() && hasGranularityConflict( kind, next->second.kind ) && isOnSamePage( offset + size, next->first ) )
+		{
+			continue;
+		}
+
+		bestRange = it;
+		bestOffset = offset;
+	}
+
+	if( bestRange == m_ranges.end() )
+	{
+		return std::nullopt;
+	}
+
+	const uint64_t rangeStart = bestRange->first;
+	const uint64_t rangeEnd = rangeStart + bestRange->second.size;
+
+	//split off the alignment padding in front and the remainder behind
+	if( bestOffset > rangeStart )
+	{
+		bestRange->second.size = bestOffset - rangeStart;
+	}
+	else
+	{
+		m_ranges.erase( bestRange );
+	}
+
+	m_ranges.emplace( bestOffset, SRange { size, kind } );
+
+	if( bestOffset + size < rangeEnd )
+	{
+		m_ranges.emplace( bestOffset + size, SRange { rangeEnd - ( bestOffset + size ), EResourceKind::Free } );
+	}
+
+	m_usedBytes += size;
+	++m_allocationCount;
+
+	return bestOffset;
+}
+
+void CFreeListAllocator::free( uint64_t offset )
+{
+	auto it = m_ranges.find( offset );
+	if( it == m_ranges.end() || it->second.kind == EResourceKind::Free )
+	{
+		throw std::runtime_error( "Freeing an offset that was not allocated." );
+	}
+
+	m_usedBytes -= it->second.size;
+	--m_allocationCount;
+
+	it->second.kind = EResourceKind::Free;
+
+	auto next = std::next( it );
+	if( next != m_ranges.end() && next->second.kind == EResourceKind::Free )
+	{
+		it->second.size += next->second.size;
+		m_ranges.erase( next );
+	}
+
+	if( it != m_ranges.begin() )
+	{
+		auto prev = std::prev( it );
+		if( prev->second.kind == EResourceKind::Free )
+		{
+			prev->second.size += it->second.size;
+			m_ranges.erase( it );
+		}
+	}
+}
+
+CFreeListAllocator::SStats CFreeListAllocator::getStats() const
+{
+	SStats stats;
+	stats.size = m_size;
+	stats.usedBytes = m_usedBytes;
+	stats.allocationCount = m_allocationCount;
+
+	for( const auto& range : m_ranges )
+	{
+		if( range.second.kind == EResourceKind::Free )
+		{
+			stats.freeBytes += range.second.size;
+			stats.largestFreeRange = std::max( stats.largestFreeRange, range.second.size );
+			++stats.freeRangeCount;
+		}
+	}
+
+	return stats;
+}
+
+double CFreeListAllocator::getFragmentation( const SStats& stats )
+{
+	if( stats.freeBytes == 0 )
+	{
+		return 0.0;
+	}
+
+	return 1.0 - static_cast< double >( stats.largestFreeRange ) / static_cast< double >( stats.freeBytes );
+}
+
+/////////////////////////////////////////////////
+
+bool CFreeListAllocator::isOnSamePage( uint64_t endOfFirst, uint64_t startOfSecond ) const
+{
+	if( endOfFirst == 0 )
+	{
+		return false;
+	}
+
+	return ( endOfFirst - 1 ) / m_granularity == startOfSecond / m_granularity;
+}
+
+bool CFreeListAllocator::hasGranularityConflict( EResourceKind first, EResourceKind second )
+{
+	if( first == EResourceKind::Free || second == EResourceKind::Free )
+	{
+		return false;
+	}
+
+	const bool firstIsOptimal = ( first == EResourceKind::OptimalImage );
+	const bool secondIsOptimal = ( second == EResourceKind::OptimalImage );
+
+	return firstIsOptimal != secondIsOptimal;
+}
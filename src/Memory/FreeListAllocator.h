@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+
+//what kind of resource occupies a range, linear and optimal resources that share a
+//bufferImageGranularity page may alias on some hardware and must be kept apart
+enum class EResourceKind : uint8_t
+{
+	Free,
+	Buffer,
+	LinearImage,
+	OptimalImage
+};
+
+//General purpose sub-allocator over a single [0, size) range. Keeps every range,
+//free or used, in offset order so neighbours can be coalesced on free and
+//checked for granularity conflicts on allocate. Knows nothing about Vulkan.
+class CFreeListAllocator
+{
+public:
+	struct SStats
+	{
+		uint64_t size = 0;
+		uint64_t usedBytes = 0;
+		uint64_t freeBytes = 0;
+		uint64_t largestFreeRange = 0;
+		uint32_t allocationCount = 0;
+		uint32_t freeRangeCount = 0;
+	};
+
+public:
+	CFreeListAllocator( uint64_t size, uint64_t granularity );
+
+	//returns the offset of the allocation, or nothing if no free range can hold it
+	std::optional<uint64_t> allocate( uint64_t size, uint64_t alignment, EResourceKind kind );
+	void free( uint64_t offset );
+
+	SStats getStats() const;
+
+	inline bool isEmpty() const
+	{
+		return m_allocationCount == 0;
+	}
+
+	inline uint64_t getSize() const
+	{
+		return m_size;
+	}
+
+	//1 - largest free range / total free bytes, 0 when the free space is one contiguous range
+	static double getFragmentation( const SStats& stats );
+
+private:
+	struct SRange
+	{
+		uint64_t size;
+		EResourceKind kind;
+	};
+
+	using RangeMap = std::map<uint64_t, SRange>;
+
+	bool isOnSamePage( uint64_t endOfFirst, uint64_t startOfSecond ) const;
+	static bool hasGranularityConflict( EResourceKind first, EResourceKind second );
+
+	uint64_t m_size;
+	uint64_t m_granularity;
+	uint64_t m_usedBytes;
+	uint32_t m_allocationCount;
+
+	RangeMap m_ranges;
+};
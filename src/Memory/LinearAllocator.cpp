@@ -0,0 +1,27 @@
+#include "vkpch.h"
+#include "LinearAllocator.h"
+
+/////////////////////////////////////////////////
+
+CLinearAllocator::CLinearAllocator( uint64_t size )
+	: m_size( size )
+	, m_head( 0 )
+	, m_allocationCount( 0 )
+{
+}
+
+std::optional<uint64_t> CLinearAllocator::allocate( uint64_t size, uint64_t alignment )
+{
+	alignment = std::max<uint64_t>( alignment, 1 );
+
+	const uint64_t offset = ( ( m_head + alignment - 1 ) / alignment ) * alignment;
+	if( size == 0 || offset + size > m_size )
+	{
+		return std::nullopt;
+	}
+
+	m_head = offset + size;
+	++m_allocationCount;
+
+	return offset;
+}
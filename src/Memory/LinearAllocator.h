@@ -0,0 +1,37 @@
+#pragma once
+
+//Bump allocator over [0, size). Individual allocations are never freed, the whole
+//range is reset at once, which makes it a good fit for data that lives for one frame.
+class CLinearAllocator
+{
+public:
+	explicit CLinearAllocator( uint64_t size = 0 );
+
+	std::optional<uint64_t> allocate( uint64_t size, uint64_t alignment );
+
+	inline void reset()
+	{
+		m_head = 0;
+		m_allocationCount = 0;
+	}
+
+	inline uint64_t getSize() const
+	{
+		return m_size;
+	}
+
+	inline uint64_t getUsedBytes() const
+	{
+		return m_head;
+	}
+
+	inline uint32_t getAllocationCount() const
+	{
+		return m_allocationCount;
+	}
+
+private:
+	uint64_t m_size;
+	uint64_t m_head;
+	uint32_t m_allocationCount;
+};
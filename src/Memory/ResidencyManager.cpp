@@ -0,0 +1,351 @@
+#include "vkpch.h"
+#include "ResidencyManager.h"
+
+#include "Profiling/CpuProfiler.h"
+#include "Utils/Log.h"
+#include "Vulkan/VulkanUtils.h"
+
+/////////////////////////////////////////////////
+
+const double BYTES_PER_MIB = 1024.0 * 1024.0;
+
+/////////////////////////////////////////////////
+
+CResidencyManager::CResidencyManager()
+	: m_physicalDevice( nullptr )
+	, m_pAllocator( nullptr )
+	, m_budgetExtensionEnabled( false )
+	, m_nextResourceId( 0 )
+	, m_currentFrame( 0 )
+	, m_resourcesUsedThisFrame( 0 )
+	, m_bytesUsedThisFrame( 0 )
+{
+}
+
+bool CResidencyManager::IsBudgetSupported( const vk::PhysicalDevice& physicalDevice )
+{
+	return isDeviceExtensionSupported( physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+}
+
+const char* CResidencyManager::GetPressureName( EMemoryPressure pressure )
+{
+	switch( pressure )
+	{
+	case EMemoryPressure::None:
+		return "none";
+	case EMemoryPressure::Elevated:
+		return "elevated";
+	case EMemoryPressure::High:
+		return "high";
+	case EMemoryPressure::Critical:
+		return "critical";
+	}
+	return "unknown";
+}
+
+void CResidencyManager::init( const vk::PhysicalDevice& physicalDevice, const CDeviceMemoryAllocator& allocator, bool budgetExtensionEnabled, const SSettings& settings )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	m_physicalDevice = physicalDevice;
+	m_pAllocator = &allocator;
+	m_memoryProperties = allocator.getMemoryProperties();
+	m_budgetExtensionEnabled = budgetExtensionEnabled;
+	m_settings = settings;
+
+	m_heaps.assign( m_memoryProperties.memoryHeapCount, SHeapBudget {} );
+	for( uint32_t heapIndex = 0; heapIndex < m_memoryProperties.memoryHeapCount; ++heapIndex )
+	{
+		const vk::MemoryHeap& memoryHeap = m_memoryProperties.memoryHeaps[ heapIndex ];
+		m_heaps[ heapIndex ].size = memoryHeap.size;
+		m_heaps[ heapIndex ].deviceLocal = static_cast< bool >( memoryHeap.flags & vk::MemoryHeapFlagBits::eDeviceLocal );
+	}
+
+	m_stats = SStats {};
+	m_stats.budgetExtension = budgetExtensionEnabled;
+	refreshBudgets();
+
+	VS_INFO( "Residency manager: budgets from {0}.", budgetExtensionEnabled ? "VK_EXT_memory_budget" : "heap sizes" );
+}
+
+void CResidencyManager::destroy()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( !m_resources.empty() )
+	{
+		VS_WARN( "Residency manager destroyed with {0} resources still registered.", m_resources.size() );
+	}
+
+	m_resources.clear();
+	m_heaps.clear();
+	m_pAllocator = nullptr;
+}
+
+void CResidencyManager::beginFrame( uint64_t frameNumber, uint64_t completedFrame )
+{
+	VS_PROFILE_SCOPE( "residency" );
+
+	std::vector<std::pair<ResourceId, EvictFn>> evictions;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		m_stats.resourcesUsedLastFrame = m_resourcesUsedThisFrame;
+		m_stats.bytesUsedLastFrame = m_bytesUsedThisFrame;
+		m_resourcesUsedThisFrame = 0;
+		m_bytesUsedThisFrame = 0;
+		m_currentFrame = frameNumber;
+
+		refreshBudgets();
+
+		for( uint32_t heapIndex = 0; heapIndex < m_heaps.size(); ++heapIndex )
+		{
+			if( m_heaps[ heapIndex ].pressure >= EMemoryPressure::High )
+			{
+				collectEvictions( heapIndex, completedFrame, evictions );
+			}
+		}
+		m_stats.evictionsLastFrame = static_cast< uint32_t >( evictions.size() );
+	}
+
+	//outside the lock, owners usually unregister or re-register from the callback
+	for( auto& eviction : evictions )
+	{
+		eviction.second( eviction.first );
+	}
+}
+
+CResidencyManager::ResourceId CResidencyManager::registerResource( uint32_t memoryTypeIndex, vk::DeviceSize size, EvictFn evict )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	const uint32_t heapIndex = m_memoryProperties.memoryTypes[ memoryTypeIndex ].heapIndex;
+
+	//counts as used by the frame being recorded, which is also the one that uploads it
+	const ResourceId id = m_nextResourceId++;
+	m_resources.emplace( id, SResource { heapIndex, size, m_currentFrame, std::move( evict ) } );
+
+	m_heaps[ heapIndex ].streamableBytes += size;
+	++m_stats.resources;
+	m_stats.resourceBytes += size;
+	return id;
+}
+
+void CResidencyManager::unregisterResource( ResourceId id )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	auto it = m_resources.find( id );
+	if( it == m_resources.end() )
+	{
+		return;
+	}
+
+	m_heaps[ it->second.heapIndex ].streamableBytes -= it->second.size;
+	--m_stats.resources;
+	m_stats.resourceBytes -= it->second.size;
+	m_resources.erase( it );
+}
+
+void CResidencyManager::setResourceSize( ResourceId id, vk::DeviceSize size )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	auto it = m_resources.find( id );
+	if( it == m_resources.end() )
+	{
+		return;
+	}
+
+	SHeapBudget& heap = m_heaps[ it->second.heapIndex ];
+	heap.streamableBytes = heap.streamableBytes - it->second.size + size;
+	m_stats.resourceBytes = m_stats.resourceBytes - it->second.size + size;
+	it->second.size = size;
+}
+
+void CResidencyManager::markUsed( ResourceId id )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	auto it = m_resources.find( id );
+	if( it == m_resources.end() || it->second.lastUsedFrame == m_currentFrame )
+	{
+		return;
+	}
+
+	it->second.lastUsedFrame = m_currentFrame;
+	++m_resourcesUsedThisFrame;
+	m_bytesUsedThisFrame += it->second.size;
+}
+
+bool CResidencyManager::canAllocate( uint32_t memoryTypeIndex, vk::DeviceSize size )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SHeapBudget& heap = m_heaps[ m_memoryProperties.memoryTypes[ memoryTypeIndex ].heapIndex ];
+	const double limit = static_cast< double >( heap.budget ) * m_settings.highWatermark;
+	if( static_cast< double >( heap.usage + size ) > limit )
+	{
+		++m_stats.refusedAllocations;
+		return false;
+	}
+
+	//counted right away, so several requests in one frame cannot overshoot together
+	heap.usage += size;
+	heap.pressure = computePressure( heap );
+	return true;
+}
+
+EMemoryPressure CResidencyManager::getPressure( uint32_t memoryTypeIndex ) const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_heaps[ m_memoryProperties.memoryTypes[ memoryTypeIndex ].heapIndex ].pressure;
+}
+
+EMemoryPressure CResidencyManager::getDeviceLocalPressure() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	EMemoryPressure pressure = EMemoryPressure::None;
+	for( const SHeapBudget& heap : m_heaps )
+	{
+		if( heap.deviceLocal )
+		{
+			pressure = std::max( pressure, heap.pressure );
+		}
+	}
+	return pressure;
+}
+
+std::vector<CResidencyManager::SHeapBudget> CResidencyManager::getHeapBudgets() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_heaps;
+}
+
+CResidencyManager::SStats CResidencyManager::getStats() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_stats;
+}
+
+void CResidencyManager::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Residency: {0} streamable resources ({1:.1f} MiB), {2} evictions ({3:.1f} MiB), {4} streaming allocations refused",
+		stats.resources, stats.resourceBytes / BYTES_PER_MIB, stats.evictions, stats.evictedBytes / BYTES_PER_MIB, stats.refusedAllocations );
+
+	const std::vector<SHeapBudget> heaps = getHeapBudgets();
+	for( size_t heapIndex = 0; heapIndex < heaps.size(); ++heapIndex )
+	{
+		const SHeapBudget& heap = heaps[ heapIndex ];
+		VS_INFO( "    heap {0}{1}: {2:.1f} / {3:.1f} MiB budget of {4:.1f} MiB, {5:.1f} MiB streamable, pressure {6}",
+			heapIndex, heap.deviceLocal ? " (device local)" : "", heap.usage / BYTES_PER_MIB, heap.budget / BYTES_PER_MIB,
+			heap.size / BYTES_PER_MIB, heap.streamableBytes / BYTES_PER_MIB, GetPressureName( heap.pressure ) );
+	}
+}
+
+/////////////////////////////////////////////////
+
+void CResidencyManager::refreshBudgets()
+{
+	vk::PhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+	if( m_budgetExtensionEnabled )
+	{
+		const auto propertyChain = m_physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		budgetProperties = propertyChain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+	}
+
+	for( uint32_t heapIndex = 0; heapIndex < m_heaps.size(); ++heapIndex )
+	{
+		SHeapBudget& heap = m_heaps[ heapIndex ];
+		const CDeviceMemoryAllocator::SHeapUsage ownUsage = m_pAllocator->getHeapUsage( heapIndex );
+
+		vk::DeviceSize processUsage;
+		if( m_budgetExtensionEnabled )
+		{
+			heap.budget = budgetProperties.heapBudget[ heapIndex ];
+			//the driver may not have seen the newest blocks yet
+			processUsage = std::max( budgetProperties.heapUsage[ heapIndex ], ownUsage.blockBytes );
+		}
+		else
+		{
+			heap.budget = static_cast< vk::DeviceSize >( static_cast< double >( heap.size ) * m_settings.fallbackBudgetFraction );
+			processUsage = ownUsage.blockBytes;
+		}
+
+		//free ranges in our blocks take new resources without growing the process' usage
+		const vk::DeviceSize reusableBytes = ownUsage.blockBytes - ownUsage.usedBytes;
+		heap.usage = processUsage > reusableBytes ? processUsage - reusableBytes : 0;
+		heap.pressure = computePressure( heap );
+	}
+}
+
+EMemoryPressure CResidencyManager::computePressure( const SHeapBudget& heap ) const
+{
+	if( heap.budget == 0 )
+	{
+		return EMemoryPressure::None;
+	}
+
+	const double fraction = static_cast< double >( heap.usage ) / static_cast< double >( heap.budget );
+	if( fraction >= 1.0 )
+	{
+		return EMemoryPressure::Critical;
+	}
+	if( fraction >= m_settings.highWatermark )
+	{
+		return EMemoryPressure::High;
+	}
+	if( fraction >= m_settings.lowWatermark )
+	{
+		return EMemoryPressure::Elevated;
+	}
+	return EMemoryPressure::None;
+}
+
+void CResidencyManager::collectEvictions( uint32_t heapIndex, uint64_t completedFrame, std::vector<std::pair<ResourceId, EvictFn>>& evictions )
+{
+	SHeapBudget& heap = m_heaps[ heapIndex ];
+	const vk::DeviceSize target = static_cast< vk::DeviceSize >( static_cast< double >( heap.budget ) * m_settings.evictionTarget );
+
+	//resources a frame in flight may still read are never candidates
+	std::vector<std::pair<uint64_t, ResourceId>> candidates;
+	for( const auto& resource : m_resources )
+	{
+		if( resource.second.heapIndex == heapIndex && resource.second.lastUsedFrame <= completedFrame )
+		{
+			candidates.emplace_back( resource.second.lastUsedFrame, resource.first );
+		}
+	}
+	std::sort( candidates.begin(), candidates.end() );
+
+	for( const auto& candidate : candidates )
+	{
+		if( heap.usage <= target || evictions.size() >= m_settings.maxEvictionsPerFrame )
+		{
+			break;
+		}
+
+		auto it = m_resources.find( candidate.second );
+		const vk::DeviceSize size = it->second.size;
+
+		//the memory goes back to our blocks once the owner frees it, which makes it reusable
+		heap.usage = heap.usage > size ? heap.usage - size : 0;
+		heap.streamableBytes -= size;
+		--m_stats.resources;
+		m_stats.resourceBytes -= size;
+		++m_stats.evictions;
+		m_stats.evictedBytes += size;
+
+		evictions.emplace_back( candidate.second, std::move( it->second.evict ) );
+		m_resources.erase( it );
+	}
+
+	heap.pressure = computePressure( heap );
+	if( heap.usage > target && evictions.size() < m_settings.maxEvictionsPerFrame )
+	{
+		VS_WARN( "Heap {0} is over its eviction target with nothing left to evict.", heapIndex );
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "DeviceMemoryAllocator.h"
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+enum class EMemoryPressure
+{
+	//comfortably inside the budget
+	None,
+	//past the low watermark, streaming should only fetch what is needed now
+	Elevated,
+	//past the high watermark, least recently used streamable resources are evicted
+	High,
+	//over the budget, streaming allocations are refused until evictions catch up
+	Critical
+};
+
+//Keeps device memory use inside the budget of each heap. Budgets come from
+//VK_EXT_memory_budget when it is enabled, which also accounts for other processes,
+//otherwise from a fraction of the heap sizes and this process' own allocations.
+//Streamable resources are registered with their size and an evict callback and are
+//marked whenever a frame uses them. Once a heap passes the high watermark, beginFrame
+//evicts the least recently used of them that no frame in flight uses anymore, a bounded
+//number per frame so pressure never turns into a hitch. Streamers ask canAllocate before
+//they allocate and lower their priority while getPressure reports pressure.
+//Thread safe, evict callbacks run on the thread that calls beginFrame.
+class CResidencyManager
+{
+public:
+	using ResourceId = uint32_t;
+	static constexpr ResourceId INVALID_RESOURCE = UINT32_MAX;
+
+	//the resource is no longer tracked once its callback runs. Its last use has completed on
+	//the GPU, so the owner may release the memory right away.
+	using EvictFn = std::function<void( ResourceId id )>;
+
+	struct SSettings
+	{
+		//fractions of the budget that raise the pressure level
+		float lowWatermark = 0.75f;
+		float highWatermark = 0.9f;
+		//evicting stops once a heap is back below this fraction of its budget
+		float evictionTarget = 0.8f;
+		//budget without VK_EXT_memory_budget, leaves room for the driver and other processes
+		float fallbackBudgetFraction = 0.8f;
+		uint32_t maxEvictionsPerFrame = 32;
+	};
+
+	struct SHeapBudget
+	{
+		vk::DeviceSize size = 0;
+		vk::DeviceSize budget = 0;
+		//what counts against the budget: the process' usage, minus the free ranges inside
+		//this allocator's blocks that new allocations can reuse
+		vk::DeviceSize usage = 0;
+		//registered streamable resources in this heap
+		vk::DeviceSize streamableBytes = 0;
+		bool deviceLocal = false;
+		EMemoryPressure pressure = EMemoryPressure::None;
+	};
+
+	struct SStats
+	{
+		bool budgetExtension = false;
+		uint32_t resources = 0;
+		vk::DeviceSize resourceBytes = 0;
+		//resources the last completed call to beginFrame saw used in the frame before
+		uint32_t resourcesUsedLastFrame = 0;
+		vk::DeviceSize bytesUsedLastFrame = 0;
+		uint32_t evictionsLastFrame = 0;
+		uint64_t evictions = 0;
+		vk::DeviceSize evictedBytes = 0;
+		uint64_t refusedAllocations = 0;
+	};
+
+public:
+	CResidencyManager();
+
+	static bool IsBudgetSupported( const vk::PhysicalDevice& physicalDevice );
+	static const char* GetPressureName( EMemoryPressure pressure );
+
+	//budgetExtensionEnabled when the device was created with VK_EXT_memory_budget
+	void init( const vk::PhysicalDevice& physicalDevice, const CDeviceMemoryAllocator& allocator, bool budgetExtensionEnabled, const SSettings& settings = SSettings {} );
+	void destroy();
+
+	//refreshes the budgets and evicts where a heap is under pressure. frameNumber is the frame
+	//about to be recorded, completedFrame the newest one the GPU has finished.
+	void beginFrame( uint64_t frameNumber, uint64_t completedFrame );
+
+	ResourceId registerResource( uint32_t memoryTypeIndex, vk::DeviceSize size, EvictFn evict );
+	void unregisterResource( ResourceId id );
+	//e.g. when more mip levels have been streamed in
+	void setResourceSize( ResourceId id, vk::DeviceSize size );
+	//the frame being recorded uses the resource, so it is not evicted before that frame completed
+	void markUsed( ResourceId id );
+
+	//whether a streaming allocation fits below the high watermark of the memory type's heap
+	bool canAllocate( uint32_t memoryTypeIndex, vk::DeviceSize size );
+	EMemoryPressure getPressure( uint32_t memoryTypeIndex ) const;
+	//the worst pressure of any device local heap, what streaming priorities follow
+	EMemoryPressure getDeviceLocalPressure() const;
+
+	std::vector<SHeapBudget> getHeapBudgets() const;
+	SStats getStats() const;
+	void logStats() const;
+
+private:
+	struct SResource
+	{
+		uint32_t heapIndex;
+		vk::DeviceSize size;
+		uint64_t lastUsedFrame;
+		EvictFn evict;
+	};
+
+	void refreshBudgets();
+	EMemoryPressure computePressure( const SHeapBudget& heap ) const;
+	void collectEvictions( uint32_t heapIndex, uint64_t completedFrame, std::vector<std::pair<ResourceId, EvictFn>>& evictions );
+
+	vk::PhysicalDevice m_physicalDevice;
+	const CDeviceMemoryAllocator* m_pAllocator;
+	vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+	bool m_budgetExtensionEnabled;
+	SSettings m_settings;
+
+	mutable std::mutex m_mutex;
+	std::vector<SHeapBudget> m_heaps;
+	std::unordered_map<ResourceId, SResource> m_resources;
+	ResourceId m_nextResourceId;
+	uint64_t m_currentFrame;
+
+	uint32_t m_resourcesUsedThisFrame;
+	vk::DeviceSize m_bytesUsedThisFrame;
+	SStats m_stats;
+};
@@ -0,0 +1,104 @@
+#include "vkpch.h"
+#include "RingAllocator.h"
+
+/////////////////////////////////////////////////
+
+static uint64_t alignUp( uint64_t value, uint64_t alignment )
+{
+	return alignment > 1 ? ( ( value + alignment - 1 ) / alignment ) * alignment : value;
+}
+
+/////////////////////////////////////////////////
+
+CRingAllocator::CRingAllocator( uint64_t size )
+	: m_size( size )
+	, m_head( 0 )
+	, m_tail( 0 )
+	, m_usedBytes( 0 )
+	, m_pendingBytes( 0 )
+{
+}
+
+std::optional<uint64_t> CRingAllocator::allocate( uint64_t size, uint64_t alignment )
+{
+	if( size == 0 || size > m_size )
+	{
+		return std::nullopt;
+	}
+
+	//nothing outstanding, start over at the front so the whole ring is contiguous again
+	if( m_usedBytes == 0 )
+	{
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	//head caught up with tail from behind, the ring is full
+	if( m_head == m_tail && m_usedBytes > 0 )
+	{
+		return std::nullopt;
+	}
+
+	const uint64_t alignedHead = alignUp( m_head, alignment );
+
+	uint64_t offset = 0;
+	uint64_t consumed = 0;
+
+	if( m_head >= m_tail )
+	{
+		//free space is [head, size) followed by [0, tail)
+		if( alignedHead + size <= m_size )
+		{
+			offset = alignedHead;
+			consumed = ( alignedHead - m_head ) + size;
+		}
+		else if( size <= m_tail )
+		{
+			//wrap, the skipped end of the ring stays used until this submission retires
+			offset = 0;
+			consumed = ( m_size - m_head ) + size;
+		}
+		else
+		{
+			return std::nullopt;
+		}
+	}
+	else
+	{
+		//free space is [head, tail)
+		if( alignedHead + size > m_tail )
+		{
+			return std::nullopt;
+		}
+
+		offset = alignedHead;
+		consumed = ( alignedHead - m_head ) + size;
+	}
+
+	m_head = offset + size;
+	m_usedBytes += consumed;
+	m_pendingBytes += consumed;
+
+	return offset;
+}
+
+void CRingAllocator::submit( uint64_t value )
+{
+	if( m_pendingBytes == 0 )
+	{
+		return;
+	}
+
+	m_submissions.push_back( SSubmission { value, m_head, m_pendingBytes } );
+	m_pendingBytes = 0;
+}
+
+void CRingAllocator::release( uint64_t completedValue )
+{
+	while( !m_submissions.empty() && m_submissions.front().value <= completedValue )
+	{
+		m_tail = m_submissions.front().head;
+		m_usedBytes -= m_submissions.front().bytes;
+		m_submissions.pop_front();
+	}
+}
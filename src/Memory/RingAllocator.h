@@ -0,0 +1,51 @@
+#pragma once
+
+#include <deque>
+
+//Ring allocator over [0, size) for transient data whose lifetime is bounded by GPU
+//progress. Allocations made between two submit() calls are released together once
+//release() is called with a value at or past the one they were submitted with.
+class CRingAllocator
+{
+public:
+	explicit CRingAllocator( uint64_t size = 0 );
+
+	std::optional<uint64_t> allocate( uint64_t size, uint64_t alignment );
+
+	//tags every allocation since the last submit with value, e.g. a frame or timeline value
+	void submit( uint64_t value );
+	//frees every submission tagged with a value <= completedValue
+	void release( uint64_t completedValue );
+
+	inline uint64_t getSize() const
+	{
+		return m_size;
+	}
+
+	inline uint64_t getUsedBytes() const
+	{
+		return m_usedBytes;
+	}
+
+	inline size_t getSubmissionsInFlight() const
+	{
+		return m_submissions.size();
+	}
+
+private:
+	struct SSubmission
+	{
+		uint64_t value;
+		uint64_t head;
+		uint64_t bytes;
+	};
+
+	uint64_t m_size;
+	uint64_t m_head;
+	uint64_t m_tail;
+	uint64_t m_usedBytes;
+	//bytes (including padding) allocated since the last submit
+	uint64_t m_pendingBytes;
+
+	std::deque<SSubmission> m_submissions;
+};
@@ -0,0 +1,88 @@
+#include "vkpch.h"
+#include "CpuProfiler.h"
+
+/////////////////////////////////////////////////
+
+//nesting depth of the zones open on this thread
+static thread_local uint32_t t_zoneDepth = 0;
+static thread_local uint32_t t_threadIndex = UINT32_MAX;
+
+/////////////////////////////////////////////////
+
+std::mutex CCpuProfiler::mutex_;
+CTimer::Clock::time_point CCpuProfiler::frameStart_ = CTimer::Clock::now();
+std::vector<CCpuProfiler::SZoneResult> CCpuProfiler::currentZones_;
+std::vector<CCpuProfiler::SZoneResult> CCpuProfiler::lastFrameZones_;
+CFrameHistory CCpuProfiler::frameHistory_;
+uint32_t CCpuProfiler::threadCount_ = 0;
+
+void CCpuProfiler::BeginFrame()
+{
+	const CTimer::Clock::time_point now = CTimer::Clock::now();
+
+	std::lock_guard<std::mutex> lock( mutex_ );
+	frameHistory_.push( static_cast< float >( std::chrono::duration<double, std::milli>( now - frameStart_ ).count() ) );
+
+	lastFrameZones_.swap( currentZones_ );
+	currentZones_.clear();
+
+	//nested zones close before their parents, list them in the order they opened
+	std::stable_sort( lastFrameZones_.begin(), lastFrameZones_.end(), []( const SZoneResult& lhs, const SZoneResult& rhs )
+	{
+		return lhs.threadIndex != rhs.threadIndex ? lhs.threadIndex < rhs.threadIndex : lhs.startMilliseconds < rhs.startMilliseconds;
+	} );
+
+	frameStart_ = now;
+}
+
+void CCpuProfiler::RecordZone( const char* name, uint32_t depth, CTimer::Clock::time_point start, CTimer::Clock::time_point end )
+{
+	const uint32_t threadIndex = GetThreadIndex();
+
+	std::lock_guard<std::mutex> lock( mutex_ );
+	SZoneResult result;
+	result.name = name;
+	result.depth = depth;
+	result.threadIndex = threadIndex;
+	result.startMilliseconds = std::chrono::duration<double, std::milli>( start - frameStart_ ).count();
+	result.durationMilliseconds = std::chrono::duration<double, std::milli>( end - start ).count();
+	currentZones_.push_back( result );
+}
+
+std::vector<CCpuProfiler::SZoneResult> CCpuProfiler::GetLastFrameZones()
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	return lastFrameZones_;
+}
+
+CFrameHistory CCpuProfiler::GetFrameHistory()
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	return frameHistory_;
+}
+
+uint32_t CCpuProfiler::GetThreadIndex()
+{
+	//small stable indices instead of opaque thread ids, assigned on first use
+	if( t_threadIndex == UINT32_MAX )
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		t_threadIndex = threadCount_++;
+	}
+	return t_threadIndex;
+}
+
+/////////////////////////////////////////////////
+
+CCpuZone::CCpuZone( const char* name )
+	: m_name( name )
+	, m_depth( t_zoneDepth++ )
+	, m_start( CTimer::Clock::now() )
+{
+}
+
+CCpuZone::~CCpuZone()
+{
+	--t_zoneDepth;
+	CCpuProfiler::RecordZone( m_name, m_depth, m_start, CTimer::Clock::now() );
+}
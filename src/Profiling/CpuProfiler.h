@@ -0,0 +1,64 @@
+#pragma once
+#include "Profiling/FrameHistory.h"
+#include "Utils/Timer.h"
+
+#include <mutex>
+
+//Collects named CPU zones for the current frame from any thread. Zones are coarse
+//(passes, waits, submits) so a mutex per zone is cheap enough.
+class CCpuProfiler
+{
+public:
+	struct SZoneResult
+	{
+		const char* name;
+		uint32_t depth;
+		uint32_t threadIndex;
+		//relative to the start of the frame
+		double startMilliseconds;
+		double durationMilliseconds;
+	};
+
+public:
+	CCpuProfiler() = delete;
+
+	//closes the previous frame and makes its zones available through GetLastFrameZones
+	static void BeginFrame();
+
+	static void RecordZone( const char* name, uint32_t depth, CTimer::Clock::time_point start, CTimer::Clock::time_point end );
+
+	static std::vector<SZoneResult> GetLastFrameZones();
+	static CFrameHistory GetFrameHistory();
+
+private:
+	static uint32_t GetThreadIndex();
+
+	static std::mutex mutex_;
+	static CTimer::Clock::time_point frameStart_;
+	static std::vector<SZoneResult> currentZones_;
+	static std::vector<SZoneResult> lastFrameZones_;
+	static CFrameHistory frameHistory_;
+	static uint32_t threadCount_;
+};
+
+//Times its own scope into the current frame
+class CCpuZone
+{
+public:
+	explicit CCpuZone( const char* name );
+	~CCpuZone();
+
+	CCpuZone( const CCpuZone& ) = delete;
+	CCpuZone& operator=( const CCpuZone& ) = delete;
+
+private:
+	const char* m_name;
+	uint32_t m_depth;
+	CTimer::Clock::time_point m_start;
+};
+
+#define VS_PROFILE_CONCAT_INNER( a, b ) a##b
+#define VS_PROFILE_CONCAT( a, b ) VS_PROFILE_CONCAT_INNER( a, b )
+
+//name must be a string literal, or otherwise outlive the frame
+#define VS_PROFILE_SCOPE( name ) CCpuZone VS_PROFILE_CONCAT( cpuZone, __LINE__ )( name )
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+
+//Fixed ring of the most recent per-frame values, laid out the way ImGui::PlotLines expects
+class CFrameHistory
+{
+public:
+	static constexpr uint32_t SIZE = 240;
+
+	CFrameHistory()
+		: m_values {}
+		, m_offset( 0 )
+		, m_count( 0 )
+	{
+	}
+
+	inline void push( float value )
+	{
+		m_values[ m_offset ] = value;
+		m_offset = ( m_offset + 1 ) % SIZE;
+		m_count = std::min( m_count + 1, SIZE );
+	}
+
+	inline const float* getValues() const
+	{
+		return m_values.data();
+	}
+
+	//index of the oldest value once the ring has wrapped
+	inline uint32_t getOffset() const
+	{
+		return m_offset;
+	}
+
+	//values filled so far, at most SIZE
+	inline uint32_t getCount() const
+	{
+		return m_count;
+	}
+
+	inline float getLatest() const
+	{
+		return m_values[ ( m_offset + SIZE - 1 ) % SIZE ];
+	}
+
+	float getAverage() const
+	{
+		float sum = 0.0f;
+		for( uint32_t i = 0; i < m_count; ++i )
+		{
+			sum += m_values[ i ];
+		}
+		return m_count > 0 ? sum / m_count : 0.0f;
+	}
+
+	float getMax() const
+	{
+		float maxValue = 0.0f;
+		for( uint32_t i = 0; i < m_count; ++i )
+		{
+			maxValue = std::max( maxValue, m_values[ i ] );
+		}
+		return maxValue;
+	}
+
+private:
+	std::array<float, SIZE> m_values;
+	uint32_t m_offset;
+	uint32_t m_count;
+};
@@ -0,0 +1,146 @@
+#include "vkpch.h"
+#include "GpuProfiler.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+CGpuProfiler::CGpuProfiler()
+	: m_device( nullptr )
+	, m_supported( false )
+	, m_timestampPeriodMilliseconds( 0.0 )
+	, m_timestampMask( 0 )
+	, m_maxZones( 0 )
+	, m_pCurrentFrame( nullptr )
+	, m_depth( 0 )
+{
+}
+
+void CGpuProfiler::init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t maxZonesPerFrame )
+{
+	m_device = device;
+	m_maxZones = std::max( maxZonesPerFrame, 1u );
+
+	const vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+	const std::vector<vk::QueueFamilyProperties> queueFamilies = physicalDevice.getQueueFamilyProperties();
+	const uint32_t validBits = queueFamilies[ queueFamilyIndex ].timestampValidBits;
+
+	m_supported = ( validBits > 0 ) && ( properties.limits.timestampPeriod > 0.0f );
+	if( !m_supported )
+	{
+		VS_WARN( "Queue family {0} does not support timestamps, GPU zones are disabled.", queueFamilyIndex );
+		return;
+	}
+
+	m_timestampPeriodMilliseconds = static_cast< double >( properties.limits.timestampPeriod ) * 1e-6;
+	m_timestampMask = ( validBits >= 64 ) ? UINT64_MAX : ( ( 1ull << validBits ) - 1 );
+
+	m_frames.resize( std::max( framesInFlight, 1u ) );
+	for( auto& frame : m_frames )
+	{
+		vk::QueryPoolCreateInfo createInfo( {}, vk::QueryType::eTimestamp, m_maxZones * 2 );
+		frame.queryPool = m_device.createQueryPool( createInfo );
+		frame.zoneNames.resize( m_maxZones );
+		frame.zoneDepths.resize( m_maxZones );
+	}
+
+	m_timestamps.resize( static_cast< size_t >( m_maxZones ) * 2 );
+}
+
+void CGpuProfiler::destroy()
+{
+	for( auto& frame : m_frames )
+	{
+		m_device.destroyQueryPool( frame.queryPool );
+	}
+	m_frames.clear();
+	m_pCurrentFrame = nullptr;
+}
+
+void CGpuProfiler::beginFrame( uint32_t frameIndex, const vk::CommandBuffer& commandBuffer )
+{
+	if( !m_supported )
+	{
+		return;
+	}
+
+	SFrameQueries& frame = m_frames[ frameIndex % m_frames.size() ];
+	readResults( frame );
+
+	commandBuffer.resetQueryPool( frame.queryPool, 0, m_maxZones * 2 );
+	frame.zoneCount = 0;
+
+	m_pCurrentFrame = &frame;
+	m_depth = 0;
+}
+
+uint32_t CGpuProfiler::beginZone( const vk::CommandBuffer& commandBuffer, const char* name )
+{
+	if( !m_pCurrentFrame || m_pCurrentFrame->zoneCount >= m_maxZones )
+	{
+		return INVALID_ZONE;
+	}
+
+	const uint32_t zone = m_pCurrentFrame->zoneCount++;
+	m_pCurrentFrame->zoneNames[ zone ] = name;
+	m_pCurrentFrame->zoneDepths[ zone ] = m_depth++;
+
+	commandBuffer.writeTimestamp( vk::PipelineStageFlagBits::eTopOfPipe, m_pCurrentFrame->queryPool, zone * 2 );
+	return zone;
+}
+
+void CGpuProfiler::endZone( const vk::CommandBuffer& commandBuffer, uint32_t zone )
+{
+	if( zone == INVALID_ZONE || !m_pCurrentFrame )
+	{
+		return;
+	}
+
+	--m_depth;
+	commandBuffer.writeTimestamp( vk::PipelineStageFlagBits::eBottomOfPipe, m_pCurrentFrame->queryPool, zone * 2 + 1 );
+}
+
+/////////////////////////////////////////////////
+
+void CGpuProfiler::readResults( SFrameQueries& frame )
+{
+	if( frame.zoneCount == 0 )
+	{
+		return;
+	}
+
+	//no wait flag, the fence already guarantees the queries are done
+	const uint32_t queryCount = frame.zoneCount * 2;
+	const vk::Result result = m_device.getQueryPoolResults( frame.queryPool, 0, queryCount, queryCount * sizeof( uint64_t ),
+		m_timestamps.data(), sizeof( uint64_t ), vk::QueryResultFlagBits::e64 );
+
+	if( result != vk::Result::eSuccess )
+	{
+		return;
+	}
+
+	uint64_t frameBegin = UINT64_MAX;
+	uint64_t frameEnd = 0;
+	for( uint32_t i = 0; i < queryCount; ++i )
+	{
+		m_timestamps[ i ] &= m_timestampMask;
+		frameBegin = std::min( frameBegin, m_timestamps[ i ] );
+		frameEnd = std::max( frameEnd, m_timestamps[ i ] );
+	}
+
+	m_lastFrameZones.clear();
+	for( uint32_t zone = 0; zone < frame.zoneCount; ++zone )
+	{
+		const uint64_t begin = m_timestamps[ zone * 2 ];
+		const uint64_t end = std::max( m_timestamps[ zone * 2 + 1 ], begin );
+
+		SZoneResult zoneResult;
+		zoneResult.name = frame.zoneNames[ zone ];
+		zoneResult.depth = frame.zoneDepths[ zone ];
+		zoneResult.startMilliseconds = ( begin - frameBegin ) * m_timestampPeriodMilliseconds;
+		zoneResult.durationMilliseconds = ( end - begin ) * m_timestampPeriodMilliseconds;
+		m_lastFrameZones.push_back( zoneResult );
+	}
+
+	m_frameHistory.push( static_cast< float >( ( frameEnd - frameBegin ) * m_timestampPeriodMilliseconds ) );
+}
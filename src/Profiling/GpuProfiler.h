@@ -0,0 +1,104 @@
+#pragma once
+#include "Profiling/FrameHistory.h"
+#include <vulkan/vulkan.hpp>
+
+//Times regions of a frame's command buffer with timestamp queries. Each frame in flight
+//owns its query pool, which is only read back once that frame's fence has signaled,
+//so reading results never waits on the GPU.
+class CGpuProfiler
+{
+public:
+	static constexpr uint32_t DEFAULT_MAX_ZONES = 64;
+	static constexpr uint32_t INVALID_ZONE = UINT32_MAX;
+
+	struct SZoneResult
+	{
+		const char* name;
+		uint32_t depth;
+		//relative to the first timestamp of the frame
+		double startMilliseconds;
+		double durationMilliseconds;
+	};
+
+public:
+	CGpuProfiler();
+
+	void init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, uint32_t queueFamilyIndex, uint32_t framesInFlight,
+		uint32_t maxZonesPerFrame = DEFAULT_MAX_ZONES );
+	void destroy();
+
+	//reads back the results this frame slot produced last time and resets its queries.
+	//Call right after beginning the command buffer, once the slot's fence has signaled.
+	void beginFrame( uint32_t frameIndex, const vk::CommandBuffer& commandBuffer );
+
+	//zone names must be string literals, or otherwise outlive the frame
+	uint32_t beginZone( const vk::CommandBuffer& commandBuffer, const char* name );
+	void endZone( const vk::CommandBuffer& commandBuffer, uint32_t zone );
+
+	inline bool isSupported() const
+	{
+		return m_supported;
+	}
+
+	//zones of the most recent frame that finished on the GPU
+	inline const std::vector<SZoneResult>& getLastFrameZones() const
+	{
+		return m_lastFrameZones;
+	}
+
+	//first to last timestamp of each finished frame
+	inline const CFrameHistory& getFrameHistory() const
+	{
+		return m_frameHistory;
+	}
+
+private:
+	struct SFrameQueries
+	{
+		vk::QueryPool queryPool;
+		std::vector<const char*> zoneNames;
+		std::vector<uint32_t> zoneDepths;
+		uint32_t zoneCount = 0;
+	};
+
+	void readResults( SFrameQueries& frame );
+
+	vk::Device m_device;
+	bool m_supported;
+	double m_timestampPeriodMilliseconds;
+	uint64_t m_timestampMask;
+	uint32_t m_maxZones;
+
+	std::vector<SFrameQueries> m_frames;
+	SFrameQueries* m_pCurrentFrame;
+	uint32_t m_depth;
+
+	std::vector<SZoneResult> m_lastFrameZones;
+	std::vector<uint64_t> m_timestamps;
+	CFrameHistory m_frameHistory;
+};
+
+//Times its own scope on the GPU
+class CGpuZone
+{
+public:
+	CGpuZone( CGpuProfiler& profiler, const vk::CommandBuffer& commandBuffer, const char* name )
+		: m_profiler( profiler )
+		, m_commandBuffer( commandBuffer )
+		, m_zone( profiler.beginZone( commandBuffer, name ) )
+	{
+	}
+
+	~CGpuZone()
+	{
+		m_profiler.endZone( m_commandBuffer, m_zone );
+	}
+
+	CGpuZone( const CGpuZone& ) = delete;
+	CGpuZone& operator=( const CGpuZone& ) = delete;
+
+private:
+	CGpuProfiler& m_profiler;
+	vk::CommandBuffer m_commandBuffer;
+	uint32_t m_zone;
+};
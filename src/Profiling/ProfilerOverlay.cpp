@@ -0,0 +1,221 @@
+#include "vkpch.h"
+#include "ProfilerOverlay.h"
+
+#include "Profiling/CpuProfiler.h"
+#include "Memory/ResidencyManager.h"
+#include "Profiling/GpuProfiler.h"
+
+#include <imgui.h>
+#include <backends/imgui_impl_glfw.h>
+#include <backends/imgui_impl_vulkan.h>
+
+/////////////////////////////////////////////////
+
+const ImVec2 FRAME_GRAPH_SIZE( 320.0f, 60.0f );
+const ImVec2 ZONE_BAR_SIZE( 100.0f, 0.0f );
+const ImVec2 HEAP_BAR_SIZE( 200.0f, 0.0f );
+const double BYTES_PER_MIB = 1024.0 * 1024.0;
+
+
+static void checkImGuiVkResult( VkResult result )
+{
+	if( result < 0 )
+	{
+		throw std::runtime_error( "ImGui Vulkan backend call failed." );
+	}
+}
+
+static void drawFrameGraph( const char* label, const CFrameHistory& history )
+{
+	const float average = history.getAverage();
+	const float maxValue = history.getMax();
+
+	char overlay[ 64 ];
+	snprintf( overlay, sizeof( overlay ), "avg %.2f ms  max %.2f ms", average, maxValue );
+
+	ImGui::Text( "%s %.2f ms (%.0f fps)", label, history.getLatest(), average > 0.0f ? 1000.0f / average : 0.0f );
+	ImGui::PlotLines( label, history.getValues(), CFrameHistory::SIZE, history.getOffset(), overlay, 0.0f, std::max( maxValue * 1.2f, 1.0f ), FRAME_GRAPH_SIZE );
+}
+
+static void drawLatencyGraph( const CFrameHistory& history )
+{
+	const float maxValue = history.getMax();
+
+	char overlay[ 64 ];
+	snprintf( overlay, sizeof( overlay ), "avg %.2f ms  max %.2f ms", history.getAverage(), maxValue );
+
+	ImGui::Text( "Input to present %.2f ms", history.getLatest() );
+	ImGui::PlotLines( "Latency", history.getValues(), CFrameHistory::SIZE, history.getOffset(), overlay, 0.0f, std::max( maxValue * 1.2f, 1.0f ), FRAME_GRAPH_SIZE );
+}
+
+//bar shows each zone's share of the frame
+template< typename TZone >
+static void drawZone( const TZone& zone, double frameMilliseconds, const char* prefix )
+{
+	const float fraction = frameMilliseconds > 0.0 ? static_cast< float >( zone.durationMilliseconds / frameMilliseconds ) : 0.0f;
+
+	ImGui::ProgressBar( std::min( fraction, 1.0f ), ZONE_BAR_SIZE, "" );
+	ImGui::SameLine();
+	ImGui::Text( "%s%*s%-24s %8.3f ms", prefix, static_cast< int >( zone.depth * 2 ), "", zone.name, zone.durationMilliseconds );
+}
+
+//bar shows each heap's usage against its budget
+static void drawResidency( const CResidencyManager& residency )
+{
+	const CResidencyManager::SStats stats = residency.getStats();
+	const std::vector<CResidencyManager::SHeapBudget> heaps = residency.getHeapBudgets();
+
+	char overlay[ 64 ];
+	for( size_t heapIndex = 0; heapIndex < heaps.size(); ++heapIndex )
+	{
+		const CResidencyManager::SHeapBudget& heap = heaps[ heapIndex ];
+		const float fraction = heap.budget > 0 ? static_cast< float >( static_cast< double >( heap.usage ) / static_cast< double >( heap.budget ) ) : 0.0f;
+
+		snprintf( overlay, sizeof( overlay ), "%.0f / %.0f MiB", heap.usage / BYTES_PER_MIB, heap.budget / BYTES_PER_MIB );
+		ImGui::ProgressBar( std::min( fraction, 1.0f ), HEAP_BAR_SIZE, overlay );
+		ImGui::SameLine();
+		ImGui::Text( "heap %zu%s, pressure %s", heapIndex, heap.deviceLocal ? " (device local)" : "", CResidencyManager::GetPressureName( heap.pressure ) );
+	}
+
+	ImGui::Text( "Budget from %s", stats.budgetExtension ? "VK_EXT_memory_budget" : "heap sizes" );
+	ImGui::Text( "Streamable %u (%.1f MiB), used last frame %u (%.1f MiB)",
+		stats.resources, stats.resourceBytes / BYTES_PER_MIB, stats.resourcesUsedLastFrame, stats.bytesUsedLastFrame / BYTES_PER_MIB );
+	ImGui::Text( "Evicted %llu (%.1f MiB), %u last frame, %llu allocations refused",
+		static_cast< unsigned long long >( stats.evictions ), stats.evictedBytes / BYTES_PER_MIB, stats.evictionsLastFrame,
+		static_cast< unsigned long long >( stats.refusedAllocations ) );
+}
+
+/////////////////////////////////////////////////
+
+CProfilerOverlay::CProfilerOverlay()
+	: m_device( nullptr )
+	, m_initialized( false )
+{
+}
+
+void CProfilerOverlay::init( const SInitInfo& initInfo )
+{
+	m_device = initInfo.device;
+
+	//the font atlas is the only texture the overlay binds
+	vk::DescriptorPoolSize poolSize( vk::DescriptorType::eCombinedImageSampler, 16 );
+	vk::DescriptorPoolCreateInfo poolCreateInfo( vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 16, 1, &poolSize );
+	m_descriptorPool = m_device.createDescriptorPool( poolCreateInfo );
+
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGui::GetIO().IniFilename = nullptr;
+	ImGui::StyleColorsDark();
+
+	ImGui_ImplGlfw_InitForVulkan( initInfo.pWindow, true );
+
+	ImGui_ImplVulkan_InitInfo vulkanInitInfo {};
+	vulkanInitInfo.Instance = static_cast< VkInstance >( initInfo.instance );
+	vulkanInitInfo.PhysicalDevice = static_cast< VkPhysicalDevice >( initInfo.physicalDevice );
+	vulkanInitInfo.Device = static_cast< VkDevice >( initInfo.device );
+	vulkanInitInfo.QueueFamily = initInfo.queueFamilyIndex;
+	vulkanInitInfo.Queue = static_cast< VkQueue >( initInfo.queue );
+	vulkanInitInfo.PipelineCache = static_cast< VkPipelineCache >( initInfo.pipelineCache );
+	vulkanInitInfo.DescriptorPool = static_cast< VkDescriptorPool >( m_descriptorPool );
+	vulkanInitInfo.MinImageCount = std::max( initInfo.minImageCount, 2u );
+	vulkanInitInfo.ImageCount = std::max( initInfo.imageCount, vulkanInitInfo.MinImageCount );
+	vulkanInitInfo.Subpass = initInfo.subpass;
+	vulkanInitInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+	vulkanInitInfo.CheckVkResultFn = checkImGuiVkResult;
+
+	ImGui_ImplVulkan_Init( &vulkanInitInfo, static_cast< VkRenderPass >( initInfo.renderPass ) );
+
+	uploadFonts( initInfo );
+	m_initialized = true;
+}
+
+void CProfilerOverlay::destroy()
+{
+	if( !m_initialized )
+	{
+		return;
+	}
+
+	ImGui_ImplVulkan_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+
+	m_device.destroyDescriptorPool( m_descriptorPool );
+	m_initialized = false;
+}
+
+void CProfilerOverlay::update( const CGpuProfiler& gpuProfiler, const CFrameHistory* pLatencyHistory, const CResidencyManager* pResidency )
+{
+	ImGui_ImplVulkan_NewFrame();
+	ImGui_ImplGlfw_NewFrame();
+	ImGui::NewFrame();
+
+	ImGui::SetNextWindowPos( ImVec2( 10.0f, 10.0f ), ImGuiCond_FirstUseEver );
+	ImGui::SetNextWindowBgAlpha( 0.8f );
+	if( ImGui::Begin( "Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize ) )
+	{
+		const CFrameHistory cpuHistory = CCpuProfiler::GetFrameHistory();
+		drawFrameGraph( "CPU", cpuHistory );
+
+		if( gpuProfiler.isSupported() )
+		{
+			drawFrameGraph( "GPU", gpuProfiler.getFrameHistory() );
+		}
+
+		if( pLatencyHistory )
+		{
+			drawLatencyGraph( *pLatencyHistory );
+		}
+
+		if( ImGui::CollapsingHeader( "CPU zones", ImGuiTreeNodeFlags_DefaultOpen ) )
+		{
+			char prefix[ 16 ];
+			for( const auto& zone : CCpuProfiler::GetLastFrameZones() )
+			{
+				snprintf( prefix, sizeof( prefix ), "[T%u] ", zone.threadIndex );
+				drawZone( zone, cpuHistory.getLatest(), prefix );
+			}
+		}
+
+		if( gpuProfiler.isSupported() && ImGui::CollapsingHeader( "GPU passes", ImGuiTreeNodeFlags_DefaultOpen ) )
+		{
+			for( const auto& zone : gpuProfiler.getLastFrameZones() )
+			{
+				drawZone( zone, gpuProfiler.getFrameHistory().getLatest(), "" );
+			}
+		}
+
+		if( pResidency && ImGui::CollapsingHeader( "Device memory" ) )
+		{
+			drawResidency( *pResidency );
+		}
+	}
+	ImGui::End();
+
+	ImGui::Render();
+}
+
+void CProfilerOverlay::render( const vk::CommandBuffer& commandBuffer )
+{
+	ImGui_ImplVulkan_RenderDrawData( ImGui::GetDrawData(), static_cast< VkCommandBuffer >( commandBuffer ) );
+}
+
+/////////////////////////////////////////////////
+
+void CProfilerOverlay::uploadFonts( const SInitInfo& initInfo )
+{
+	vk::CommandPool commandPool = m_device.createCommandPool( vk::CommandPoolCreateInfo( vk::CommandPoolCreateFlagBits::eTransient, initInfo.queueFamilyIndex ) );
+	vk::CommandBuffer commandBuffer = m_device.allocateCommandBuffers( vk::CommandBufferAllocateInfo( commandPool, vk::CommandBufferLevel::ePrimary, 1 ) ).front();
+
+	commandBuffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+	ImGui_ImplVulkan_CreateFontsTexture( static_cast< VkCommandBuffer >( commandBuffer ) );
+	commandBuffer.end();
+
+	//one time at startup, waiting here is simpler than tracking the staging buffer
+	vk::SubmitInfo submitInfo( 0, nullptr, nullptr, 1, &commandBuffer );
+	initInfo.queue.submit( submitInfo, nullptr );
+	initInfo.queue.waitIdle();
+
+	ImGui_ImplVulkan_DestroyFontUploadObjects();
+	m_device.destroyCommandPool( commandPool );
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+struct GLFWwindow;
+class CFrameHistory;
+class CGpuProfiler;
+class CResidencyManager;
+
+//ImGui window showing CPU and GPU frame time graphs and the zones of the last frame.
+//Owns the ImGui context and its GLFW and Vulkan backends.
+class CProfilerOverlay
+{
+public:
+	struct SInitInfo
+	{
+		GLFWwindow* pWindow = nullptr;
+		vk::Instance instance;
+		vk::PhysicalDevice physicalDevice;
+		vk::Device device;
+		uint32_t queueFamilyIndex = 0;
+		vk::Queue queue;
+		vk::PipelineCache pipelineCache;
+		//the overlay is drawn in this subpass of the render pass
+		vk::RenderPass renderPass;
+		uint32_t subpass = 0;
+		uint32_t minImageCount = 2;
+		uint32_t imageCount = 2;
+	};
+
+public:
+	CProfilerOverlay();
+
+	void init( const SInitInfo& initInfo );
+	void destroy();
+
+	//builds this frame's UI from the profilers, call once per frame before render.
+	//pLatencyHistory adds a graph of input to present latency, pResidency the device memory budgets.
+	void update( const CGpuProfiler& gpuProfiler, const CFrameHistory* pLatencyHistory = nullptr, const CResidencyManager* pResidency = nullptr );
+	//records the UI into a command buffer inside the overlay's render pass.
+	//Secondary command buffers have to inherit that render pass.
+	void render( const vk::CommandBuffer& commandBuffer );
+
+	inline bool isInitialized() const
+	{
+		return m_initialized;
+	}
+
+private:
+	void uploadFonts( const SInitInfo& initInfo );
+
+	vk::Device m_device;
+	vk::DescriptorPool m_descriptorPool;
+	bool m_initialized;
+};
@@ -0,0 +1,194 @@
+#include "vkpch.h"
+#include "AsyncLogSink.h"
+
+#include "spdlog/pattern_formatter.h"
+
+/////////////////////////////////////////////////
+
+CAsyncLogSink::CAsyncLogSink( size_t queueCapacity )
+	: m_queue( queueCapacity )
+	, m_recordsQueued( 0 )
+	, m_recordsWritten( 0 )
+	, m_recordsDropped( 0 )
+	, m_workerSleeping( false )
+	, m_running( true )
+{
+	m_worker = std::thread( &CAsyncLogSink::workerLoop, this );
+}
+
+CAsyncLogSink::~CAsyncLogSink()
+{
+	stop();
+}
+
+void CAsyncLogSink::addSink( spdlog::sink_ptr pSink )
+{
+	std::lock_guard<std::mutex> lock( m_sinkMutex );
+	m_sinks.push_back( std::move( pSink ) );
+}
+
+void CAsyncLogSink::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_wakeMutex );
+		if( !m_running.exchange( false ) )
+		{
+			return;
+		}
+	}
+	m_wakeCondition.notify_one();
+
+	if( m_worker.joinable() )
+	{
+		m_worker.join();
+	}
+
+	//the worker is gone, this thread is the only consumer now
+	drain();
+
+	std::lock_guard<std::mutex> lock( m_sinkMutex );
+	for( auto& pSink : m_sinks )
+	{
+		pSink->flush();
+	}
+}
+
+CAsyncLogSink::SStats CAsyncLogSink::getStats() const
+{
+	SStats stats;
+	stats.recordsQueued = m_recordsQueued.load( std::memory_order_relaxed );
+	stats.recordsWritten = m_recordsWritten.load( std::memory_order_relaxed );
+	stats.recordsDropped = m_recordsDropped.load( std::memory_order_relaxed );
+	return stats;
+}
+
+void CAsyncLogSink::log( const spdlog::details::log_msg& msg )
+{
+	SRecord record;
+	record.time = msg.time;
+	record.level = msg.level;
+	record.threadId = msg.thread_id;
+	record.loggerName = msg.logger_name;
+	record.payload.assign( msg.payload.data(), msg.payload.size() );
+
+	if( !m_running.load( std::memory_order_acquire ) )
+	{
+		std::lock_guard<std::mutex> lock( m_sinkMutex );
+		writeRecord( record );
+		return;
+	}
+
+	if( !m_queue.tryPush( std::move( record ) ) )
+	{
+		m_recordsDropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+
+	//pairs with the worker publishing m_workerSleeping before it rechecks the counters,
+	//so either the worker sees this record or this thread sees the worker asleep
+	m_recordsQueued.fetch_add( 1, std::memory_order_seq_cst );
+	if( m_workerSleeping.load( std::memory_order_seq_cst ) )
+	{
+		std::lock_guard<std::mutex> lock( m_wakeMutex );
+		m_wakeCondition.notify_one();
+	}
+}
+
+void CAsyncLogSink::flush()
+{
+	if( m_running.load( std::memory_order_acquire ) )
+	{
+		const uint64_t target = m_recordsQueued.load();
+
+		std::unique_lock<std::mutex> lock( m_wakeMutex );
+		m_wakeCondition.notify_one();
+		m_drainedCondition.wait( lock, [ & ]()
+		{
+			return m_recordsWritten.load() >= target || !m_running.load();
+		} );
+	}
+
+	std::lock_guard<std::mutex> lock( m_sinkMutex );
+	for( auto& pSink : m_sinks )
+	{
+		pSink->flush();
+	}
+}
+
+void CAsyncLogSink::set_pattern( const std::string& pattern )
+{
+	set_formatter( std::make_unique<spdlog::pattern_formatter>( pattern ) );
+}
+
+void CAsyncLogSink::set_formatter( std::unique_ptr<spdlog::formatter> pFormatter )
+{
+	std::lock_guard<std::mutex> lock( m_sinkMutex );
+	for( auto& pSink : m_sinks )
+	{
+		pSink->set_formatter( pFormatter->clone() );
+	}
+}
+
+/////////////////////////////////////////////////
+
+void CAsyncLogSink::workerLoop()
+{
+	while( true )
+	{
+		if( drain() > 0 )
+		{
+			{
+				std::lock_guard<std::mutex> lock( m_wakeMutex );
+			}
+			m_drainedCondition.notify_all();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( m_wakeMutex );
+		if( !m_running.load() )
+		{
+			break;
+		}
+
+		m_workerSleeping.store( true, std::memory_order_seq_cst );
+		if( m_recordsQueued.load( std::memory_order_seq_cst ) == m_recordsWritten.load( std::memory_order_seq_cst ) )
+		{
+			m_wakeCondition.wait( lock );
+		}
+		m_workerSleeping.store( false, std::memory_order_relaxed );
+	}
+
+	//release anyone still waiting in flush
+	m_drainedCondition.notify_all();
+}
+
+uint64_t CAsyncLogSink::drain()
+{
+	uint64_t written = 0;
+
+	SRecord record;
+	std::lock_guard<std::mutex> lock( m_sinkMutex );
+	while( m_queue.tryPop( record ) )
+	{
+		writeRecord( record );
+		++written;
+	}
+
+	return written;
+}
+
+void CAsyncLogSink::writeRecord( const SRecord& record )
+{
+	spdlog::details::log_msg msg( record.time, spdlog::source_loc {}, record.loggerName, record.level, spdlog::string_view_t( record.payload ) );
+	msg.thread_id = record.threadId;
+
+	for( auto& pSink : m_sinks )
+	{
+		if( pSink->should_log( msg.level ) )
+		{
+			pSink->log( msg );
+		}
+	}
+
+	m_recordsWritten.fetch_add( 1, std::memory_order_seq_cst );
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Utils/MpscQueue.h"
+
+#include "spdlog/sinks/sink.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//spdlog sink that only copies the record into a lock-free queue. A background thread
+//drains the queue into the downstream sinks, so the logging thread never waits on console
+//or file I/O. Records are dropped, and counted, when the queue is full.
+class CAsyncLogSink : public spdlog::sinks::sink
+{
+public:
+	static constexpr size_t DEFAULT_QUEUE_CAPACITY = 8192;
+
+	struct SStats
+	{
+		uint64_t recordsQueued = 0;
+		uint64_t recordsWritten = 0;
+		uint64_t recordsDropped = 0;
+	};
+
+public:
+	explicit CAsyncLogSink( size_t queueCapacity = DEFAULT_QUEUE_CAPACITY );
+	~CAsyncLogSink() override;
+
+	void addSink( spdlog::sink_ptr pSink );
+	//writes whatever is still queued, then later records go straight to the downstream sinks
+	void stop();
+
+	SStats getStats() const;
+
+	// Inherited via spdlog::sinks::sink
+	void log( const spdlog::details::log_msg& msg ) override;
+	//blocks until every record queued before the call has been written
+	void flush() override;
+	void set_pattern( const std::string& pattern ) override;
+	void set_formatter( std::unique_ptr<spdlog::formatter> pFormatter ) override;
+
+private:
+	struct SRecord
+	{
+		spdlog::log_clock::time_point time;
+		spdlog::level::level_enum level = spdlog::level::off;
+		size_t threadId = 0;
+		spdlog::string_view_t loggerName;
+		std::string payload;
+	};
+
+	void workerLoop();
+	//returns the number of records written
+	uint64_t drain();
+	void writeRecord( const SRecord& record );
+
+	CMpscQueue<SRecord> m_queue;
+
+	std::atomic<uint64_t> m_recordsQueued;
+	std::atomic<uint64_t> m_recordsWritten;
+	std::atomic<uint64_t> m_recordsDropped;
+
+	//guards the downstream sinks, only contended while they are being reconfigured
+	std::mutex m_sinkMutex;
+	std::vector<spdlog::sink_ptr> m_sinks;
+
+	std::thread m_worker;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_drainedCondition;
+	std::atomic<bool> m_workerSleeping;
+	std::atomic<bool> m_running;
+};
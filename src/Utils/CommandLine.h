@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+//Parses the value of a numeric command line option, e.g. "--width 1280". Throws
+//std::invalid_argument naming the option if the value is not a whole number in
+//[minValue, UINT32_MAX], std::stoul alone would take "-1", "12px" or an empty string.
+inline uint32_t parseCountArgument( const std::string& option, const std::string& value, uint32_t minValue = 0 )
+{
+	size_t parsedLength = 0;
+	unsigned long long parsed = 0;
+	try
+	{
+		parsed = std::stoull( value, &parsedLength );
+	}
+	catch( const std::exception& )
+	{
+		parsedLength = 0;
+	}
+
+	if( value.empty() || value.front() == '-' || parsedLength != value.size() || parsed < minValue || parsed > UINT32_MAX )
+	{
+		throw std::invalid_argument( option + " takes a whole number of at least " + std::to_string( minValue ) + ", got '" + value + "'." );
+	}
+
+	return static_cast< uint32_t >( parsed );
+}
@@ -0,0 +1,168 @@
+#include "vkpch.h"
+#include "InstanceTransforms.h"
+
+#include "Profiling/CpuProfiler.h"
+#include "Utils/JobSystem.h"
+
+#include <emmintrin.h>
+
+/////////////////////////////////////////////////
+
+const float PI = 3.14159265358979f;
+
+
+//x in [-pi, pi]. Folded into [-pi/2, pi/2], where sin(x) = sin(pi - x) and cos(x) = -cos(pi - x),
+//then Taylor polynomials up to x^9 and x^8, good to about 3e-5.
+static void sinCos( __m128 x, __m128& sine, __m128& cosine )
+{
+	const __m128 signMask = _mm_castsi128_ps( _mm_set1_epi32( static_cast< int >( 0x80000000 ) ) );
+	const __m128 sign = _mm_and_ps( x, signMask );
+	const __m128 absX = _mm_andnot_ps( signMask, x );
+
+	const __m128 folded = _mm_cmpgt_ps( absX, _mm_set1_ps( PI * 0.5f ) );
+	const __m128 reflected = _mm_or_ps( _mm_sub_ps( _mm_set1_ps( PI ), absX ), sign );
+	x = _mm_or_ps( _mm_and_ps( folded, reflected ), _mm_andnot_ps( folded, x ) );
+
+	const __m128 x2 = _mm_mul_ps( x, x );
+
+	__m128 s = _mm_set1_ps( 1.0f / 362880.0f );
+	s = _mm_add_ps( _mm_mul_ps( s, x2 ), _mm_set1_ps( -1.0f / 5040.0f ) );
+	s = _mm_add_ps( _mm_mul_ps( s, x2 ), _mm_set1_ps( 1.0f / 120.0f ) );
+	s = _mm_add_ps( _mm_mul_ps( s, x2 ), _mm_set1_ps( -1.0f / 6.0f ) );
+	s = _mm_add_ps( _mm_mul_ps( s, x2 ), _mm_set1_ps( 1.0f ) );
+	sine = _mm_mul_ps( s, x );
+
+	__m128 c = _mm_set1_ps( 1.0f / 40320.0f );
+	c = _mm_add_ps( _mm_mul_ps( c, x2 ), _mm_set1_ps( -1.0f / 720.0f ) );
+	c = _mm_add_ps( _mm_mul_ps( c, x2 ), _mm_set1_ps( 1.0f / 24.0f ) );
+	c = _mm_add_ps( _mm_mul_ps( c, x2 ), _mm_set1_ps( -0.5f ) );
+	c = _mm_add_ps( _mm_mul_ps( c, x2 ), _mm_set1_ps( 1.0f ) );
+	cosine = _mm_xor_ps( c, _mm_and_ps( folded, signMask ) );
+}
+
+/////////////////////////////////////////////////
+
+CInstanceTransforms::CInstanceTransforms()
+	: m_count( 0 )
+{
+}
+
+void CInstanceTransforms::reserve( uint32_t count )
+{
+	const size_t paddedCount = ( static_cast< size_t >( count ) + SIMD_WIDTH - 1 ) / SIMD_WIDTH * SIMD_WIDTH;
+	for( std::vector<float>* pField : { &m_positionX, &m_positionY, &m_positionZ, &m_scale, &m_angle, &m_angularVelocity } )
+	{
+		pField->reserve( paddedCount );
+	}
+}
+
+uint32_t CInstanceTransforms::add( const SInstance& instance )
+{
+	//a whole batch at a time, the padding instances have zero scale and draw nothing
+	if( m_count == getPaddedCount() )
+	{
+		for( std::vector<float>* pField : { &m_positionX, &m_positionY, &m_positionZ, &m_scale, &m_angle, &m_angularVelocity } )
+		{
+			pField->resize( pField->size() + SIMD_WIDTH, 0.0f );
+		}
+	}
+
+	m_positionX[ m_count ] = instance.position.x;
+	m_positionY[ m_count ] = instance.position.y;
+	m_positionZ[ m_count ] = instance.position.z;
+	m_scale[ m_count ] = instance.scale;
+	//within [-pi, pi] like every angle after an update
+	m_angle[ m_count ] = std::remainder( instance.angle, 2.0f * PI );
+	m_angularVelocity[ m_count ] = instance.angularVelocity;
+	return m_count++;
+}
+
+void CInstanceTransforms::clear()
+{
+	for( std::vector<float>* pField : { &m_positionX, &m_positionY, &m_positionZ, &m_scale, &m_angle, &m_angularVelocity } )
+	{
+		pField->clear();
+	}
+	m_count = 0;
+}
+
+void CInstanceTransforms::update( float deltaSeconds, float* pDst )
+{
+	updateRange( deltaSeconds, 0, getPaddedCount(), pDst );
+}
+
+void CInstanceTransforms::update( float deltaSeconds, float* pDst, CJobSystem& jobSystem, CJobCounter& counter )
+{
+	const uint32_t paddedCount = getPaddedCount();
+	for( uint32_t first = 0; first < paddedCount; first += JOB_BATCH_SIZE )
+	{
+		const uint32_t count = std::min( JOB_BATCH_SIZE, paddedCount - first );
+		jobSystem.run( [ this, deltaSeconds, first, count, pDst ]() { updateRange( deltaSeconds, first, count, pDst ); }, &counter );
+	}
+}
+
+void CInstanceTransforms::updateRange( float deltaSeconds, uint32_t first, uint32_t count, float* pDst )
+{
+	VS_PROFILE_SCOPE( "update instances" );
+
+	const __m128 delta = _mm_set1_ps( deltaSeconds );
+	const __m128 twoPi = _mm_set1_ps( 2.0f * PI );
+	const __m128 inverseTwoPi = _mm_set1_ps( 0.5f / PI );
+	const __m128 zero = _mm_setzero_ps();
+
+	const uint32_t end = first + count;
+	for( uint32_t i = first; i < end; i += SIMD_WIDTH )
+	{
+		//advance and wrap back into [-pi, pi] by the nearest whole turn
+		__m128 angle = _mm_add_ps( _mm_loadu_ps( &m_angle[ i ] ), _mm_mul_ps( _mm_loadu_ps( &m_angularVelocity[ i ] ), delta ) );
+		const __m128 turns = _mm_cvtepi32_ps( _mm_cvtps_epi32( _mm_mul_ps( angle, inverseTwoPi ) ) );
+		angle = _mm_sub_ps( angle, _mm_mul_ps( turns, twoPi ) );
+		_mm_storeu_ps( &m_angle[ i ], angle );
+
+		__m128 sine;
+		__m128 cosine;
+		sinCos( angle, sine, cosine );
+
+		const __m128 scale = _mm_loadu_ps( &m_scale[ i ] );
+		const __m128 scaledCosine = _mm_mul_ps( scale, cosine );
+		const __m128 scaledSine = _mm_mul_ps( scale, sine );
+
+		//the rows ( s cos, 0, s sin, x ), ( 0, s, 0, y ) and ( -s sin, 0, s cos, z ) of four
+		//instances, one column per register until they are transposed into one row per register
+		__m128 row0X = scaledCosine;
+		__m128 row0Y = zero;
+		__m128 row0Z = scaledSine;
+		__m128 row0W = _mm_loadu_ps( &m_positionX[ i ] );
+		_MM_TRANSPOSE4_PS( row0X, row0Y, row0Z, row0W );
+
+		__m128 row1X = zero;
+		__m128 row1Y = scale;
+		__m128 row1Z = zero;
+		__m128 row1W = _mm_loadu_ps( &m_positionY[ i ] );
+		_MM_TRANSPOSE4_PS( row1X, row1Y, row1Z, row1W );
+
+		__m128 row2X = _mm_sub_ps( zero, scaledSine );
+		__m128 row2Y = zero;
+		__m128 row2Z = scaledCosine;
+		__m128 row2W = _mm_loadu_ps( &m_positionZ[ i ] );
+		_MM_TRANSPOSE4_PS( row2X, row2Y, row2Z, row2W );
+
+		//non temporal, the destination is usually write combined memory the CPU never reads
+		float* pInstance = pDst + static_cast< size_t >( i ) * FLOATS_PER_INSTANCE;
+		_mm_stream_ps( pInstance, row0X );
+		_mm_stream_ps( pInstance + 4, row1X );
+		_mm_stream_ps( pInstance + 8, row2X );
+		_mm_stream_ps( pInstance + 12, row0Y );
+		_mm_stream_ps( pInstance + 16, row1Y );
+		_mm_stream_ps( pInstance + 20, row2Y );
+		_mm_stream_ps( pInstance + 24, row0Z );
+		_mm_stream_ps( pInstance + 28, row1Z );
+		_mm_stream_ps( pInstance + 32, row2Z );
+		_mm_stream_ps( pInstance + 36, row0W );
+		_mm_stream_ps( pInstance + 40, row1W );
+		_mm_stream_ps( pInstance + 44, row2W );
+	}
+
+	//streaming stores are weakly ordered, they have to land before the job counts as done
+	_mm_sfence();
+}
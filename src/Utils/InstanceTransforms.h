@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class CJobCounter;
+class CJobSystem;
+
+//Transforms of many instances in structure of arrays layout, one array per field, each padded
+//to a multiple of SIMD_WIDTH. update() advances and rebuilds SIMD_WIDTH instances at a time
+//with SSE, which every x64 CPU has, and writes each object to world transform as three rows
+//straight into the destination, e.g. a mapped vertex buffer read at instance rate. No matrix
+//is ever built per instance. Large counts are split into jobs of JOB_BATCH_SIZE instances.
+class CInstanceTransforms
+{
+public:
+	static constexpr uint32_t SIMD_WIDTH = 4;
+	//the rows of a 3x4 matrix
+	static constexpr uint32_t FLOATS_PER_INSTANCE = 12;
+	static constexpr uint32_t JOB_BATCH_SIZE = 16384;
+
+	struct SInstance
+	{
+		glm::vec3 position = glm::vec3( 0.0f );
+		float scale = 1.0f;
+		//radians around the y axis
+		float angle = 0.0f;
+		float angularVelocity = 0.0f;
+	};
+
+public:
+	CInstanceTransforms();
+
+	void reserve( uint32_t count );
+	uint32_t add( const SInstance& instance );
+	void clear();
+
+	//pDst is 16 byte aligned and holds getPaddedCount() * FLOATS_PER_INSTANCE floats
+	void update( float deltaSeconds, float* pDst );
+	//same, queued as jobs counted by counter. Neither pDst nor the instances may be touched until it is done.
+	void update( float deltaSeconds, float* pDst, CJobSystem& jobSystem, CJobCounter& counter );
+	//instances [first, first + count), first a multiple of SIMD_WIDTH
+	void updateRange( float deltaSeconds, uint32_t first, uint32_t count, float* pDst );
+
+	inline uint32_t getCount() const
+	{
+		return m_count;
+	}
+
+	inline uint32_t getPaddedCount() const
+	{
+		return static_cast< uint32_t >( m_angle.size() );
+	}
+
+private:
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+	std::vector<float> m_scale;
+	//kept within [-pi, pi]
+	std::vector<float> m_angle;
+	std::vector<float> m_angularVelocity;
+	uint32_t m_count;
+};
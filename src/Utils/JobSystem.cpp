@@ -0,0 +1,428 @@
+#include "vkpch.h"
+#include "JobSystem.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+//jobs a thread can have queued before it falls back to the injection queue
+const size_t JOB_DEQUE_CAPACITY = 4096;
+
+//rounds an idle worker yields before it goes to sleep, waking a thread costs far more
+const uint32_t IDLE_SPIN_ROUNDS = 64;
+
+
+struct SJob
+{
+	CJobSystem::JobFunction function;
+	CJobCounter* pCounter = nullptr;
+	//dependencies not done yet, plus one while run() still registers them
+	std::atomic<uint32_t> pendingDependencies { 0 };
+	//set when a dependency failed, the job is then skipped
+	std::atomic<bool> failed { false };
+	std::exception_ptr pException;
+	uint32_t queuedBy = UINT32_MAX;
+};
+
+static thread_local const CJobSystem* t_pJobSystem = nullptr;
+static thread_local uint32_t t_threadIndex = UINT32_MAX;
+//picks steal victims, any non zero seed will do
+static thread_local uint32_t t_stealSeed = 0x9E3779B9u;
+
+
+static uint32_t nextRandom()
+{
+	//xorshift32
+	t_stealSeed ^= t_stealSeed << 13;
+	t_stealSeed ^= t_stealSeed >> 17;
+	t_stealSeed ^= t_stealSeed << 5;
+	return t_stealSeed;
+}
+
+//the first failing dependency wins, the flag orders the write before the job is released
+static void markFailed( SJob& job, const std::exception_ptr& pException )
+{
+	bool expected = false;
+	if( job.failed.compare_exchange_strong( expected, true, std::memory_order_relaxed ) )
+	{
+		job.pException = pException;
+	}
+}
+
+/////////////////////////////////////////////////
+
+CJobCounter::CJobCounter()
+	: m_pending( 0 )
+	, m_references( 0 )
+{
+}
+
+/////////////////////////////////////////////////
+
+CJobSystem::SThreadState::SThreadState()
+	: deque( JOB_DEQUE_CAPACITY )
+	, jobsRun( 0 )
+	, jobsStolen( 0 )
+	, jobsRunWhileWaiting( 0 )
+{
+}
+
+CJobSystem::CJobSystem()
+	: m_injectedJobs( 0 )
+	, m_queuedJobs( 0 )
+	, m_sleepingThreads( 0 )
+	, m_stop( false )
+{
+}
+
+CJobSystem::~CJobSystem()
+{
+	destroy();
+}
+
+void CJobSystem::init( uint32_t threadCount )
+{
+	if( threadCount == 0 )
+	{
+		threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+	}
+
+	m_stop.store( false );
+	m_threads.resize( threadCount );
+	for( auto& pThread : m_threads )
+	{
+		pThread = std::make_unique<SThreadState>();
+	}
+
+	//the caller is thread 0, it runs jobs while it waits
+	t_pJobSystem = this;
+	t_threadIndex = 0;
+
+	for( uint32_t threadIndex = 1; threadIndex < threadCount; ++threadIndex )
+	{
+		m_threads[ threadIndex ]->thread = std::thread( &CJobSystem::workerLoop, this, threadIndex );
+	}
+
+	VS_INFO( "Job system using {0} threads.", threadCount );
+}
+
+void CJobSystem::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_sleepMutex );
+		m_stop.store( true );
+	}
+	m_wakeCondition.notify_all();
+
+	for( auto& pThread : m_threads )
+	{
+		if( pThread->thread.joinable() )
+		{
+			pThread->thread.join();
+		}
+	}
+
+	//nobody waits for what is left anymore, every thread is joined so the owner side is free
+	SJob* pJob = nullptr;
+	for( auto& pThread : m_threads )
+	{
+		while( pThread->deque.tryPop( pJob ) )
+		{
+			delete pJob;
+		}
+	}
+
+	for( SJob* pInjected : m_injectionQueue )
+	{
+		delete pInjected;
+	}
+	m_injectionQueue.clear();
+	m_injectedJobs.store( 0 );
+	m_queuedJobs.store( 0 );
+
+	m_threads.clear();
+
+	if( t_pJobSystem == this )
+	{
+		t_pJobSystem = nullptr;
+		t_threadIndex = UINT32_MAX;
+	}
+}
+
+void CJobSystem::run( JobFunction function, CJobCounter* pCounter, std::initializer_list<CJobCounter*> dependencies )
+{
+	SJob* pJob = new SJob;
+	pJob->function = std::move( function );
+	pJob->pCounter = pCounter;
+	pJob->queuedBy = getThreadIndex();
+	pJob->pendingDependencies.store( static_cast< uint32_t >( dependencies.size() ) + 1, std::memory_order_relaxed );
+
+	if( pCounter )
+	{
+		pCounter->m_pending.fetch_add( 1 );
+		pCounter->m_references.fetch_add( 1 );
+	}
+
+	for( CJobCounter* pDependency : dependencies )
+	{
+		std::lock_guard<std::mutex> lock( pDependency->m_mutex );
+		if( pDependency->m_pending.load() > 0 )
+		{
+			//released by the dependency's last job
+			pDependency->m_dependents.push_back( pJob );
+			continue;
+		}
+
+		if( pDependency->m_pException )
+		{
+			markFailed( *pJob, pDependency->m_pException );
+		}
+		pJob->pendingDependencies.fetch_sub( 1, std::memory_order_acq_rel );
+	}
+
+	if( pJob->pendingDependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	{
+		schedule( pJob );
+	}
+}
+
+void CJobSystem::wait( CJobCounter& counter )
+{
+	const uint32_t threadIndex = getThreadIndex();
+
+	while( !counter.isDone() )
+	{
+		//the jobs still missing run elsewhere, or wait for dependencies
+		if( !runOneJob( threadIndex, true ) )
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	std::exception_ptr pException;
+	{
+		std::lock_guard<std::mutex> lock( counter.m_mutex );
+		pException.swap( counter.m_pException );
+	}
+
+	if( pException )
+	{
+		std::rethrow_exception( pException );
+	}
+}
+
+uint32_t CJobSystem::getThreadIndex() const
+{
+	return ( t_pJobSystem == this ) ? t_threadIndex : UINT32_MAX;
+}
+
+CJobSystem::SStats CJobSystem::getStats() const
+{
+	SStats stats;
+	stats.threadCount = getThreadCount();
+	for( const auto& pThread : m_threads )
+	{
+		stats.jobsRun += pThread->jobsRun.load( std::memory_order_relaxed );
+		stats.jobsStolen += pThread->jobsStolen.load( std::memory_order_relaxed );
+		stats.jobsRunWhileWaiting += pThread->jobsRunWhileWaiting.load( std::memory_order_relaxed );
+	}
+	return stats;
+}
+
+void CJobSystem::logStats() const
+{
+	const SStats stats = getStats();
+	VS_INFO( "Job system: {0} threads, {1} jobs run, {2:.1f}% stolen, {3:.1f}% run while waiting.", stats.threadCount, stats.jobsRun,
+		100.0 * stats.jobsStolen / std::max<uint64_t>( stats.jobsRun, 1 ), 100.0 * stats.jobsRunWhileWaiting / std::max<uint64_t>( stats.jobsRun, 1 ) );
+}
+
+/////////////////////////////////////////////////
+
+void CJobSystem::workerLoop( uint32_t threadIndex )
+{
+	t_pJobSystem = this;
+	t_threadIndex = threadIndex;
+	t_stealSeed = 0x9E3779B9u * ( threadIndex + 1 );
+
+	uint32_t idleRounds = 0;
+	while( !m_stop.load( std::memory_order_relaxed ) )
+	{
+		if( runOneJob( threadIndex, false ) )
+		{
+			idleRounds = 0;
+			continue;
+		}
+
+		if( ++idleRounds < IDLE_SPIN_ROUNDS )
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		//schedule() bumps m_queuedJobs before it reads m_sleepingThreads, and this thread does
+		//the opposite, so either it sees the job or schedule() sees it sleeping and notifies
+		std::unique_lock<std::mutex> lock( m_sleepMutex );
+		m_sleepingThreads.fetch_add( 1 );
+		m_wakeCondition.wait( lock, [ this ]() { return m_queuedJobs.load() > 0 || m_stop.load(); } );
+		m_sleepingThreads.fetch_sub( 1 );
+		idleRounds = 0;
+	}
+}
+
+void CJobSystem::schedule( SJob* pJob )
+{
+	m_queuedJobs.fetch_add( 1 );
+
+	const uint32_t threadIndex = getThreadIndex();
+	if( threadIndex == UINT32_MAX || !m_threads[ threadIndex ]->deque.tryPush( pJob ) )
+	{
+		std::lock_guard<std::mutex> lock( m_injectionMutex );
+		m_injectionQueue.push_back( pJob );
+		m_injectedJobs.fetch_add( 1, std::memory_order_release );
+	}
+
+	if( m_sleepingThreads.load() > 0 )
+	{
+		//taking the lock makes sure a thread about to sleep is either waiting or sees the job
+		{
+			std::lock_guard<std::mutex> lock( m_sleepMutex );
+		}
+		m_wakeCondition.notify_one();
+	}
+}
+
+SJob* CJobSystem::findJob( uint32_t threadIndex, bool& stolen )
+{
+	SJob* pJob = nullptr;
+	const uint32_t threadCount = getThreadCount();
+
+	//newest first from the own deque, its data is most likely still in cache
+	if( threadIndex < threadCount && m_threads[ threadIndex ]->deque.tryPop( pJob ) )
+	{
+		return pJob;
+	}
+
+	if( m_injectedJobs.load( std::memory_order_acquire ) > 0 )
+	{
+		std::lock_guard<std::mutex> lock( m_injectionMutex );
+		if( !m_injectionQueue.empty() )
+		{
+			pJob = m_injectionQueue.front();
+			m_injectionQueue.pop_front();
+			m_injectedJobs.fetch_sub( 1, std::memory_order_relaxed );
+			return pJob;
+		}
+	}
+
+	//random start, so thieves spread over the victims instead of piling onto thread 0
+	if( threadCount > 0 )
+	{
+		const uint32_t start = nextRandom() % threadCount;
+		for( uint32_t i = 0; i < threadCount; ++i )
+		{
+			const uint32_t victim = ( start + i ) % threadCount;
+			if( victim != threadIndex && m_threads[ victim ]->deque.trySteal( pJob ) )
+			{
+				stolen = true;
+				return pJob;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+bool CJobSystem::runOneJob( uint32_t threadIndex, bool waiting )
+{
+	bool stolen = false;
+	SJob* pJob = findJob( threadIndex, stolen );
+	if( !pJob )
+	{
+		return false;
+	}
+
+	m_queuedJobs.fetch_sub( 1, std::memory_order_relaxed );
+
+	if( threadIndex < getThreadCount() )
+	{
+		SThreadState& thread = *m_threads[ threadIndex ];
+		thread.jobsRun.fetch_add( 1, std::memory_order_relaxed );
+		if( stolen || pJob->queuedBy != threadIndex )
+		{
+			thread.jobsStolen.fetch_add( 1, std::memory_order_relaxed );
+		}
+		if( waiting )
+		{
+			thread.jobsRunWhileWaiting.fetch_add( 1, std::memory_order_relaxed );
+		}
+	}
+
+	execute( pJob );
+	return true;
+}
+
+void CJobSystem::execute( SJob* pJob )
+{
+	std::exception_ptr pException = pJob->pException;
+	if( !pException )
+	{
+		try
+		{
+			pJob->function();
+		}
+		catch( ... )
+		{
+			pException = std::current_exception();
+		}
+	}
+
+	//captures are released before the counter tells anyone the job is done
+	CJobCounter* pCounter = pJob->pCounter;
+	delete pJob;
+
+	if( pCounter )
+	{
+		finish( *pCounter, pException );
+	}
+	else if( pException )
+	{
+		VS_ERROR( "A job without a counter threw, its exception is dropped." );
+	}
+}
+
+void CJobSystem::finish( CJobCounter& counter, const std::exception_ptr& pException )
+{
+	if( pException )
+	{
+		std::lock_guard<std::mutex> lock( counter.m_mutex );
+		if( !counter.m_pException )
+		{
+			counter.m_pException = pException;
+		}
+	}
+
+	std::vector<SJob*> dependents;
+	std::exception_ptr pFailure;
+	if( counter.m_pending.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	{
+		std::lock_guard<std::mutex> lock( counter.m_mutex );
+		dependents.swap( counter.m_dependents );
+		pFailure = counter.m_pException;
+	}
+
+	//last touch of the counter, a waiter may destroy it right after
+	counter.m_references.fetch_sub( 1, std::memory_order_acq_rel );
+
+	for( SJob* pDependent : dependents )
+	{
+		if( pFailure )
+		{
+			markFailed( *pDependent, pFailure );
+		}
+
+		if( pDependent->pendingDependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+		{
+			schedule( pDependent );
+		}
+	}
+}
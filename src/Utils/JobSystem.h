@@ -0,0 +1,135 @@
+#pragma once
+#include "Utils/WorkStealingDeque.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class CJobSystem;
+struct SJob;
+
+//Tracks a group of jobs: it counts the jobs that were run with it and have not finished yet.
+//Jobs can depend on counters, and CJobSystem::wait() blocks on one. A counter must stay
+//alive until it is done, and may be reused once it is.
+class CJobCounter
+{
+public:
+	CJobCounter();
+
+	CJobCounter( const CJobCounter& ) = delete;
+	CJobCounter& operator=( const CJobCounter& ) = delete;
+
+	//every job run with this counter has finished
+	inline bool isDone() const
+	{
+		return m_references.load( std::memory_order_acquire ) == 0;
+	}
+
+private:
+	friend class CJobSystem;
+
+	//jobs that have not finished running, dependents start when it reaches zero
+	std::atomic<uint32_t> m_pending;
+	//same, but only released once a finishing job no longer touches the counter
+	std::atomic<uint32_t> m_references;
+
+	std::mutex m_mutex;
+	std::vector<SJob*> m_dependents;
+	//first exception a job of this counter threw, rethrown by wait()
+	std::exception_ptr m_pException;
+};
+
+//Runs small jobs on one thread per core. Every thread owns a work-stealing deque: jobs it
+//runs go to the bottom of its own deque and idle threads steal from the top of the others,
+//so fan-out stays local while the load still spreads. Threads that are not part of the
+//system queue into a shared injection queue instead.
+//The thread that calls init() is thread 0 and runs jobs whenever it waits, like any thread
+//that waits from inside a job, so a wait never just blocks a core.
+class CJobSystem
+{
+public:
+	using JobFunction = std::function<void()>;
+
+	struct SStats
+	{
+		uint32_t threadCount = 0;
+		uint64_t jobsRun = 0;
+		//run by another thread than the one that queued them
+		uint64_t jobsStolen = 0;
+		//run by a thread that was waiting on a counter
+		uint64_t jobsRunWhileWaiting = 0;
+	};
+
+public:
+	CJobSystem();
+	~CJobSystem();
+
+	CJobSystem( const CJobSystem& ) = delete;
+	CJobSystem& operator=( const CJobSystem& ) = delete;
+
+	//threadCount includes the calling thread, 0 uses one thread per hardware thread
+	void init( uint32_t threadCount = 0 );
+	//jobs still queued are dropped, jobs that are running are finished first
+	void destroy();
+
+	//pCounter, if any, counts the job until it finished. The job starts only once every
+	//counter in dependencies is done; if a job of one of them threw, this job is skipped
+	//and the exception is passed on to pCounter.
+	void run( JobFunction function, CJobCounter* pCounter = nullptr, std::initializer_list<CJobCounter*> dependencies = {} );
+
+	//runs other jobs until the counter is done, then rethrows the first exception of its jobs
+	void wait( CJobCounter& counter );
+
+	inline bool isInitialized() const
+	{
+		return !m_threads.empty();
+	}
+
+	inline uint32_t getThreadCount() const
+	{
+		return static_cast< uint32_t >( m_threads.size() );
+	}
+
+	//index of the calling thread, UINT32_MAX if it does not belong to this system
+	uint32_t getThreadIndex() const;
+
+	SStats getStats() const;
+	void logStats() const;
+
+private:
+	struct alignas( 64 ) SThreadState
+	{
+		SThreadState();
+
+		CWorkStealingDeque<SJob*> deque;
+		std::thread thread;
+
+		std::atomic<uint64_t> jobsRun;
+		std::atomic<uint64_t> jobsStolen;
+		std::atomic<uint64_t> jobsRunWhileWaiting;
+	};
+
+	void workerLoop( uint32_t threadIndex );
+	void schedule( SJob* pJob );
+	SJob* findJob( uint32_t threadIndex, bool& stolen );
+	bool runOneJob( uint32_t threadIndex, bool waiting );
+	void execute( SJob* pJob );
+	void finish( CJobCounter& counter, const std::exception_ptr& pException );
+
+	std::vector<std::unique_ptr<SThreadState>> m_threads;
+
+	//jobs queued by threads outside the system, and by threads whose deque is full
+	std::mutex m_injectionMutex;
+	std::deque<SJob*> m_injectionQueue;
+	std::atomic<size_t> m_injectedJobs;
+
+	//jobs sitting in any queue, idle threads sleep while it is zero
+	std::atomic<uint64_t> m_queuedJobs;
+	std::atomic<uint32_t> m_sleepingThreads;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<bool> m_stop;
+};
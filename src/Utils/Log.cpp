@@ -1,17 +1,111 @@
 #include "vkpch.h"
 #include "Log.h"
 
+#include "Utils/AsyncLogSink.h"
+#include "Utils/MessageRateLimiter.h"
+
 #include "spdlog/spdlog.h"
 #include"spdlog/sinks/stdout_color_sinks.h"
 
+/////////////////////////////////////////////////
+
+const char* const LOG_PATTERN = "%^[%T] %v%$";
+const char* const CORE_LOGGER_NAME = "VULKAN SANDBOX";
+
+//occurrences of the same message let through per window
+const uint32_t REPEATED_MESSAGE_BURST = 3;
+const std::chrono::seconds REPEATED_MESSAGE_WINDOW( 1 );
+
+/////////////////////////////////////////////////
+
 std::shared_ptr<spdlog::logger> CLog::coreLogger_;
+std::shared_ptr<CAsyncLogSink> CLog::asyncSink_;
+std::unique_ptr<CMessageRateLimiter> CLog::rateLimiter_;
 
-void CLog::Initialize()
+void CLog::Initialize( ELogMode mode )
 {
-	spdlog::set_pattern( "%^[%T] %v%$" );
+	//several apps may run one after another in the same process, e.g. in the benchmark.
+	//After Shutdown the async sink writes on the calling thread, so the logger stays usable.
+	if( coreLogger_ )
+	{
+		return;
+	}
 
-	coreLogger_ = spdlog::stdout_color_mt( "VULKAN SANDBOX" );
+	spdlog::set_pattern( LOG_PATTERN );
+
+	rateLimiter_ = std::make_unique<CMessageRateLimiter>( REPEATED_MESSAGE_BURST, REPEATED_MESSAGE_WINDOW );
+
+	if( mode == ELogMode::Asynchronous )
+	{
+		asyncSink_ = std::make_shared<CAsyncLogSink>();
+		asyncSink_->addSink( std::make_shared<spdlog::sinks::stdout_color_sink_mt>() );
+
+		coreLogger_ = std::make_shared<spdlog::logger>( CORE_LOGGER_NAME, asyncSink_ );
+		coreLogger_->set_pattern( LOG_PATTERN );
+		spdlog::register_logger( coreLogger_ );
+	}
+	else
+	{
+		coreLogger_ = spdlog::stdout_color_mt( CORE_LOGGER_NAME );
+	}
 	coreLogger_->set_level( spdlog::level::trace );
 
-	VS_INFO( "Logger Initialized." );
-}
\ No newline at end of file
+	VS_INFO( "Logger Initialized ({0}).", mode == ELogMode::Asynchronous ? "async" : "sync" );
+}
+
+void CLog::Shutdown()
+{
+	if( !coreLogger_ )
+	{
+		return;
+	}
+
+	const SStats stats = GetStats();
+	if( stats.recordsDropped > 0 || stats.recordsCoalesced > 0 )
+	{
+		VS_INFO( "Log: {0} records dropped, {1} repeated messages coalesced.", stats.recordsDropped, stats.recordsCoalesced );
+	}
+
+	if( asyncSink_ )
+	{
+		asyncSink_->stop();
+	}
+	coreLogger_->flush();
+}
+
+void CLog::AddSink( spdlog::sink_ptr pSink )
+{
+	if( asyncSink_ )
+	{
+		asyncSink_->addSink( std::move( pSink ) );
+	}
+	else
+	{
+		coreLogger_->sinks().push_back( std::move( pSink ) );
+	}
+}
+
+bool CLog::ShouldLogRepeated( uint64_t messageKey, uint32_t& suppressedCount )
+{
+	suppressedCount = 0;
+	return !rateLimiter_ || rateLimiter_->allow( messageKey, suppressedCount );
+}
+
+CLog::SStats CLog::GetStats()
+{
+	SStats stats;
+	if( asyncSink_ )
+	{
+		const CAsyncLogSink::SStats sinkStats = asyncSink_->getStats();
+		stats.recordsQueued = sinkStats.recordsQueued;
+		stats.recordsWritten = sinkStats.recordsWritten;
+		stats.recordsDropped = sinkStats.recordsDropped;
+	}
+
+	if( rateLimiter_ )
+	{
+		stats.recordsCoalesced = rateLimiter_->getSuppressedTotal();
+	}
+
+	return stats;
+}
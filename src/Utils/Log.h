@@ -3,11 +3,47 @@
 #include "spdlog/logger.h"
 #include "spdlog/fmt/ostr.h"
 
+class CAsyncLogSink;
+class CMessageRateLimiter;
+
+enum class ELogMode
+{
+	//records are written on the calling thread
+	Synchronous,
+	//records are queued and written by a background thread
+	Asynchronous
+};
+
 class CLog
 {
+public:
+	struct SStats
+	{
+		uint64_t recordsQueued = 0;
+		uint64_t recordsWritten = 0;
+		//lost because the async queue was full
+		uint64_t recordsDropped = 0;
+		//repeated messages swallowed by ShouldLogRepeated
+		uint64_t recordsCoalesced = 0;
+	};
+
 public:
 	CLog() = delete;
-	static void Initialize();
+	static void Initialize( ELogMode mode = ELogMode::Asynchronous );
+	//writes everything still queued and stops the background thread
+	static void Shutdown();
+
+	static void AddSink( spdlog::sink_ptr pSink );
+
+	//rate limits messages that repeat under the same key, see CMessageRateLimiter
+	static bool ShouldLogRepeated( uint64_t messageKey, uint32_t& suppressedCount );
+
+	static SStats GetStats();
+
+	inline static bool IsAsynchronous()
+	{
+		return asyncSink_ != nullptr;
+	}
 
 	inline static std::shared_ptr<spdlog::logger> GetCoreLogger()
 	{
@@ -16,6 +52,8 @@ public:
 
 private:
 	static std::shared_ptr<spdlog::logger> coreLogger_;
+	static std::shared_ptr<CAsyncLogSink> asyncSink_;
+	static std::unique_ptr<CMessageRateLimiter> rateLimiter_;
 };
 
 
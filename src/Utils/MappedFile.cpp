@@ -0,0 +1,159 @@
+#include "vkpch.h"
+#include "MappedFile.h"
+
+#ifdef VKS_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/////////////////////////////////////////////////
+
+CMappedFile::CMappedFile()
+	: m_pData( nullptr )
+	, m_size( 0 )
+#ifdef VKS_WINDOWS
+	, m_fileHandle( INVALID_HANDLE_VALUE )
+	, m_mappingHandle( nullptr )
+#else
+	, m_fileDescriptor( -1 )
+#endif
+{
+}
+
+CMappedFile::~CMappedFile()
+{
+	close();
+}
+
+#ifdef VKS_WINDOWS
+
+void CMappedFile::open( const std::string& filePath )
+{
+	close();
+
+	//sequential scan makes the cache manager read ahead more aggressively
+	m_fileHandle = CreateFileW( std::filesystem::path( filePath ).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if( m_fileHandle == INVALID_HANDLE_VALUE )
+	{
+		throw std::runtime_error( "Failed to open '" + filePath + "'." );
+	}
+
+	LARGE_INTEGER size {};
+	if( !GetFileSizeEx( m_fileHandle, &size ) || size.QuadPart == 0 )
+	{
+		close();
+		throw std::runtime_error( "'" + filePath + "' is empty or its size is unknown." );
+	}
+	m_size = static_cast< uint64_t >( size.QuadPart );
+
+	m_mappingHandle = CreateFileMappingW( m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	m_pData = m_mappingHandle ? static_cast< const uint8_t* >( MapViewOfFile( m_mappingHandle, FILE_MAP_READ, 0, 0, 0 ) ) : nullptr;
+	if( !m_pData )
+	{
+		close();
+		throw std::runtime_error( "Failed to map '" + filePath + "'." );
+	}
+}
+
+void CMappedFile::close()
+{
+	if( m_pData )
+	{
+		UnmapViewOfFile( m_pData );
+	}
+	if( m_mappingHandle )
+	{
+		CloseHandle( m_mappingHandle );
+	}
+	if( m_fileHandle != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( m_fileHandle );
+	}
+
+	m_pData = nullptr;
+	m_size = 0;
+	m_mappingHandle = nullptr;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+}
+
+void CMappedFile::prefetch( uint64_t offset, uint64_t size ) const
+{
+	if( !m_pData || offset >= m_size )
+	{
+		return;
+	}
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast< uint8_t* >( m_pData + offset );
+	range.NumberOfBytes = static_cast< SIZE_T >( std::min( size, m_size - offset ) );
+	//only a hint, failing leaves the pages to be faulted in on use
+	PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+}
+
+#else
+
+void CMappedFile::open( const std::string& filePath )
+{
+	close();
+
+	m_fileDescriptor = ::open( filePath.c_str(), O_RDONLY );
+	if( m_fileDescriptor < 0 )
+	{
+		throw std::runtime_error( "Failed to open '" + filePath + "'." );
+	}
+
+	struct stat fileStat {};
+	if( fstat( m_fileDescriptor, &fileStat ) != 0 || fileStat.st_size == 0 )
+	{
+		close();
+		throw std::runtime_error( "'" + filePath + "' is empty or its size is unknown." );
+	}
+	m_size = static_cast< uint64_t >( fileStat.st_size );
+
+	void* pMapping = mmap( nullptr, static_cast< size_t >( m_size ), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0 );
+	if( pMapping == MAP_FAILED )
+	{
+		close();
+		throw std::runtime_error( "Failed to map '" + filePath + "'." );
+	}
+	m_pData = static_cast< const uint8_t* >( pMapping );
+}
+
+void CMappedFile::close()
+{
+	if( m_pData )
+	{
+		munmap( const_cast< uint8_t* >( m_pData ), static_cast< size_t >( m_size ) );
+	}
+	if( m_fileDescriptor >= 0 )
+	{
+		::close( m_fileDescriptor );
+	}
+
+	m_pData = nullptr;
+	m_size = 0;
+	m_fileDescriptor = -1;
+}
+
+void CMappedFile::prefetch( uint64_t offset, uint64_t size ) const
+{
+	if( !m_pData || offset >= m_size )
+	{
+		return;
+	}
+
+	//madvise wants a page aligned start
+	const uint64_t pageSize = static_cast< uint64_t >( sysconf( _SC_PAGESIZE ) );
+	const uint64_t begin = offset & ~( pageSize - 1 );
+	const uint64_t end = std::min( offset + size, m_size );
+	madvise( const_cast< uint8_t* >( m_pData + begin ), static_cast< size_t >( end - begin ), MADV_WILLNEED );
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+//Read only view of a whole file through the virtual memory system. Pages are read from disk
+//the first time they are touched, so parts of the file that are never used cost no I/O.
+class CMappedFile
+{
+public:
+	CMappedFile();
+	~CMappedFile();
+
+	CMappedFile( const CMappedFile& ) = delete;
+	CMappedFile& operator=( const CMappedFile& ) = delete;
+
+	//throws if the file cannot be opened or mapped
+	void open( const std::string& filePath );
+	void close();
+
+	//asks the OS to start reading a range ahead of use, so copying it later is not one page fault at a time
+	void prefetch( uint64_t offset, uint64_t size ) const;
+
+	inline bool isOpen() const
+	{
+		return m_pData != nullptr;
+	}
+
+	inline const uint8_t* getData() const
+	{
+		return m_pData;
+	}
+
+	inline uint64_t getSize() const
+	{
+		return m_size;
+	}
+
+private:
+	const uint8_t* m_pData;
+	uint64_t m_size;
+
+#ifdef VKS_WINDOWS
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+};
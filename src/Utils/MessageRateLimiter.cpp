@@ -0,0 +1,58 @@
+#include "vkpch.h"
+#include "MessageRateLimiter.h"
+
+/////////////////////////////////////////////////
+
+const size_t MIN_SWEEP_SIZE = 256;
+
+/////////////////////////////////////////////////
+
+CMessageRateLimiter::CMessageRateLimiter( uint32_t burst, Clock::duration window )
+	: m_burst( std::max( burst, 1u ) )
+	, m_window( window )
+	, m_sweepSize( MIN_SWEEP_SIZE )
+	, m_suppressedTotal( 0 )
+{
+}
+
+bool CMessageRateLimiter::allow( uint64_t messageKey, uint32_t& suppressedCount )
+{
+	const Clock::time_point now = Clock::now();
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	if( m_messages.size() >= m_sweepSize )
+	{
+		dropExpired( now );
+		m_sweepSize = std::max( m_messages.size() * 2, MIN_SWEEP_SIZE );
+	}
+
+	SMessageState& state = m_messages[ messageKey ];
+
+	if( state.countInWindow == 0 || now - state.windowStart >= m_window )
+	{
+		state.windowStart = now;
+		state.countInWindow = 0;
+	}
+
+	if( state.countInWindow >= m_burst )
+	{
+		++state.suppressed;
+		++m_suppressedTotal;
+		return false;
+	}
+
+	++state.countInWindow;
+	suppressedCount = state.suppressed;
+	state.suppressed = 0;
+	return true;
+}
+
+/////////////////////////////////////////////////
+
+void CMessageRateLimiter::dropExpired( Clock::time_point now )
+{
+	for( auto it = m_messages.begin(); it != m_messages.end(); )
+	{
+		it = ( now - it->second.windowStart >= m_window ) ? m_messages.erase( it ) : std::next( it );
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+//Lets the first few occurrences of a message through per time window and swallows the rest.
+//The next message that gets through reports how many were swallowed in between, so a
+//warning repeated every frame costs one log line per window instead of one per frame.
+class CMessageRateLimiter
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	CMessageRateLimiter( uint32_t burst, Clock::duration window );
+
+	//returns false if the message should be dropped. suppressedCount receives the number of
+	//occurrences swallowed since the last one that was let through.
+	bool allow( uint64_t messageKey, uint32_t& suppressedCount );
+
+	inline uint64_t getSuppressedTotal() const
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		return m_suppressedTotal;
+	}
+
+private:
+	struct SMessageState
+	{
+		Clock::time_point windowStart;
+		uint32_t countInWindow = 0;
+		uint32_t suppressed = 0;
+	};
+
+	//drops the messages whose window has run out, their suppressed counts are only in the total
+	void dropExpired( Clock::time_point now );
+
+	const uint32_t m_burst;
+	const Clock::duration m_window;
+
+	//keyed by message ids or by hashes of texts that may never repeat, so it is swept once it
+	//doubles in size since the last sweep
+	std::unordered_map<uint64_t, SMessageState> m_messages;
+	size_t m_sweepSize;
+	uint64_t m_suppressedTotal;
+	mutable std::mutex m_mutex;
+};
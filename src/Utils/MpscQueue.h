@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+//Bounded lock-free queue for many producers and a single consumer.
+//Every cell carries a sequence number that tells producers whether it is free and the
+//consumer whether it has been published, so neither side ever takes a lock.
+//tryPush fails instead of blocking when the queue is full.
+template< typename T >
+class CMpscQueue
+{
+public:
+	//capacity is rounded up to a power of two
+	explicit CMpscQueue( size_t capacity )
+	{
+		size_t cellCount = 2;
+		while( cellCount < capacity )
+		{
+			cellCount <<= 1;
+		}
+
+		m_mask = cellCount - 1;
+		m_pCells = std::make_unique<SCell[]>( cellCount );
+		for( size_t i = 0; i < cellCount; ++i )
+		{
+			m_pCells[ i ].sequence.store( i, std::memory_order_relaxed );
+		}
+
+		m_enqueuePos.store( 0, std::memory_order_relaxed );
+		m_dequeuePos = 0;
+	}
+
+	CMpscQueue( const CMpscQueue& ) = delete;
+	CMpscQueue& operator=( const CMpscQueue& ) = delete;
+
+	//safe to call from any thread
+	bool tryPush( T&& value )
+	{
+		size_t pos = m_enqueuePos.load( std::memory_order_relaxed );
+		while( true )
+		{
+			SCell& cell = m_pCells[ pos & m_mask ];
+			const size_t sequence = cell.sequence.load( std::memory_order_acquire );
+			const intptr_t difference = static_cast< intptr_t >( sequence ) - static_cast< intptr_t >( pos );
+
+			if( difference == 0 )
+			{
+				//cell is free for this position, claim it
+				if( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					cell.value = std::move( value );
+					cell.sequence.store( pos + 1, std::memory_order_release );
+					return true;
+				}
+			}
+			else if( difference < 0 )
+			{
+				//the consumer has not released this cell yet, the queue is full
+				return false;
+			}
+			else
+			{
+				//another producer claimed it first
+				pos = m_enqueuePos.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	//consumer thread only
+	bool tryPop( T& value )
+	{
+		SCell& cell = m_pCells[ m_dequeuePos & m_mask ];
+		const size_t sequence = cell.sequence.load( std::memory_order_acquire );
+		if( static_cast< intptr_t >( sequence ) - static_cast< intptr_t >( m_dequeuePos + 1 ) < 0 )
+		{
+			return false;
+		}
+
+		value = std::move( cell.value );
+		cell.sequence.store( m_dequeuePos + m_mask + 1, std::memory_order_release );
+		++m_dequeuePos;
+		return true;
+	}
+
+	inline size_t getCapacity() const
+	{
+		return m_mask + 1;
+	}
+
+private:
+	struct SCell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<SCell[]> m_pCells;
+	size_t m_mask;
+
+	//kept on separate cache lines so producers and the consumer do not false share
+	alignas( 64 ) std::atomic<size_t> m_enqueuePos;
+	alignas( 64 ) size_t m_dequeuePos;
+};
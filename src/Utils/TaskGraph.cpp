@@ -0,0 +1,237 @@
+#include "vkpch.h"
+#include "TaskGraph.h"
+
+#include "Utils/Log.h"
+
+#include <thread>
+
+/////////////////////////////////////////////////
+
+CTaskGraph::CTaskGraph()
+	: m_runningTasks( 0 )
+	, m_completedTasks( 0 )
+	, m_mainRunsAnyTask( false )
+	, m_wallMilliseconds( 0.0 )
+{
+}
+
+CTaskGraph::TaskId CTaskGraph::addTask( const char* name, std::function<void()> function, std::initializer_list<TaskId> dependencies, EThread thread )
+{
+	const TaskId taskId = static_cast< TaskId >( m_tasks.size() );
+
+	STask task;
+	task.name = name;
+	task.function = std::move( function );
+	task.thread = thread;
+
+	for( const TaskId dependency : dependencies )
+	{
+		if( dependency >= taskId )
+		{
+			throw std::runtime_error( std::string( "Task '" ) + name + "' depends on a task that was not added yet." );
+		}
+
+		task.dependencies.push_back( dependency );
+		m_tasks[ dependency ].dependents.push_back( taskId );
+	}
+
+	task.pendingDependencies = static_cast< uint32_t >( task.dependencies.size() );
+	m_tasks.push_back( std::move( task ) );
+	return taskId;
+}
+
+void CTaskGraph::run( uint32_t workerCount )
+{
+	m_start = CTimer::Clock::now();
+	m_timings.assign( m_tasks.size(), STaskTiming { nullptr, 0, 0.0, 0.0, false } );
+	m_mainRunsAnyTask = ( workerCount == 0 );
+
+	for( TaskId taskId = 0; taskId < m_tasks.size(); ++taskId )
+	{
+		m_timings[ taskId ].name = m_tasks[ taskId ].name;
+		if( m_tasks[ taskId ].pendingDependencies == 0 )
+		{
+			( m_tasks[ taskId ].thread == EThread::Main ? m_readyMainTasks : m_readyTasks ).push_back( taskId );
+		}
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve( workerCount );
+	for( uint32_t i = 0; i < workerCount; ++i )
+	{
+		workers.emplace_back( &CTaskGraph::threadLoop, this, i + 1, false );
+	}
+
+	threadLoop( 0, true );
+
+	for( auto& worker : workers )
+	{
+		worker.join();
+	}
+
+	m_wallMilliseconds = std::chrono::duration<double, std::milli>( CTimer::Clock::now() - m_start ).count();
+
+	if( m_pException )
+	{
+		std::rethrow_exception( m_pException );
+	}
+
+	markCriticalPath();
+}
+
+void CTaskGraph::logTimings( const char* graphName ) const
+{
+	double taskMilliseconds = 0.0;
+	std::string criticalPath;
+
+	for( const STaskTiming& timing : m_timings )
+	{
+		VS_INFO( "  {0:<18} T{1}  start {2:8.3f} ms  took {3:8.3f} ms{4}", timing.name, timing.threadIndex, timing.startMilliseconds,
+			timing.durationMilliseconds, timing.onCriticalPath ? "  *" : "" );
+
+		taskMilliseconds += timing.durationMilliseconds;
+		if( timing.onCriticalPath )
+		{
+			criticalPath += criticalPath.empty() ? timing.name : std::string( " > " ) + timing.name;
+		}
+	}
+
+	VS_INFO( "{0} took {1:.3f} ms for {2:.3f} ms of tasks, critical path (*): {3}", graphName, m_wallMilliseconds, taskMilliseconds, criticalPath );
+}
+
+/////////////////////////////////////////////////
+
+void CTaskGraph::threadLoop( uint32_t threadIndex, bool mainThread )
+{
+	TaskId taskId = 0;
+	while( popTask( mainThread, taskId ) )
+	{
+		executeTask( taskId, threadIndex );
+	}
+}
+
+bool CTaskGraph::popTask( bool mainThread, TaskId& taskId )
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+
+	for( ;; )
+	{
+		const bool finished = m_completedTasks == m_tasks.size() || ( m_pException && m_runningTasks == 0 );
+		if( finished )
+		{
+			return false;
+		}
+
+		if( !m_pException )
+		{
+			std::deque<TaskId>* pQueue = nullptr;
+			if( mainThread && !m_readyMainTasks.empty() )
+			{
+				pQueue = &m_readyMainTasks;
+			}
+			else if( ( !mainThread || m_mainRunsAnyTask ) && !m_readyTasks.empty() )
+			{
+				pQueue = &m_readyTasks;
+			}
+
+			if( pQueue )
+			{
+				taskId = pQueue->front();
+				pQueue->pop_front();
+				++m_runningTasks;
+				return true;
+			}
+		}
+
+		m_condition.wait( lock );
+	}
+}
+
+void CTaskGraph::executeTask( TaskId taskId, uint32_t threadIndex )
+{
+	const CTimer::Clock::time_point start = CTimer::Clock::now();
+
+	std::exception_ptr pException;
+	try
+	{
+		m_tasks[ taskId ].function();
+	}
+	catch( ... )
+	{
+		pException = std::current_exception();
+	}
+
+	const CTimer::Clock::time_point end = CTimer::Clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		STaskTiming& timing = m_timings[ taskId ];
+		timing.threadIndex = threadIndex;
+		timing.startMilliseconds = std::chrono::duration<double, std::milli>( start - m_start ).count();
+		timing.durationMilliseconds = std::chrono::duration<double, std::milli>( end - start ).count();
+
+		--m_runningTasks;
+
+		if( pException )
+		{
+			if( !m_pException )
+			{
+				m_pException = pException;
+			}
+		}
+		else
+		{
+			++m_completedTasks;
+			for( const TaskId dependent : m_tasks[ taskId ].dependents )
+			{
+				STask& task = m_tasks[ dependent ];
+				if( --task.pendingDependencies == 0 )
+				{
+					( task.thread == EThread::Main ? m_readyMainTasks : m_readyTasks ).push_back( dependent );
+				}
+			}
+		}
+	}
+
+	m_condition.notify_all();
+}
+
+void CTaskGraph::markCriticalPath()
+{
+	if( m_timings.empty() )
+	{
+		return;
+	}
+
+	auto endOf = [ this ]( TaskId taskId )
+	{
+		return m_timings[ taskId ].startMilliseconds + m_timings[ taskId ].durationMilliseconds;
+	};
+
+	//walk back from the task that finished last through whichever dependency finished last
+	TaskId taskId = 0;
+	for( TaskId candidate = 1; candidate < m_timings.size(); ++candidate )
+	{
+		if( endOf( candidate ) > endOf( taskId ) )
+		{
+			taskId = candidate;
+		}
+	}
+
+	for( ;; )
+	{
+		m_timings[ taskId ].onCriticalPath = true;
+
+		const std::vector<TaskId>& dependencies = m_tasks[ taskId ].dependencies;
+		if( dependencies.empty() )
+		{
+			break;
+		}
+
+		taskId = *std::max_element( dependencies.begin(), dependencies.end(), [ &endOf ]( TaskId lhs, TaskId rhs )
+		{
+			return endOf( lhs ) < endOf( rhs );
+		} );
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "Utils/Timer.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+//Runs a fixed set of named tasks once, each as soon as the tasks it depends on have finished.
+//Tasks run on short lived worker threads unless they are pinned to the thread calling run(),
+//which is needed for windowing calls. Records when and where every task ran.
+class CTaskGraph
+{
+public:
+	using TaskId = uint32_t;
+
+	enum class EThread
+	{
+		Any,
+		//the thread that calls run()
+		Main
+	};
+
+	struct STaskTiming
+	{
+		const char* name;
+		//0 is the main thread, workers count from 1
+		uint32_t threadIndex;
+		//relative to the start of run()
+		double startMilliseconds;
+		double durationMilliseconds;
+		//the chain of tasks that bounded the total time
+		bool onCriticalPath;
+	};
+
+public:
+	CTaskGraph();
+
+	//dependencies have to be added first, so the graph can never contain a cycle.
+	//Names must be string literals, or otherwise outlive the graph.
+	TaskId addTask( const char* name, std::function<void()> function, std::initializer_list<TaskId> dependencies = {}, EThread thread = EThread::Any );
+
+	//blocks until every task ran. If a task throws, no further tasks are started and the
+	//first exception is rethrown once the tasks already running have finished.
+	void run( uint32_t workerCount );
+
+	inline const std::vector<STaskTiming>& getTimings() const
+	{
+		return m_timings;
+	}
+
+	inline double getWallMilliseconds() const
+	{
+		return m_wallMilliseconds;
+	}
+
+	void logTimings( const char* graphName ) const;
+
+private:
+	struct STask
+	{
+		const char* name;
+		std::function<void()> function;
+		EThread thread;
+		std::vector<TaskId> dependencies;
+		std::vector<TaskId> dependents;
+		uint32_t pendingDependencies = 0;
+	};
+
+	void threadLoop( uint32_t threadIndex, bool mainThread );
+	bool popTask( bool mainThread, TaskId& taskId );
+	void executeTask( TaskId taskId, uint32_t threadIndex );
+	void markCriticalPath();
+
+	std::vector<STask> m_tasks;
+	std::vector<STaskTiming> m_timings;
+
+	std::deque<TaskId> m_readyTasks;
+	std::deque<TaskId> m_readyMainTasks;
+	uint32_t m_runningTasks;
+	uint32_t m_completedTasks;
+	//main thread helps with unpinned tasks only when there are no workers
+	bool m_mainRunsAnyTask;
+
+	std::exception_ptr m_pException;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+
+	CTimer::Clock::time_point m_start;
+	double m_wallMilliseconds;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+
+class CTimer
+{
+public:
+	using Clock = std::chrono::high_resolution_clock;
+
+	CTimer()
+		: m_start( Clock::now() )
+	{
+	}
+
+	inline void reset()
+	{
+		m_start = Clock::now();
+	}
+
+	inline double elapsedMilliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>( Clock::now() - m_start ).count();
+	}
+
+private:
+	Clock::time_point m_start;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+//Bounded lock-free deque with a single owner and any number of thieves (Chase-Lev, with
+//the memory orderings of Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models").
+//The owner pushes and pops at the bottom, so it works depth first on what it queued last,
+//while thieves take the oldest items from the top. Only a pop racing a steal for the last
+//item needs a compare-and-swap. tryPush fails instead of growing when the deque is full.
+//T is copied through std::atomic, so it is meant to be a pointer or another small trivial type.
+template< typename T >
+class CWorkStealingDeque
+{
+public:
+	//capacity is rounded up to a power of two
+	explicit CWorkStealingDeque( size_t capacity )
+	{
+		size_t cellCount = 2;
+		while( cellCount < capacity )
+		{
+			cellCount <<= 1;
+		}
+
+		m_mask = static_cast< int64_t >( cellCount - 1 );
+		m_pCells = std::make_unique<std::atomic<T>[]>( cellCount );
+		m_top.store( 0, std::memory_order_relaxed );
+		m_bottom.store( 0, std::memory_order_relaxed );
+	}
+
+	CWorkStealingDeque( const CWorkStealingDeque& ) = delete;
+	CWorkStealingDeque& operator=( const CWorkStealingDeque& ) = delete;
+
+	//owner thread only
+	bool tryPush( T value )
+	{
+		const int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+		const int64_t top = m_top.load( std::memory_order_acquire );
+		if( bottom - top > m_mask )
+		{
+			return false;
+		}
+
+		m_pCells[ bottom & m_mask ].store( value, std::memory_order_relaxed );
+		//publishes the item to thieves that read the new bottom
+		m_bottom.store( bottom + 1, std::memory_order_release );
+		return true;
+	}
+
+	//owner thread only, takes the newest item
+	bool tryPop( T& value )
+	{
+		const int64_t bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+		m_bottom.store( bottom, std::memory_order_relaxed );
+		//the reservation of the bottom item has to be visible before top is read
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		int64_t top = m_top.load( std::memory_order_relaxed );
+
+		if( top > bottom )
+		{
+			//was empty
+			m_bottom.store( bottom + 1, std::memory_order_relaxed );
+			return false;
+		}
+
+		value = m_pCells[ bottom & m_mask ].load( std::memory_order_relaxed );
+		if( top == bottom )
+		{
+			//the last item, a thief may be taking it at the same time
+			const bool won = m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+			m_bottom.store( bottom + 1, std::memory_order_relaxed );
+			return won;
+		}
+
+		return true;
+	}
+
+	//any thread, takes the oldest item. Fails when empty or when it lost a race.
+	bool trySteal( T& value )
+	{
+		int64_t top = m_top.load( std::memory_order_acquire );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		const int64_t bottom = m_bottom.load( std::memory_order_acquire );
+		if( top >= bottom )
+		{
+			return false;
+		}
+
+		value = m_pCells[ top & m_mask ].load( std::memory_order_relaxed );
+		return m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+	}
+
+	//a snapshot, only exact on the owner thread while nobody steals
+	inline bool isEmpty() const
+	{
+		return m_bottom.load( std::memory_order_relaxed ) <= m_top.load( std::memory_order_relaxed );
+	}
+
+	inline size_t getCapacity() const
+	{
+		return static_cast< size_t >( m_mask + 1 );
+	}
+
+private:
+	std::unique_ptr<std::atomic<T>[]> m_pCells;
+	int64_t m_mask;
+
+	//thieves only touch top, the owner mostly bottom, so they live on separate cache lines
+	alignas( 64 ) std::atomic<int64_t> m_top;
+	alignas( 64 ) std::atomic<int64_t> m_bottom;
+};
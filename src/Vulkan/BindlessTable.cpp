@@ -0,0 +1,289 @@
+#include "vkpch.h"
+#include "BindlessTable.h"
+
+#include "Vulkan/DeletionQueue.h"
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+//binding of each type in the set, matches shaders/Bindless.glsl
+constexpr uint32_t BINDING_SAMPLED_IMAGES = 0;
+constexpr uint32_t BINDING_SAMPLERS = 1;
+constexpr uint32_t BINDING_STORAGE_BUFFERS = 2;
+
+constexpr vk::DescriptorType DESCRIPTOR_TYPES[] =
+{
+	vk::DescriptorType::eSampledImage,
+	vk::DescriptorType::eSampler,
+	vk::DescriptorType::eStorageBuffer
+};
+
+/////////////////////////////////////////////////
+
+CBindlessTable::CBindlessTable()
+	: m_device( nullptr )
+	, m_setLayout( nullptr )
+	, m_descriptorPool( nullptr )
+	, m_descriptorSet( nullptr )
+	, m_pipelineLayout( nullptr )
+	, m_descriptorWrites( 0 )
+{
+}
+
+bool CBindlessTable::IsSupported( const vk::PhysicalDevice& physicalDevice )
+{
+	auto featureChain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	const vk::PhysicalDeviceVulkan12Features& features = featureChain.get<vk::PhysicalDeviceVulkan12Features>();
+
+	return features.runtimeDescriptorArray
+		&& features.descriptorBindingPartiallyBound
+		&& features.descriptorBindingUpdateUnusedWhilePending
+		&& features.descriptorBindingSampledImageUpdateAfterBind
+		&& features.descriptorBindingStorageBufferUpdateAfterBind
+		&& features.shaderSampledImageArrayNonUniformIndexing
+		&& features.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+void CBindlessTable::EnableFeatures( vk::PhysicalDeviceVulkan12Features& features )
+{
+	features.setDescriptorIndexing( VK_TRUE );
+	features.setRuntimeDescriptorArray( VK_TRUE );
+	features.setDescriptorBindingPartiallyBound( VK_TRUE );
+	features.setDescriptorBindingUpdateUnusedWhilePending( VK_TRUE );
+	//also covers samplers
+	features.setDescriptorBindingSampledImageUpdateAfterBind( VK_TRUE );
+	features.setDescriptorBindingStorageBufferUpdateAfterBind( VK_TRUE );
+	features.setShaderSampledImageArrayNonUniformIndexing( VK_TRUE );
+	features.setShaderStorageBufferArrayNonUniformIndexing( VK_TRUE );
+}
+
+const char* CBindlessTable::GetTypeName( EBindlessType type )
+{
+	switch( type )
+	{
+	case EBindlessType::SampledImage:
+		return "sampled images";
+	case EBindlessType::Sampler:
+		return "samplers";
+	case EBindlessType::StorageBuffer:
+		return "storage buffers";
+	}
+	return "unknown";
+}
+
+void CBindlessTable::init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, const SSettings& settings )
+{
+	m_device = device;
+
+	auto propertyChain = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+	const vk::PhysicalDeviceVulkan12Properties& limits = propertyChain.get<vk::PhysicalDeviceVulkan12Properties>();
+
+	uint32_t capacities[ TYPE_COUNT ] =
+	{
+		std::min( { settings.maxSampledImages, limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSampledImages } ),
+		std::min( { settings.maxSamplers, limits.maxDescriptorSetUpdateAfterBindSamplers, limits.maxPerStageDescriptorUpdateAfterBindSamplers } ),
+		std::min( { settings.maxStorageBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers } )
+	};
+
+	//every binding is visible to every stage, so all of them count against the per stage total.
+	//Images and buffers give up the same share, samplers are few anyway.
+	const uint32_t perStageLimit = limits.maxPerStageUpdateAfterBindResources;
+	if( perStageLimit < TYPE_COUNT )
+	{
+		throw std::runtime_error( "Device allows too few update after bind resources per stage for a bindless table." );
+	}
+
+	//a binding has at least one descriptor, which has to count as well
+	for( uint32_t& capacity : capacities )
+	{
+		capacity = std::max( capacity, 1u );
+	}
+
+	const uint64_t total = static_cast< uint64_t >( capacities[ 0 ] ) + capacities[ 1 ] + capacities[ 2 ];
+	if( total > perStageLimit )
+	{
+		//samplers always leave at least one slot each for images and buffers
+		capacities[ 1 ] = std::min( capacities[ 1 ], perStageLimit - 2 );
+		const uint32_t remaining = perStageLimit - capacities[ 1 ];
+		const double scale = static_cast< double >( remaining ) / ( static_cast< double >( capacities[ 0 ] ) + capacities[ 2 ] );
+		capacities[ 0 ] = std::clamp( static_cast< uint32_t >( capacities[ 0 ] * scale ), 1u, remaining - 1 );
+		capacities[ 2 ] = std::clamp( static_cast< uint32_t >( capacities[ 2 ] * scale ), 1u, remaining - capacities[ 0 ] );
+	}
+
+	std::array<vk::DescriptorSetLayoutBinding, TYPE_COUNT> bindings;
+	std::array<vk::DescriptorBindingFlags, TYPE_COUNT> bindingFlags;
+	std::array<vk::DescriptorPoolSize, TYPE_COUNT> poolSizes;
+	for( uint32_t type = 0; type < TYPE_COUNT; ++type )
+	{
+		m_slots[ type ] = SSlots();
+		m_slots[ type ].capacity = capacities[ type ];
+
+		bindings[ type ] = vk::DescriptorSetLayoutBinding( type, DESCRIPTOR_TYPES[ type ], m_slots[ type ].capacity, SHADER_STAGES );
+		bindingFlags[ type ] = vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending |
+			vk::DescriptorBindingFlagBits::ePartiallyBound;
+		poolSizes[ type ] = vk::DescriptorPoolSize( DESCRIPTOR_TYPES[ type ], m_slots[ type ].capacity );
+	}
+
+	vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo( static_cast< uint32_t >( bindingFlags.size() ), bindingFlags.data() );
+	vk::DescriptorSetLayoutCreateInfo setLayoutCreateInfo( vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+		static_cast< uint32_t >( bindings.size() ), bindings.data() );
+	setLayoutCreateInfo.setPNext( &bindingFlagsCreateInfo );
+	m_setLayout = m_device.createDescriptorSetLayout( setLayoutCreateInfo );
+
+	vk::DescriptorPoolCreateInfo poolCreateInfo( vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, static_cast< uint32_t >( poolSizes.size() ), poolSizes.data() );
+	m_descriptorPool = m_device.createDescriptorPool( poolCreateInfo );
+
+	vk::DescriptorSetAllocateInfo allocateInfo( m_descriptorPool, 1, &m_setLayout );
+	m_descriptorSet = m_device.allocateDescriptorSets( allocateInfo ).front();
+
+	vk::PushConstantRange pushConstantRange( SHADER_STAGES, 0, PUSH_CONSTANT_SIZE );
+	vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo( {}, 1, &m_setLayout, 1, &pushConstantRange );
+	m_pipelineLayout = m_device.createPipelineLayout( pipelineLayoutCreateInfo );
+	if( m_pipelineLayout == vk::PipelineLayout( nullptr ) )
+	{
+		throw std::runtime_error( "Failed to create bindless pipeline layout." );
+	}
+
+	m_descriptorWrites = 0;
+
+	VS_TRACE( "Bindless table: {0} sampled images, {1} samplers, {2} storage buffers", m_slots[ 0 ].capacity, m_slots[ 1 ].capacity, m_slots[ 2 ].capacity );
+}
+
+void CBindlessTable::destroy()
+{
+	if( !m_device )
+	{
+		return;
+	}
+
+	m_device.destroyPipelineLayout( m_pipelineLayout );
+	//frees the set with it
+	m_device.destroyDescriptorPool( m_descriptorPool );
+	m_device.destroyDescriptorSetLayout( m_setLayout );
+
+	m_pipelineLayout = nullptr;
+	m_descriptorPool = nullptr;
+	m_descriptorSet = nullptr;
+	m_setLayout = nullptr;
+}
+
+CBindlessTable::Handle CBindlessTable::registerImage( const vk::ImageView& view, vk::ImageLayout layout )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	const Handle handle = allocateSlot( EBindlessType::SampledImage );
+	writeImage( handle, view, layout );
+	return handle;
+}
+
+CBindlessTable::Handle CBindlessTable::registerSampler( const vk::Sampler& sampler )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	const Handle handle = allocateSlot( EBindlessType::Sampler );
+
+	vk::DescriptorImageInfo imageInfo( sampler, nullptr, vk::ImageLayout::eUndefined );
+	vk::WriteDescriptorSet write( m_descriptorSet, BINDING_SAMPLERS, handle, 1, vk::DescriptorType::eSampler, &imageInfo );
+	m_device.updateDescriptorSets( write, {} );
+	++m_descriptorWrites;
+
+	return handle;
+}
+
+CBindlessTable::Handle CBindlessTable::registerBuffer( const vk::Buffer& buffer, vk::DeviceSize offset, vk::DeviceSize range )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	const Handle handle = allocateSlot( EBindlessType::StorageBuffer );
+
+	vk::DescriptorBufferInfo bufferInfo( buffer, offset, range );
+	vk::WriteDescriptorSet write( m_descriptorSet, BINDING_STORAGE_BUFFERS, handle, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo );
+	m_device.updateDescriptorSets( write, {} );
+	++m_descriptorWrites;
+
+	return handle;
+}
+
+void CBindlessTable::updateImage( Handle handle, const vk::ImageView& view, vk::ImageLayout layout )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	writeImage( handle, view, layout );
+}
+
+void CBindlessTable::release( EBindlessType type, Handle handle, CDeletionQueue& deletionQueue, uint64_t retireValue )
+{
+	if( handle == INVALID_HANDLE )
+	{
+		return;
+	}
+
+	//the descriptor is left as is, partially bound slots may point at destroyed objects while unused
+	deletionQueue.push( retireValue, [ this, type, handle ]
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_slots[ static_cast< uint32_t >( type ) ].freeSlots.push_back( handle );
+	} );
+}
+
+void CBindlessTable::bind( const vk::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint ) const
+{
+	commandBuffer.bindDescriptorSets( bindPoint, m_pipelineLayout, 0, m_descriptorSet, {} );
+}
+
+CBindlessTable::SStats CBindlessTable::getStats() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SStats stats;
+	for( uint32_t type = 0; type < TYPE_COUNT; ++type )
+	{
+		stats.capacity[ type ] = m_slots[ type ].capacity;
+		stats.highWater[ type ] = m_slots[ type ].highWater;
+		stats.used[ type ] = m_slots[ type ].highWater - static_cast< uint32_t >( m_slots[ type ].freeSlots.size() );
+	}
+	stats.descriptorWrites = m_descriptorWrites;
+
+	return stats;
+}
+
+void CBindlessTable::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Bindless table: {0} descriptor writes", stats.descriptorWrites );
+	for( uint32_t type = 0; type < TYPE_COUNT; ++type )
+	{
+		VS_INFO( "    {0:<16}: {1} used, {2} high water, {3} capacity", GetTypeName( static_cast< EBindlessType >( type ) ),
+			stats.used[ type ], stats.highWater[ type ], stats.capacity[ type ] );
+	}
+}
+
+/////////////////////////////////////////////////
+
+CBindlessTable::Handle CBindlessTable::allocateSlot( EBindlessType type )
+{
+	SSlots& slots = m_slots[ static_cast< uint32_t >( type ) ];
+
+	//most recently freed first, its descriptor is the most likely to still be in cache
+	if( !slots.freeSlots.empty() )
+	{
+		const Handle handle = slots.freeSlots.back();
+		slots.freeSlots.pop_back();
+		return handle;
+	}
+
+	if( slots.highWater >= slots.capacity )
+	{
+		throw std::runtime_error( std::string( "Bindless table is out of " ) + GetTypeName( type ) + "." );
+	}
+
+	return slots.highWater++;
+}
+
+void CBindlessTable::writeImage( Handle handle, const vk::ImageView& view, vk::ImageLayout layout )
+{
+	vk::DescriptorImageInfo imageInfo( nullptr, view, layout );
+	vk::WriteDescriptorSet write( m_descriptorSet, BINDING_SAMPLED_IMAGES, handle, 1, vk::DescriptorType::eSampledImage, &imageInfo );
+	m_device.updateDescriptorSets( write, {} );
+	++m_descriptorWrites;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+
+class CDeletionQueue;
+
+enum class EBindlessType
+{
+	SampledImage,
+	Sampler,
+	StorageBuffer
+};
+
+//One descriptor set holding every sampled image, sampler and storage buffer the renderer uses,
+//built on descriptor indexing. Resources are registered once and referred to by the index
+//returned, which shaders take from push constants (see shaders/Bindless.glsl), so draws never
+//allocate or bind descriptor sets. The set is update after bind and partially bound: slots can
+//be written while frames in flight use other slots, and unused slots may hold anything.
+//Registering and releasing is thread safe.
+class CBindlessTable
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+	//the smallest maxPushConstantsSize the spec allows, shared by every pipeline using the table
+	static constexpr uint32_t PUSH_CONSTANT_SIZE = 128;
+
+	struct SSettings
+	{
+		//clamped to the device limits
+		uint32_t maxSampledImages = 16384;
+		uint32_t maxSamplers = 256;
+		uint32_t maxStorageBuffers = 16384;
+	};
+
+	struct SStats
+	{
+		uint32_t capacity[ 3 ] = {};
+		uint32_t used[ 3 ] = {};
+		//highest slot ever handed out + 1, slots are reused before it grows
+		uint32_t highWater[ 3 ] = {};
+		uint32_t descriptorWrites = 0;
+	};
+
+public:
+	CBindlessTable();
+
+	//true when the device has the descriptor indexing features the table needs
+	static bool IsSupported( const vk::PhysicalDevice& physicalDevice );
+	//sets those features, to be chained into device creation
+	static void EnableFeatures( vk::PhysicalDeviceVulkan12Features& features );
+	static const char* GetTypeName( EBindlessType type );
+
+	void init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, const SSettings& settings = SSettings() );
+	//the device has to be idle
+	void destroy();
+
+	//throws when the table is full
+	Handle registerImage( const vk::ImageView& view, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal );
+	Handle registerSampler( const vk::Sampler& sampler );
+	Handle registerBuffer( const vk::Buffer& buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE );
+
+	//points a registered slot at another view, e.g. once more mips are resident. Frames in
+	//flight must not be using the slot.
+	void updateImage( Handle handle, const vk::ImageView& view, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal );
+
+	//the slot is reused once retireValue completes, frames before it may still read it
+	void release( EBindlessType type, Handle handle, CDeletionQueue& deletionQueue, uint64_t retireValue );
+
+	//binds the set at index 0, once per command buffer, secondaries inherit no bindings
+	void bind( const vk::CommandBuffer& commandBuffer, vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics ) const;
+
+	template<typename T>
+	void pushConstants( const vk::CommandBuffer& commandBuffer, const T& constants ) const
+	{
+		static_assert( sizeof( T ) <= PUSH_CONSTANT_SIZE, "Push constants do not fit the range of the bindless pipeline layout." );
+		commandBuffer.pushConstants( m_pipelineLayout, SHADER_STAGES, 0, sizeof( T ), &constants );
+	}
+
+	//layout with the table at set 0 and the push constant range, for every pipeline using the table
+	inline vk::PipelineLayout getPipelineLayout() const
+	{
+		return m_pipelineLayout;
+	}
+
+	inline vk::DescriptorSetLayout getSetLayout() const
+	{
+		return m_setLayout;
+	}
+
+	inline vk::DescriptorSet getDescriptorSet() const
+	{
+		return m_descriptorSet;
+	}
+
+	SStats getStats() const;
+	void logStats() const;
+
+private:
+	static constexpr uint32_t TYPE_COUNT = 3;
+	static constexpr vk::ShaderStageFlags SHADER_STAGES = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+	//slots of one binding, freed slots are handed out again before new ones
+	struct SSlots
+	{
+		uint32_t capacity = 0;
+		uint32_t highWater = 0;
+		std::vector<Handle> freeSlots;
+	};
+
+	Handle allocateSlot( EBindlessType type );
+	void writeImage( Handle handle, const vk::ImageView& view, vk::ImageLayout layout );
+
+	vk::Device m_device;
+	vk::DescriptorSetLayout m_setLayout;
+	vk::DescriptorPool m_descriptorPool;
+	vk::DescriptorSet m_descriptorSet;
+	vk::PipelineLayout m_pipelineLayout;
+
+	SSlots m_slots[ TYPE_COUNT ];
+	uint32_t m_descriptorWrites;
+	//guards the slots and the descriptor writes, updates to one set need host synchronization
+	mutable std::mutex m_mutex;
+};
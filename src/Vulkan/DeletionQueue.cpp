@@ -0,0 +1,44 @@
+#include "vkpch.h"
+#include "DeletionQueue.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+CDeletionQueue::~CDeletionQueue()
+{
+	if( !m_entries.empty() )
+	{
+		//destroying the entries would destroy what retire() captured, possibly after the device
+		VS_WARN( "Deletion queue destroyed with {0} entries still pending, they are leaked without running. Call flushAll() while the device is alive.",
+			m_entries.size() );
+		new std::deque<SEntry>( std::move( m_entries ) );
+	}
+}
+
+void CDeletionQueue::push( uint64_t retireValue, Deleter deleter )
+{
+	//keeps the queue sorted, so flush only ever looks at the front
+	if( !m_entries.empty() && retireValue < m_entries.back().retireValue )
+	{
+		throw std::runtime_error( "Deletion queue values must not decrease." );
+	}
+
+	m_entries.push_back( SEntry { retireValue, std::move( deleter ) } );
+}
+
+void CDeletionQueue::flush( uint64_t completedValue )
+{
+	while( !m_entries.empty() && m_entries.front().retireValue <= completedValue )
+	{
+		//popped first, a deleter may push new entries
+		Deleter deleter = std::move( m_entries.front().deleter );
+		m_entries.pop_front();
+		deleter();
+	}
+}
+
+void CDeletionQueue::flushAll()
+{
+	flush( UINT64_MAX );
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+//Defers destroying objects until the GPU work that may still use them has finished, so
+//nothing has to drain the GPU first. Entries are keyed by a value that only ever grows,
+//such as a frame number or the value of a timeline semaphore, and run once the owner
+//reports that value as completed. Each queue is keyed by one such counter.
+//Not thread safe, it belongs to the thread that submits.
+class CDeletionQueue
+{
+public:
+	using Deleter = std::function<void()>;
+
+public:
+	CDeletionQueue() = default;
+	//pending entries are leaked, neither run nor destroyed, so flushAll() has to come first
+	~CDeletionQueue();
+
+	CDeletionQueue( const CDeletionQueue& ) = delete;
+	CDeletionQueue& operator=( const CDeletionQueue& ) = delete;
+
+	//retireValue must not be lower than the one of the previous push
+	void push( uint64_t retireValue, Deleter deleter );
+
+	//takes ownership of a vk::Unique* handle, or of a container of them, and releases it
+	//once retireValue has completed
+	template< typename T >
+	void retire( uint64_t retireValue, T&& object )
+	{
+		//Deleter has to be copyable, the unique handles are not
+		auto pObject = std::make_shared<std::decay_t<T>>( std::forward<T>( object ) );
+		push( retireValue, [ pObject ]() mutable { pObject.reset(); } );
+	}
+
+	//runs every deleter whose value is at most completedValue, in the order they were pushed
+	void flush( uint64_t completedValue );
+	//for teardown, once the device is idle
+	void flushAll();
+
+	inline size_t getPendingCount() const
+	{
+		return m_entries.size();
+	}
+
+private:
+	struct SEntry
+	{
+		uint64_t retireValue;
+		Deleter deleter;
+	};
+
+	std::deque<SEntry> m_entries;
+};
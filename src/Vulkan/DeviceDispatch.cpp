@@ -0,0 +1,24 @@
+#include "vkpch.h"
+#include "DeviceDispatch.h"
+
+//storage of VULKAN_HPP_DEFAULT_DISPATCHER, defined in exactly one translation unit
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+/////////////////////////////////////////////////
+
+void CDeviceDispatch::InitLoader()
+{
+	//the one entry point still taken from the loader's exports, everything else is queried
+	VULKAN_HPP_DEFAULT_DISPATCHER.init( vkGetInstanceProcAddr );
+}
+
+void CDeviceDispatch::InitInstance( const vk::Instance& instance )
+{
+	//device level functions resolve to loader trampolines until InitDevice
+	VULKAN_HPP_DEFAULT_DISPATCHER.init( instance );
+}
+
+void CDeviceDispatch::InitDevice( const vk::Device& device )
+{
+	VULKAN_HPP_DEFAULT_DISPATCHER.init( device );
+}
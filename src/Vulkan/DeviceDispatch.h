@@ -0,0 +1,18 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+//The build defines VULKAN_HPP_DISPATCH_LOADER_DYNAMIC, so every Vulkan-Hpp call made without
+//an explicit dispatcher goes through VULKAN_HPP_DEFAULT_DISPATCHER rather than the exports of
+//the loader library. Once the device exists, its entry points are fetched with vkGetDeviceProcAddr,
+//so device, queue and command buffer calls jump straight into the driver instead of through
+//the loader trampoline that looks up the device's dispatch table on every call.
+//Like volk's volkLoadDevice the table serves a single device, which is all the apps create.
+class CDeviceDispatch
+{
+public:
+	//global commands such as vkCreateInstance, call before any other Vulkan function
+	static void InitLoader();
+	static void InitInstance( const vk::Instance& instance );
+	//replaces the device level entry points, no other thread may use Vulkan meanwhile
+	static void InitDevice( const vk::Device& device );
+};
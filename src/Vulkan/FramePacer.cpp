@@ -0,0 +1,422 @@
+#include "vkpch.h"
+#include "FramePacer.h"
+
+#include "Utils/Log.h"
+#include "Vulkan/VulkanUtils.h"
+
+#include <cmath>
+#include <thread>
+
+/////////////////////////////////////////////////
+
+const double DEFAULT_DISPLAY_INTERVAL_MILLISECONDS = 1000.0 / 60.0;
+//finish this long before the vblank, so small variations do not miss it
+const double PACING_MARGIN_MILLISECONDS = 1.5;
+const double WORK_DECAY = 0.05;
+//sleep_until overshoots by up to a scheduler tick, the rest is spent yielding
+const std::chrono::microseconds SPIN_DURATION( 1000 );
+
+const uint64_t PRESENT_WAIT_TIMEOUT_NANOSECONDS = 100'000'000;
+//frames whose present never completes are dropped from the statistics after this many
+const size_t MAX_PENDING_FRAMES = 16;
+
+
+static double toMilliseconds( CTimer::Clock::duration duration )
+{
+	return std::chrono::duration<double, std::milli>( duration ).count();
+}
+
+/////////////////////////////////////////////////
+
+CFramePacer::CFramePacer()
+	: m_device( nullptr )
+	, m_presentWaitEnabled( false )
+#if VKS_PRESENT_WAIT_AVAILABLE
+	, m_pfnWaitForPresent( nullptr )
+#endif
+	, m_pacingDelayMilliseconds( 0.0f )
+	, m_gpuMilliseconds( 0.0f )
+	, m_lastCompletedFrame( 0 )
+	, m_displayIntervalMilliseconds( DEFAULT_DISPLAY_INTERVAL_MILLISECONDS )
+	, m_intervalSamples {}
+	, m_intervalSampleCount( 0 )
+	, m_predictedWorkMilliseconds( 0.0 )
+	, m_completedFrames( 0 )
+	, m_presentWaitFrames( 0 )
+	, m_latencySumMilliseconds( 0.0 )
+	, m_latencyMaxMilliseconds( 0.0f )
+{
+}
+
+vk::PresentModeKHR CFramePacer::ChoosePresentMode( EPresentPolicy policy, const std::vector<vk::PresentModeKHR>& availableModes )
+{
+	auto isAvailable = [ &availableModes ]( vk::PresentModeKHR mode )
+	{
+		return std::find( availableModes.begin(), availableModes.end(), mode ) != availableModes.end();
+	};
+
+	//FIFO is the only mode every surface has to support
+	if( policy == EPresentPolicy::PowerSaving )
+	{
+		return vk::PresentModeKHR::eFifo;
+	}
+
+	if( isAvailable( vk::PresentModeKHR::eMailbox ) )
+	{
+		return vk::PresentModeKHR::eMailbox;
+	}
+
+	//tears, but never waits for a vblank
+	if( isAvailable( vk::PresentModeKHR::eImmediate ) )
+	{
+		return vk::PresentModeKHR::eImmediate;
+	}
+
+	return vk::PresentModeKHR::eFifo;
+}
+
+const char* CFramePacer::GetPolicyName( EPresentPolicy policy )
+{
+	switch( policy )
+	{
+		case EPresentPolicy::LowLatency:
+			return "low latency";
+		case EPresentPolicy::PowerSaving:
+			return "power saving";
+		case EPresentPolicy::CappedFps:
+			return "capped fps";
+	}
+
+	return "unknown";
+}
+
+bool CFramePacer::IsPresentWaitSupported( const vk::PhysicalDevice& physicalDevice )
+{
+#if VKS_PRESENT_WAIT_AVAILABLE
+	if( !isDeviceExtensionSupported( physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME ) ||
+		!isDeviceExtensionSupported( physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME ) )
+	{
+		return false;
+	}
+
+	auto featureChain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR>();
+	return featureChain.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+		featureChain.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+#else
+	return false;
+#endif
+}
+
+void CFramePacer::init( const vk::Device& device, const SSettings& settings, bool presentWaitEnabled )
+{
+	m_device = device;
+	m_settings = settings;
+	m_settings.targetFps = std::max( m_settings.targetFps, 1u );
+
+#if VKS_PRESENT_WAIT_AVAILABLE
+	m_pfnWaitForPresent = presentWaitEnabled ? reinterpret_cast< PFN_vkWaitForPresentKHR >( m_device.getProcAddr( "vkWaitForPresentKHR" ) ) : nullptr;
+	m_presentWaitEnabled = ( m_pfnWaitForPresent != nullptr );
+#else
+	m_presentWaitEnabled = false;
+#endif
+
+	m_nextCappedStart = CTimer::Clock::now();
+
+	VS_INFO( "Frame pacing: {0}, latency measured by {1}.", GetPolicyName( m_settings.policy ),
+		m_presentWaitEnabled ? "present wait" : "fences (estimate)" );
+}
+
+void CFramePacer::beginFrame( float gpuMilliseconds )
+{
+	collectCompletedFrames();
+
+	const CTimer::Clock::time_point now = CTimer::Clock::now();
+	const CTimer::Clock::time_point target = scheduleFrameStart( now );
+	if( target > now )
+	{
+		sleepUntil( target );
+	}
+
+	m_inputTime = CTimer::Clock::now();
+	m_pacingDelayMilliseconds = static_cast< float >( toMilliseconds( m_inputTime - now ) );
+	m_gpuMilliseconds = gpuMilliseconds;
+}
+
+void CFramePacer::onPresent( uint64_t frameNumber, const vk::SwapchainKHR& swapChain, const vk::Fence& fence )
+{
+	SPendingFrame frame;
+	frame.frameNumber = frameNumber;
+	frame.swapChain = swapChain;
+	frame.fence = fence;
+	frame.inputTime = m_inputTime;
+	frame.presentCallTime = CTimer::Clock::now();
+	frame.pacingDelayMilliseconds = m_pacingDelayMilliseconds;
+	frame.waitForPresent = m_presentWaitEnabled;
+	frame.retired = false;
+
+	const double workMilliseconds = toMilliseconds( frame.presentCallTime - frame.inputTime ) + m_gpuMilliseconds;
+	m_predictedWorkMilliseconds = workMilliseconds > m_predictedWorkMilliseconds ? workMilliseconds :
+		m_predictedWorkMilliseconds + ( workMilliseconds - m_predictedWorkMilliseconds ) * WORK_DECAY;
+
+	m_pendingFrames.push_back( frame );
+	if( m_pendingFrames.size() > MAX_PENDING_FRAMES )
+	{
+		m_pendingFrames.pop_front();
+	}
+}
+
+void CFramePacer::onFrameRetired( uint64_t frameNumber )
+{
+	const CTimer::Clock::time_point now = CTimer::Clock::now();
+	for( auto& frame : m_pendingFrames )
+	{
+		if( frame.frameNumber > frameNumber )
+		{
+			break;
+		}
+
+		if( !frame.retired )
+		{
+			frame.retired = true;
+			frame.retiredTime = now;
+		}
+	}
+}
+
+void CFramePacer::onSwapChainRecreated()
+{
+	for( auto& frame : m_pendingFrames )
+	{
+		frame.waitForPresent = false;
+	}
+}
+
+CFramePacer::SStats CFramePacer::getStats() const
+{
+	SStats stats;
+	stats.frames = m_completedFrames;
+	stats.presentWaitFrames = m_presentWaitFrames;
+	stats.averageMilliseconds = m_completedFrames > 0 ? static_cast< float >( m_latencySumMilliseconds / m_completedFrames ) : 0.0f;
+	stats.maxMilliseconds = m_latencyMaxMilliseconds;
+
+	//the ring fills from the front, so the first count values are the valid ones
+	const uint32_t count = m_latencyHistory.getCount();
+	if( count > 0 )
+	{
+		std::vector<float> sorted( m_latencyHistory.getValues(), m_latencyHistory.getValues() + count );
+		std::sort( sorted.begin(), sorted.end() );
+
+		auto percentile = [ &sorted ]( double fraction )
+		{
+			const size_t rank = static_cast< size_t >( std::ceil( fraction * sorted.size() ) );
+			return sorted[ std::min( std::max( rank, size_t( 1 ) ), sorted.size() ) - 1 ];
+		};
+
+		stats.p50Milliseconds = percentile( 0.5 );
+		stats.p99Milliseconds = percentile( 0.99 );
+	}
+
+	return stats;
+}
+
+void CFramePacer::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Frame pacing: {0}, {1} frames, {2} measured by present wait", GetPolicyName( m_settings.policy ), stats.frames, stats.presentWaitFrames );
+	VS_INFO( "    input to present : avg {0:.3f} ms  p50 {1:.3f} ms  p99 {2:.3f} ms  max {3:.3f} ms", stats.averageMilliseconds,
+		stats.p50Milliseconds, stats.p99Milliseconds, stats.maxMilliseconds );
+	VS_INFO( "    display interval : {0:.3f} ms, predicted frame work {1:.3f} ms", m_displayIntervalMilliseconds, m_predictedWorkMilliseconds );
+}
+
+void CFramePacer::writeCsv( const std::string& filePath ) const
+{
+	std::ofstream file( filePath, std::ios::trunc );
+	if( !file.is_open() )
+	{
+		VS_WARN( "Failed to write frame latencies to '{0}'.", filePath );
+		return;
+	}
+
+	file << "frame,input_to_present_ms,cpu_ms,pacing_delay_ms,present_wait\n";
+	for( const auto& record : m_records )
+	{
+		file << record.frameNumber << ',' << record.inputToPresentMilliseconds << ',' << record.cpuMilliseconds << ','
+			<< record.pacingDelayMilliseconds << ',' << ( record.measuredByPresentWait ? 1 : 0 ) << '\n';
+	}
+
+	VS_INFO( "Wrote {0} frame latencies to '{1}'.", m_records.size(), filePath );
+}
+
+/////////////////////////////////////////////////
+
+void CFramePacer::collectCompletedFrames()
+{
+	//power saving waits for the previous frame to reach the display, so the next one
+	//starts relative to an actual vblank instead of an estimate
+	if( m_settings.policy == EPresentPolicy::PowerSaving && !m_pendingFrames.empty() && m_pendingFrames.back().waitForPresent )
+	{
+		waitForPresent( m_pendingFrames.back(), PRESENT_WAIT_TIMEOUT_NANOSECONDS );
+	}
+
+	//presents complete in order, the first one that did not stops the walk
+	while( !m_pendingFrames.empty() )
+	{
+		SPendingFrame& frame = m_pendingFrames.front();
+
+		if( frame.waitForPresent )
+		{
+			if( !waitForPresent( frame, 0 ) )
+			{
+				if( frame.waitForPresent )
+				{
+					break;
+				}
+
+				continue;
+			}
+
+			completeFrame( frame, CTimer::Clock::now(), true );
+		}
+		else
+		{
+			if( !frame.retired && m_device.getFenceStatus( frame.fence ) == vk::Result::eSuccess )
+			{
+				frame.retired = true;
+				frame.retiredTime = CTimer::Clock::now();
+			}
+
+			if( !frame.retired )
+			{
+				break;
+			}
+
+			completeFrame( frame, frame.retiredTime, false );
+		}
+
+		m_pendingFrames.pop_front();
+	}
+}
+
+bool CFramePacer::waitForPresent( SPendingFrame& frame, uint64_t timeoutNanoseconds )
+{
+#if VKS_PRESENT_WAIT_AVAILABLE
+	const VkResult result = m_pfnWaitForPresent( static_cast< VkDevice >( m_device ), static_cast< VkSwapchainKHR >( frame.swapChain ),
+		frame.frameNumber, timeoutNanoseconds );
+
+	switch( result )
+	{
+		case VK_SUCCESS:
+		case VK_SUBOPTIMAL_KHR:
+			return true;
+		case VK_TIMEOUT:
+			return false;
+		case VK_ERROR_OUT_OF_DATE_KHR:
+		case VK_ERROR_SURFACE_LOST_KHR:
+			//this present will never be reported, its fence still is
+			frame.waitForPresent = false;
+			return false;
+		default:
+			throw std::runtime_error( "Failed to wait for present." );
+	}
+#else
+	frame.waitForPresent = false;
+	return false;
+#endif
+}
+
+void CFramePacer::completeFrame( const SPendingFrame& frame, CTimer::Clock::time_point completionTime, bool measuredByPresentWait )
+{
+	if( m_lastCompletedFrame != 0 && frame.frameNumber == m_lastCompletedFrame + 1 )
+	{
+		m_intervalSamples[ m_intervalSampleCount % m_intervalSamples.size() ] = static_cast< float >( toMilliseconds( completionTime - m_lastCompletionTime ) );
+		++m_intervalSampleCount;
+
+		const size_t sampleCount = std::min<size_t>( m_intervalSampleCount, m_intervalSamples.size() );
+		auto samples = m_intervalSamples;
+		std::nth_element( samples.begin(), samples.begin() + sampleCount / 2, samples.begin() + sampleCount );
+		m_displayIntervalMilliseconds = samples[ sampleCount / 2 ];
+	}
+
+	m_lastCompletionTime = completionTime;
+	m_lastCompletedFrame = frame.frameNumber;
+
+	SFrameLatency latency;
+	latency.frameNumber = frame.frameNumber;
+	latency.inputToPresentMilliseconds = static_cast< float >( toMilliseconds( completionTime - frame.inputTime ) );
+	latency.cpuMilliseconds = static_cast< float >( toMilliseconds( frame.presentCallTime - frame.inputTime ) );
+	latency.pacingDelayMilliseconds = frame.pacingDelayMilliseconds;
+	latency.measuredByPresentWait = measuredByPresentWait;
+
+	m_latencyHistory.push( latency.inputToPresentMilliseconds );
+	if( m_settings.keepRecords )
+	{
+		m_records.push_back( latency );
+	}
+
+	++m_completedFrames;
+	m_presentWaitFrames += measuredByPresentWait ? 1 : 0;
+	m_latencySumMilliseconds += latency.inputToPresentMilliseconds;
+	m_latencyMaxMilliseconds = std::max( m_latencyMaxMilliseconds, latency.inputToPresentMilliseconds );
+}
+
+CTimer::Clock::time_point CFramePacer::scheduleFrameStart( CTimer::Clock::time_point now )
+{
+	switch( m_settings.policy )
+	{
+		case EPresentPolicy::LowLatency:
+			return now;
+
+		case EPresentPolicy::CappedFps:
+		{
+			const auto interval = std::chrono::duration_cast< CTimer::Clock::duration >( std::chrono::duration<double>( 1.0 / m_settings.targetFps ) );
+
+			//after a hitch start over from now instead of catching up with a burst of frames
+			if( m_nextCappedStart + interval < now )
+			{
+				m_nextCappedStart = now;
+			}
+
+			const CTimer::Clock::time_point target = m_nextCappedStart;
+			m_nextCappedStart += interval;
+			return target;
+		}
+
+		case EPresentPolicy::PowerSaving:
+		{
+			if( m_lastCompletedFrame == 0 )
+			{
+				return now;
+			}
+
+			//every frame still queued takes one vblank, this one gets the vblank after them.
+			//Starting as late as the predicted work allows keeps input fresh without missing it.
+			const double queuedIntervals = static_cast< double >( m_pendingFrames.size() + 1 );
+			const double startMilliseconds = queuedIntervals * m_displayIntervalMilliseconds - m_predictedWorkMilliseconds - PACING_MARGIN_MILLISECONDS;
+			const double maxDelayMilliseconds = 2.0 * m_displayIntervalMilliseconds;
+
+			const CTimer::Clock::time_point target = m_lastCompletionTime +
+				std::chrono::duration_cast< CTimer::Clock::duration >( std::chrono::duration<double, std::milli>( startMilliseconds ) );
+			const CTimer::Clock::time_point latest = now +
+				std::chrono::duration_cast< CTimer::Clock::duration >( std::chrono::duration<double, std::milli>( maxDelayMilliseconds ) );
+
+			return std::min( target, latest );
+		}
+	}
+
+	return now;
+}
+
+void CFramePacer::sleepUntil( CTimer::Clock::time_point target )
+{
+	const CTimer::Clock::time_point spinStart = target - SPIN_DURATION;
+	if( CTimer::Clock::now() < spinStart )
+	{
+		std::this_thread::sleep_until( spinStart );
+	}
+
+	while( CTimer::Clock::now() < target )
+	{
+		std::this_thread::yield();
+	}
+}
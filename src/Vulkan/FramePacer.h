@@ -0,0 +1,159 @@
+#pragma once
+#include "Profiling/FrameHistory.h"
+#include "Utils/Timer.h"
+
+#include <deque>
+#include <vulkan/vulkan.hpp>
+
+//present id and present wait came with the 1.2.189 headers, older SDKs only get the fence estimates
+#if defined( VK_KHR_present_id ) && defined( VK_KHR_present_wait )
+#define VKS_PRESENT_WAIT_AVAILABLE 1
+#else
+#define VKS_PRESENT_WAIT_AVAILABLE 0
+#endif
+
+enum class EPresentPolicy
+{
+	//mailbox, or immediate when there is no mailbox, frames start as soon as a slot is free
+	LowLatency,
+	//FIFO, frames start just in time for the next vblank instead of queueing up behind it
+	PowerSaving,
+	//frames start at a fixed rate, presented with the lowest latency mode there is
+	CappedFps
+};
+
+//Decides when the CPU starts the next frame and measures how long it takes from sampling
+//input to the frame reaching the display. With VK_KHR_present_wait that is the moment the
+//present completes. Without it, it is the moment the frame's fence is seen signaled, an
+//estimate that leaves out the compositor and scanout.
+//Belongs to the thread that presents.
+class CFramePacer
+{
+public:
+	struct SSettings
+	{
+		EPresentPolicy policy = EPresentPolicy::LowLatency;
+		//only used by EPresentPolicy::CappedFps
+		uint32_t targetFps = 60;
+		//keeps every frame's latency for writeCsv, otherwise only the recent history is kept
+		bool keepRecords = false;
+	};
+
+	struct SFrameLatency
+	{
+		uint64_t frameNumber;
+		//from sampling input to the present completing, or to the fence being seen signaled
+		float inputToPresentMilliseconds;
+		//from sampling input to the present call
+		float cpuMilliseconds;
+		//how long beginFrame held the frame back
+		float pacingDelayMilliseconds;
+		bool measuredByPresentWait;
+	};
+
+	struct SStats
+	{
+		uint64_t frames = 0;
+		uint64_t presentWaitFrames = 0;
+		float averageMilliseconds = 0.0f;
+		float maxMilliseconds = 0.0f;
+		//over the recent history only
+		float p50Milliseconds = 0.0f;
+		float p99Milliseconds = 0.0f;
+	};
+
+public:
+	CFramePacer();
+
+	static vk::PresentModeKHR ChoosePresentMode( EPresentPolicy policy, const std::vector<vk::PresentModeKHR>& availableModes );
+	static const char* GetPolicyName( EPresentPolicy policy );
+
+	//true when both extensions and their features are there, the device has to enable them
+	static bool IsPresentWaitSupported( const vk::PhysicalDevice& physicalDevice );
+
+	void init( const vk::Device& device, const SSettings& settings, bool presentWaitEnabled );
+
+	//call right before sampling input. Collects the frames that reached the display since the
+	//last call, then sleeps if the policy wants this frame to start later.
+	//gpuMilliseconds is the latest GPU frame time, 0 when unknown.
+	void beginFrame( float gpuMilliseconds );
+	//after a successful present of frameNumber, which is also the present id when present wait is enabled
+	void onPresent( uint64_t frameNumber, const vk::SwapchainKHR& swapChain, const vk::Fence& fence );
+	//call once fence of frameNumber is known to be signaled, before it is reset
+	void onFrameRetired( uint64_t frameNumber );
+	//presents on the old swapchain can no longer be waited on
+	void onSwapChainRecreated();
+
+	inline bool isPresentWaitEnabled() const
+	{
+		return m_presentWaitEnabled;
+	}
+
+	inline const CFrameHistory& getLatencyHistory() const
+	{
+		return m_latencyHistory;
+	}
+
+	inline const std::vector<SFrameLatency>& getRecords() const
+	{
+		return m_records;
+	}
+
+	SStats getStats() const;
+	void logStats() const;
+	void writeCsv( const std::string& filePath ) const;
+
+private:
+	struct SPendingFrame
+	{
+		uint64_t frameNumber;
+		vk::SwapchainKHR swapChain;
+		vk::Fence fence;
+		CTimer::Clock::time_point inputTime;
+		CTimer::Clock::time_point presentCallTime;
+		float pacingDelayMilliseconds;
+		bool waitForPresent;
+		bool retired;
+		CTimer::Clock::time_point retiredTime;
+	};
+
+	void collectCompletedFrames();
+	//false on timeout, or when the present can never be waited on and the fence has to do
+	bool waitForPresent( SPendingFrame& frame, uint64_t timeoutNanoseconds );
+	void completeFrame( const SPendingFrame& frame, CTimer::Clock::time_point completionTime, bool measuredByPresentWait );
+	CTimer::Clock::time_point scheduleFrameStart( CTimer::Clock::time_point now );
+	static void sleepUntil( CTimer::Clock::time_point target );
+
+	vk::Device m_device;
+	SSettings m_settings;
+	bool m_presentWaitEnabled;
+#if VKS_PRESENT_WAIT_AVAILABLE
+	PFN_vkWaitForPresentKHR m_pfnWaitForPresent;
+#endif
+
+	std::deque<SPendingFrame> m_pendingFrames;
+
+	//state of the frame between beginFrame and onPresent
+	CTimer::Clock::time_point m_inputTime;
+	float m_pacingDelayMilliseconds;
+	float m_gpuMilliseconds;
+
+	//when the newest frame reached the display, and the estimated time between two of them
+	CTimer::Clock::time_point m_lastCompletionTime;
+	uint64_t m_lastCompletedFrame;
+	double m_displayIntervalMilliseconds;
+	//recent times between consecutive frames, the median ignores missed vblanks and stalls
+	std::array<float, 32> m_intervalSamples;
+	uint32_t m_intervalSampleCount;
+	//rises at once and decays slowly, so a single slow frame makes the pacer careful for a while
+	double m_predictedWorkMilliseconds;
+	//next start under EPresentPolicy::CappedFps
+	CTimer::Clock::time_point m_nextCappedStart;
+
+	CFrameHistory m_latencyHistory;
+	std::vector<SFrameLatency> m_records;
+	uint64_t m_completedFrames;
+	uint64_t m_presentWaitFrames;
+	double m_latencySumMilliseconds;
+	float m_latencyMaxMilliseconds;
+};
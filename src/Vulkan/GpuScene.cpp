@@ -0,0 +1,544 @@
+#include "vkpch.h"
+#include "GpuScene.h"
+
+#include "Assets/MeshFile.h"
+#include "Profiling/CpuProfiler.h"
+#include "Utils/Log.h"
+#include "Vulkan/BindlessTable.h"
+#include "Vulkan/ShaderRegistry.h"
+#include "Vulkan/UploadService.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <map>
+#include <random>
+
+/////////////////////////////////////////////////
+
+//the layouts below mirror the std430 structs in shaders/Scene.glsl, vertices are SMeshVertex
+struct SGpuMeshLod
+{
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	//in bounding radii, the last level takes everything beyond the others
+	float maxDistance;
+};
+
+struct SGpuObject
+{
+	//rows of the object to world transform
+	glm::vec4 transform[ 3 ];
+	//world space center and radius
+	glm::vec4 boundingSphere;
+	glm::vec4 color;
+	//texture id in the streamer's table
+	uint32_t material;
+	uint32_t reserved[ 3 ];
+};
+
+struct SCullConstants
+{
+	glm::vec4 frustumPlanes[ 6 ];
+	glm::vec3 cameraPosition;
+	uint32_t objectCount;
+	uint32_t objectBuffer;
+	uint32_t lodBuffer;
+	uint32_t drawBuffer;
+	uint32_t countBuffer;
+};
+
+struct SDrawConstants
+{
+	glm::mat4 viewProjection;
+	uint32_t objectBuffer;
+	uint32_t vertexBuffer;
+	uint32_t textureTable;
+	uint32_t sampler;
+};
+
+static_assert( sizeof( SCullConstants ) == 128, "SCullConstants must match the push constant block of cull.comp." );
+static_assert( sizeof( SGpuObject ) == 96, "SGpuObject must match SObject in Scene.glsl." );
+
+const uint32_t CULL_GROUP_SIZE = 64;
+
+//vertical field of view of the orbit camera, 60 degrees
+const float CAMERA_FOV_Y = glm::pi<float>() / 3.0f;
+const float CAMERA_NEAR = 0.5f;
+
+//subdivisions of the icosahedron per level of detail
+const uint32_t LOD_SUBDIVISIONS[ CGpuScene::LOD_COUNT ] = { 3, 1, 0 };
+
+
+//unit sphere, the normals are the positions
+static void buildIcosphere( uint32_t subdivisions, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices )
+{
+	const float t = ( 1.0f + std::sqrt( 5.0f ) ) * 0.5f;
+	positions =
+	{
+		{ -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+		{ 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+		{ t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+	};
+	for( glm::vec3& position : positions )
+	{
+		position = glm::normalize( position );
+	}
+
+	indices =
+	{
+		0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+		1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+		3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+		4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
+	};
+
+	for( uint32_t level = 0; level < subdivisions; ++level )
+	{
+		//shared edges get one midpoint, so the mesh stays indexed without cracks
+		std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+		auto midpoint = [ &positions, &midpoints ]( uint32_t a, uint32_t b )
+		{
+			const auto key = std::make_pair( std::min( a, b ), std::max( a, b ) );
+			const auto found = midpoints.find( key );
+			if( found != midpoints.end() )
+			{
+				return found->second;
+			}
+
+			const uint32_t index = static_cast< uint32_t >( positions.size() );
+			positions.push_back( glm::normalize( positions[ a ] + positions[ b ] ) );
+			midpoints.emplace( key, index );
+			return index;
+		};
+
+		std::vector<uint32_t> subdivided;
+		subdivided.reserve( indices.size() * 4 );
+		for( size_t i = 0; i < indices.size(); i += 3 )
+		{
+			const uint32_t a = indices[ i ];
+			const uint32_t b = indices[ i + 1 ];
+			const uint32_t c = indices[ i + 2 ];
+			const uint32_t ab = midpoint( a, b );
+			const uint32_t bc = midpoint( b, c );
+			const uint32_t ca = midpoint( c, a );
+
+			subdivided.insert( subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca } );
+		}
+		indices.swap( subdivided );
+	}
+}
+
+//wraps the texture once around the sphere, u has a seam where it wraps
+static glm::vec2 getSphereUv( const glm::vec3& position )
+{
+	const float u = 0.5f + std::atan2( position.z, position.x ) / glm::two_pi<float>();
+	const float v = std::acos( std::min( std::max( position.y, -1.0f ), 1.0f ) ) / glm::pi<float>();
+	return glm::vec2( u, v );
+}
+
+/////////////////////////////////////////////////
+
+CGpuScene::CGpuScene()
+	: m_device( nullptr )
+	, m_pAllocator( nullptr )
+	, m_pBindlessTable( nullptr )
+	, m_cullPipeline( nullptr )
+	, m_objectCount( 0 )
+	, m_meshBounds( 0.0f )
+	, m_sceneRadius( 0.0f )
+{
+}
+
+bool CGpuScene::IsSupported( const vk::PhysicalDevice& physicalDevice )
+{
+	auto featureChain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	const vk::PhysicalDeviceFeatures& features = featureChain.get<vk::PhysicalDeviceFeatures2>().features;
+	const vk::PhysicalDeviceVulkan12Features& vulkan12Features = featureChain.get<vk::PhysicalDeviceVulkan12Features>();
+
+	return features.multiDrawIndirect && features.drawIndirectFirstInstance && vulkan12Features.drawIndirectCount;
+}
+
+void CGpuScene::EnableFeatures( vk::PhysicalDeviceFeatures& features, vk::PhysicalDeviceVulkan12Features& vulkan12Features )
+{
+	features.setMultiDrawIndirect( VK_TRUE );
+	//the object index reaches the vertex shader as the first instance
+	features.setDrawIndirectFirstInstance( VK_TRUE );
+	vulkan12Features.setDrawIndirectCount( VK_TRUE );
+}
+
+void CGpuScene::init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, CDeviceMemoryAllocator& allocator, CUploadService& uploadService,
+	CBindlessTable& bindlessTable, const vk::PipelineCache& pipelineCache, const SSettings& settings )
+{
+	m_device = device;
+	m_pAllocator = &allocator;
+	m_pBindlessTable = &bindlessTable;
+
+	const uint32_t maxDrawCount = physicalDevice.getProperties().limits.maxDrawIndirectCount;
+	m_objectCount = std::min( std::max( settings.objectCount, 1u ), maxDrawCount );
+	if( m_objectCount < settings.objectCount )
+	{
+		VS_WARN( "The device draws at most {0} objects per indirect call, the scene is cut down from {1}.", maxDrawCount, settings.objectCount );
+	}
+
+	m_stats = SStats();
+	m_stats.objectCount = m_objectCount;
+
+	createMeshes( uploadService, settings );
+	createObjects( uploadService, settings );
+
+	m_drawBuffer = createBuffer( sizeof( vk::DrawIndexedIndirectCommand ) * m_objectCount,
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer );
+	m_countBuffer = createBuffer( sizeof( uint32_t ), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+		vk::BufferUsageFlagBits::eTransferDst );
+
+	createCullPipeline( pipelineCache );
+}
+
+void CGpuScene::destroy()
+{
+	if( !m_device )
+	{
+		return;
+	}
+
+	m_device.destroyPipeline( m_cullPipeline );
+	m_cullPipeline = nullptr;
+
+	for( SBuffer* pBuffer : { &m_vertexBuffer, &m_indexBuffer, &m_lodBuffer, &m_objectBuffer, &m_drawBuffer, &m_countBuffer } )
+	{
+		destroyBuffer( *pBuffer );
+	}
+
+	m_objectCount = 0;
+	m_device = nullptr;
+}
+
+CGpuScene::SCamera CGpuScene::getOrbitCamera( double seconds, float aspectRatio ) const
+{
+	//a full orbit every two minutes, low enough to look across the grid towards the horizon
+	const float angle = static_cast< float >( seconds / 120.0 ) * glm::two_pi<float>();
+	const float orbitRadius = m_sceneRadius * 0.6f;
+
+	SCamera camera;
+	camera.position = glm::vec3( std::cos( angle ) * orbitRadius, m_sceneRadius * 0.08f + 4.0f, std::sin( angle ) * orbitRadius );
+
+	const glm::mat4 view = glm::lookAt( camera.position, glm::vec3( 0.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+	glm::mat4 projection = glm::perspective( CAMERA_FOV_Y, aspectRatio, CAMERA_NEAR, m_sceneRadius * 2.0f );
+	//Vulkan clip space points y down
+	projection[ 1 ][ 1 ] *= -1.0f;
+
+	camera.viewProjection = projection * view;
+	return camera;
+}
+
+void CGpuScene::recordCulling( const vk::CommandBuffer& commandBuffer, const SCamera& camera )
+{
+	VS_PROFILE_SCOPE( "record culling" );
+
+	//the previous frame's draws are done reading the list before it is reset
+	vk::MemoryBarrier toReset( {}, vk::AccessFlagBits::eTransferWrite );
+	commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eDrawIndirect, vk::PipelineStageFlagBits::eTransfer, {}, toReset, nullptr, nullptr );
+	commandBuffer.fillBuffer( m_countBuffer.buffer, 0, sizeof( uint32_t ), 0 );
+
+	vk::MemoryBarrier toCull( vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite );
+	commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eDrawIndirect, vk::PipelineStageFlagBits::eComputeShader,
+		{}, toCull, nullptr, nullptr );
+
+	SCullConstants constants;
+	//Gribb-Hartmann, the rows of the view projection give planes with normals pointing inwards
+	const glm::mat4& m = camera.viewProjection;
+	const glm::vec4 rows[ 4 ] =
+	{
+		glm::vec4( m[ 0 ][ 0 ], m[ 1 ][ 0 ], m[ 2 ][ 0 ], m[ 3 ][ 0 ] ),
+		glm::vec4( m[ 0 ][ 1 ], m[ 1 ][ 1 ], m[ 2 ][ 1 ], m[ 3 ][ 1 ] ),
+		glm::vec4( m[ 0 ][ 2 ], m[ 1 ][ 2 ], m[ 2 ][ 2 ], m[ 3 ][ 2 ] ),
+		glm::vec4( m[ 0 ][ 3 ], m[ 1 ][ 3 ], m[ 2 ][ 3 ], m[ 3 ][ 3 ] )
+	};
+	constants.frustumPlanes[ 0 ] = rows[ 3 ] + rows[ 0 ];
+	constants.frustumPlanes[ 1 ] = rows[ 3 ] - rows[ 0 ];
+	constants.frustumPlanes[ 2 ] = rows[ 3 ] + rows[ 1 ];
+	constants.frustumPlanes[ 3 ] = rows[ 3 ] - rows[ 1 ];
+	//depth is 0..1, so near is the third row alone
+	constants.frustumPlanes[ 4 ] = rows[ 2 ];
+	constants.frustumPlanes[ 5 ] = rows[ 3 ] - rows[ 2 ];
+	for( glm::vec4& plane : constants.frustumPlanes )
+	{
+		plane /= glm::length( glm::vec3( plane ) );
+	}
+
+	constants.cameraPosition = camera.position;
+	constants.objectCount = m_objectCount;
+	constants.objectBuffer = m_objectBuffer.handle;
+	constants.lodBuffer = m_lodBuffer.handle;
+	constants.drawBuffer = m_drawBuffer.handle;
+	constants.countBuffer = m_countBuffer.handle;
+
+	commandBuffer.bindPipeline( vk::PipelineBindPoint::eCompute, m_cullPipeline );
+	m_pBindlessTable->bind( commandBuffer, vk::PipelineBindPoint::eCompute );
+	m_pBindlessTable->pushConstants( commandBuffer, constants );
+	commandBuffer.dispatch( ( m_objectCount + CULL_GROUP_SIZE - 1 ) / CULL_GROUP_SIZE, 1, 1 );
+
+	vk::MemoryBarrier toDraw( vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead );
+	commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, toDraw, nullptr, nullptr );
+}
+
+void CGpuScene::recordDraws( const vk::CommandBuffer& commandBuffer, const SCamera& camera, uint32_t textureTable, uint32_t sampler )
+{
+	SDrawConstants constants;
+	constants.viewProjection = camera.viewProjection;
+	constants.objectBuffer = m_objectBuffer.handle;
+	constants.vertexBuffer = m_vertexBuffer.handle;
+	constants.textureTable = textureTable;
+	constants.sampler = sampler;
+	m_pBindlessTable->pushConstants( commandBuffer, constants );
+
+	commandBuffer.bindIndexBuffer( m_indexBuffer.buffer, 0, vk::IndexType::eUint32 );
+	commandBuffer.drawIndexedIndirectCount( m_drawBuffer.buffer, 0, m_countBuffer.buffer, 0, m_objectCount, sizeof( vk::DrawIndexedIndirectCommand ) );
+}
+
+void CGpuScene::getMaterialScreenSizes( const SCamera& camera, float viewportHeight, std::vector<float>& sizes ) const
+{
+	//pixels per world unit at distance 1
+	const float focalLength = viewportHeight * 0.5f / std::tan( CAMERA_FOV_Y * 0.5f );
+
+	sizes.resize( m_materialBounds.size() );
+	for( size_t material = 0; material < m_materialBounds.size(); ++material )
+	{
+		const glm::vec4& bounds = m_materialBounds[ material ];
+		const float distance = std::max( glm::length( glm::vec3( bounds ) - camera.position ) - bounds.w, CAMERA_NEAR );
+		sizes[ material ] = 2.0f * m_materialObjectRadii[ material ] * focalLength / distance;
+	}
+}
+
+void CGpuScene::logStats() const
+{
+	if( !isInitialized() )
+	{
+		return;
+	}
+
+	VS_INFO( "GPU scene: {0} objects, LOD triangles {1}/{2}/{3}, {4:.2f} MiB of buffers", m_stats.objectCount,
+		m_stats.lodTriangles[ 0 ], m_stats.lodTriangles[ 1 ], m_stats.lodTriangles[ 2 ], m_stats.bufferBytes / ( 1024.0 * 1024.0 ) );
+}
+
+/////////////////////////////////////////////////
+
+CGpuScene::SBuffer CGpuScene::createBuffer( vk::DeviceSize size, vk::BufferUsageFlags usage )
+{
+	SBuffer buffer;
+	vk::BufferCreateInfo createInfo( {}, size, usage | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive );
+	buffer.buffer = m_device.createBuffer( createInfo );
+	buffer.allocation = m_pAllocator->allocateForBuffer( buffer.buffer, EMemoryUsage::GpuOnly );
+	buffer.handle = ( usage & vk::BufferUsageFlagBits::eStorageBuffer ) ? m_pBindlessTable->registerBuffer( buffer.buffer ) : CBindlessTable::INVALID_HANDLE;
+
+	m_stats.bufferBytes += size;
+	return buffer;
+}
+
+void CGpuScene::destroyBuffer( SBuffer& buffer )
+{
+	//the table is torn down with the scene, its slots need not be returned
+	m_device.destroyBuffer( buffer.buffer );
+	m_pAllocator->free( buffer.allocation );
+	buffer = SBuffer();
+}
+
+void CGpuScene::createMeshes( CUploadService& uploadService, const SSettings& settings )
+{
+	if( !settings.meshFile.empty() )
+	{
+		loadMeshFile( uploadService, settings );
+		return;
+	}
+
+	std::vector<SMeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<SGpuMeshLod> lods( LOD_COUNT );
+
+	for( uint32_t lod = 0; lod < LOD_COUNT; ++lod )
+	{
+		std::vector<glm::vec3> lodPositions;
+		std::vector<uint32_t> lodIndices;
+		buildIcosphere( LOD_SUBDIVISIONS[ lod ], lodPositions, lodIndices );
+
+		lods[ lod ].indexCount = static_cast< uint32_t >( lodIndices.size() );
+		lods[ lod ].firstIndex = static_cast< uint32_t >( indices.size() );
+		lods[ lod ].vertexOffset = static_cast< int32_t >( vertices.size() );
+		lods[ lod ].maxDistance = ( lod + 1 < LOD_COUNT ) ? settings.lodDistances[ lod ] : std::numeric_limits<float>::max();
+		m_stats.lodTriangles[ lod ] = lods[ lod ].indexCount / 3;
+
+		for( const glm::vec3& position : lodPositions )
+		{
+			const glm::vec2 uv = getSphereUv( position );
+			vertices.push_back( SMeshVertex { { position.x, position.y, position.z }, { position.x, position.y, position.z }, { uv.x, uv.y } } );
+		}
+		indices.insert( indices.end(), lodIndices.begin(), lodIndices.end() );
+	}
+
+	m_meshBounds = glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+
+	const vk::DeviceSize vertexBytes = vertices.size() * sizeof( SMeshVertex );
+	const vk::DeviceSize indexBytes = indices.size() * sizeof( uint32_t );
+	const vk::DeviceSize lodBytes = lods.size() * sizeof( SGpuMeshLod );
+
+	m_vertexBuffer = createBuffer( vertexBytes, vk::BufferUsageFlagBits::eStorageBuffer );
+	m_indexBuffer = createBuffer( indexBytes, vk::BufferUsageFlagBits::eIndexBuffer );
+	m_lodBuffer = createBuffer( lodBytes, vk::BufferUsageFlagBits::eStorageBuffer );
+
+	uploadService.uploadBuffer( m_vertexBuffer.buffer, 0, vertices.data(), vertexBytes, vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead );
+	uploadService.uploadBuffer( m_indexBuffer.buffer, 0, indices.data(), indexBytes, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eIndexRead );
+	uploadService.uploadBuffer( m_lodBuffer.buffer, 0, lods.data(), lodBytes, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead );
+}
+
+void CGpuScene::loadMeshFile( CUploadService& uploadService, const SSettings& settings )
+{
+	VS_PROFILE_SCOPE( "load mesh file" );
+
+	CMeshFile meshFile;
+	meshFile.open( settings.meshFile );
+
+	const CMeshFile::SView<SMeshRecord> meshes = meshFile.getMeshes();
+	if( meshes.count == 0 || meshes[ 0 ].lodCount == 0 )
+	{
+		throw std::runtime_error( "Mesh file '" + settings.meshFile + "' has no mesh to draw." );
+	}
+
+	//only the first mesh is drawn: its vertices and the index range of its levels are read, meshlets are not touched
+	const SMeshRecord& mesh = meshes[ 0 ];
+	const uint32_t lodCount = std::min( mesh.lodCount, MESH_MAX_LODS );
+
+	uint32_t firstIndex = UINT32_MAX;
+	uint32_t endIndex = 0;
+	for( uint32_t lod = 0; lod < lodCount; ++lod )
+	{
+		firstIndex = std::min( firstIndex, mesh.lods[ lod ].firstIndex );
+		endIndex = std::max( endIndex, mesh.lods[ lod ].firstIndex + mesh.lods[ lod ].indexCount );
+	}
+
+	//levels without indices would leave nothing to create buffers for
+	if( endIndex <= firstIndex || mesh.vertexCount == 0 )
+	{
+		throw std::runtime_error( "Mesh file '" + settings.meshFile + "' has no mesh to draw." );
+	}
+
+	meshFile.prefetchSection( EMeshSection::Vertices, mesh.firstVertex, mesh.vertexCount );
+	meshFile.prefetchSection( EMeshSection::Indices, firstIndex, endIndex - firstIndex );
+
+	//the vertex shader fetches vertices by index, one out of range reads past the vertex buffer
+	const CMeshFile::SView<uint32_t> indices = meshFile.getSection<uint32_t>( EMeshSection::Indices );
+	for( uint64_t i = firstIndex; i < endIndex; ++i )
+	{
+		if( indices[ i ] >= mesh.vertexCount )
+		{
+			throw std::runtime_error( "Mesh file '" + settings.meshFile + "' has an index past the vertices of its mesh." );
+		}
+	}
+
+	//levels the file lacks repeat its least detailed one
+	std::vector<SGpuMeshLod> lods( LOD_COUNT );
+	for( uint32_t lod = 0; lod < LOD_COUNT; ++lod )
+	{
+		const SMeshLod& fileLod = mesh.lods[ std::min( lod, lodCount - 1 ) ];
+		lods[ lod ].indexCount = fileLod.indexCount;
+		lods[ lod ].firstIndex = fileLod.firstIndex - firstIndex;
+		//indices are relative to the mesh's first vertex, which lands at the start of the buffer
+		lods[ lod ].vertexOffset = 0;
+		lods[ lod ].maxDistance = ( lod + 1 < LOD_COUNT ) ? settings.lodDistances[ lod ] : std::numeric_limits<float>::max();
+		m_stats.lodTriangles[ lod ] = lods[ lod ].indexCount / 3;
+	}
+
+	m_meshBounds = glm::vec4( mesh.boundingSphere[ 0 ], mesh.boundingSphere[ 1 ], mesh.boundingSphere[ 2 ], std::max( mesh.boundingSphere[ 3 ], 1e-6f ) );
+
+	const vk::DeviceSize lodBytes = lods.size() * sizeof( SGpuMeshLod );
+	m_vertexBuffer = createBuffer( static_cast< vk::DeviceSize >( mesh.vertexCount ) * sizeof( SMeshVertex ), vk::BufferUsageFlagBits::eStorageBuffer );
+	m_indexBuffer = createBuffer( static_cast< vk::DeviceSize >( endIndex - firstIndex ) * sizeof( uint32_t ), vk::BufferUsageFlagBits::eIndexBuffer );
+	m_lodBuffer = createBuffer( lodBytes, vk::BufferUsageFlagBits::eStorageBuffer );
+
+	//straight from the mapping into staging memory, the file is never copied into a vector
+	meshFile.uploadSection( EMeshSection::Vertices, mesh.firstVertex, mesh.vertexCount, uploadService, m_vertexBuffer.buffer, 0,
+		vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead );
+	meshFile.uploadSection( EMeshSection::Indices, firstIndex, endIndex - firstIndex, uploadService, m_indexBuffer.buffer, 0,
+		vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eIndexRead );
+	uploadService.uploadBuffer( m_lodBuffer.buffer, 0, lods.data(), lodBytes, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead );
+
+	VS_INFO( "Loaded mesh 0 of {0} from '{1}': {2} vertices, {3} of {4} bytes read.", meshes.count, settings.meshFile, mesh.vertexCount,
+		static_cast< uint64_t >( mesh.vertexCount ) * sizeof( SMeshVertex ) + static_cast< uint64_t >( endIndex - firstIndex ) * sizeof( uint32_t ), meshFile.getFileSize() );
+}
+
+void CGpuScene::createObjects( CUploadService& uploadService, const SSettings& settings )
+{
+	//square grid around the origin, every object jittered inside its cell
+	const uint32_t gridSize = static_cast< uint32_t >( std::ceil( std::sqrt( static_cast< double >( m_objectCount ) ) ) );
+	const float halfExtent = gridSize * settings.spacing * 0.5f;
+	m_sceneRadius = halfExtent * std::sqrt( 2.0f );
+
+	std::mt19937 random( settings.seed );
+	std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+
+	//materials go to square tiles of the grid, so the camera is close to some and far from others
+	const uint32_t materialCount = std::max( settings.materialCount, 1u );
+	const uint32_t tilesPerRow = static_cast< uint32_t >( std::ceil( std::sqrt( static_cast< double >( materialCount ) ) ) );
+	const uint32_t tileSize = ( gridSize + tilesPerRow - 1 ) / tilesPerRow;
+	std::vector<glm::vec3> boundsMin( materialCount, glm::vec3( std::numeric_limits<float>::max() ) );
+	std::vector<glm::vec3> boundsMax( materialCount, glm::vec3( -std::numeric_limits<float>::max() ) );
+	m_materialObjectRadii.assign( materialCount, 0.0f );
+
+	std::vector<SGpuObject> objects( m_objectCount );
+	for( uint32_t i = 0; i < m_objectCount; ++i )
+	{
+		const float x = ( i % gridSize + 0.2f + unit( random ) * 0.6f ) * settings.spacing - halfExtent;
+		const float z = ( i / gridSize + 0.2f + unit( random ) * 0.6f ) * settings.spacing - halfExtent;
+		const float scale = settings.spacing * ( 0.1f + unit( random ) * 0.2f );
+		const glm::vec3 center( x, scale + unit( random ) * settings.spacing, z );
+
+		//the mesh's bounding sphere is mapped onto the sphere of the given center and radius
+		const float meshScale = scale / m_meshBounds.w;
+		const glm::vec3 translation = center - glm::vec3( m_meshBounds ) * meshScale;
+
+		SGpuObject& object = objects[ i ];
+		object.transform[ 0 ] = glm::vec4( meshScale, 0.0f, 0.0f, translation.x );
+		object.transform[ 1 ] = glm::vec4( 0.0f, meshScale, 0.0f, translation.y );
+		object.transform[ 2 ] = glm::vec4( 0.0f, 0.0f, meshScale, translation.z );
+		object.boundingSphere = glm::vec4( center, scale );
+		object.color = glm::vec4( 0.3f + unit( random ) * 0.7f, 0.3f + unit( random ) * 0.7f, 0.3f + unit( random ) * 0.7f, 1.0f );
+		object.material = ( ( i / gridSize ) / tileSize * tilesPerRow + ( i % gridSize ) / tileSize ) % materialCount;
+
+		boundsMin[ object.material ] = glm::min( boundsMin[ object.material ], center - scale );
+		boundsMax[ object.material ] = glm::max( boundsMax[ object.material ], center + scale );
+		m_materialObjectRadii[ object.material ] = std::max( m_materialObjectRadii[ object.material ], scale );
+	}
+
+	//materials without objects get an empty sphere at the origin
+	m_materialBounds.assign( materialCount, glm::vec4( 0.0f ) );
+	for( uint32_t material = 0; material < materialCount; ++material )
+	{
+		if( m_materialObjectRadii[ material ] > 0.0f )
+		{
+			const glm::vec3 center = ( boundsMin[ material ] + boundsMax[ material ] ) * 0.5f;
+			m_materialBounds[ material ] = glm::vec4( center, glm::length( boundsMax[ material ] - center ) );
+		}
+	}
+
+	const vk::DeviceSize objectBytes = objects.size() * sizeof( SGpuObject );
+	m_objectBuffer = createBuffer( objectBytes, vk::BufferUsageFlagBits::eStorageBuffer );
+	uploadService.uploadBuffer( m_objectBuffer.buffer, 0, objects.data(), objectBytes, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eVertexShader,
+		vk::AccessFlagBits::eShaderRead );
+}
+
+void CGpuScene::createCullPipeline( const vk::PipelineCache& pipelineCache )
+{
+	const vk::ShaderModule shaderModule = m_device.createShaderModule( CShaderRegistry::Get( "cull.comp" ).getModuleCreateInfo() );
+
+	vk::PipelineShaderStageCreateInfo stage( {}, vk::ShaderStageFlagBits::eCompute, shaderModule, "main" );
+	vk::ComputePipelineCreateInfo createInfo( {}, stage, m_pBindlessTable->getPipelineLayout() );
+	auto resultValue = m_device.createComputePipeline( pipelineCache, createInfo );
+
+	m_device.destroyShaderModule( shaderModule );
+
+	if( resultValue.result != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "Failed to create the culling pipeline." );
+	}
+	m_cullPipeline = resultValue.value;
+}
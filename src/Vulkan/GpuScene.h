@@ -0,0 +1,124 @@
+#pragma once
+#include "Memory/DeviceMemoryAllocator.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+class CBindlessTable;
+class CUploadService;
+
+//Objects drawn without the CPU touching them per frame. Transforms and bounds live in a
+//storage buffer, a compute pass culls them against the frustum, picks a level of detail and
+//appends one VkDrawIndexedIndirectCommand per visible object, and the draw pass consumes
+//that list with drawIndexedIndirectCount. The CPU cost of a frame does not depend on the
+//object count. Every object is an instance of the same mesh with LOD_COUNT levels of detail.
+class CGpuScene
+{
+public:
+	static constexpr uint32_t LOD_COUNT = 3;
+
+	struct SSettings
+	{
+		uint32_t objectCount = 100000;
+		//distance between neighbours on the grid the objects are scattered over
+		float spacing = 4.0f;
+		//distance in bounding radii up to which each level but the last is used
+		float lodDistances[ LOD_COUNT - 1 ] = { 24.0f, 96.0f };
+		uint32_t seed = 1;
+		//.vksm file whose first mesh replaces the procedural sphere, see src/Assets/MeshFormat.h
+		std::string meshFile;
+		//textures the objects sample, handed out by tiles of the grid so each one covers an area.
+		//0 leaves the objects untextured.
+		uint32_t materialCount = 0;
+	};
+
+	struct SCamera
+	{
+		glm::mat4 viewProjection;
+		glm::vec3 position;
+	};
+
+	struct SStats
+	{
+		uint32_t objectCount = 0;
+		uint32_t lodTriangles[ LOD_COUNT ] = {};
+		vk::DeviceSize bufferBytes = 0;
+	};
+
+public:
+	CGpuScene();
+
+	//multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount
+	static bool IsSupported( const vk::PhysicalDevice& physicalDevice );
+	static void EnableFeatures( vk::PhysicalDeviceFeatures& features, vk::PhysicalDeviceVulkan12Features& vulkan12Features );
+
+	//queues the uploads of every buffer, they are used once the frame that flushes them waits for them
+	void init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, CDeviceMemoryAllocator& allocator, CUploadService& uploadService,
+		CBindlessTable& bindlessTable, const vk::PipelineCache& pipelineCache, const SSettings& settings );
+	void destroy();
+
+	//camera circling the scene, seconds drives the orbit
+	SCamera getOrbitCamera( double seconds, float aspectRatio ) const;
+
+	//outside of a render pass: resets the draw count, culls and makes the draws visible to the indirect stage
+	void recordCulling( const vk::CommandBuffer& commandBuffer, const SCamera& camera );
+	//inside the render pass, with a pipeline made of scene.vert and scene.frag bound. textureTable is the
+	//bindless storage buffer mapping materials to texture slots, INVALID_HANDLE draws untextured.
+	void recordDraws( const vk::CommandBuffer& commandBuffer, const SCamera& camera, uint32_t textureTable, uint32_t sampler );
+
+	//per material, the largest diameter in pixels any of its objects can cover on a viewport that high
+	void getMaterialScreenSizes( const SCamera& camera, float viewportHeight, std::vector<float>& sizes ) const;
+
+	inline bool isInitialized() const
+	{
+		return m_objectCount > 0;
+	}
+
+	inline const SStats& getStats() const
+	{
+		return m_stats;
+	}
+
+	void logStats() const;
+
+private:
+	struct SBuffer
+	{
+		vk::Buffer buffer;
+		SAllocation allocation;
+		//slot in the bindless table, storage buffers only
+		uint32_t handle = UINT32_MAX;
+	};
+
+	SBuffer createBuffer( vk::DeviceSize size, vk::BufferUsageFlags usage );
+	void destroyBuffer( SBuffer& buffer );
+	void createMeshes( CUploadService& uploadService, const SSettings& settings );
+	void loadMeshFile( CUploadService& uploadService, const SSettings& settings );
+	void createObjects( CUploadService& uploadService, const SSettings& settings );
+	void createCullPipeline( const vk::PipelineCache& pipelineCache );
+
+	vk::Device m_device;
+	CDeviceMemoryAllocator* m_pAllocator;
+	CBindlessTable* m_pBindlessTable;
+
+	//vertices are pulled from a storage buffer, only indices go through the input assembler
+	SBuffer m_vertexBuffer;
+	SBuffer m_indexBuffer;
+	SBuffer m_lodBuffer;
+	SBuffer m_objectBuffer;
+	//written by the culling pass every frame
+	SBuffer m_drawBuffer;
+	SBuffer m_countBuffer;
+
+	vk::Pipeline m_cullPipeline;
+
+	uint32_t m_objectCount;
+	//object space bounding sphere of the mesh, objects are scaled by its radius
+	glm::vec4 m_meshBounds;
+	//the grid the objects are scattered over, for the camera
+	float m_sceneRadius;
+	//world space sphere around every object of a material, and the largest object radius among them
+	std::vector<glm::vec4> m_materialBounds;
+	std::vector<float> m_materialObjectRadii;
+	SStats m_stats;
+};
@@ -0,0 +1,173 @@
+#include "vkpch.h"
+#include "InstanceRenderer.h"
+
+#include "Profiling/CpuProfiler.h"
+#include "Utils/Log.h"
+#include "Vulkan/BindlessTable.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+/////////////////////////////////////////////////
+
+struct SInstanceConstants
+{
+	glm::mat4 viewProjection;
+};
+
+const uint32_t INSTANCE_STRIDE = CInstanceTransforms::FLOATS_PER_INSTANCE * sizeof( float );
+
+//a frame that stalls, e.g. while the window is dragged, does not make the instances jump
+const float MAX_STEP_SECONDS = 0.1f;
+
+const float CAMERA_FOV_Y = glm::pi<float>() / 3.0f;
+
+/////////////////////////////////////////////////
+
+CInstanceRenderer::CInstanceRenderer()
+	: m_pAllocator( nullptr )
+	, m_pBindlessTable( nullptr )
+	, m_gridRadius( 0.0f )
+{
+}
+
+void CInstanceRenderer::GetVertexInput( std::vector<vk::VertexInputBindingDescription>& bindings, std::vector<vk::VertexInputAttributeDescription>& attributes )
+{
+	bindings = { vk::VertexInputBindingDescription( 0, INSTANCE_STRIDE, vk::VertexInputRate::eInstance ) };
+
+	attributes.clear();
+	for( uint32_t row = 0; row < 3; ++row )
+	{
+		attributes.push_back( vk::VertexInputAttributeDescription( row, 0, vk::Format::eR32G32B32A32Sfloat, row * 4 * sizeof( float ) ) );
+	}
+}
+
+void CInstanceRenderer::init( const vk::Device& device, CDeviceMemoryAllocator& allocator, CBindlessTable& bindlessTable, uint32_t framesInFlight, const SSettings& settings )
+{
+	VS_PROFILE_SCOPE( "init instances" );
+
+	m_device = device;
+	m_pAllocator = &allocator;
+	m_pBindlessTable = &bindlessTable;
+
+	//square grid in the xz plane, each triangle spins around its own y axis at its own rate
+	const uint32_t side = static_cast< uint32_t >( std::ceil( std::sqrt( static_cast< double >( settings.instanceCount ) ) ) );
+	const float halfExtent = ( side - 1 ) * settings.spacing * 0.5f;
+	m_gridRadius = halfExtent * std::sqrt( 2.0f ) + settings.spacing;
+
+	std::mt19937 random( settings.seed );
+	std::uniform_real_distribution<float> jitter( -0.25f, 0.25f );
+	std::uniform_real_distribution<float> scale( 0.6f, 1.2f );
+	std::uniform_real_distribution<float> angle( -glm::pi<float>(), glm::pi<float>() );
+	std::uniform_real_distribution<float> angularVelocity( -4.0f, 4.0f );
+
+	m_transforms.clear();
+	m_transforms.reserve( settings.instanceCount );
+	for( uint32_t i = 0; i < settings.instanceCount; ++i )
+	{
+		CInstanceTransforms::SInstance instance;
+		instance.position = glm::vec3( ( i % side ) * settings.spacing - halfExtent, jitter( random ), ( i / side ) * settings.spacing - halfExtent );
+		instance.scale = scale( random );
+		instance.angle = angle( random );
+		instance.angularVelocity = angularVelocity( random );
+		m_transforms.add( instance );
+	}
+
+	//padded to whole SIMD batches, the padding instances are degenerate
+	const vk::DeviceSize bufferSize = static_cast< vk::DeviceSize >( std::max( m_transforms.getPaddedCount(), 1u ) ) * INSTANCE_STRIDE;
+	m_frameBuffers.resize( framesInFlight );
+	for( SFrameBuffer& frameBuffer : m_frameBuffers )
+	{
+		vk::BufferCreateInfo createInfo( {}, bufferSize, vk::BufferUsageFlagBits::eVertexBuffer, vk::SharingMode::eExclusive );
+		frameBuffer.buffer = m_device.createBuffer( createInfo );
+		frameBuffer.allocation = m_pAllocator->allocateForBuffer( frameBuffer.buffer, EMemoryUsage::CpuToGpu );
+
+		//the transforms are written with aligned streaming stores
+		if( reinterpret_cast< uintptr_t >( frameBuffer.allocation.pMapped ) % 16 != 0 )
+		{
+			throw std::runtime_error( "Instance buffer is not mapped at a 16 byte boundary." );
+		}
+
+		//nothing is drawn from it before its first update, but it should not be garbage either
+		m_transforms.update( 0.0f, reinterpret_cast< float* >( frameBuffer.allocation.pMapped ) );
+		m_pAllocator->flush( frameBuffer.allocation );
+	}
+
+	m_stats = SStats();
+	m_stats.instanceCount = m_transforms.getCount();
+	m_stats.bufferBytes = bufferSize * framesInFlight;
+	m_stepTimer.reset();
+}
+
+void CInstanceRenderer::destroy()
+{
+	if( !m_device )
+	{
+		return;
+	}
+
+	for( SFrameBuffer& frameBuffer : m_frameBuffers )
+	{
+		m_device.destroyBuffer( frameBuffer.buffer );
+		m_pAllocator->free( frameBuffer.allocation );
+	}
+	m_frameBuffers.clear();
+	m_transforms.clear();
+
+	m_device = nullptr;
+}
+
+void CInstanceRenderer::update( uint32_t frameIndex, CJobSystem& jobSystem, CJobCounter& counter )
+{
+	const float stepSeconds = std::min( static_cast< float >( m_stepTimer.elapsedMilliseconds() / 1000.0 ), MAX_STEP_SECONDS );
+	m_stepTimer.reset();
+	m_updateTimer.reset();
+
+	const SFrameBuffer& frameBuffer = m_frameBuffers[ frameIndex ];
+	m_transforms.update( stepSeconds, reinterpret_cast< float* >( frameBuffer.allocation.pMapped ), jobSystem, m_batchJobs );
+
+	//only does something on non coherent memory
+	jobSystem.run( [ this, &frameBuffer ]()
+	{
+		m_pAllocator->flush( frameBuffer.allocation );
+
+		const double milliseconds = m_updateTimer.elapsedMilliseconds();
+		m_stats.updateMilliseconds = milliseconds;
+		m_stats.maxUpdateMilliseconds = std::max( m_stats.maxUpdateMilliseconds, milliseconds );
+		++m_stats.updates;
+	}, &counter, { &m_batchJobs } );
+}
+
+void CInstanceRenderer::recordDraw( const vk::CommandBuffer& commandBuffer, uint32_t frameIndex, float aspectRatio ) const
+{
+	//looking down across the grid from one side
+	const glm::vec3 cameraPosition( 0.0f, m_gridRadius * 0.5f + 2.0f, m_gridRadius * 1.1f + 2.0f );
+	const glm::mat4 view = glm::lookAt( cameraPosition, glm::vec3( 0.0f, 0.0f, -m_gridRadius * 0.2f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+	glm::mat4 projection = glm::perspective( CAMERA_FOV_Y, aspectRatio, 0.5f, m_gridRadius * 4.0f + 4.0f );
+	//Vulkan clip space points y down
+	projection[ 1 ][ 1 ] *= -1.0f;
+
+	SInstanceConstants constants;
+	constants.viewProjection = projection * view;
+	m_pBindlessTable->pushConstants( commandBuffer, constants );
+
+	commandBuffer.bindVertexBuffers( 0, m_frameBuffers[ frameIndex ].buffer, vk::DeviceSize( 0 ) );
+	commandBuffer.draw( 3, m_transforms.getCount(), 0, 0 );
+}
+
+CInstanceRenderer::SStats CInstanceRenderer::getStats() const
+{
+	return m_stats;
+}
+
+void CInstanceRenderer::logStats() const
+{
+	if( !isInitialized() )
+	{
+		return;
+	}
+
+	VS_INFO( "Instances: {0} in {1:.2f} MiB of mapped buffers, last update took {2:.3f} ms, slowest {3:.3f} ms over {4} updates", m_stats.instanceCount,
+		m_stats.bufferBytes / ( 1024.0 * 1024.0 ), m_stats.updateMilliseconds, m_stats.maxUpdateMilliseconds, m_stats.updates );
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Memory/DeviceMemoryAllocator.h"
+#include "Utils/InstanceTransforms.h"
+#include "Utils/JobSystem.h"
+#include "Utils/Timer.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+class CBindlessTable;
+
+//Many small spinning triangles in one instanced draw. Their transforms are advanced on the
+//CPU every frame by CInstanceTransforms, in SIMD batches spread across job threads, and
+//written straight into a persistently mapped vertex buffer per frame in flight that
+//instanced.vert reads at instance rate. Nothing is copied or staged on the way to the GPU.
+class CInstanceRenderer
+{
+public:
+	struct SSettings
+	{
+		uint32_t instanceCount = 100000;
+		//distance between neighbours on the grid the instances are laid out on
+		float spacing = 1.5f;
+		uint32_t seed = 1;
+	};
+
+	struct SStats
+	{
+		uint32_t instanceCount = 0;
+		vk::DeviceSize bufferBytes = 0;
+		uint64_t updates = 0;
+		//from queueing a frame's update to its last batch being written
+		double updateMilliseconds = 0.0;
+		double maxUpdateMilliseconds = 0.0;
+	};
+
+public:
+	CInstanceRenderer();
+
+	//vertex input of pipelines drawing with recordDraw(), three vec4 rows per instance at binding 0
+	static void GetVertexInput( std::vector<vk::VertexInputBindingDescription>& bindings, std::vector<vk::VertexInputAttributeDescription>& attributes );
+
+	void init( const vk::Device& device, CDeviceMemoryAllocator& allocator, CBindlessTable& bindlessTable, uint32_t framesInFlight, const SSettings& settings );
+	//the device has to be idle
+	void destroy();
+
+	//queues the update of frameIndex's buffer as jobs counted by counter, the frame that last used
+	//it has to be complete. The buffer may be submitted once the counter is done.
+	void update( uint32_t frameIndex, CJobSystem& jobSystem, CJobCounter& counter );
+	//inside a render pass, with a pipeline of instanced.vert and the vertex input above bound
+	void recordDraw( const vk::CommandBuffer& commandBuffer, uint32_t frameIndex, float aspectRatio ) const;
+
+	inline bool isInitialized() const
+	{
+		return static_cast< bool >( m_device );
+	}
+
+	SStats getStats() const;
+	void logStats() const;
+
+private:
+	struct SFrameBuffer
+	{
+		vk::Buffer buffer;
+		SAllocation allocation;
+	};
+
+	vk::Device m_device;
+	CDeviceMemoryAllocator* m_pAllocator;
+	CBindlessTable* m_pBindlessTable;
+
+	CInstanceTransforms m_transforms;
+	std::vector<SFrameBuffer> m_frameBuffers;
+	//the grid the instances are laid out on, for the camera
+	float m_gridRadius;
+
+	//time since the last update, the step every instance advances by
+	CTimer m_stepTimer;
+	CTimer m_updateTimer;
+	//batches of the update in flight, the caller's counter waits on the flush after them
+	CJobCounter m_batchJobs;
+	SStats m_stats;
+};
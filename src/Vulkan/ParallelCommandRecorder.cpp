@@ -0,0 +1,230 @@
+#include "vkpch.h"
+#include "ParallelCommandRecorder.h"
+
+#include "Profiling/CpuProfiler.h"
+#include "Utils/JobSystem.h"
+#include "Utils/Log.h"
+#include "Utils/Timer.h"
+#include "Vulkan/VulkanUtils.h"
+
+/////////////////////////////////////////////////
+
+CParallelCommandRecorder::CParallelCommandRecorder()
+	: m_device( nullptr )
+	, m_pJobSystem( nullptr )
+	, m_sliceCount( 0 )
+	, m_framesInFlight( 0 )
+	, m_frameIndex( 0 )
+	, m_activeSlices( 0 )
+	, m_pContext( nullptr )
+	, m_pDraws( nullptr )
+{
+}
+
+CParallelCommandRecorder::~CParallelCommandRecorder()
+{
+	destroy();
+}
+
+void CParallelCommandRecorder::init( const vk::Device& device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t sliceCount, CJobSystem& jobSystem )
+{
+	m_device = device;
+	m_pJobSystem = &jobSystem;
+	m_sliceCount = std::max( sliceCount > 0 ? sliceCount : jobSystem.getThreadCount(), 1u );
+	m_framesInFlight = std::max( framesInFlight, 1u );
+
+	m_commandPools.resize( static_cast< size_t >( m_framesInFlight ) * m_sliceCount );
+	m_secondaryBuffers.resize( m_commandPools.size() );
+
+	for( size_t i = 0; i < m_commandPools.size(); ++i )
+	{
+		vk::CommandPoolCreateInfo poolCreateInfo( vk::CommandPoolCreateFlagBits::eTransient, queueFamilyIndex );
+		m_commandPools[ i ] = m_device.createCommandPool( poolCreateInfo );
+
+		vk::CommandBufferAllocateInfo allocateInfo( m_commandPools[ i ], vk::CommandBufferLevel::eSecondary, 1 );
+		m_secondaryBuffers[ i ] = m_device.allocateCommandBuffers( allocateInfo ).front();
+	}
+
+	m_benchmarkPool = m_device.createCommandPool( vk::CommandPoolCreateInfo( vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamilyIndex ) );
+	m_benchmarkPrimary = m_device.allocateCommandBuffers( vk::CommandBufferAllocateInfo( m_benchmarkPool, vk::CommandBufferLevel::ePrimary, 1 ) ).front();
+
+	VS_INFO( "Parallel command recorder using {0} slices on {1} job threads.", m_sliceCount, jobSystem.getThreadCount() );
+}
+
+void CParallelCommandRecorder::destroy()
+{
+	if( !m_device )
+	{
+		return;
+	}
+
+	for( auto& pool : m_commandPools )
+	{
+		m_device.destroyCommandPool( pool );
+	}
+	m_commandPools.clear();
+	m_secondaryBuffers.clear();
+
+	m_device.destroyCommandPool( m_benchmarkPool );
+	m_device = nullptr;
+	m_pJobSystem = nullptr;
+}
+
+void CParallelCommandRecorder::record( uint32_t frameIndex, const vk::CommandBuffer& primary, const SRecordContext& context, const std::vector<SDrawItem>& draws )
+{
+	record( frameIndex, primary, context, draws, m_sliceCount );
+}
+
+void CParallelCommandRecorder::record( uint32_t frameIndex, const vk::CommandBuffer& primary, const SRecordContext& context, const std::vector<SDrawItem>& draws, uint32_t activeSlices )
+{
+	recordSecondaries( frameIndex, context, draws, activeSlices );
+
+	vk::RenderPassBeginInfo renderPassBeginInfo( context.renderPass, context.framebuffer, context.renderArea,
+		static_cast< uint32_t >( context.clearValues.size() ), context.clearValues.data() );
+	primary.beginRenderPass( renderPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers );
+	for( uint32_t subpass = 0; subpass < context.subpass; ++subpass )
+	{
+		primary.nextSubpass( vk::SubpassContents::eSecondaryCommandBuffers );
+	}
+
+	executeSecondaries( primary, context );
+
+	//a render pass can only end in its last subpass
+	for( uint32_t subpass = context.subpass + 1; subpass < context.subpassCount; ++subpass )
+	{
+		primary.nextSubpass( vk::SubpassContents::eSecondaryCommandBuffers );
+	}
+	primary.endRenderPass();
+}
+
+void CParallelCommandRecorder::recordInRenderPass( uint32_t frameIndex, const vk::CommandBuffer& primary, const SRecordContext& context, const std::vector<SDrawItem>& draws )
+{
+	recordSecondaries( frameIndex, context, draws, m_sliceCount );
+	executeSecondaries( primary, context );
+}
+
+std::vector<CParallelCommandRecorder::SScalingResult> CParallelCommandRecorder::measureScaling( const SRecordContext& context, const std::vector<SDrawItem>& draws, uint32_t iterations )
+{
+	std::vector<SScalingResult> results;
+	iterations = std::max( iterations, 1u );
+
+	for( uint32_t sliceCount = 1; sliceCount <= m_sliceCount; ++sliceCount )
+	{
+		SScalingResult result { sliceCount, 0.0, std::numeric_limits<double>::max() };
+
+		for( uint32_t i = 0; i < iterations; ++i )
+		{
+			m_benchmarkPrimary.reset( {} );
+
+			CTimer timer;
+			m_benchmarkPrimary.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+			record( 0, m_benchmarkPrimary, context, draws, sliceCount );
+			m_benchmarkPrimary.end();
+			const double milliseconds = timer.elapsedMilliseconds();
+
+			result.averageMilliseconds += milliseconds;
+			result.minMilliseconds = std::min( result.minMilliseconds, milliseconds );
+		}
+
+		result.averageMilliseconds /= iterations;
+		results.push_back( result );
+	}
+
+	VS_INFO( "Command recording scaling, {0} draws, {1} iterations, {2} job threads:", draws.size(), iterations, m_pJobSystem->getThreadCount() );
+	for( const auto& result : results )
+	{
+		VS_INFO( "    {0:2} slices : avg {1:8.3f} ms, min {2:8.3f} ms, speedup {3:.2f}x", result.sliceCount, result.averageMilliseconds,
+			result.minMilliseconds, results.front().averageMilliseconds / std::max( result.averageMilliseconds, 1e-9 ) );
+	}
+
+	return results;
+}
+
+/////////////////////////////////////////////////
+
+void CParallelCommandRecorder::recordSecondaries( uint32_t frameIndex, const SRecordContext& context, const std::vector<SDrawItem>& draws, uint32_t activeSlices )
+{
+	m_frameIndex = frameIndex % m_framesInFlight;
+	m_activeSlices = std::clamp( activeSlices, 1u, m_sliceCount );
+	m_pContext = &context;
+	m_pDraws = &draws;
+
+	//the calling thread records slice 0 itself, then helps with the rest while it waits
+	CJobCounter counter;
+	for( uint32_t sliceIndex = 1; sliceIndex < m_activeSlices; ++sliceIndex )
+	{
+		m_pJobSystem->run( [ this, sliceIndex ]() { recordSlice( sliceIndex ); }, &counter );
+	}
+
+	std::exception_ptr pException;
+	try
+	{
+		recordSlice( 0 );
+	}
+	catch( ... )
+	{
+		pException = std::current_exception();
+	}
+
+	//always waits, the jobs use the counter and the context until they are done
+	m_pJobSystem->wait( counter );
+
+	if( pException )
+	{
+		std::rethrow_exception( pException );
+	}
+}
+
+void CParallelCommandRecorder::executeSecondaries( const vk::CommandBuffer& primary, const SRecordContext& context )
+{
+	//slices are executed in order, so the result never depends on scheduling
+	const vk::CommandBuffer* pSecondaries = &m_secondaryBuffers[ static_cast< size_t >( m_frameIndex ) * m_sliceCount ];
+	m_executeList.clear();
+	if( context.firstCommands )
+	{
+		m_executeList.push_back( context.firstCommands );
+	}
+	m_executeList.insert( m_executeList.end(), pSecondaries, pSecondaries + m_activeSlices );
+	if( context.overlayCommands )
+	{
+		m_executeList.push_back( context.overlayCommands );
+	}
+	primary.executeCommands( m_executeList );
+}
+
+void CParallelCommandRecorder::recordSlice( uint32_t sliceIndex )
+{
+	VS_PROFILE_SCOPE( "record slice" );
+
+	const size_t slot = static_cast< size_t >( m_frameIndex ) * m_sliceCount + sliceIndex;
+
+	m_device.resetCommandPool( m_commandPools[ slot ], {} );
+
+	//contiguous slices, the first (drawCount % activeSlices) slices take one extra draw
+	const size_t drawCount = m_pDraws->size();
+	const size_t baseCount = drawCount / m_activeSlices;
+	const size_t remainder = drawCount % m_activeSlices;
+	const size_t begin = sliceIndex * baseCount + std::min<size_t>( sliceIndex, remainder );
+	const size_t end = begin + baseCount + ( sliceIndex < remainder ? 1 : 0 );
+
+	vk::CommandBufferInheritanceInfo inheritanceInfo( m_pContext->renderPass, m_pContext->subpass, m_pContext->framebuffer );
+	vk::CommandBufferBeginInfo beginInfo( vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit, &inheritanceInfo );
+
+	const vk::CommandBuffer& cmd = m_secondaryBuffers[ slot ];
+	cmd.begin( beginInfo );
+	cmd.bindPipeline( vk::PipelineBindPoint::eGraphics, m_pContext->pipeline );
+	//secondaries inherit no descriptor sets and no dynamic state from the primary
+	if( m_pContext->descriptorSet )
+	{
+		cmd.bindDescriptorSets( vk::PipelineBindPoint::eGraphics, m_pContext->pipelineLayout, 0, m_pContext->descriptorSet, {} );
+	}
+	setViewportAndScissor( cmd, m_pContext->renderArea );
+
+	for( size_t i = begin; i < end; ++i )
+	{
+		const SDrawItem& draw = ( *m_pDraws )[ i ];
+		cmd.draw( draw.vertexCount, draw.instanceCount, draw.firstVertex, draw.firstInstance );
+	}
+
+	cmd.end();
+}
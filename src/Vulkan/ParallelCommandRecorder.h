@@ -0,0 +1,93 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+class CJobSystem;
+
+struct SDrawItem
+{
+	uint32_t vertexCount;
+	uint32_t instanceCount;
+	uint32_t firstVertex;
+	uint32_t firstInstance;
+};
+
+//Splits a draw list into slices that jobs record into secondary command buffers for the
+//same subpass. Every slice has its own command pool per frame in flight, so no pool is ever
+//shared between threads or reset while the GPU still uses it.
+class CParallelCommandRecorder
+{
+public:
+	struct SRecordContext
+	{
+		vk::RenderPass renderPass;
+		uint32_t subpass = 0;
+		vk::Framebuffer framebuffer;
+		vk::Rect2D renderArea;
+		//only used by record(), which begins the render pass itself and steps through its
+		//other subpasses without recording anything in them
+		uint32_t subpassCount = 1;
+		std::vector<vk::ClearValue> clearValues;
+		vk::Pipeline pipeline;
+		//bound by every secondary when set, e.g. the bindless table
+		vk::PipelineLayout pipelineLayout;
+		vk::DescriptorSet descriptorSet;
+		//optional secondaries executed before and after the draw slices, e.g. timestamps and UI
+		vk::CommandBuffer firstCommands;
+		vk::CommandBuffer overlayCommands;
+	};
+
+	struct SScalingResult
+	{
+		uint32_t sliceCount;
+		double averageMilliseconds;
+		double minMilliseconds;
+	};
+
+public:
+	CParallelCommandRecorder();
+	~CParallelCommandRecorder();
+
+	//sliceCount 0 records one slice per thread of the job system
+	void init( const vk::Device& device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t sliceCount, CJobSystem& jobSystem );
+	void destroy();
+
+	//records the whole render pass into primary, which must be in the recording state.
+	//The pools of frameIndex are reset, so the GPU must have retired that frame.
+	void record( uint32_t frameIndex, const vk::CommandBuffer& primary, const SRecordContext& context, const std::vector<SDrawItem>& draws );
+	void record( uint32_t frameIndex, const vk::CommandBuffer& primary, const SRecordContext& context, const std::vector<SDrawItem>& draws, uint32_t activeSlices );
+	//same, for a render pass someone else began with secondary command buffer contents
+	void recordInRenderPass( uint32_t frameIndex, const vk::CommandBuffer& primary, const SRecordContext& context, const std::vector<SDrawItem>& draws );
+
+	//records the draw list repeatedly in 1..sliceCount slices without submitting anything.
+	//Uses the pools of frame 0, so call it while no frame is in flight.
+	std::vector<SScalingResult> measureScaling( const SRecordContext& context, const std::vector<SDrawItem>& draws, uint32_t iterations );
+
+	inline uint32_t getSliceCount() const
+	{
+		return m_sliceCount;
+	}
+
+private:
+	void recordSecondaries( uint32_t frameIndex, const SRecordContext& context, const std::vector<SDrawItem>& draws, uint32_t activeSlices );
+	void executeSecondaries( const vk::CommandBuffer& primary, const SRecordContext& context );
+	void recordSlice( uint32_t sliceIndex );
+
+	vk::Device m_device;
+	CJobSystem* m_pJobSystem;
+	uint32_t m_sliceCount;
+	uint32_t m_framesInFlight;
+
+	//indexed [frame * m_sliceCount + slice]
+	std::vector<vk::CommandPool> m_commandPools;
+	std::vector<vk::CommandBuffer> m_secondaryBuffers;
+	std::vector<vk::CommandBuffer> m_executeList;
+
+	vk::CommandPool m_benchmarkPool;
+	vk::CommandBuffer m_benchmarkPrimary;
+
+	//state of the record call in progress, read by the slice jobs
+	uint32_t m_frameIndex;
+	uint32_t m_activeSlices;
+	const SRecordContext* m_pContext;
+	const std::vector<SDrawItem>* m_pDraws;
+};
@@ -0,0 +1,336 @@
+#include "vkpch.h"
+#include "PipelineCache.h"
+
+#include "Utils/Log.h"
+#include "Utils/Timer.h"
+
+/////////////////////////////////////////////////
+
+//prefixed to the driver blob so a truncated or foreign file is never handed to the driver
+struct SPipelineCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t driverVersion;
+	uint64_t dataSize;
+	uint64_t dataHash;
+};
+
+const uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x43504B56; // "VKPC"
+
+//layout of VkPipelineCacheHeaderVersionOne as written by the driver
+const size_t PIPELINE_CACHE_HEADER_SIZE = 16 + VK_UUID_SIZE;
+
+
+static uint64_t hashBytes( const char* pData, size_t size )
+{
+	//FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for( size_t i = 0; i < size; ++i )
+	{
+		hash ^= static_cast< uint8_t >( pData[ i ] );
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/////////////////////////////////////////////////
+
+CPipelineCache::CPipelineCache()
+	: m_device( nullptr )
+	, m_cache( nullptr )
+	, m_creationFeedbackEnabled( false )
+{
+}
+
+void CPipelineCache::preload( const std::string& filePath )
+{
+	CTimer timer;
+
+	SFileData fileData;
+	readFromDisk( filePath, fileData );
+	m_preloadedFile = std::move( fileData );
+
+	VS_INFO( "Pipeline cache file read, {0} bytes in {1:.3f} ms.", m_preloadedFile->data.size(), timer.elapsedMilliseconds() );
+}
+
+void CPipelineCache::init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, const std::string& filePath, bool creationFeedbackEnabled )
+{
+	m_device = device;
+	m_deviceProperties = physicalDevice.getProperties();
+	m_filePath = filePath;
+	m_creationFeedbackEnabled = creationFeedbackEnabled;
+
+	CTimer timer;
+	std::vector<char> cacheData = loadFromDisk();
+
+	vk::PipelineCacheCreateInfo createInfo( {}, cacheData.size(), cacheData.data() );
+	try
+	{
+		m_cache = m_device.createPipelineCache( createInfo );
+	}
+	catch( const vk::SystemError& )
+	{
+		//the driver is free to reject data it validated differently than we did
+		VS_WARN( "Driver rejected pipeline cache data, starting with an empty cache." );
+		cacheData.clear();
+		m_cache = m_device.createPipelineCache( vk::PipelineCacheCreateInfo {} );
+	}
+
+	const double loadMilliseconds = timer.elapsedMilliseconds();
+	{
+		std::lock_guard<std::mutex> lock( m_statsMutex );
+		m_stats.loadedBytes = cacheData.size();
+		m_stats.loadMilliseconds = loadMilliseconds;
+	}
+
+	VS_INFO( "Pipeline cache initialized with {0} bytes from '{1}' in {2:.3f} ms.", cacheData.size(), m_filePath, loadMilliseconds );
+}
+
+void CPipelineCache::save()
+{
+	if( !m_cache )
+	{
+		return;
+	}
+
+	std::vector<uint8_t> cacheData = m_device.getPipelineCacheData( m_cache );
+	const char* pData = reinterpret_cast< const char* >( cacheData.data() );
+
+	if( !isCacheDataCompatible( pData, cacheData.size() ) )
+	{
+		VS_WARN( "Pipeline cache data has an unexpected header, not saving." );
+		return;
+	}
+
+	SPipelineCacheFileHeader header {};
+	header.magic = PIPELINE_CACHE_FILE_MAGIC;
+	header.driverVersion = m_deviceProperties.driverVersion;
+	header.dataSize = cacheData.size();
+	header.dataHash = hashBytes( pData, cacheData.size() );
+
+	//write next to the target and rename over it, so a crash never leaves a half written cache behind
+	const std::string tempPath = m_filePath + ".tmp";
+	{
+		std::ofstream file( tempPath, std::ios::binary | std::ios::trunc );
+		if( !file.is_open() )
+		{
+			VS_WARN( "Failed to open '{0}' for writing.", tempPath );
+			return;
+		}
+
+		file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+		file.write( pData, cacheData.size() );
+		file.flush();
+
+		if( !file.good() )
+		{
+			VS_WARN( "Failed to write pipeline cache to '{0}'.", tempPath );
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename( tempPath, m_filePath, error );
+	if( error )
+	{
+		VS_WARN( "Failed to replace pipeline cache '{0}': {1}", m_filePath, error.message() );
+		std::filesystem::remove( tempPath, error );
+		return;
+	}
+
+	VS_INFO( "Pipeline cache saved, {0} bytes.", cacheData.size() );
+}
+
+void CPipelineCache::destroy()
+{
+	if( m_cache )
+	{
+		m_device.destroyPipelineCache( m_cache );
+		m_cache = nullptr;
+	}
+}
+
+vk::Pipeline CPipelineCache::createGraphicsPipeline( vk::GraphicsPipelineCreateInfo createInfo )
+{
+	vk::PipelineCreationFeedbackEXT pipelineFeedback {};
+	std::vector<vk::PipelineCreationFeedbackEXT> stageFeedbacks( createInfo.stageCount );
+
+	vk::PipelineCreationFeedbackCreateInfoEXT feedbackCreateInfo {};
+	if( m_creationFeedbackEnabled )
+	{
+		feedbackCreateInfo.setPPipelineCreationFeedback( &pipelineFeedback );
+		feedbackCreateInfo.setPipelineStageCreationFeedbackCount( createInfo.stageCount );
+		feedbackCreateInfo.setPPipelineStageCreationFeedbacks( stageFeedbacks.data() );
+		feedbackCreateInfo.setPNext( createInfo.pNext );
+		createInfo.setPNext( &feedbackCreateInfo );
+	}
+
+	CTimer timer;
+	auto resultValue = m_device.createGraphicsPipeline( m_cache, createInfo );
+	const double milliseconds = timer.elapsedMilliseconds();
+
+	if( resultValue.result != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "Failed to create graphics pipeline." );
+	}
+
+	recordCreation( pipelineFeedback, milliseconds );
+	return resultValue.value;
+}
+
+void CPipelineCache::merge( const std::vector<vk::PipelineCache>& srcCaches )
+{
+	if( !srcCaches.empty() )
+	{
+		m_device.mergePipelineCaches( m_cache, srcCaches );
+	}
+}
+
+void CPipelineCache::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Pipeline cache: {0} pipelines created, {1} bytes loaded in {2:.3f} ms", stats.pipelinesCreated, stats.loadedBytes, stats.loadMilliseconds );
+	VS_INFO( "    hits          : {0} ({1:.3f} ms)", stats.cacheHits, stats.hitMilliseconds );
+	VS_INFO( "    misses        : {0} ({1:.3f} ms)", stats.cacheMisses, stats.missMilliseconds );
+	if( stats.uncategorized > 0 )
+	{
+		VS_INFO( "    uncategorized : {0} ({1:.3f} ms)", stats.uncategorized, stats.uncategorizedMilliseconds );
+	}
+}
+
+/////////////////////////////////////////////////
+
+bool CPipelineCache::readFromDisk( const std::string& filePath, SFileData& fileData )
+{
+	fileData.filePath = filePath;
+
+	std::ifstream file( filePath, std::ios::ate | std::ios::binary );
+	if( !file.is_open() )
+	{
+		VS_INFO( "No pipeline cache found at '{0}'.", filePath );
+		return false;
+	}
+
+	const size_t fileSize = static_cast< size_t >( file.tellg() );
+	if( fileSize < sizeof( SPipelineCacheFileHeader ) )
+	{
+		VS_WARN( "Pipeline cache '{0}' is truncated, ignoring it.", filePath );
+		return false;
+	}
+
+	SPipelineCacheFileHeader header {};
+	file.seekg( 0 );
+	file.read( reinterpret_cast< char* >( &header ), sizeof( header ) );
+
+	if( header.magic != PIPELINE_CACHE_FILE_MAGIC || header.dataSize != fileSize - sizeof( header ) )
+	{
+		VS_WARN( "Pipeline cache '{0}' is corrupt, ignoring it.", filePath );
+		return false;
+	}
+
+	std::vector<char> data( static_cast< size_t >( header.dataSize ) );
+	file.read( data.data(), data.size() );
+
+	if( !file.good() || hashBytes( data.data(), data.size() ) != header.dataHash )
+	{
+		VS_WARN( "Pipeline cache '{0}' failed its checksum, ignoring it.", filePath );
+		return false;
+	}
+
+	fileData.data = std::move( data );
+	fileData.driverVersion = header.driverVersion;
+	return true;
+}
+
+std::vector<char> CPipelineCache::loadFromDisk()
+{
+	SFileData fileData;
+	if( m_preloadedFile && m_preloadedFile->filePath == m_filePath )
+	{
+		fileData = std::move( *m_preloadedFile );
+	}
+	else if( !readFromDisk( m_filePath, fileData ) )
+	{
+		return {};
+	}
+	m_preloadedFile.reset();
+
+	//a failed preload leaves no data behind, it already logged why
+	if( fileData.data.empty() )
+	{
+		return {};
+	}
+
+	if( fileData.driverVersion != m_deviceProperties.driverVersion )
+	{
+		VS_INFO( "Pipeline cache was written by a different driver version, ignoring it." );
+		return {};
+	}
+
+	if( !isCacheDataCompatible( fileData.data.data(), fileData.data.size() ) )
+	{
+		VS_INFO( "Pipeline cache was written for a different device, ignoring it." );
+		return {};
+	}
+
+	return std::move( fileData.data );
+}
+
+bool CPipelineCache::isCacheDataCompatible( const char* pData, size_t size ) const
+{
+	if( size < PIPELINE_CACHE_HEADER_SIZE )
+	{
+		return false;
+	}
+
+	uint32_t headerFields[ 4 ];
+	memcpy( headerFields, pData, sizeof( headerFields ) );
+
+	const uint32_t headerSize = headerFields[ 0 ];
+	const uint32_t headerVersion = headerFields[ 1 ];
+	const uint32_t vendorID = headerFields[ 2 ];
+	const uint32_t deviceID = headerFields[ 3 ];
+
+	if( headerSize < PIPELINE_CACHE_HEADER_SIZE || headerSize > size )
+	{
+		return false;
+	}
+
+	if( headerVersion != static_cast< uint32_t >( vk::PipelineCacheHeaderVersion::eOne ) )
+	{
+		return false;
+	}
+
+	if( vendorID != m_deviceProperties.vendorID || deviceID != m_deviceProperties.deviceID )
+	{
+		return false;
+	}
+
+	return memcmp( pData + sizeof( headerFields ), m_deviceProperties.pipelineCacheUUID.data(), VK_UUID_SIZE ) == 0;
+}
+
+void CPipelineCache::recordCreation( const vk::PipelineCreationFeedbackEXT& feedback, double milliseconds )
+{
+	std::lock_guard<std::mutex> lock( m_statsMutex );
+	++m_stats.pipelinesCreated;
+
+	if( !m_creationFeedbackEnabled || !( feedback.flags & vk::PipelineCreationFeedbackFlagBitsEXT::eValid ) )
+	{
+		++m_stats.uncategorized;
+		m_stats.uncategorizedMilliseconds += milliseconds;
+		VS_TRACE( "Pipeline created in {0:.3f} ms.", milliseconds );
+	}
+	else if( feedback.flags & vk::PipelineCreationFeedbackFlagBitsEXT::eApplicationPipelineCacheHit )
+	{
+		++m_stats.cacheHits;
+		m_stats.hitMilliseconds += milliseconds;
+		VS_TRACE( "Pipeline created in {0:.3f} ms (cache hit).", milliseconds );
+	}
+	else
+	{
+		++m_stats.cacheMisses;
+		m_stats.missMilliseconds += milliseconds;
+		VS_TRACE( "Pipeline created in {0:.3f} ms (cache miss).", milliseconds );
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+
+//Owns the VkPipelineCache shared by every pipeline the app creates.
+//The cache blob is loaded from disk on init, validated against the current
+//device and driver, and written back atomically on save.
+//createGraphicsPipeline may be called from several threads at once, the driver synchronizes
+//the VkPipelineCache internally. merge, save and destroy must not race with it.
+class CPipelineCache
+{
+public:
+	struct SStats
+	{
+		uint32_t pipelinesCreated = 0;
+		//hits and misses are only known when VK_EXT_pipeline_creation_feedback is enabled
+		uint32_t cacheHits = 0;
+		uint32_t cacheMisses = 0;
+		uint32_t uncategorized = 0;
+
+		double hitMilliseconds = 0.0;
+		double missMilliseconds = 0.0;
+		double uncategorizedMilliseconds = 0.0;
+
+		size_t loadedBytes = 0;
+		double loadMilliseconds = 0.0;
+	};
+
+public:
+	CPipelineCache();
+
+	//reads and checksums the cache file without a device, so the disk I/O can overlap
+	//instance and device creation. init validates the data instead of reading the file again.
+	void preload( const std::string& filePath );
+	void init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, const std::string& filePath, bool creationFeedbackEnabled );
+	void save();
+	void destroy();
+
+	vk::Pipeline createGraphicsPipeline( vk::GraphicsPipelineCreateInfo createInfo );
+	void merge( const std::vector<vk::PipelineCache>& srcCaches );
+
+	void logStats() const;
+
+	inline vk::PipelineCache getHandle() const
+	{
+		return m_cache;
+	}
+
+	inline SStats getStats() const
+	{
+		std::lock_guard<std::mutex> lock( m_statsMutex );
+		return m_stats;
+	}
+
+private:
+	struct SFileData
+	{
+		std::string filePath;
+		std::vector<char> data;
+		uint32_t driverVersion = 0;
+	};
+
+	static bool readFromDisk( const std::string& filePath, SFileData& fileData );
+	std::vector<char> loadFromDisk();
+	bool isCacheDataCompatible( const char* pData, size_t size ) const;
+	void recordCreation( const vk::PipelineCreationFeedbackEXT& feedback, double milliseconds );
+
+	vk::Device m_device;
+	vk::PhysicalDeviceProperties m_deviceProperties;
+	vk::PipelineCache m_cache;
+
+	std::string m_filePath;
+	bool m_creationFeedbackEnabled;
+	std::optional<SFileData> m_preloadedFile;
+
+	SStats m_stats;
+	mutable std::mutex m_statsMutex;
+};
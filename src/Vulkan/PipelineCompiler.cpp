@@ -0,0 +1,282 @@
+#include "vkpch.h"
+#include "PipelineCompiler.h"
+
+#include "Utils/Log.h"
+#include "Utils/Timer.h"
+
+/////////////////////////////////////////////////
+
+CPipelineCompiler::CPipelineCompiler()
+	: m_device( nullptr )
+	, m_pPipelineCache( nullptr )
+	, m_activeCompiles( 0 )
+	, m_stopWorkers( false )
+{
+}
+
+CPipelineCompiler::~CPipelineCompiler()
+{
+	destroy();
+}
+
+void CPipelineCompiler::init( const vk::Device& device, CPipelineCache& pipelineCache, uint32_t threadCount )
+{
+	m_device = device;
+	m_pPipelineCache = &pipelineCache;
+
+	if( threadCount == 0 )
+	{
+		threadCount = std::max( std::thread::hardware_concurrency(), 2u ) - 1;
+	}
+
+	m_stopWorkers = false;
+	for( uint32_t workerIndex = 0; workerIndex < threadCount; ++workerIndex )
+	{
+		m_workers.emplace_back( &CPipelineCompiler::workerLoop, this, workerIndex );
+	}
+
+	VS_INFO( "Pipeline compiler using {0} threads.", threadCount );
+}
+
+void CPipelineCompiler::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_stopWorkers = true;
+
+		//nobody will compile what is still queued, release anyone waiting on it
+		for( auto& queuedJob : m_queue )
+		{
+			queuedJob.pJob->status.store( EPipelineStatus::Failed, std::memory_order_release );
+		}
+		m_queue.clear();
+	}
+	m_workCondition.notify_all();
+	m_doneCondition.notify_all();
+
+	for( auto& worker : m_workers )
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	for( auto& pJob : m_jobs )
+	{
+		if( pJob->pipeline )
+		{
+			m_device.destroyPipeline( pJob->pipeline );
+			pJob->pipeline = nullptr;
+		}
+	}
+	m_jobs.clear();
+}
+
+CPipelineHandle CPipelineCompiler::compileGraphicsPipeline( SGraphicsPipelineDesc desc )
+{
+	auto pJob = std::make_shared<SPipelineCompileJob>();
+	pJob->desc = std::move( desc );
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		if( m_workers.empty() )
+		{
+			throw std::runtime_error( "Pipeline compiler is not initialized." );
+		}
+
+		m_jobs.push_back( pJob );
+		m_queue.push_back( SQueuedJob { pJob, CTimer::Clock::now() } );
+		++m_stats.pipelinesRequested;
+	}
+	m_workCondition.notify_one();
+
+	return CPipelineHandle( pJob );
+}
+
+void CPipelineCompiler::wait( const CPipelineHandle& handle )
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+	m_doneCondition.wait( lock, [ & ]() { return handle.getStatus() != EPipelineStatus::Pending; } );
+}
+
+void CPipelineCompiler::waitIdle()
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+	m_doneCondition.wait( lock, [ this ]() { return m_queue.empty() && m_activeCompiles == 0; } );
+}
+
+CPipelineCompiler::SStats CPipelineCompiler::getStats() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_stats;
+}
+
+void CPipelineCompiler::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Pipeline compiler: {0} requested, {1} compiled, {2} failed, up to {3} compiling in parallel",
+		stats.pipelinesRequested, stats.pipelinesCompiled, stats.pipelinesFailed, stats.peakConcurrentCompiles );
+	VS_INFO( "    compile time  : {0:.3f} ms total, {1:.3f} ms slowest", stats.totalCompileMilliseconds, stats.maxCompileMilliseconds );
+
+	for( const SCompileRecord& record : stats.records )
+	{
+		VS_TRACE( "    {0:<24} worker {1:>2}  queued {2:>8.3f} ms  compiled {3:>8.3f} ms{4}",
+			record.name, record.workerIndex, record.queueMilliseconds, record.compileMilliseconds, record.succeeded ? "" : "  FAILED" );
+	}
+}
+
+/////////////////////////////////////////////////
+
+void CPipelineCompiler::workerLoop( uint32_t workerIndex )
+{
+	while( true )
+	{
+		SQueuedJob queuedJob;
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_workCondition.wait( lock, [ this ]() { return m_stopWorkers || !m_queue.empty(); } );
+
+			if( m_stopWorkers )
+			{
+				return;
+			}
+
+			queuedJob = std::move( m_queue.front() );
+			m_queue.pop_front();
+
+			++m_activeCompiles;
+			m_stats.peakConcurrentCompiles = std::max( m_stats.peakConcurrentCompiles, m_activeCompiles );
+		}
+
+		SPipelineCompileJob& job = *queuedJob.pJob;
+		const double queueMilliseconds = std::chrono::duration<double, std::milli>( CTimer::Clock::now() - queuedJob.queuedAt ).count();
+
+		CTimer timer;
+		bool succeeded = true;
+		try
+		{
+			job.pipeline = buildPipeline( job.desc );
+		}
+		catch( const std::exception& e )
+		{
+			VS_ERROR( "Failed to compile pipeline '{0}': {1}", job.desc.name, e.what() );
+			succeeded = false;
+		}
+		const double compileMilliseconds = timer.elapsedMilliseconds();
+
+		job.status.store( succeeded ? EPipelineStatus::Ready : EPipelineStatus::Failed, std::memory_order_release );
+
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			--m_activeCompiles;
+
+			if( succeeded )
+			{
+				++m_stats.pipelinesCompiled;
+			}
+			else
+			{
+				++m_stats.pipelinesFailed;
+			}
+			m_stats.totalCompileMilliseconds += compileMilliseconds;
+			m_stats.maxCompileMilliseconds = std::max( m_stats.maxCompileMilliseconds, compileMilliseconds );
+			m_stats.records.push_back( SCompileRecord { job.desc.name, workerIndex, queueMilliseconds, compileMilliseconds, succeeded } );
+		}
+		m_doneCondition.notify_all();
+	}
+}
+
+vk::Pipeline CPipelineCompiler::buildPipeline( const SGraphicsPipelineDesc& desc )
+{
+	//modules only live for the duration of the compile, the pipeline does not reference them afterwards
+	std::vector<vk::ShaderModule> shaderModules;
+	std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+	shaderModules.reserve( desc.stages.size() );
+	shaderStages.reserve( desc.stages.size() );
+
+	//the stages point into these, so they must not reallocate
+	std::vector<std::vector<vk::SpecializationMapEntry>> specializationEntries( desc.stages.size() );
+	std::vector<vk::SpecializationInfo> specializationInfos( desc.stages.size() );
+
+	auto destroyShaderModules = [ & ]()
+	{
+		for( auto& shaderModule : shaderModules )
+		{
+			m_device.destroyShaderModule( shaderModule );
+		}
+	};
+
+	vk::Pipeline pipeline;
+	try
+	{
+		for( size_t stageIndex = 0; stageIndex < desc.stages.size(); ++stageIndex )
+		{
+			const auto& stage = desc.stages[ stageIndex ];
+			shaderModules.push_back( m_device.createShaderModule( stage.code.getModuleCreateInfo() ) );
+			shaderStages.emplace_back( vk::PipelineShaderStageCreateFlags {}, stage.stage, shaderModules.back(), stage.entryPoint.c_str() );
+
+			if( !stage.specializationConstants.empty() )
+			{
+				//the constants are tightly packed values, so they double as the data block
+				auto& entries = specializationEntries[ stageIndex ];
+				for( uint32_t constantIndex = 0; constantIndex < stage.specializationConstants.size(); ++constantIndex )
+				{
+					const uint32_t offset = static_cast< uint32_t >( constantIndex * sizeof( SSpecializationConstant ) + offsetof( SSpecializationConstant, value ) );
+					entries.emplace_back( stage.specializationConstants[ constantIndex ].constantId, offset, sizeof( uint32_t ) );
+				}
+
+				specializationInfos[ stageIndex ] = vk::SpecializationInfo( static_cast< uint32_t >( entries.size() ), entries.data(),
+					stage.specializationConstants.size() * sizeof( SSpecializationConstant ), stage.specializationConstants.data() );
+				shaderStages.back().setPSpecializationInfo( &specializationInfos[ stageIndex ] );
+			}
+		}
+
+		vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo( {},
+			static_cast< uint32_t >( desc.vertexBindings.size() ), desc.vertexBindings.data(),
+			static_cast< uint32_t >( desc.vertexAttributes.size() ), desc.vertexAttributes.data() );
+		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo( {}, desc.topology, false );
+
+		//counts must be at least one even when the state is dynamic
+		vk::PipelineViewportStateCreateInfo viewportStateCreateInfo( {},
+			std::max( static_cast< uint32_t >( desc.viewports.size() ), 1u ), desc.viewports.empty() ? nullptr : desc.viewports.data(),
+			std::max( static_cast< uint32_t >( desc.scissors.size() ), 1u ), desc.scissors.empty() ? nullptr : desc.scissors.data() );
+
+		vk::PipelineColorBlendStateCreateInfo colorBlendStateCreateInfo {};
+		colorBlendStateCreateInfo.setLogicOpEnable( VK_FALSE );
+		colorBlendStateCreateInfo.setLogicOp( vk::LogicOp::eCopy );
+		colorBlendStateCreateInfo.setAttachmentCount( static_cast< uint32_t >( desc.colorBlendAttachments.size() ) );
+		colorBlendStateCreateInfo.setPAttachments( desc.colorBlendAttachments.data() );
+
+		vk::PipelineDynamicStateCreateInfo dynamicStateCreateInfo( {}, static_cast< uint32_t >( desc.dynamicStates.size() ), desc.dynamicStates.data() );
+
+		vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo {};
+		graphicsPipelineCreateInfo.setStageCount( static_cast< uint32_t >( shaderStages.size() ) );
+		graphicsPipelineCreateInfo.setPStages( shaderStages.data() );
+
+		graphicsPipelineCreateInfo.setPVertexInputState( &vertexInputStateCreateInfo );
+		graphicsPipelineCreateInfo.setPInputAssemblyState( &inputAssemblyStateCreateInfo );
+		graphicsPipelineCreateInfo.setPViewportState( &viewportStateCreateInfo );
+		graphicsPipelineCreateInfo.setPRasterizationState( &desc.rasterization );
+		graphicsPipelineCreateInfo.setPMultisampleState( &desc.multisample );
+		graphicsPipelineCreateInfo.setPDepthStencilState( desc.depthStencil ? &desc.depthStencil.value() : nullptr );
+		graphicsPipelineCreateInfo.setPColorBlendState( &colorBlendStateCreateInfo );
+		graphicsPipelineCreateInfo.setPDynamicState( desc.dynamicStates.empty() ? nullptr : &dynamicStateCreateInfo );
+
+		graphicsPipelineCreateInfo.setLayout( desc.layout );
+		graphicsPipelineCreateInfo.setRenderPass( desc.renderPass );
+		graphicsPipelineCreateInfo.setSubpass( desc.subpass );
+
+		graphicsPipelineCreateInfo.setBasePipelineHandle( vk::Pipeline( nullptr ) );
+		graphicsPipelineCreateInfo.setBasePipelineIndex( -1 );
+
+		pipeline = m_pPipelineCache->createGraphicsPipeline( graphicsPipelineCreateInfo );
+	}
+	catch( ... )
+	{
+		destroyShaderModules();
+		throw;
+	}
+
+	destroyShaderModules();
+	return pipeline;
+}
@@ -0,0 +1,188 @@
+#pragma once
+#include "Vulkan/PipelineCache.h"
+#include "Vulkan/ShaderRegistry.h"
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//One 32 bit specialization constant, which covers bool, int, uint and float constants
+struct SSpecializationConstant
+{
+	uint32_t constantId;
+	uint32_t value;
+};
+
+//Owned copy of everything a graphics pipeline is built from, so the request can
+//outlive the scope that described it and be compiled on another thread.
+//Shader code is a view into CShaderRegistry, which outlives every request.
+struct SGraphicsPipelineDesc
+{
+	struct SShaderStage
+	{
+		vk::ShaderStageFlagBits stage;
+		SShaderCode code;
+		std::string entryPoint = "main";
+		std::vector<SSpecializationConstant> specializationConstants;
+	};
+
+	std::string name;
+	std::vector<SShaderStage> stages;
+
+	std::vector<vk::VertexInputBindingDescription> vertexBindings;
+	std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+
+	//may stay empty when viewport and scissor are dynamic
+	std::vector<vk::Viewport> viewports;
+	std::vector<vk::Rect2D> scissors;
+
+	vk::PipelineRasterizationStateCreateInfo rasterization;
+	vk::PipelineMultisampleStateCreateInfo multisample;
+	std::optional<vk::PipelineDepthStencilStateCreateInfo> depthStencil;
+	std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments;
+	std::vector<vk::DynamicState> dynamicStates;
+
+	vk::PipelineLayout layout;
+	vk::RenderPass renderPass;
+	uint32_t subpass = 0;
+};
+
+enum class EPipelineStatus
+{
+	Pending,
+	Ready,
+	Failed
+};
+
+struct SPipelineCompileJob
+{
+	SGraphicsPipelineDesc desc;
+
+	//written by the worker before status is published, read after it
+	std::atomic<EPipelineStatus> status { EPipelineStatus::Pending };
+	vk::Pipeline pipeline;
+};
+
+//Pollable reference to a pipeline requested from CPipelineCompiler. Cheap to copy,
+//the compiler keeps ownership of the pipeline itself.
+class CPipelineHandle
+{
+public:
+	CPipelineHandle() = default;
+
+	inline bool isValid() const
+	{
+		return m_pJob != nullptr;
+	}
+
+	inline EPipelineStatus getStatus() const
+	{
+		return m_pJob ? m_pJob->status.load( std::memory_order_acquire ) : EPipelineStatus::Failed;
+	}
+
+	inline bool isReady() const
+	{
+		return getStatus() == EPipelineStatus::Ready;
+	}
+
+	//the compiled pipeline, or fallback while it is still compiling or if compilation failed
+	inline vk::Pipeline get( vk::Pipeline fallback = nullptr ) const
+	{
+		return isReady() ? m_pJob->pipeline : fallback;
+	}
+
+private:
+	friend class CPipelineCompiler;
+
+	explicit CPipelineHandle( std::shared_ptr<SPipelineCompileJob> pJob )
+		: m_pJob( std::move( pJob ) )
+	{
+	}
+
+	std::shared_ptr<SPipelineCompileJob> m_pJob;
+};
+
+//Builds graphics pipelines on a pool of worker threads through the shared CPipelineCache.
+//Requests return immediately with a handle, the renderer polls it and skips or falls back
+//to another pipeline until the compile has finished.
+class CPipelineCompiler
+{
+public:
+	struct SCompileRecord
+	{
+		std::string name;
+		uint32_t workerIndex;
+		//time spent waiting for a worker, and time spent in the driver
+		double queueMilliseconds;
+		double compileMilliseconds;
+		bool succeeded;
+	};
+
+	struct SStats
+	{
+		uint32_t pipelinesRequested = 0;
+		uint32_t pipelinesCompiled = 0;
+		uint32_t pipelinesFailed = 0;
+		//most pipelines that were compiling at the same moment
+		uint32_t peakConcurrentCompiles = 0;
+
+		double totalCompileMilliseconds = 0.0;
+		double maxCompileMilliseconds = 0.0;
+
+		std::vector<SCompileRecord> records;
+	};
+
+public:
+	CPipelineCompiler();
+	~CPipelineCompiler();
+
+	//threadCount 0 uses every hardware thread but one, which is left to the render loop
+	void init( const vk::Device& device, CPipelineCache& pipelineCache, uint32_t threadCount );
+	//waits for the compiles in progress, drops queued ones and destroys every pipeline built
+	void destroy();
+
+	CPipelineHandle compileGraphicsPipeline( SGraphicsPipelineDesc desc );
+
+	//blocks until the handle is no longer pending
+	void wait( const CPipelineHandle& handle );
+	void waitIdle();
+
+	SStats getStats() const;
+	void logStats() const;
+
+	inline uint32_t getThreadCount() const
+	{
+		return static_cast< uint32_t >( m_workers.size() );
+	}
+
+private:
+	struct SQueuedJob
+	{
+		std::shared_ptr<SPipelineCompileJob> pJob;
+		std::chrono::high_resolution_clock::time_point queuedAt;
+	};
+
+	void workerLoop( uint32_t workerIndex );
+	vk::Pipeline buildPipeline( const SGraphicsPipelineDesc& desc );
+
+	vk::Device m_device;
+	CPipelineCache* m_pPipelineCache;
+
+	std::vector<std::thread> m_workers;
+	std::deque<SQueuedJob> m_queue;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_workCondition;
+	std::condition_variable m_doneCondition;
+	uint32_t m_activeCompiles;
+	bool m_stopWorkers;
+
+	//every job ever requested, so destroy can release their pipelines
+	std::vector<std::shared_ptr<SPipelineCompileJob>> m_jobs;
+
+	SStats m_stats;
+};
@@ -0,0 +1,94 @@
+#include "vkpch.h"
+#include "PipelineRegistry.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+CPipelineRegistry::CPipelineRegistry()
+	: m_pCompiler( nullptr )
+{
+}
+
+void CPipelineRegistry::init( CPipelineCompiler& compiler )
+{
+	m_pCompiler = &compiler;
+}
+
+void CPipelineRegistry::destroy()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_entries.clear();
+	m_idsByHash.clear();
+	m_pCompiler = nullptr;
+}
+
+CPipelineRegistry::PipelineId CPipelineRegistry::registerPipeline( const SPipelineState& state )
+{
+	//hashed outside the lock, it is the only part that grows with the size of the state
+	const uint64_t hash = state.getHash();
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	++m_stats.requests;
+
+	std::vector<PipelineId>& ids = m_idsByHash[ hash ];
+	for( const PipelineId id : ids )
+	{
+		if( m_entries[ id ].state == state )
+		{
+			++m_stats.deduplicated;
+			return id;
+		}
+	}
+
+	if( !ids.empty() )
+	{
+		++m_stats.hashCollisions;
+	}
+
+	const PipelineId id = static_cast< PipelineId >( m_entries.size() );
+	m_entries.push_back( SEntry { state, CPipelineHandle() } );
+	ids.push_back( id );
+	++m_stats.uniqueStates;
+	return id;
+}
+
+CPipelineHandle CPipelineRegistry::acquire( PipelineId id )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	if( id >= m_entries.size() )
+	{
+		throw std::runtime_error( "Unknown pipeline id " + std::to_string( id ) + "." );
+	}
+
+	++m_stats.acquires;
+
+	SEntry& entry = m_entries[ id ];
+	if( !entry.handle.isValid() )
+	{
+		if( !m_pCompiler )
+		{
+			throw std::runtime_error( "Pipeline registry is not initialized." );
+		}
+
+		entry.handle = m_pCompiler->compileGraphicsPipeline( entry.state.toDesc() );
+		++m_stats.pipelinesCreated;
+	}
+	return entry.handle;
+}
+
+CPipelineRegistry::SStats CPipelineRegistry::getStats() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_stats;
+}
+
+void CPipelineRegistry::logStats() const
+{
+	const SStats stats = getStats();
+
+	VS_INFO( "Pipeline registry: {0} requests for {1} unique states, {2} deduplicated, {3} hash collisions",
+		stats.requests, stats.uniqueStates, stats.deduplicated, stats.hashCollisions );
+	VS_INFO( "    {0} pipelines created on first use, {1} states never used, {2} acquires",
+		stats.pipelinesCreated, stats.uniqueStates - stats.pipelinesCreated, stats.acquires );
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Vulkan/PipelineState.h"
+
+#include <mutex>
+#include <unordered_map>
+
+//Deduplicates graphics pipeline requests by their SPipelineState and compiles every distinct
+//state once, the first time its pipeline is acquired. Registering is only a hash lookup, so
+//materials can register every permutation they might use and still only pay for the ones
+//that are drawn, and any number of materials sharing a state share one pipeline.
+//Pipelines are compiled through CPipelineCompiler, which keeps ownership of them.
+//Every method may be called from any thread.
+class CPipelineRegistry
+{
+public:
+	using PipelineId = uint32_t;
+	static constexpr PipelineId INVALID_PIPELINE = UINT32_MAX;
+
+	struct SStats
+	{
+		uint32_t requests = 0;
+		//requests that found their state already registered
+		uint32_t deduplicated = 0;
+		uint32_t uniqueStates = 0;
+		//distinct states whose hashes were equal, told apart by the full comparison
+		uint32_t hashCollisions = 0;
+		//states that were acquired and handed to the compiler
+		uint32_t pipelinesCreated = 0;
+		uint32_t acquires = 0;
+	};
+
+public:
+	CPipelineRegistry();
+
+	void init( CPipelineCompiler& compiler );
+	//forgets every state, the pipelines themselves are destroyed with the compiler
+	void destroy();
+
+	PipelineId registerPipeline( const SPipelineState& state );
+	//queues the compile on the first call for an id, later calls return the same handle
+	CPipelineHandle acquire( PipelineId id );
+
+	inline CPipelineHandle acquire( const SPipelineState& state )
+	{
+		return acquire( registerPipeline( state ) );
+	}
+
+	SStats getStats() const;
+	void logStats() const;
+
+private:
+	struct SEntry
+	{
+		SPipelineState state;
+		CPipelineHandle handle;
+	};
+
+	CPipelineCompiler* m_pCompiler;
+
+	//ids index the entries, the map finds them by hash
+	std::vector<SEntry> m_entries;
+	std::unordered_map<uint64_t, std::vector<PipelineId>> m_idsByHash;
+	mutable std::mutex m_mutex;
+
+	SStats m_stats;
+};
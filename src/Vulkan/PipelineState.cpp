@@ -0,0 +1,261 @@
+#include "vkpch.h"
+#include "PipelineState.h"
+
+/////////////////////////////////////////////////
+
+//FNV-1a over values added one by one, so padding and the layout of the structs never reach the hash
+class CStateHasher
+{
+public:
+	inline void addBytes( const void* pData, size_t size )
+	{
+		const uint8_t* pBytes = static_cast< const uint8_t* >( pData );
+		for( size_t i = 0; i < size; ++i )
+		{
+			m_hash ^= pBytes[ i ];
+			m_hash *= 1099511628211ull;
+		}
+	}
+
+	inline void add( uint32_t value )
+	{
+		addBytes( &value, sizeof( value ) );
+	}
+
+	inline void add( uint64_t value )
+	{
+		addBytes( &value, sizeof( value ) );
+	}
+
+	inline void add( bool value )
+	{
+		add( static_cast< uint32_t >( value ) );
+	}
+
+	inline void add( float value )
+	{
+		//-0.0 and 0.0 compare equal, so they have to hash the same
+		value = value == 0.0f ? 0.0f : value;
+		uint32_t bits;
+		std::memcpy( &bits, &value, sizeof( bits ) );
+		add( bits );
+	}
+
+	inline void add( const std::string& value )
+	{
+		add( static_cast< uint32_t >( value.size() ) );
+		addBytes( value.data(), value.size() );
+	}
+
+	template< typename T >
+	inline void addEnum( T value )
+	{
+		add( static_cast< uint32_t >( value ) );
+	}
+
+	template< typename T >
+	inline void addFlags( vk::Flags<T> value )
+	{
+		add( static_cast< uint32_t >( static_cast< typename vk::Flags<T>::MaskType >( value ) ) );
+	}
+
+	template< typename T >
+	inline void addHandle( T handle )
+	{
+		add( reinterpret_cast< uint64_t >( static_cast< typename T::CType >( handle ) ) );
+	}
+
+	inline uint64_t get() const
+	{
+		return m_hash;
+	}
+
+private:
+	uint64_t m_hash = 14695981039346656037ull;
+};
+
+/////////////////////////////////////////////////
+
+bool SRasterState::operator==( const SRasterState& other ) const
+{
+	return polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace
+		&& depthClampEnable == other.depthClampEnable && depthBiasEnable == other.depthBiasEnable
+		&& depthBiasConstantFactor == other.depthBiasConstantFactor && depthBiasSlopeFactor == other.depthBiasSlopeFactor
+		&& lineWidth == other.lineWidth;
+}
+
+vk::PipelineRasterizationStateCreateInfo SRasterState::toCreateInfo() const
+{
+	vk::PipelineRasterizationStateCreateInfo createInfo {};
+	createInfo.setDepthClampEnable( depthClampEnable );
+	createInfo.setRasterizerDiscardEnable( VK_FALSE );
+	createInfo.setPolygonMode( polygonMode );
+	createInfo.setCullMode( cullMode );
+	createInfo.setFrontFace( frontFace );
+	createInfo.setDepthBiasEnable( depthBiasEnable );
+	createInfo.setDepthBiasConstantFactor( depthBiasConstantFactor );
+	createInfo.setDepthBiasSlopeFactor( depthBiasSlopeFactor );
+	createInfo.setLineWidth( lineWidth );
+	return createInfo;
+}
+
+bool SDepthState::operator==( const SDepthState& other ) const
+{
+	return testEnable == other.testEnable && writeEnable == other.writeEnable && compareOp == other.compareOp;
+}
+
+vk::PipelineDepthStencilStateCreateInfo SDepthState::toCreateInfo() const
+{
+	return vk::PipelineDepthStencilStateCreateInfo( {}, testEnable, writeEnable, compareOp );
+}
+
+bool SBlendState::operator==( const SBlendState& other ) const
+{
+	return blendEnable == other.blendEnable && srcColorFactor == other.srcColorFactor && dstColorFactor == other.dstColorFactor
+		&& colorOp == other.colorOp && srcAlphaFactor == other.srcAlphaFactor && dstAlphaFactor == other.dstAlphaFactor
+		&& alphaOp == other.alphaOp && writeMask == other.writeMask;
+}
+
+vk::PipelineColorBlendAttachmentState SBlendState::toAttachmentState() const
+{
+	return vk::PipelineColorBlendAttachmentState( blendEnable, srcColorFactor, dstColorFactor, colorOp, srcAlphaFactor, dstAlphaFactor, alphaOp, writeMask );
+}
+
+/////////////////////////////////////////////////
+
+bool SPipelineState::SShader::operator==( const SShader& other ) const
+{
+	if( stage != other.stage || name != other.name || entryPoint != other.entryPoint
+		|| specializationConstants.size() != other.specializationConstants.size() )
+	{
+		return false;
+	}
+
+	for( size_t i = 0; i < specializationConstants.size(); ++i )
+	{
+		if( specializationConstants[ i ].constantId != other.specializationConstants[ i ].constantId
+			|| specializationConstants[ i ].value != other.specializationConstants[ i ].value )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t SPipelineState::getHash() const
+{
+	CStateHasher hasher;
+
+	hasher.add( static_cast< uint32_t >( shaders.size() ) );
+	for( const SShader& shader : shaders )
+	{
+		hasher.addEnum( shader.stage );
+		hasher.add( shader.name );
+		hasher.add( shader.entryPoint );
+		hasher.add( static_cast< uint32_t >( shader.specializationConstants.size() ) );
+		for( const SSpecializationConstant& constant : shader.specializationConstants )
+		{
+			hasher.add( constant.constantId );
+			hasher.add( constant.value );
+		}
+	}
+
+	hasher.add( static_cast< uint32_t >( vertexBindings.size() ) );
+	for( const auto& binding : vertexBindings )
+	{
+		hasher.add( binding.binding );
+		hasher.add( binding.stride );
+		hasher.addEnum( binding.inputRate );
+	}
+	hasher.add( static_cast< uint32_t >( vertexAttributes.size() ) );
+	for( const auto& attribute : vertexAttributes )
+	{
+		hasher.add( attribute.location );
+		hasher.add( attribute.binding );
+		hasher.addEnum( attribute.format );
+		hasher.add( attribute.offset );
+	}
+	hasher.addEnum( topology );
+
+	hasher.addEnum( raster.polygonMode );
+	hasher.addFlags( raster.cullMode );
+	hasher.addEnum( raster.frontFace );
+	hasher.add( raster.depthClampEnable );
+	hasher.add( raster.depthBiasEnable );
+	hasher.add( raster.depthBiasConstantFactor );
+	hasher.add( raster.depthBiasSlopeFactor );
+	hasher.add( raster.lineWidth );
+
+	hasher.addEnum( samples );
+
+	hasher.add( depth.testEnable );
+	hasher.add( depth.writeEnable );
+	hasher.addEnum( depth.compareOp );
+
+	hasher.add( static_cast< uint32_t >( blendAttachments.size() ) );
+	for( const SBlendState& blend : blendAttachments )
+	{
+		hasher.add( blend.blendEnable );
+		hasher.addEnum( blend.srcColorFactor );
+		hasher.addEnum( blend.dstColorFactor );
+		hasher.addEnum( blend.colorOp );
+		hasher.addEnum( blend.srcAlphaFactor );
+		hasher.addEnum( blend.dstAlphaFactor );
+		hasher.addEnum( blend.alphaOp );
+		hasher.addFlags( blend.writeMask );
+	}
+
+	hasher.add( static_cast< uint32_t >( dynamicStates.size() ) );
+	for( const vk::DynamicState dynamicState : dynamicStates )
+	{
+		hasher.addEnum( dynamicState );
+	}
+
+	hasher.addHandle( layout );
+	hasher.addHandle( renderPass );
+	hasher.add( subpass );
+
+	return hasher.get();
+}
+
+bool SPipelineState::operator==( const SPipelineState& other ) const
+{
+	return shaders == other.shaders
+		&& vertexBindings == other.vertexBindings && vertexAttributes == other.vertexAttributes && topology == other.topology
+		&& raster == other.raster && samples == other.samples && depth == other.depth
+		&& blendAttachments == other.blendAttachments && dynamicStates == other.dynamicStates
+		&& layout == other.layout && renderPass == other.renderPass && subpass == other.subpass;
+}
+
+SGraphicsPipelineDesc SPipelineState::toDesc() const
+{
+	SGraphicsPipelineDesc desc;
+	desc.name = debugName;
+
+	for( const SShader& shader : shaders )
+	{
+		desc.stages.push_back( { shader.stage, CShaderRegistry::Get( shader.name ), shader.entryPoint, shader.specializationConstants } );
+	}
+
+	desc.vertexBindings = vertexBindings;
+	desc.vertexAttributes = vertexAttributes;
+	desc.topology = topology;
+
+	desc.dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+	desc.dynamicStates.insert( desc.dynamicStates.end(), dynamicStates.begin(), dynamicStates.end() );
+
+	desc.rasterization = raster.toCreateInfo();
+	desc.multisample.setRasterizationSamples( samples );
+	//ignored by subpasses without a depth attachment
+	desc.depthStencil = depth.toCreateInfo();
+
+	for( const SBlendState& blend : blendAttachments )
+	{
+		desc.colorBlendAttachments.push_back( blend.toAttachmentState() );
+	}
+
+	desc.layout = layout;
+	desc.renderPass = renderPass;
+	desc.subpass = subpass;
+	return desc;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include "Vulkan/PipelineCompiler.h"
+
+//Compact descriptions of the fixed function state of a graphics pipeline. They hold only what
+//the renderer varies, compare and hash field by field, and the common configurations are
+//constexpr presets, so materials name a preset instead of filling in create infos.
+
+struct SRasterState
+{
+	vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+	vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+	vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise;
+	bool depthClampEnable = false;
+	bool depthBiasEnable = false;
+	float depthBiasConstantFactor = 0.0f;
+	float depthBiasSlopeFactor = 0.0f;
+	float lineWidth = 1.0f;
+
+	static constexpr SRasterState CullBack( vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise )
+	{
+		SRasterState state;
+		state.frontFace = frontFace;
+		return state;
+	}
+
+	static constexpr SRasterState CullNone()
+	{
+		SRasterState state;
+		state.cullMode = vk::CullModeFlagBits::eNone;
+		return state;
+	}
+
+	static constexpr SRasterState Wireframe()
+	{
+		SRasterState state;
+		state.polygonMode = vk::PolygonMode::eLine;
+		state.cullMode = vk::CullModeFlagBits::eNone;
+		return state;
+	}
+
+	//slope scaled bias against acne in depth only passes such as shadow maps
+	static constexpr SRasterState DepthBiased( float constantFactor, float slopeFactor )
+	{
+		SRasterState state;
+		state.depthBiasEnable = true;
+		state.depthBiasConstantFactor = constantFactor;
+		state.depthBiasSlopeFactor = slopeFactor;
+		return state;
+	}
+
+	bool operator==( const SRasterState& other ) const;
+	vk::PipelineRasterizationStateCreateInfo toCreateInfo() const;
+};
+
+struct SDepthState
+{
+	bool testEnable = false;
+	bool writeEnable = false;
+	vk::CompareOp compareOp = vk::CompareOp::eAlways;
+
+	static constexpr SDepthState Disabled()
+	{
+		return SDepthState {};
+	}
+
+	static constexpr SDepthState ReadWrite( vk::CompareOp compareOp = vk::CompareOp::eLess )
+	{
+		return SDepthState { true, true, compareOp };
+	}
+
+	//for transparent geometry and for passes after a depth prepass
+	static constexpr SDepthState ReadOnly( vk::CompareOp compareOp = vk::CompareOp::eLessOrEqual )
+	{
+		return SDepthState { true, false, compareOp };
+	}
+
+	bool operator==( const SDepthState& other ) const;
+	vk::PipelineDepthStencilStateCreateInfo toCreateInfo() const;
+};
+
+struct SBlendState
+{
+	bool blendEnable = false;
+	vk::BlendFactor srcColorFactor = vk::BlendFactor::eOne;
+	vk::BlendFactor dstColorFactor = vk::BlendFactor::eZero;
+	vk::BlendOp colorOp = vk::BlendOp::eAdd;
+	vk::BlendFactor srcAlphaFactor = vk::BlendFactor::eOne;
+	vk::BlendFactor dstAlphaFactor = vk::BlendFactor::eZero;
+	vk::BlendOp alphaOp = vk::BlendOp::eAdd;
+	vk::ColorComponentFlags writeMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+
+	static constexpr SBlendState Opaque()
+	{
+		return SBlendState {};
+	}
+
+	static constexpr SBlendState AlphaBlend()
+	{
+		SBlendState state;
+		state.blendEnable = true;
+		state.srcColorFactor = vk::BlendFactor::eSrcAlpha;
+		state.dstColorFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		state.dstAlphaFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		return state;
+	}
+
+	static constexpr SBlendState PremultipliedAlpha()
+	{
+		SBlendState state;
+		state.blendEnable = true;
+		state.dstColorFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		state.dstAlphaFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		return state;
+	}
+
+	static constexpr SBlendState Additive()
+	{
+		SBlendState state;
+		state.blendEnable = true;
+		state.dstColorFactor = vk::BlendFactor::eOne;
+		state.dstAlphaFactor = vk::BlendFactor::eOne;
+		return state;
+	}
+
+	bool operator==( const SBlendState& other ) const;
+	vk::PipelineColorBlendAttachmentState toAttachmentState() const;
+};
+
+//Everything that makes two graphics pipelines different, and the key CPipelineRegistry
+//deduplicates by. Shaders are referenced by their CShaderRegistry name and carry their
+//specialization constants, so a permutation is just another key.
+//Viewport and scissor are always dynamic, a resize never creates new permutations.
+//The layout and render pass are compared and hashed by handle, so the hash is only
+//stable for as long as they live. Everything else hashes by value, never by padding.
+struct SPipelineState
+{
+	struct SShader
+	{
+		vk::ShaderStageFlagBits stage;
+		std::string name;
+		std::string entryPoint = "main";
+		std::vector<SSpecializationConstant> specializationConstants;
+
+		bool operator==( const SShader& other ) const;
+	};
+
+	//for logs and tools only, requests that differ just by name share a pipeline
+	std::string debugName;
+
+	std::vector<SShader> shaders;
+
+	std::vector<vk::VertexInputBindingDescription> vertexBindings;
+	std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+
+	SRasterState raster;
+	vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+	SDepthState depth;
+	//one per color attachment of the subpass
+	std::vector<SBlendState> blendAttachments;
+	//in addition to viewport and scissor
+	std::vector<vk::DynamicState> dynamicStates;
+
+	vk::PipelineLayout layout;
+	vk::RenderPass renderPass;
+	uint32_t subpass = 0;
+
+	uint64_t getHash() const;
+	bool operator==( const SPipelineState& other ) const;
+	inline bool operator!=( const SPipelineState& other ) const
+	{
+		return !( *this == other );
+	}
+
+	//resolves the shaders through CShaderRegistry, which throws for unknown names
+	SGraphicsPipelineDesc toDesc() const;
+};
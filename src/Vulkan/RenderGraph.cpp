@@ -0,0 +1,1216 @@
+#include "vkpch.h"
+#include "RenderGraph.h"
+
+#include "Utils/Log.h"
+#include "Utils/Timer.h"
+#include "Vulkan/DeletionQueue.h"
+
+#include <map>
+
+/////////////////////////////////////////////////
+
+const uint32_t UNUSED_GROUP = UINT32_MAX;
+
+const vk::AccessFlags WRITE_ACCESS_FLAGS = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+
+static bool isDepthFormat( vk::Format format )
+{
+	switch( format )
+	{
+		case vk::Format::eD16Unorm:
+		case vk::Format::eX8D24UnormPack32:
+		case vk::Format::eD32Sfloat:
+		case vk::Format::eS8Uint:
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool hasStencil( vk::Format format )
+{
+	return format == vk::Format::eS8Uint || format == vk::Format::eD16UnormS8Uint ||
+		format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint;
+}
+
+static vk::ImageAspectFlags getAspect( vk::Format format )
+{
+	if( !isDepthFormat( format ) )
+	{
+		return vk::ImageAspectFlagBits::eColor;
+	}
+
+	if( format == vk::Format::eS8Uint )
+	{
+		return vk::ImageAspectFlagBits::eStencil;
+	}
+
+	return hasStencil( format ) ? vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil : vk::ImageAspectFlagBits::eDepth;
+}
+
+/////////////////////////////////////////////////
+
+CRenderGraph::CPassBuilder::CPassBuilder( CRenderGraph& graph, PassId pass )
+	: m_graph( graph )
+	, m_pass( pass )
+{
+}
+
+CRenderGraph::CPassBuilder& CRenderGraph::CPassBuilder::writeColor( ResourceId resource, std::optional<vk::ClearColorValue> clearValue )
+{
+	SAccess& access = m_graph.addAccess( m_pass, resource, EAccess::ColorWrite );
+	if( clearValue.has_value() )
+	{
+		access.clear = true;
+		access.clearValue.setColor( clearValue.value() );
+	}
+	return *this;
+}
+
+CRenderGraph::CPassBuilder& CRenderGraph::CPassBuilder::writeDepth( ResourceId resource, std::optional<vk::ClearDepthStencilValue> clearValue )
+{
+	SAccess& access = m_graph.addAccess( m_pass, resource, EAccess::DepthWrite );
+	if( clearValue.has_value() )
+	{
+		access.clear = true;
+		access.clearValue.setDepthStencil( clearValue.value() );
+	}
+	return *this;
+}
+
+CRenderGraph::CPassBuilder& CRenderGraph::CPassBuilder::readDepth( ResourceId resource )
+{
+	m_graph.addAccess( m_pass, resource, EAccess::DepthRead );
+	return *this;
+}
+
+CRenderGraph::CPassBuilder& CRenderGraph::CPassBuilder::readAttachment( ResourceId resource )
+{
+	m_graph.addAccess( m_pass, resource, EAccess::InputRead );
+	return *this;
+}
+
+CRenderGraph::CPassBuilder& CRenderGraph::CPassBuilder::readTexture( ResourceId resource, vk::PipelineStageFlags stages )
+{
+	m_graph.addAccess( m_pass, resource, EAccess::SampledRead ).stages = stages;
+	return *this;
+}
+
+CRenderGraph::CPassBuilder& CRenderGraph::CPassBuilder::setSideEffect()
+{
+	m_graph.m_passes[ m_pass ].sideEffect = true;
+	return *this;
+}
+
+/////////////////////////////////////////////////
+
+CRenderGraph::CRenderGraph()
+	: m_device( nullptr )
+	, m_pMemoryAllocator( nullptr )
+	, m_compiled( false )
+	, m_imagesCreated( false )
+{
+}
+
+void CRenderGraph::init( const vk::Device& device, CDeviceMemoryAllocator& memoryAllocator )
+{
+	m_device = device;
+	m_pMemoryAllocator = &memoryAllocator;
+}
+
+void CRenderGraph::destroy()
+{
+	destroyImages( nullptr, 0 );
+
+	for( auto& group : m_groups )
+	{
+		m_device.destroyRenderPass( group.renderPass );
+	}
+
+	m_groups.clear();
+	m_memorySlots.clear();
+	m_passes.clear();
+	m_resources.clear();
+	m_compiled = false;
+}
+
+CRenderGraph::ResourceId CRenderGraph::createImage( const char* name, const SImageDesc& desc )
+{
+	if( m_compiled )
+	{
+		throw std::runtime_error( "Render graph is compiled, reset it before adding images." );
+	}
+
+	SResource resource {};
+	resource.name = name;
+	resource.desc = desc;
+	resource.imported = false;
+	m_resources.push_back( resource );
+
+	return static_cast< ResourceId >( m_resources.size() - 1 );
+}
+
+CRenderGraph::ResourceId CRenderGraph::importImage( const char* name, const SImportDesc& desc )
+{
+	if( m_compiled )
+	{
+		throw std::runtime_error( "Render graph is compiled, reset it before importing images." );
+	}
+
+	SResource resource {};
+	resource.name = name;
+	resource.desc.format = desc.format;
+	resource.desc.samples = desc.samples;
+	resource.imported = true;
+	resource.import = desc;
+	m_resources.push_back( resource );
+
+	return static_cast< ResourceId >( m_resources.size() - 1 );
+}
+
+CRenderGraph::CPassBuilder CRenderGraph::addPass( const char* name, ExecuteFn execute )
+{
+	if( m_compiled )
+	{
+		throw std::runtime_error( "Render graph is compiled, reset it before adding passes." );
+	}
+
+	SPass pass {};
+	pass.name = name;
+	pass.execute = std::move( execute );
+	pass.sideEffect = false;
+	pass.culled = false;
+	pass.contents = vk::SubpassContents::eInline;
+	m_passes.push_back( std::move( pass ) );
+
+	return CPassBuilder( *this, static_cast< PassId >( m_passes.size() - 1 ) );
+}
+
+void CRenderGraph::compile()
+{
+	if( m_compiled )
+	{
+		return;
+	}
+
+	CTimer timer;
+
+	cullPasses();
+	groupPasses();
+	assignMemorySlots();
+	buildRenderPasses();
+
+	m_stats.passes = static_cast< uint32_t >( m_passes.size() );
+	m_stats.culledPasses = static_cast< uint32_t >( std::count_if( m_passes.begin(), m_passes.end(), []( const SPass& pass ) { return pass.culled; } ) );
+	m_stats.renderPasses = static_cast< uint32_t >( m_groups.size() );
+	m_stats.compileMilliseconds = timer.elapsedMilliseconds();
+
+	m_compiled = true;
+}
+
+void CRenderGraph::reset( CDeletionQueue& deletionQueue, uint64_t retireValue )
+{
+	destroyImages( &deletionQueue, retireValue );
+
+	std::vector<vk::RenderPass> renderPasses;
+	for( const auto& group : m_groups )
+	{
+		renderPasses.push_back( group.renderPass );
+	}
+
+	const vk::Device device = m_device;
+	deletionQueue.push( retireValue, [ device, renderPasses ]
+	{
+		for( const auto& renderPass : renderPasses )
+		{
+			device.destroyRenderPass( renderPass );
+		}
+	} );
+
+	m_groups.clear();
+	m_memorySlots.clear();
+	m_passes.clear();
+	m_resources.clear();
+	m_stats = SStats {};
+	m_compiled = false;
+}
+
+void CRenderGraph::setExtent( const vk::Extent2D& extent )
+{
+	if( m_imagesCreated )
+	{
+		throw std::runtime_error( "Render graph images exist already, use resize." );
+	}
+
+	m_extent = extent;
+}
+
+void CRenderGraph::resize( const vk::Extent2D& extent, CDeletionQueue& deletionQueue, uint64_t retireValue )
+{
+	destroyImages( &deletionQueue, retireValue );
+	m_extent = extent;
+}
+
+void CRenderGraph::setImportedImage( ResourceId resource, const vk::Image& image, const vk::ImageView& view )
+{
+	if( !m_resources[ resource ].imported )
+	{
+		throw std::runtime_error( std::string( "Render graph image '" ) + m_resources[ resource ].name + "' is not imported." );
+	}
+
+	m_resources[ resource ].image = image;
+	m_resources[ resource ].view = view;
+}
+
+void CRenderGraph::setPassContents( PassId pass, vk::SubpassContents contents )
+{
+	m_passes[ pass ].contents = contents;
+}
+
+void CRenderGraph::execute( const vk::CommandBuffer& commandBuffer )
+{
+	compile();
+	if( !m_imagesCreated )
+	{
+		createImages();
+	}
+
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+	for( auto& group : m_groups )
+	{
+		if( !group.barriers.empty() )
+		{
+			vk::PipelineStageFlags srcStages;
+			vk::PipelineStageFlags dstStages;
+			imageBarriers.clear();
+
+			for( const SImageBarrier& barrier : group.barriers )
+			{
+				const SResource& resource = m_resources[ barrier.resource ];
+				imageBarriers.emplace_back( barrier.srcAccess, barrier.dstAccess, barrier.oldLayout, barrier.newLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+					resource.image, vk::ImageSubresourceRange( getAspect( resource.desc.format ), 0, 1, 0, 1 ) );
+
+				srcStages |= barrier.srcStages;
+				dstStages |= barrier.dstStages;
+			}
+
+			commandBuffer.pipelineBarrier( srcStages, dstStages, {}, nullptr, nullptr, imageBarriers );
+		}
+
+		SPassContext context;
+		context.commandBuffer = commandBuffer;
+		context.renderPass = group.renderPass;
+		context.framebuffer = getGroupFramebuffer( group );
+		context.renderArea = vk::Rect2D( vk::Offset2D { 0, 0 }, group.extent );
+
+		vk::RenderPassBeginInfo beginInfo( group.renderPass, context.framebuffer, context.renderArea,
+			static_cast< uint32_t >( group.clearValues.size() ), group.clearValues.data() );
+		commandBuffer.beginRenderPass( beginInfo, m_passes[ group.passes.front() ].contents );
+
+		for( uint32_t subpass = 0; subpass < group.passes.size(); ++subpass )
+		{
+			const SPass& pass = m_passes[ group.passes[ subpass ] ];
+			if( subpass > 0 )
+			{
+				commandBuffer.nextSubpass( pass.contents );
+			}
+
+			context.subpass = subpass;
+			if( pass.execute )
+			{
+				pass.execute( context );
+			}
+		}
+
+		commandBuffer.endRenderPass();
+	}
+}
+
+vk::RenderPass CRenderGraph::getRenderPass( PassId pass ) const
+{
+	return m_passes[ pass ].culled ? vk::RenderPass( nullptr ) : m_groups[ m_passes[ pass ].group ].renderPass;
+}
+
+uint32_t CRenderGraph::getSubpass( PassId pass ) const
+{
+	return m_passes[ pass ].subpass;
+}
+
+uint32_t CRenderGraph::getSubpassCount( PassId pass ) const
+{
+	return static_cast< uint32_t >( m_groups[ m_passes[ pass ].group ].passes.size() );
+}
+
+const std::vector<vk::ClearValue>& CRenderGraph::getClearValues( PassId pass ) const
+{
+	return m_groups[ m_passes[ pass ].group ].clearValues;
+}
+
+vk::Framebuffer CRenderGraph::getFramebuffer( PassId pass )
+{
+	compile();
+	if( !m_imagesCreated )
+	{
+		createImages();
+	}
+
+	return m_passes[ pass ].culled ? vk::Framebuffer( nullptr ) : getGroupFramebuffer( m_groups[ m_passes[ pass ].group ] );
+}
+
+vk::Rect2D CRenderGraph::getRenderArea( PassId pass ) const
+{
+	const ResourceId attachment = m_groups[ m_passes[ pass ].group ].attachments.front();
+	return vk::Rect2D( vk::Offset2D { 0, 0 }, getImageExtent( m_resources[ attachment ] ) );
+}
+
+bool CRenderGraph::isCulled( PassId pass ) const
+{
+	return m_passes[ pass ].culled;
+}
+
+void CRenderGraph::logStats() const
+{
+	VS_INFO( "Render graph: {0} passes ({1} culled) in {2} render passes, compiled in {3:.3f} ms", m_stats.passes, m_stats.culledPasses,
+		m_stats.renderPasses, m_stats.compileMilliseconds );
+	VS_INFO( "    synchronization : {0} subpass dependencies, {1} image barriers per frame", m_stats.subpassDependencies, m_stats.imageBarriers );
+	VS_INFO( "    transient images: {0} in {1} bytes, {2} bytes without aliasing", m_stats.transientImages, m_stats.transientBytes, m_stats.unaliasedBytes );
+}
+
+/////////////////////////////////////////////////
+
+CRenderGraph::SAccess& CRenderGraph::addAccess( PassId pass, ResourceId resource, EAccess type )
+{
+	if( m_compiled )
+	{
+		throw std::runtime_error( "Render graph is compiled, reset it before changing passes." );
+	}
+
+	if( resource >= m_resources.size() )
+	{
+		throw std::runtime_error( std::string( "Render graph pass '" ) + m_passes[ pass ].name + "' uses an unknown image." );
+	}
+
+	const bool depthAccess = ( type == EAccess::DepthWrite || type == EAccess::DepthRead );
+	if( ( type == EAccess::ColorWrite || depthAccess ) && depthAccess != isDepthFormat( m_resources[ resource ].desc.format ) )
+	{
+		throw std::runtime_error( std::string( "Render graph image '" ) + m_resources[ resource ].name + "' has the wrong format for this attachment." );
+	}
+
+	std::vector<SAccess>& accesses = m_passes[ pass ].accesses;
+	for( const SAccess& access : accesses )
+	{
+		if( access.resource == resource )
+		{
+			throw std::runtime_error( std::string( "Render graph pass '" ) + m_passes[ pass ].name + "' uses image '" + m_resources[ resource ].name + "' twice." );
+		}
+	}
+
+	SAccess access {};
+	access.resource = resource;
+	access.type = type;
+	access.clear = false;
+	accesses.push_back( access );
+
+	return accesses.back();
+}
+
+void CRenderGraph::cullPasses()
+{
+	//walks back from what leaves the graph, a pass survives if something later reads what it writes
+	std::vector<bool> live( m_resources.size(), false );
+	for( size_t resource = 0; resource < m_resources.size(); ++resource )
+	{
+		live[ resource ] = m_resources[ resource ].imported && m_resources[ resource ].import.exported;
+	}
+
+	for( size_t passIndex = m_passes.size(); passIndex-- > 0; )
+	{
+		SPass& pass = m_passes[ passIndex ];
+
+		bool needed = pass.sideEffect;
+		for( const SAccess& access : pass.accesses )
+		{
+			needed |= IsWrite( access.type ) && live[ access.resource ];
+		}
+
+		pass.culled = !needed;
+		if( pass.culled )
+		{
+			continue;
+		}
+
+		//a clear replaces the contents, anything else depends on what was there before
+		for( const SAccess& access : pass.accesses )
+		{
+			live[ access.resource ] = !( IsWrite( access.type ) && access.clear );
+		}
+	}
+}
+
+void CRenderGraph::groupPasses()
+{
+	m_groups.clear();
+
+	for( PassId passId = 0; passId < m_passes.size(); ++passId )
+	{
+		SPass& pass = m_passes[ passId ];
+		if( pass.culled )
+		{
+			continue;
+		}
+
+		if( std::none_of( pass.accesses.begin(), pass.accesses.end(), []( const SAccess& access ) { return IsAttachment( access.type ); } ) )
+		{
+			throw std::runtime_error( std::string( "Render graph pass '" ) + pass.name + "' has no attachments." );
+		}
+
+		if( m_groups.empty() || !canMerge( m_groups.back(), pass ) )
+		{
+			m_groups.emplace_back();
+		}
+
+		SGroup& group = m_groups.back();
+		pass.group = static_cast< uint32_t >( m_groups.size() - 1 );
+		pass.subpass = static_cast< uint32_t >( group.passes.size() );
+		group.passes.push_back( passId );
+
+		for( const SAccess& access : pass.accesses )
+		{
+			if( IsAttachment( access.type ) && std::find( group.attachments.begin(), group.attachments.end(), access.resource ) == group.attachments.end() )
+			{
+				group.attachments.push_back( access.resource );
+			}
+		}
+
+		//0 follows the graph extent, like the images
+		group.extent = m_resources[ group.attachments.front() ].desc.extent;
+	}
+}
+
+bool CRenderGraph::canMerge( const SGroup& group, const SPass& pass ) const
+{
+	const SResource& groupAttachment = m_resources[ group.attachments.front() ];
+
+	for( const SAccess& access : pass.accesses )
+	{
+		const SResource& resource = m_resources[ access.resource ];
+		const bool inGroup = std::find( group.attachments.begin(), group.attachments.end(), access.resource ) != group.attachments.end();
+
+		if( access.type == EAccess::SampledRead )
+		{
+			//needs everything that wrote it to have finished, not only the same pixel
+			if( inGroup )
+			{
+				return false;
+			}
+			continue;
+		}
+
+		//a framebuffer has one size and sample count
+		if( resource.desc.extent != groupAttachment.desc.extent || resource.desc.samples != groupAttachment.desc.samples )
+		{
+			return false;
+		}
+
+		//writing what an earlier subpass samples would be a feedback loop
+		for( const PassId groupPass : group.passes )
+		{
+			for( const SAccess& groupAccess : m_passes[ groupPass ].accesses )
+			{
+				if( groupAccess.resource == access.resource && groupAccess.type == EAccess::SampledRead )
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void CRenderGraph::assignMemorySlots()
+{
+	for( auto& resource : m_resources )
+	{
+		resource.usage = {};
+		resource.firstGroup = UNUSED_GROUP;
+		resource.lastGroup = 0;
+		resource.transientAttachment = false;
+		resource.memorySlot = UNUSED_GROUP;
+	}
+
+	for( const SPass& pass : m_passes )
+	{
+		if( pass.culled )
+		{
+			continue;
+		}
+
+		for( const SAccess& access : pass.accesses )
+		{
+			SResource& resource = m_resources[ access.resource ];
+			resource.firstGroup = std::min( resource.firstGroup, pass.group );
+			resource.lastGroup = std::max( resource.lastGroup, pass.group );
+
+			switch( access.type )
+			{
+				case EAccess::ColorWrite:
+					resource.usage |= vk::ImageUsageFlagBits::eColorAttachment;
+					break;
+				case EAccess::DepthWrite:
+				case EAccess::DepthRead:
+					resource.usage |= vk::ImageUsageFlagBits::eDepthStencilAttachment;
+					break;
+				case EAccess::InputRead:
+					resource.usage |= vk::ImageUsageFlagBits::eInputAttachment;
+					break;
+				case EAccess::SampledRead:
+					resource.usage |= vk::ImageUsageFlagBits::eSampled;
+					break;
+			}
+		}
+	}
+
+	//interval coloring in order of first use. Depth and color images get separate slots,
+	//some devices keep them in different memory types.
+	std::vector<bool> slotIsDepth;
+	m_memorySlots.clear();
+
+	std::vector<ResourceId> order;
+	for( ResourceId resourceId = 0; resourceId < m_resources.size(); ++resourceId )
+	{
+		if( !m_resources[ resourceId ].imported && m_resources[ resourceId ].firstGroup != UNUSED_GROUP )
+		{
+			order.push_back( resourceId );
+		}
+	}
+
+	std::stable_sort( order.begin(), order.end(), [ this ]( ResourceId lhs, ResourceId rhs )
+	{
+		return m_resources[ lhs ].firstGroup < m_resources[ rhs ].firstGroup;
+	} );
+
+	for( const ResourceId resourceId : order )
+	{
+		SResource& resource = m_resources[ resourceId ];
+		const bool depth = isDepthFormat( resource.desc.format );
+
+		const vk::ImageUsageFlags attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+		resource.transientAttachment = ( resource.firstGroup == resource.lastGroup ) && !( resource.usage & ~attachmentUsage );
+
+		uint32_t slotIndex = 0;
+		while( slotIndex < m_memorySlots.size() && ( m_memorySlots[ slotIndex ].lastGroup >= resource.firstGroup || slotIsDepth[ slotIndex ] != depth ) )
+		{
+			++slotIndex;
+		}
+
+		if( slotIndex == m_memorySlots.size() )
+		{
+			m_memorySlots.emplace_back();
+			slotIsDepth.push_back( depth );
+		}
+
+		m_memorySlots[ slotIndex ].resources.push_back( resourceId );
+		m_memorySlots[ slotIndex ].lastGroup = resource.lastGroup;
+		resource.memorySlot = slotIndex;
+	}
+
+	m_stats.transientImages = static_cast< uint32_t >( order.size() );
+}
+
+void CRenderGraph::buildRenderPasses()
+{
+	std::vector<SResourceState> states( m_resources.size() );
+	for( size_t resource = 0; resource < m_resources.size(); ++resource )
+	{
+		if( m_resources[ resource ].imported )
+		{
+			const SImportDesc& import = m_resources[ resource ].import;
+			states[ resource ].layout = import.initialLayout;
+			states[ resource ].stages = import.initialStages;
+			states[ resource ].hasContents = ( import.initialLayout != vk::ImageLayout::eUndefined );
+		}
+	}
+
+	//one transient image serves every frame in flight, so its first use waits for the last use
+	//by the execution before. When images share memory that is the last image of the slot.
+	for( const SMemorySlot& slot : m_memorySlots )
+	{
+		const SResourceState lastState = getFinalState( slot.resources.back() );
+		states[ slot.resources.front() ].stages = lastState.stages;
+		states[ slot.resources.front() ].writeAccess = lastState.writeAccess;
+	}
+
+	m_stats.subpassDependencies = 0;
+	m_stats.imageBarriers = 0;
+
+	for( uint32_t groupIndex = 0; groupIndex < m_groups.size(); ++groupIndex )
+	{
+		buildRenderPass( groupIndex, states );
+	}
+}
+
+CRenderGraph::SResourceState CRenderGraph::getFinalState( ResourceId resource ) const
+{
+	SResourceState state;
+	for( const SGroup& group : m_groups )
+	{
+		vk::PipelineStageFlags groupStages;
+		vk::AccessFlags groupWriteAccess;
+
+		for( const PassId pass : group.passes )
+		{
+			for( const SAccess& access : m_passes[ pass ].accesses )
+			{
+				if( access.resource != resource )
+				{
+					continue;
+				}
+
+				//sampled reads happen before the render pass, as barriers or external dependencies
+				if( !IsAttachment( access.type ) )
+				{
+					state.stages |= GetStages( access );
+					continue;
+				}
+
+				groupStages |= GetStages( access );
+				if( IsWrite( access.type ) )
+				{
+					groupWriteAccess |= GetAccessFlags( access.type ) & WRITE_ACCESS_FLAGS;
+				}
+			}
+		}
+
+		//same as the end of buildRenderPass: a write replaces what came before, reads add up
+		state.stages = groupWriteAccess ? groupStages : state.stages | groupStages;
+		state.writeAccess = groupWriteAccess ? groupWriteAccess : state.writeAccess;
+	}
+	return state;
+}
+
+void CRenderGraph::buildRenderPass( uint32_t groupIndex, std::vector<SResourceState>& states )
+{
+	SGroup& group = m_groups[ groupIndex ];
+	const uint32_t subpassCount = static_cast< uint32_t >( group.passes.size() );
+
+	//one dependency per subpass pair, the masks of every image between them are merged
+	std::map<std::pair<uint32_t, uint32_t>, vk::SubpassDependency> dependencies;
+	auto addDependency = [ &dependencies ]( uint32_t srcSubpass, uint32_t dstSubpass, vk::PipelineStageFlags srcStages, vk::AccessFlags srcAccess,
+		vk::PipelineStageFlags dstStages, vk::AccessFlags dstAccess )
+	{
+		vk::SubpassDependency& dependency = dependencies[ { srcSubpass, dstSubpass } ];
+		dependency.srcSubpass = srcSubpass;
+		dependency.dstSubpass = dstSubpass;
+		dependency.srcStageMask |= srcStages;
+		dependency.srcAccessMask |= srcAccess;
+		dependency.dstStageMask |= dstStages;
+		dependency.dstAccessMask |= dstAccess;
+
+		//subpasses only ever read the pixel they write
+		if( srcSubpass != VK_SUBPASS_EXTERNAL && dstSubpass != VK_SUBPASS_EXTERNAL )
+		{
+			dependency.dependencyFlags = vk::DependencyFlagBits::eByRegion;
+		}
+	};
+
+	//sampled images are no attachments, anything their layout needs happens before the render pass
+	for( uint32_t subpass = 0; subpass < subpassCount; ++subpass )
+	{
+		for( const SAccess& access : m_passes[ group.passes[ subpass ] ].accesses )
+		{
+			if( access.type != EAccess::SampledRead )
+			{
+				continue;
+			}
+
+			SResourceState& state = states[ access.resource ];
+			const vk::ImageLayout layout = GetLayout( access.type, isDepthFormat( m_resources[ access.resource ].desc.format ) );
+
+			if( state.layout != layout )
+			{
+				group.barriers.push_back( SImageBarrier { access.resource, state.hasContents ? state.layout : vk::ImageLayout::eUndefined, layout,
+					state.stages ? state.stages : vk::PipelineStageFlags( vk::PipelineStageFlagBits::eTopOfPipe ), state.writeAccess,
+					GetStages( access ), GetAccessFlags( access.type ) } );
+			}
+			else if( state.stages )
+			{
+				addDependency( VK_SUBPASS_EXTERNAL, subpass, state.stages, state.writeAccess, GetStages( access ), GetAccessFlags( access.type ) );
+			}
+
+			state.layout = layout;
+			state.stages |= GetStages( access );
+		}
+	}
+
+	std::vector<vk::AttachmentDescription> attachmentDescs;
+	std::vector<std::vector<vk::AttachmentReference>> colorRefs( subpassCount );
+	std::vector<std::vector<vk::AttachmentReference>> inputRefs( subpassCount );
+	std::vector<vk::AttachmentReference> depthRefs( subpassCount, vk::AttachmentReference( VK_ATTACHMENT_UNUSED, vk::ImageLayout::eUndefined ) );
+	std::vector<std::vector<uint32_t>> preserveRefs( subpassCount );
+
+	group.clearValues.assign( group.attachments.size(), vk::ClearValue {} );
+
+	for( uint32_t attachmentIndex = 0; attachmentIndex < group.attachments.size(); ++attachmentIndex )
+	{
+		const ResourceId resourceId = group.attachments[ attachmentIndex ];
+		const SResource& resource = m_resources[ resourceId ];
+		const bool depth = isDepthFormat( resource.desc.format );
+		SResourceState& state = states[ resourceId ];
+
+		std::vector<std::pair<uint32_t, const SAccess*>> uses;
+		for( uint32_t subpass = 0; subpass < subpassCount; ++subpass )
+		{
+			for( const SAccess& access : m_passes[ group.passes[ subpass ] ].accesses )
+			{
+				if( access.resource == resourceId && IsAttachment( access.type ) )
+				{
+					uses.emplace_back( subpass, &access );
+				}
+			}
+		}
+
+		const SAccess& firstUse = *uses.front().second;
+		const SAccess& lastUse = *uses.back().second;
+		const SAccess* pNextAccess = findNextAccess( group.passes.back(), resourceId );
+		const bool exported = resource.imported && resource.import.exported;
+
+		vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eDontCare;
+		if( firstUse.clear )
+		{
+			loadOp = vk::AttachmentLoadOp::eClear;
+			group.clearValues[ attachmentIndex ] = firstUse.clearValue;
+		}
+		else if( state.hasContents )
+		{
+			loadOp = vk::AttachmentLoadOp::eLoad;
+		}
+
+		const vk::AttachmentStoreOp storeOp = ( pNextAccess || exported ) ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+		//leaving in the layout of the next use saves a barrier there
+		vk::ImageLayout finalLayout = GetLayout( lastUse.type, depth );
+		if( pNextAccess )
+		{
+			finalLayout = GetLayout( pNextAccess->type, depth );
+		}
+		else if( exported && resource.import.finalLayout != vk::ImageLayout::eUndefined )
+		{
+			finalLayout = resource.import.finalLayout;
+		}
+
+		const bool stencil = hasStencil( resource.desc.format );
+		attachmentDescs.emplace_back( vk::AttachmentDescriptionFlags {}, resource.desc.format, resource.desc.samples, loadOp, storeOp,
+			stencil ? loadOp : vk::AttachmentLoadOp::eDontCare, stencil ? storeOp : vk::AttachmentStoreOp::eDontCare,
+			loadOp == vk::AttachmentLoadOp::eLoad ? state.layout : vk::ImageLayout::eUndefined, finalLayout );
+
+		//waits on whatever used the image or its memory before
+		vk::PipelineStageFlags srcStages = state.stages;
+		vk::AccessFlags srcAccess = state.writeAccess;
+		if( !resource.imported && resource.firstGroup == groupIndex )
+		{
+			const std::vector<ResourceId>& slotResources = m_memorySlots[ resource.memorySlot ].resources;
+			const auto slotPosition = std::find( slotResources.begin(), slotResources.end(), resourceId );
+			if( slotPosition != slotResources.begin() )
+			{
+				srcStages = states[ *( slotPosition - 1 ) ].stages;
+				srcAccess = states[ *( slotPosition - 1 ) ].writeAccess;
+			}
+		}
+
+		if( srcStages )
+		{
+			addDependency( VK_SUBPASS_EXTERNAL, uses.front().first, srcStages, srcAccess, GetStages( firstUse ), GetAccessFlags( firstUse.type ) );
+		}
+
+		//every use waits for the last write, a write also waits for the reads since then
+		std::optional<std::pair<uint32_t, const SAccess*>> lastWrite;
+		std::vector<std::pair<uint32_t, const SAccess*>> readsSinceWrite;
+		vk::PipelineStageFlags groupStages;
+		vk::AccessFlags groupWriteAccess;
+
+		for( const auto& use : uses )
+		{
+			const uint32_t subpass = use.first;
+			const SAccess& access = *use.second;
+
+			const vk::AttachmentReference reference( attachmentIndex, GetLayout( access.type, depth ) );
+			switch( access.type )
+			{
+				case EAccess::ColorWrite:
+					colorRefs[ subpass ].push_back( reference );
+					break;
+				case EAccess::DepthWrite:
+				case EAccess::DepthRead:
+					depthRefs[ subpass ] = reference;
+					break;
+				case EAccess::InputRead:
+					inputRefs[ subpass ].push_back( reference );
+					break;
+				default:
+					break;
+			}
+
+			if( lastWrite.has_value() && lastWrite->first != subpass )
+			{
+				addDependency( lastWrite->first, subpass, GetStages( *lastWrite->second ), GetAccessFlags( lastWrite->second->type ) & WRITE_ACCESS_FLAGS,
+					GetStages( access ), GetAccessFlags( access.type ) );
+			}
+
+			if( IsWrite( access.type ) )
+			{
+				for( const auto& read : readsSinceWrite )
+				{
+					if( read.first != subpass )
+					{
+						addDependency( read.first, subpass, GetStages( *read.second ), {}, GetStages( access ), GetAccessFlags( access.type ) );
+					}
+				}
+
+				readsSinceWrite.clear();
+				lastWrite = use;
+				groupWriteAccess |= GetAccessFlags( access.type ) & WRITE_ACCESS_FLAGS;
+			}
+			else
+			{
+				readsSinceWrite.push_back( use );
+			}
+
+			groupStages |= GetStages( access );
+		}
+
+		//subpasses between the first and last use have to keep the contents
+		for( uint32_t subpass = uses.front().first + 1; subpass < uses.back().first; ++subpass )
+		{
+			const bool used = std::any_of( uses.begin(), uses.end(), [ subpass ]( const auto& use ) { return use.first == subpass; } );
+			if( !used )
+			{
+				preserveRefs[ subpass ].push_back( attachmentIndex );
+			}
+		}
+
+		//hands the image to its next use, from every subpass that wrote it and the last one that used it
+		if( pNextAccess || exported )
+		{
+			const vk::PipelineStageFlags dstStages = pNextAccess ? GetStages( *pNextAccess ) : resource.import.finalStages;
+			const vk::AccessFlags dstAccess = pNextAccess ? GetAccessFlags( pNextAccess->type ) : resource.import.finalAccess;
+
+			for( const auto& use : uses )
+			{
+				if( IsWrite( use.second->type ) || use.first == uses.back().first )
+				{
+					addDependency( use.first, VK_SUBPASS_EXTERNAL, GetStages( *use.second ), GetAccessFlags( use.second->type ) & WRITE_ACCESS_FLAGS, dstStages, dstAccess );
+				}
+			}
+		}
+
+		state.layout = finalLayout;
+		state.stages = groupWriteAccess ? groupStages : state.stages | groupStages;
+		state.writeAccess = groupWriteAccess ? groupWriteAccess : state.writeAccess;
+		state.hasContents = ( storeOp == vk::AttachmentStoreOp::eStore );
+	}
+
+	std::vector<vk::SubpassDescription> subpassDescs;
+	for( uint32_t subpass = 0; subpass < subpassCount; ++subpass )
+	{
+		const bool hasDepth = depthRefs[ subpass ].attachment != VK_ATTACHMENT_UNUSED;
+		subpassDescs.emplace_back( vk::SubpassDescriptionFlags {}, vk::PipelineBindPoint::eGraphics,
+			static_cast< uint32_t >( inputRefs[ subpass ].size() ), inputRefs[ subpass ].data(),
+			static_cast< uint32_t >( colorRefs[ subpass ].size() ), colorRefs[ subpass ].data(), nullptr,
+			hasDepth ? &depthRefs[ subpass ] : nullptr,
+			static_cast< uint32_t >( preserveRefs[ subpass ].size() ), preserveRefs[ subpass ].data() );
+	}
+
+	std::vector<vk::SubpassDependency> dependencyList;
+	for( auto& entry : dependencies )
+	{
+		vk::SubpassDependency dependency = entry.second;
+		if( !dependency.srcStageMask )
+		{
+			dependency.srcStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
+		}
+		if( !dependency.dstStageMask )
+		{
+			dependency.dstStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
+		}
+		dependencyList.push_back( dependency );
+	}
+
+	vk::RenderPassCreateInfo renderPassCreateInfo( {}, static_cast< uint32_t >( attachmentDescs.size() ), attachmentDescs.data(),
+		static_cast< uint32_t >( subpassDescs.size() ), subpassDescs.data(), static_cast< uint32_t >( dependencyList.size() ), dependencyList.data() );
+
+	group.renderPass = m_device.createRenderPass( renderPassCreateInfo );
+	if( group.renderPass == vk::RenderPass( nullptr ) )
+	{
+		throw std::runtime_error( std::string( "Failed to create render pass for '" ) + m_passes[ group.passes.front() ].name + "'." );
+	}
+
+	m_stats.subpassDependencies += static_cast< uint32_t >( dependencyList.size() );
+	m_stats.imageBarriers += static_cast< uint32_t >( group.barriers.size() );
+}
+
+void CRenderGraph::createImages()
+{
+	for( auto& resource : m_resources )
+	{
+		if( resource.imported || resource.firstGroup == UNUSED_GROUP )
+		{
+			continue;
+		}
+
+		const vk::Extent2D extent = getImageExtent( resource );
+		const vk::ImageUsageFlags usage = resource.usage | ( resource.transientAttachment ? vk::ImageUsageFlagBits::eTransientAttachment : vk::ImageUsageFlags {} );
+
+		vk::ImageCreateInfo imageCreateInfo( {}, vk::ImageType::e2D, resource.desc.format, vk::Extent3D( extent.width, extent.height, 1 ), 1, 1,
+			resource.desc.samples, vk::ImageTiling::eOptimal, usage, vk::SharingMode::eExclusive, 0, nullptr, vk::ImageLayout::eUndefined );
+		resource.image = m_device.createImage( imageCreateInfo );
+	}
+
+	m_stats.transientBytes = 0;
+	m_stats.unaliasedBytes = 0;
+
+	for( auto& slot : m_memorySlots )
+	{
+		vk::MemoryRequirements slotRequirements( 0, 1, ~0u );
+		for( const ResourceId resourceId : slot.resources )
+		{
+			const vk::MemoryRequirements requirements = m_device.getImageMemoryRequirements( m_resources[ resourceId ].image );
+			slotRequirements.size = std::max( slotRequirements.size, requirements.size );
+			slotRequirements.alignment = std::max( slotRequirements.alignment, requirements.alignment );
+			slotRequirements.memoryTypeBits &= requirements.memoryTypeBits;
+			m_stats.unaliasedBytes += requirements.size;
+		}
+
+		if( slotRequirements.memoryTypeBits == 0 )
+		{
+			throw std::runtime_error( std::string( "Render graph image '" ) + m_resources[ slot.resources.front() ].name + "' can not share memory with the images before it." );
+		}
+
+		slot.allocation = m_pMemoryAllocator->allocate( slotRequirements, EMemoryUsage::GpuOnly, EResourceKind::OptimalImage );
+		m_stats.transientBytes += slotRequirements.size;
+
+		for( const ResourceId resourceId : slot.resources )
+		{
+			m_device.bindImageMemory( m_resources[ resourceId ].image, slot.allocation.memory, slot.allocation.offset );
+		}
+	}
+
+	for( auto& resource : m_resources )
+	{
+		if( resource.imported || resource.firstGroup == UNUSED_GROUP )
+		{
+			continue;
+		}
+
+		vk::ImageViewCreateInfo viewCreateInfo( {}, resource.image, vk::ImageViewType::e2D, resource.desc.format, vk::ComponentMapping {},
+			vk::ImageSubresourceRange( getAspect( resource.desc.format ), 0, 1, 0, 1 ) );
+		resource.view = m_device.createImageView( viewCreateInfo );
+	}
+
+	for( auto& group : m_groups )
+	{
+		group.extent = getImageExtent( m_resources[ group.attachments.front() ] );
+	}
+
+	m_imagesCreated = true;
+}
+
+void CRenderGraph::destroyImages( CDeletionQueue* pDeletionQueue, uint64_t retireValue )
+{
+	std::vector<vk::Image> images;
+	std::vector<vk::ImageView> views;
+	std::vector<vk::Framebuffer> framebuffers;
+	std::vector<SAllocation> allocations;
+
+	for( auto& resource : m_resources )
+	{
+		if( !resource.imported )
+		{
+			if( resource.view )
+			{
+				views.push_back( resource.view );
+			}
+			if( resource.image )
+			{
+				images.push_back( resource.image );
+			}
+			resource.view = nullptr;
+			resource.image = nullptr;
+		}
+	}
+
+	for( auto& group : m_groups )
+	{
+		for( const auto& entry : group.framebuffers )
+		{
+			framebuffers.push_back( entry.framebuffer );
+		}
+		group.framebuffers.clear();
+	}
+
+	for( auto& slot : m_memorySlots )
+	{
+		if( slot.allocation.isValid() )
+		{
+			allocations.push_back( slot.allocation );
+		}
+		slot.allocation = SAllocation {};
+	}
+
+	m_imagesCreated = false;
+
+	const vk::Device device = m_device;
+	CDeviceMemoryAllocator* pMemoryAllocator = m_pMemoryAllocator;
+	auto deleter = [ device, pMemoryAllocator, images, views, framebuffers, allocations ]() mutable
+	{
+		for( const auto& framebuffer : framebuffers )
+		{
+			device.destroyFramebuffer( framebuffer );
+		}
+		for( const auto& view : views )
+		{
+			device.destroyImageView( view );
+		}
+		for( const auto& image : images )
+		{
+			device.destroyImage( image );
+		}
+		for( auto& allocation : allocations )
+		{
+			pMemoryAllocator->free( allocation );
+		}
+	};
+
+	if( pDeletionQueue )
+	{
+		pDeletionQueue->push( retireValue, std::move( deleter ) );
+	}
+	else
+	{
+		deleter();
+	}
+}
+
+vk::Framebuffer CRenderGraph::getGroupFramebuffer( SGroup& group )
+{
+	std::vector<vk::ImageView> views;
+	views.reserve( group.attachments.size() );
+	for( const ResourceId resourceId : group.attachments )
+	{
+		if( !m_resources[ resourceId ].view )
+		{
+			throw std::runtime_error( std::string( "Render graph image '" ) + m_resources[ resourceId ].name + "' has no image set." );
+		}
+		views.push_back( m_resources[ resourceId ].view );
+	}
+
+	//imported images change every frame, e.g. one framebuffer per swapchain image
+	for( const auto& entry : group.framebuffers )
+	{
+		if( entry.views == views )
+		{
+			return entry.framebuffer;
+		}
+	}
+
+	vk::FramebufferCreateInfo createInfo( {}, group.renderPass, static_cast< uint32_t >( views.size() ), views.data(), group.extent.width, group.extent.height, 1 );
+	group.framebuffers.push_back( SFramebufferEntry { views, m_device.createFramebuffer( createInfo ) } );
+
+	return group.framebuffers.back().framebuffer;
+}
+
+vk::Extent2D CRenderGraph::getImageExtent( const SResource& resource ) const
+{
+	return ( resource.desc.extent.width == 0 || resource.desc.extent.height == 0 ) ? m_extent : resource.desc.extent;
+}
+
+const CRenderGraph::SAccess* CRenderGraph::findNextAccess( PassId pass, ResourceId resource ) const
+{
+	for( PassId passId = pass + 1; passId < m_passes.size(); ++passId )
+	{
+		if( m_passes[ passId ].culled )
+		{
+			continue;
+		}
+
+		for( const SAccess& access : m_passes[ passId ].accesses )
+		{
+			if( access.resource == resource )
+			{
+				return &access;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+vk::ImageLayout CRenderGraph::GetLayout( EAccess type, bool depthFormat )
+{
+	switch( type )
+	{
+		case EAccess::ColorWrite:
+			return vk::ImageLayout::eColorAttachmentOptimal;
+		case EAccess::DepthWrite:
+			return vk::ImageLayout::eDepthStencilAttachmentOptimal;
+		case EAccess::DepthRead:
+			return vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+		case EAccess::InputRead:
+		case EAccess::SampledRead:
+			return depthFormat ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eShaderReadOnlyOptimal;
+	}
+
+	return vk::ImageLayout::eGeneral;
+}
+
+vk::PipelineStageFlags CRenderGraph::GetStages( const SAccess& access )
+{
+	switch( access.type )
+	{
+		case EAccess::ColorWrite:
+			return vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		case EAccess::DepthWrite:
+		case EAccess::DepthRead:
+			return vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+		case EAccess::InputRead:
+			return vk::PipelineStageFlagBits::eFragmentShader;
+		case EAccess::SampledRead:
+			return access.stages;
+	}
+
+	return vk::PipelineStageFlagBits::eAllCommands;
+}
+
+vk::AccessFlags CRenderGraph::GetAccessFlags( EAccess type )
+{
+	switch( type )
+	{
+		case EAccess::ColorWrite:
+			return vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+		case EAccess::DepthWrite:
+			return vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+		case EAccess::DepthRead:
+			return vk::AccessFlagBits::eDepthStencilAttachmentRead;
+		case EAccess::InputRead:
+			return vk::AccessFlagBits::eInputAttachmentRead;
+		case EAccess::SampledRead:
+			return vk::AccessFlagBits::eShaderRead;
+	}
+
+	return {};
+}
+
+bool CRenderGraph::IsWrite( EAccess type )
+{
+	return type == EAccess::ColorWrite || type == EAccess::DepthWrite;
+}
+
+bool CRenderGraph::IsAttachment( EAccess type )
+{
+	return type != EAccess::SampledRead;
+}
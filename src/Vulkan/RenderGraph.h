@@ -0,0 +1,285 @@
+#pragma once
+#include "Memory/DeviceMemoryAllocator.h"
+
+#include <functional>
+#include <vulkan/vulkan.hpp>
+
+class CDeletionQueue;
+
+//Frame graph of raster passes. Passes declare the images they write and read, and compile()
+//turns that into render passes: passes whose output is never used are culled, consecutive
+//passes that only read each other's output at the same pixel become subpasses of one render
+//pass, and layout transitions and barriers become attachment layouts and subpass dependencies.
+//Images created by the graph are transient, the ones whose lifetimes do not overlap share memory.
+//Passes run in the order they were added. Once compiled the graph is executed as is every
+//frame, changing its passes takes a reset().
+class CRenderGraph
+{
+public:
+	using ResourceId = uint32_t;
+	using PassId = uint32_t;
+
+	struct SImageDesc
+	{
+		vk::Format format = vk::Format::eUndefined;
+		//0 follows the extent of the graph
+		vk::Extent2D extent;
+		vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+	};
+
+	//how an image owned by someone else, e.g. a swapchain image, enters and leaves the graph
+	struct SImportDesc
+	{
+		vk::Format format = vk::Format::eUndefined;
+		vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+		//eUndefined discards the contents
+		vk::ImageLayout initialLayout = vk::ImageLayout::eUndefined;
+		//the first use waits for these, e.g. the stage the acquire semaphore is waited at
+		vk::PipelineStageFlags initialStages = vk::PipelineStageFlagBits::eTopOfPipe;
+		vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags finalStages = vk::PipelineStageFlagBits::eBottomOfPipe;
+		vk::AccessFlags finalAccess;
+		//contents are used after the graph, so passes writing them are never culled
+		bool exported = true;
+	};
+
+	struct SPassContext
+	{
+		vk::CommandBuffer commandBuffer;
+		vk::RenderPass renderPass;
+		uint32_t subpass;
+		vk::Framebuffer framebuffer;
+		vk::Rect2D renderArea;
+	};
+
+	using ExecuteFn = std::function<void( const SPassContext& context )>;
+
+	struct SStats
+	{
+		uint32_t passes = 0;
+		uint32_t culledPasses = 0;
+		uint32_t renderPasses = 0;
+		uint32_t subpassDependencies = 0;
+		//pipeline barriers recorded outside of render passes per execute
+		uint32_t imageBarriers = 0;
+		uint32_t transientImages = 0;
+		vk::DeviceSize transientBytes = 0;
+		//what the transient images would take without aliasing
+		vk::DeviceSize unaliasedBytes = 0;
+		double compileMilliseconds = 0.0;
+	};
+
+	//declares what a pass accesses, every image at most once per pass
+	class CPassBuilder
+	{
+	public:
+		//without a clear value the previous contents are kept
+		CPassBuilder& writeColor( ResourceId resource, std::optional<vk::ClearColorValue> clearValue = std::nullopt );
+		CPassBuilder& writeDepth( ResourceId resource, std::optional<vk::ClearDepthStencilValue> clearValue = std::nullopt );
+		CPassBuilder& readDepth( ResourceId resource );
+		//reads the same pixel as an input attachment, passes joined this way can share a render pass
+		CPassBuilder& readAttachment( ResourceId resource );
+		//sampled anywhere in the image, which ends the render pass of the pass that wrote it
+		CPassBuilder& readTexture( ResourceId resource, vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eFragmentShader );
+		//never culled, e.g. for passes that write buffers read back by the CPU
+		CPassBuilder& setSideEffect();
+
+		inline PassId getId() const
+		{
+			return m_pass;
+		}
+
+	private:
+		friend class CRenderGraph;
+		CPassBuilder( CRenderGraph& graph, PassId pass );
+
+		CRenderGraph& m_graph;
+		PassId m_pass;
+	};
+
+public:
+	CRenderGraph();
+
+	void init( const vk::Device& device, CDeviceMemoryAllocator& memoryAllocator );
+	//destroys everything at once, the device has to be idle
+	void destroy();
+
+	ResourceId createImage( const char* name, const SImageDesc& desc );
+	ResourceId importImage( const char* name, const SImportDesc& desc );
+	//name must be a string literal, or otherwise outlive the graph
+	CPassBuilder addPass( const char* name, ExecuteFn execute );
+
+	//builds the render passes, images are only created by the first execute
+	void compile();
+	//drops every pass and resource. Objects frames in flight may still use go through the queue.
+	void reset( CDeletionQueue& deletionQueue, uint64_t retireValue );
+
+	//extent of images created without one, e.g. the swapchain extent
+	void setExtent( const vk::Extent2D& extent );
+	//recreates images and framebuffers at the new extent, the render passes stay
+	void resize( const vk::Extent2D& extent, CDeletionQueue& deletionQueue, uint64_t retireValue );
+
+	//has to be set before every execute that uses the image, e.g. to the acquired swapchain image
+	void setImportedImage( ResourceId resource, const vk::Image& image, const vk::ImageView& view );
+	//eInline by default, can change every frame
+	void setPassContents( PassId pass, vk::SubpassContents contents );
+
+	void execute( const vk::CommandBuffer& commandBuffer );
+
+	vk::RenderPass getRenderPass( PassId pass ) const;
+	uint32_t getSubpass( PassId pass ) const;
+	uint32_t getSubpassCount( PassId pass ) const;
+	//one per attachment of the pass's render pass, what execute begins it with
+	const std::vector<vk::ClearValue>& getClearValues( PassId pass ) const;
+	//framebuffer of the pass's render pass with the imported images set right now
+	vk::Framebuffer getFramebuffer( PassId pass );
+	vk::Rect2D getRenderArea( PassId pass ) const;
+	bool isCulled( PassId pass ) const;
+
+	inline bool isCompiled() const
+	{
+		return m_compiled;
+	}
+
+	inline const SStats& getStats() const
+	{
+		return m_stats;
+	}
+
+	void logStats() const;
+
+private:
+	enum class EAccess
+	{
+		ColorWrite,
+		DepthWrite,
+		DepthRead,
+		InputRead,
+		SampledRead
+	};
+
+	struct SAccess
+	{
+		ResourceId resource;
+		EAccess type;
+		bool clear;
+		vk::ClearValue clearValue;
+		//shader stages of sampled reads
+		vk::PipelineStageFlags stages;
+	};
+
+	struct SResource
+	{
+		const char* name;
+		SImageDesc desc;
+		bool imported;
+		SImportDesc import;
+
+		//filled by compile, lifetime in render pass indices
+		vk::ImageUsageFlags usage;
+		uint32_t firstGroup;
+		uint32_t lastGroup;
+		//used by a single render pass and never stored, tilers can keep it in on-chip memory
+		bool transientAttachment;
+		uint32_t memorySlot;
+
+		vk::Image image;
+		vk::ImageView view;
+	};
+
+	struct SPass
+	{
+		const char* name;
+		ExecuteFn execute;
+		std::vector<SAccess> accesses;
+		bool sideEffect;
+		bool culled;
+		uint32_t group;
+		uint32_t subpass;
+		vk::SubpassContents contents;
+	};
+
+	struct SImageBarrier
+	{
+		ResourceId resource;
+		vk::ImageLayout oldLayout;
+		vk::ImageLayout newLayout;
+		vk::PipelineStageFlags srcStages;
+		vk::AccessFlags srcAccess;
+		vk::PipelineStageFlags dstStages;
+		vk::AccessFlags dstAccess;
+	};
+
+	struct SFramebufferEntry
+	{
+		std::vector<vk::ImageView> views;
+		vk::Framebuffer framebuffer;
+	};
+
+	//one render pass, its subpasses are the passes in order
+	struct SGroup
+	{
+		std::vector<PassId> passes;
+		std::vector<ResourceId> attachments;
+		std::vector<vk::ClearValue> clearValues;
+		std::vector<SImageBarrier> barriers;
+		vk::RenderPass renderPass;
+		vk::Extent2D extent;
+		std::vector<SFramebufferEntry> framebuffers;
+	};
+
+	//transient images sharing memory, their lifetimes never overlap
+	struct SMemorySlot
+	{
+		std::vector<ResourceId> resources;
+		uint32_t lastGroup;
+		SAllocation allocation;
+	};
+
+	//layout and the last accesses of an image while compile walks the render passes
+	struct SResourceState
+	{
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags stages;
+		vk::AccessFlags writeAccess;
+		bool hasContents = false;
+	};
+
+	SAccess& addAccess( PassId pass, ResourceId resource, EAccess type );
+
+	void cullPasses();
+	void groupPasses();
+	bool canMerge( const SGroup& group, const SPass& pass ) const;
+	void assignMemorySlots();
+	void buildRenderPasses();
+	void buildRenderPass( uint32_t groupIndex, std::vector<SResourceState>& states );
+	//stages and writes of the last uses of a resource in one execution
+	SResourceState getFinalState( ResourceId resource ) const;
+
+	void createImages();
+	void destroyImages( CDeletionQueue* pDeletionQueue, uint64_t retireValue );
+	vk::Framebuffer getGroupFramebuffer( SGroup& group );
+
+	vk::Extent2D getImageExtent( const SResource& resource ) const;
+	//first access of the resource by a pass after the given one, if any
+	const SAccess* findNextAccess( PassId pass, ResourceId resource ) const;
+
+	static vk::ImageLayout GetLayout( EAccess type, bool depthFormat );
+	static vk::PipelineStageFlags GetStages( const SAccess& access );
+	static vk::AccessFlags GetAccessFlags( EAccess type );
+	static bool IsWrite( EAccess type );
+	static bool IsAttachment( EAccess type );
+
+	vk::Device m_device;
+	CDeviceMemoryAllocator* m_pMemoryAllocator;
+
+	std::vector<SResource> m_resources;
+	std::vector<SPass> m_passes;
+	std::vector<SGroup> m_groups;
+	std::vector<SMemorySlot> m_memorySlots;
+	vk::Extent2D m_extent;
+
+	bool m_compiled;
+	bool m_imagesCreated;
+	SStats m_stats;
+};
@@ -0,0 +1,157 @@
+#include "vkpch.h"
+#include "ShaderRegistry.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+//generated by the glslc build step in premake5.lua as comma separated words (-mfmt=num)
+alignas( 16 ) constexpr uint32_t SHADER_VERT_SPV[] =
+{
+#include "shader.vert.inl"
+};
+
+alignas( 16 ) constexpr uint32_t SHADER_FRAG_SPV[] =
+{
+#include "shader.frag.inl"
+};
+
+alignas( 16 ) constexpr uint32_t SCENE_VERT_SPV[] =
+{
+#include "scene.vert.inl"
+};
+
+alignas( 16 ) constexpr uint32_t SCENE_FRAG_SPV[] =
+{
+#include "scene.frag.inl"
+};
+
+alignas( 16 ) constexpr uint32_t INSTANCED_VERT_SPV[] =
+{
+#include "instanced.vert.inl"
+};
+
+alignas( 16 ) constexpr uint32_t CULL_COMP_SPV[] =
+{
+#include "cull.comp.inl"
+};
+
+
+struct SEmbeddedShader
+{
+	const char* name;
+	const uint32_t* pCode;
+	size_t wordCount;
+};
+
+//new shaders in shaders/ are compiled automatically but have to be listed here
+constexpr SEmbeddedShader EMBEDDED_SHADERS[] =
+{
+	{ "shader.vert", SHADER_VERT_SPV, std::size( SHADER_VERT_SPV ) },
+	{ "shader.frag", SHADER_FRAG_SPV, std::size( SHADER_FRAG_SPV ) },
+	{ "scene.vert", SCENE_VERT_SPV, std::size( SCENE_VERT_SPV ) },
+	{ "scene.frag", SCENE_FRAG_SPV, std::size( SCENE_FRAG_SPV ) },
+	{ "instanced.vert", INSTANCED_VERT_SPV, std::size( INSTANCED_VERT_SPV ) },
+	{ "cull.comp", CULL_COMP_SPV, std::size( CULL_COMP_SPV ) },
+};
+
+const uint32_t SPIRV_MAGIC = 0x07230203;
+
+
+static const SEmbeddedShader* findEmbeddedShader( const std::string& name )
+{
+	for( const SEmbeddedShader& shader : EMBEDDED_SHADERS )
+	{
+		if( name == shader.name )
+		{
+			return &shader;
+		}
+	}
+	return nullptr;
+}
+
+/////////////////////////////////////////////////
+
+std::string CShaderRegistry::overrideDirectory_;
+std::unordered_map<std::string, std::vector<uint32_t>> CShaderRegistry::overrides_;
+std::vector<std::vector<uint32_t>> CShaderRegistry::retiredOverrides_;
+std::mutex CShaderRegistry::mutex_;
+
+void CShaderRegistry::SetOverrideDirectory( const std::string& directory )
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	overrideDirectory_ = directory;
+
+	//moving keeps the words where the views point
+	for( auto& [ name, code ] : overrides_ )
+	{
+		retiredOverrides_.push_back( std::move( code ) );
+	}
+	overrides_.clear();
+}
+
+SShaderCode CShaderRegistry::Get( const std::string& name )
+{
+	if( const std::vector<uint32_t>* pOverride = LoadOverride( name ) )
+	{
+		return SShaderCode { pOverride->data(), pOverride->size() };
+	}
+
+	const SEmbeddedShader* pShader = findEmbeddedShader( name );
+	if( !pShader )
+	{
+		throw std::runtime_error( "Unknown shader '" + name + "'." );
+	}
+
+	return SShaderCode { pShader->pCode, pShader->wordCount };
+}
+
+bool CShaderRegistry::IsEmbedded( const std::string& name )
+{
+	return findEmbeddedShader( name ) != nullptr;
+}
+
+/////////////////////////////////////////////////
+
+const std::vector<uint32_t>* CShaderRegistry::LoadOverride( const std::string& name )
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	if( overrideDirectory_.empty() )
+	{
+		return nullptr;
+	}
+
+	auto it = overrides_.find( name );
+	if( it != overrides_.end() )
+	{
+		return &it->second;
+	}
+
+	const std::filesystem::path path = std::filesystem::path( overrideDirectory_ ) / ( name + ".spv" );
+	std::ifstream file( path, std::ios::ate | std::ios::binary );
+	if( !file.is_open() )
+	{
+		return nullptr;
+	}
+
+	const size_t fileSize = static_cast< size_t >( file.tellg() );
+	if( fileSize == 0 || fileSize % sizeof( uint32_t ) != 0 )
+	{
+		VS_WARN( "Shader override '{0}' is not valid SPIR-V, using the embedded one.", path.string() );
+		return nullptr;
+	}
+
+	//read straight into words so the code is aligned for vkCreateShaderModule
+	std::vector<uint32_t> code( fileSize / sizeof( uint32_t ) );
+	file.seekg( 0 );
+	file.read( reinterpret_cast< char* >( code.data() ), fileSize );
+
+	if( !file.good() || code.front() != SPIRV_MAGIC )
+	{
+		VS_WARN( "Shader override '{0}' is not valid SPIR-V, using the embedded one.", path.string() );
+		return nullptr;
+	}
+
+	VS_INFO( "Using shader override '{0}'.", path.string() );
+	return &overrides_.emplace( name, std::move( code ) ).first->second;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+//Non owning view of SPIR-V words. Embedded shaders live for the whole program,
+//loose overrides for as long as the registry keeps them.
+struct SShaderCode
+{
+	const uint32_t* pCode = nullptr;
+	size_t wordCount = 0;
+
+	inline size_t getSizeInBytes() const
+	{
+		return wordCount * sizeof( uint32_t );
+	}
+
+	inline vk::ShaderModuleCreateInfo getModuleCreateInfo() const
+	{
+		return vk::ShaderModuleCreateInfo( {}, getSizeInBytes(), pCode );
+	}
+};
+
+//Looks up shaders by source file name ("shader.vert"). The SPIR-V is compiled by the
+//build and embedded in the executable, so the common path does no file I/O and no copies.
+//When an override directory is set, "<dir>/<name>.spv" takes precedence if it exists,
+//which allows iterating on shaders without rebuilding.
+class CShaderRegistry
+{
+public:
+	//views returned before stay valid, only later lookups see the new directory
+	static void SetOverrideDirectory( const std::string& directory );
+
+	//throws if the shader is neither embedded nor found in the override directory
+	static SShaderCode Get( const std::string& name );
+	static bool IsEmbedded( const std::string& name );
+
+private:
+	static const std::vector<uint32_t>* LoadOverride( const std::string& name );
+
+	static std::string overrideDirectory_;
+	//loaded once and kept, handed out views must stay valid
+	static std::unordered_map<std::string, std::vector<uint32_t>> overrides_;
+	//dropped by SetOverrideDirectory, still kept for the views handed out before
+	static std::vector<std::vector<uint32_t>> retiredOverrides_;
+	static std::mutex mutex_;
+};
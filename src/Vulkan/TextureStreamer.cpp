@@ -0,0 +1,817 @@
+#include "vkpch.h"
+#include "TextureStreamer.h"
+
+#include "Assets/TextureFile.h"
+#include "Profiling/CpuProfiler.h"
+#include "Utils/Log.h"
+#include "Utils/Timer.h"
+#include "Vulkan/BindlessTable.h"
+#include "Vulkan/UploadService.h"
+
+/////////////////////////////////////////////////
+
+//texel sized, and the optimalBufferCopyOffsetAlignment of every device in practice
+const vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+//only fragment shaders sample the textures
+const vk::PipelineStageFlags TEXTURE_DST_STAGE = vk::PipelineStageFlagBits::eFragmentShader;
+
+
+static uint32_t hashTexel( uint32_t x )
+{
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+//an 8 by 8 checker tinted by the seed with some noise on top, so every level can be told apart
+//and a missing level shows as a blurry checker
+static void generatePattern( uint32_t seed, uint32_t level, uint32_t width, uint32_t height, uint8_t* pDst )
+{
+	const uint32_t tint = hashTexel( seed + 1 );
+	const uint32_t cellSize = std::max( width / 8, 1u );
+
+	for( uint32_t y = 0; y < height; ++y )
+	{
+		for( uint32_t x = 0; x < width; ++x )
+		{
+			const bool light = ( ( x / cellSize ) + ( y / cellSize ) ) % 2 == 0;
+			const uint32_t noise = hashTexel( ( ( y << 16 ) ^ x ) + level * 0x9e3779b9 + seed ) & 31;
+			for( uint32_t channel = 0; channel < 3; ++channel )
+			{
+				const uint32_t base = light ? 160 + ( ( tint >> ( channel * 8 ) ) & 63 ) : 40 + ( ( tint >> ( channel * 8 + 2 ) ) & 31 );
+				pDst[ channel ] = static_cast< uint8_t >( std::min( base + noise, 255u ) );
+			}
+			pDst[ 3 ] = 255;
+			pDst += 4;
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+
+CTextureStreamer::CTextureStreamer()
+	: m_device( nullptr )
+	, m_pAllocator( nullptr )
+	, m_pUploadService( nullptr )
+	, m_pBindlessTable( nullptr )
+	, m_pResidencyManager( nullptr )
+	, m_pJobSystem( nullptr )
+	, m_stagingBuffer( nullptr )
+	, m_decodeJobsInFlight( 0 )
+	, m_decodingStopped( false )
+	, m_sampler( nullptr )
+	, m_samplerHandle( UINT32_MAX )
+	, m_tableBuffer( nullptr )
+	, m_tableStride( 0 )
+	, m_completedUploadValue( 0 )
+	, m_bytesUploadedThisFrame( 0 )
+	, m_levelsDecoded( 0 )
+	, m_bytesDecoded( 0 )
+	, m_decodeMicroseconds( 0 )
+{
+}
+
+CTextureStreamer::~CTextureStreamer() = default;
+
+void CTextureStreamer::init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, CDeviceMemoryAllocator& allocator, CUploadService& uploadService,
+	CBindlessTable& bindlessTable, CResidencyManager& residencyManager, CJobSystem& jobSystem, uint32_t framesInFlight, const SSettings& settings )
+{
+	m_device = device;
+	m_pAllocator = &allocator;
+	m_pUploadService = &uploadService;
+	m_pBindlessTable = &bindlessTable;
+	m_pResidencyManager = &residencyManager;
+	m_pJobSystem = &jobSystem;
+	m_settings = settings;
+	m_settings.tailSize = std::max( m_settings.tailSize, 1u );
+	m_settings.maxDecodeJobs = std::max( m_settings.maxDecodeJobs, 1u );
+	m_decodingStopped = false;
+	m_stats = SStats();
+
+	vk::BufferCreateInfo stagingCreateInfo( {}, m_settings.stagingPoolSize, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive );
+	m_stagingBuffer = m_device.createBuffer( stagingCreateInfo );
+	m_stagingAllocation = m_pAllocator->allocateForBuffer( m_stagingBuffer, EMemoryUsage::CpuToGpu );
+	m_pStagingPool = std::make_unique<CFreeListAllocator>( m_settings.stagingPoolSize, 1 );
+
+	vk::SamplerCreateInfo samplerCreateInfo( {}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eRepeat,
+		vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat, 0.0f, VK_FALSE, 1.0f, VK_FALSE, vk::CompareOp::eNever, 0.0f, VK_LOD_CLAMP_NONE );
+	m_sampler = m_device.createSampler( samplerCreateInfo );
+	m_samplerHandle = m_pBindlessTable->registerSampler( m_sampler );
+
+	createPlaceholder();
+	createTableBuffers( physicalDevice, framesInFlight );
+
+	VS_INFO( "Texture streaming: {0} MiB of staging, {1} MiB uploaded per frame, tails up to {2} texels.", m_settings.stagingPoolSize / ( 1024 * 1024 ),
+		m_settings.uploadBytesPerFrame / ( 1024.0 * 1024.0 ), m_settings.tailSize );
+}
+
+void CTextureStreamer::stopDecoding()
+{
+	m_decodingStopped = true;
+	if( m_pJobSystem && m_pJobSystem->isInitialized() )
+	{
+		m_pJobSystem->wait( m_decodeJobs );
+	}
+}
+
+void CTextureStreamer::destroy()
+{
+	if( !m_device )
+	{
+		return;
+	}
+
+	stopDecoding();
+	m_deletionQueue.flushAll();
+
+	//the table is torn down after the streamer, its slots need not be returned
+	for( std::unique_ptr<STexture>& pTexture : m_textures )
+	{
+		if( pTexture->pLoad )
+		{
+			destroyImage( pTexture->pLoad->target );
+		}
+		destroyImage( pTexture->tail );
+		destroyImage( pTexture->streamed );
+	}
+	m_textures.clear();
+	m_orphanedLevels.clear();
+	destroyImage( m_placeholder );
+
+	m_device.destroySampler( m_sampler );
+	m_sampler = nullptr;
+
+	m_device.destroyBuffer( m_tableBuffer );
+	m_pAllocator->free( m_tableAllocation );
+	m_tableBuffer = nullptr;
+	m_tableHandles.clear();
+
+	m_device.destroyBuffer( m_stagingBuffer );
+	m_pAllocator->free( m_stagingAllocation );
+	m_stagingBuffer = nullptr;
+	m_pStagingPool.reset();
+
+	m_device = nullptr;
+}
+
+CTextureStreamer::TextureId CTextureStreamer::addTexture( const STextureDesc& desc )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( m_textures.size() >= m_settings.maxTextures )
+	{
+		VS_WARN( "The texture table holds {0} textures, '{1}' is not streamed.", m_settings.maxTextures, desc.filePath );
+		return INVALID_TEXTURE;
+	}
+
+	m_textures.push_back( std::make_unique<STexture>() );
+	m_textures.back()->desc = desc;
+	return static_cast< TextureId >( m_textures.size() - 1 );
+}
+
+void CTextureStreamer::requestWidth( TextureId id, uint32_t width )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( id < m_textures.size() )
+	{
+		m_textures[ id ]->requestedWidth = width;
+	}
+}
+
+void CTextureStreamer::update( uint32_t frameIndex, uint64_t frameNumber, uint64_t completedFrame )
+{
+	VS_PROFILE_SCOPE( "texture streaming" );
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	m_deletionQueue.flush( completedFrame );
+	m_stats.bytesUploadedLastFrame = m_bytesUploadedThisFrame;
+	m_bytesUploadedThisFrame = 0;
+	m_completedUploadValue = m_pUploadService->getCompletedValue();
+
+	m_orphanedLevels.erase( std::remove_if( m_orphanedLevels.begin(), m_orphanedLevels.end(),
+		[ this ]( const std::shared_ptr<SLevelLoad>& pLevel ) { return releaseStaging( *pLevel ); } ), m_orphanedLevels.end() );
+
+	for( TextureId id = 0; id < m_textures.size(); ++id )
+	{
+		STexture& texture = *m_textures[ id ];
+		if( !texture.openQueued )
+		{
+			queueOpen( id );
+		}
+		else if( texture.mipCount == 0 && texture.state.load( std::memory_order_acquire ) == ETextureState::Ready )
+		{
+			finishOpen( texture );
+		}
+	}
+
+	handleEvictions( frameNumber );
+	finishLoads( frameNumber );
+
+	const EMemoryPressure pressure = m_pResidencyManager->getDeviceLocalPressure();
+	if( pressure >= EMemoryPressure::High )
+	{
+		//finer levels would only be evicted again, whatever still needs decoding or copying is dropped
+		for( std::unique_ptr<STexture>& pTexture : m_textures )
+		{
+			if( pTexture->pLoad && !pTexture->pLoad->isTail && std::any_of( pTexture->pLoad->levels.begin(), pTexture->pLoad->levels.end(),
+				[]( const std::shared_ptr<SLevelLoad>& pLevel ) { return pLevel->state.load() != ELevelState::Recorded; } ) )
+			{
+				cancelLoad( *pTexture, frameNumber );
+			}
+		}
+	}
+
+	startLoads( pressure, frameNumber );
+	recordCopies();
+	queueDecodes();
+	writeTable( frameIndex );
+}
+
+uint32_t CTextureStreamer::getTextureTable( uint32_t frameIndex ) const
+{
+	return m_tableHandles[ frameIndex ];
+}
+
+CTextureStreamer::SStats CTextureStreamer::getStats() const
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	SStats stats = m_stats;
+	stats.textures = static_cast< uint32_t >( m_textures.size() );
+	for( const std::unique_ptr<STexture>& pTexture : m_textures )
+	{
+		stats.tailsResident += pTexture->tail.isValid() ? 1 : 0;
+		stats.streamedResident += pTexture->streamed.isValid() ? 1 : 0;
+		stats.loadsInFlight += pTexture->pLoad ? 1 : 0;
+		stats.failedTextures += pTexture->state.load() == ETextureState::Failed ? 1 : 0;
+		stats.residentBytes += pTexture->tail.allocation.size + pTexture->streamed.allocation.size;
+	}
+
+	stats.decodeJobsInFlight = m_decodeJobsInFlight.load();
+	stats.stagingBytesInUse = m_pStagingPool ? m_pStagingPool->getStats().usedBytes : 0;
+	stats.levelsDecoded = m_levelsDecoded.load();
+	stats.bytesDecoded = m_bytesDecoded.load();
+	stats.decodeMilliseconds = m_decodeMicroseconds.load() / 1000.0;
+	return stats;
+}
+
+void CTextureStreamer::logStats() const
+{
+	if( !isInitialized() )
+	{
+		return;
+	}
+
+	const SStats stats = getStats();
+	VS_INFO( "Texture streaming: {0} textures, {1} tails and {2} finer images resident ({3:.2f} MiB), {4} failed", stats.textures, stats.tailsResident,
+		stats.streamedResident, stats.residentBytes / ( 1024.0 * 1024.0 ), stats.failedTextures );
+	VS_INFO( "  decoded {0} levels ({1:.2f} MiB) in {2:.1f} ms of job time, uploaded {3:.2f} MiB", stats.levelsDecoded, stats.bytesDecoded / ( 1024.0 * 1024.0 ),
+		stats.decodeMilliseconds, stats.bytesUploaded / ( 1024.0 * 1024.0 ) );
+	VS_INFO( "  loads completed {0}, cancelled {1}, refused {2}, evictions {3}", stats.loadsCompleted, stats.loadsCancelled, stats.refusedLoads, stats.evictions );
+}
+
+/////////////////////////////////////////////////
+
+void CTextureStreamer::createPlaceholder()
+{
+	STexture texture;
+	texture.width = 1;
+	texture.height = 1;
+	texture.mipCount = 1;
+	texture.format = vk::Format::eR8G8B8A8Unorm;
+	createImage( texture, 0, false, m_placeholder );
+
+	const uint32_t white = 0xFFFFFFFF;
+	m_pUploadService->uploadImage( m_placeholder.image, vk::ImageSubresourceLayers( vk::ImageAspectFlagBits::eColor, 0, 0, 1 ), vk::Extent3D( 1, 1, 1 ),
+		&white, sizeof( white ), vk::ImageLayout::eShaderReadOnlyOptimal, TEXTURE_DST_STAGE, vk::AccessFlagBits::eShaderRead );
+}
+
+void CTextureStreamer::createTableBuffers( const vk::PhysicalDevice& physicalDevice, uint32_t framesInFlight )
+{
+	const vk::DeviceSize alignment = physicalDevice.getProperties().limits.minStorageBufferOffsetAlignment;
+	m_tableStride = ( m_settings.maxTextures * sizeof( uint32_t ) + alignment - 1 ) / alignment * alignment;
+
+	vk::BufferCreateInfo createInfo( {}, m_tableStride * framesInFlight, vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive );
+	m_tableBuffer = m_device.createBuffer( createInfo );
+	m_tableAllocation = m_pAllocator->allocateForBuffer( m_tableBuffer, EMemoryUsage::CpuToGpu );
+
+	//textures not added yet read the placeholder too
+	uint32_t* pSlots = reinterpret_cast< uint32_t* >( m_tableAllocation.pMapped );
+	std::fill( pSlots, pSlots + m_tableStride / sizeof( uint32_t ) * framesInFlight, m_placeholder.handle );
+	m_pAllocator->flush( m_tableAllocation );
+
+	m_tableHandles.clear();
+	for( uint32_t i = 0; i < framesInFlight; ++i )
+	{
+		m_tableHandles.push_back( m_pBindlessTable->registerBuffer( m_tableBuffer, i * m_tableStride, m_tableStride ) );
+	}
+}
+
+void CTextureStreamer::queueOpen( TextureId id )
+{
+	STexture& texture = *m_textures[ id ];
+	texture.openQueued = true;
+
+	if( texture.desc.filePath.empty() )
+	{
+		texture.state = ETextureState::Ready;
+		return;
+	}
+
+	if( m_decodingStopped )
+	{
+		return;
+	}
+
+	//only the header and the mip table are read, but that may still wait on the disk
+	texture.pFile = std::make_shared<CTextureFile>();
+	m_pJobSystem->run( [ pFile = texture.pFile, pTexture = &texture ]()
+	{
+		try
+		{
+			pFile->open( pTexture->desc.filePath );
+			pTexture->state.store( ETextureState::Ready, std::memory_order_release );
+		}
+		catch( const std::exception& e )
+		{
+			VS_ERROR( "Failed to open texture: {0}", e.what() );
+			pTexture->state.store( ETextureState::Failed, std::memory_order_release );
+		}
+	}, &m_decodeJobs );
+}
+
+void CTextureStreamer::finishOpen( STexture& texture )
+{
+	if( texture.pFile )
+	{
+		const STextureFileHeader& header = texture.pFile->getHeader();
+		texture.width = header.width;
+		texture.height = header.height;
+		texture.mipCount = header.mipCount;
+		texture.format = texture.pFile->isSrgb() ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+	}
+	else
+	{
+		texture.width = m_settings.proceduralSize;
+		texture.height = m_settings.proceduralSize;
+		texture.mipCount = 1;
+		while( ( m_settings.proceduralSize >> texture.mipCount ) > 0 )
+		{
+			++texture.mipCount;
+		}
+		texture.format = vk::Format::eR8G8B8A8Srgb;
+	}
+
+	texture.tailLevel = 0;
+	while( texture.tailLevel + 1 < texture.mipCount &&
+		std::max( texture.width >> texture.tailLevel, texture.height >> texture.tailLevel ) > m_settings.tailSize )
+	{
+		++texture.tailLevel;
+	}
+
+	texture.finestLevel = 0;
+	while( texture.finestLevel + 1 < texture.mipCount &&
+		static_cast< vk::DeviceSize >( std::max( texture.width >> texture.finestLevel, 1u ) ) * std::max( texture.height >> texture.finestLevel, 1u ) * 4 >
+		m_settings.stagingPoolSize / 2 )
+	{
+		++texture.finestLevel;
+	}
+	texture.tailLevel = std::max( texture.tailLevel, texture.finestLevel );
+
+	//tails are small and always wanted, they are not subject to the budget
+	SImage tail;
+	createImage( texture, texture.tailLevel, false, tail );
+	texture.pLoad = createLoad( texture, tail, true );
+}
+
+void CTextureStreamer::finishLoads( uint64_t frameNumber )
+{
+	for( TextureId id = 0; id < m_textures.size(); ++id )
+	{
+		STexture& texture = *m_textures[ id ];
+		if( !texture.pLoad )
+		{
+			continue;
+		}
+
+		const std::vector<std::shared_ptr<SLevelLoad>>& levels = texture.pLoad->levels;
+		if( std::any_of( levels.begin(), levels.end(), []( const std::shared_ptr<SLevelLoad>& pLevel ) { return pLevel->state.load() == ELevelState::Failed; } ) )
+		{
+			//the tail stays if it is resident, but nothing more is loaded
+			VS_ERROR( "Failed to decode a level of texture {0}, it is no longer streamed.", id );
+			texture.state = ETextureState::Failed;
+			cancelLoad( texture, frameNumber );
+			continue;
+		}
+
+		const bool complete = std::all_of( levels.begin(), levels.end(), [ this ]( const std::shared_ptr<SLevelLoad>& pLevel )
+		{
+			return pLevel->state.load() == ELevelState::Recorded && pLevel->uploadValue <= m_completedUploadValue;
+		} );
+		if( !complete )
+		{
+			continue;
+		}
+
+		for( const std::shared_ptr<SLevelLoad>& pLevel : levels )
+		{
+			releaseStaging( *pLevel );
+		}
+
+		SImage& target = texture.pLoad->target;
+		if( texture.pLoad->isTail )
+		{
+			texture.tail = target;
+		}
+		else
+		{
+			retireImage( texture.streamed, frameNumber );
+			target.residencyId = m_pResidencyManager->registerResource( target.allocation.memoryTypeIndex, target.allocation.size,
+				[ this, id ]( CResidencyManager::ResourceId resource ) { onEvicted( id, resource ); } );
+			texture.streamed = target;
+		}
+
+		texture.pLoad.reset();
+		++m_stats.loadsCompleted;
+	}
+}
+
+void CTextureStreamer::handleEvictions( uint64_t frameNumber )
+{
+	for( std::unique_ptr<STexture>& pTexture : m_textures )
+	{
+		STexture& texture = *pTexture;
+		if( texture.evictedResource == CResidencyManager::INVALID_RESOURCE )
+		{
+			continue;
+		}
+
+		//an image retired since the callback was queued is already on its way out
+		if( texture.streamed.isValid() && texture.streamed.residencyId == texture.evictedResource )
+		{
+			texture.streamed.residencyId = CResidencyManager::INVALID_RESOURCE;
+			retireImage( texture.streamed, frameNumber );
+			++m_stats.evictions;
+		}
+		texture.evictedResource = CResidencyManager::INVALID_RESOURCE;
+	}
+}
+
+void CTextureStreamer::startLoads( EMemoryPressure pressure, uint64_t frameNumber )
+{
+	if( pressure >= EMemoryPressure::High )
+	{
+		return;
+	}
+
+	//textures by how many levels they lack, the blurriest first
+	std::vector<std::pair<uint32_t, TextureId>> candidates;
+	uint32_t activeLoads = 0;
+	for( TextureId id = 0; id < m_textures.size(); ++id )
+	{
+		STexture& texture = *m_textures[ id ];
+		if( !texture.tail.isValid() || texture.state.load() != ETextureState::Ready )
+		{
+			continue;
+		}
+
+		const uint32_t wantedLevel = getWantedLevel( texture, pressure );
+		if( texture.pLoad )
+		{
+			//a finer request replaces a load in flight rather than waiting for it
+			if( wantedLevel >= texture.pLoad->target.baseLevel )
+			{
+				++activeLoads;
+				continue;
+			}
+			cancelLoad( texture, frameNumber );
+		}
+
+		const uint32_t residentLevel = texture.streamed.isValid() ? texture.streamed.baseLevel : texture.tailLevel;
+		if( wantedLevel < residentLevel )
+		{
+			candidates.emplace_back( residentLevel - wantedLevel, id );
+		}
+	}
+
+	std::stable_sort( candidates.begin(), candidates.end(), []( const auto& a, const auto& b ) { return a.first > b.first; } );
+
+	for( const auto& candidate : candidates )
+	{
+		if( activeLoads >= m_settings.maxStreamingLoads )
+		{
+			break;
+		}
+
+		STexture& texture = *m_textures[ candidate.second ];
+		SImage target;
+		if( !createImage( texture, getWantedLevel( texture, pressure ), true, target ) )
+		{
+			//the budget is the same for every other candidate
+			++m_stats.refusedLoads;
+			break;
+		}
+
+		texture.pLoad = createLoad( texture, target, false );
+		++activeLoads;
+	}
+}
+
+void CTextureStreamer::queueDecodes()
+{
+	if( m_decodingStopped )
+	{
+		return;
+	}
+
+	uint32_t jobsInFlight = m_decodeJobsInFlight.load();
+
+	//tails first, nothing is drawn with a texture before its tail
+	for( const bool tails : { true, false } )
+	{
+		for( std::unique_ptr<STexture>& pTexture : m_textures )
+		{
+			if( !pTexture->pLoad || pTexture->pLoad->isTail != tails )
+			{
+				continue;
+			}
+
+			for( const std::shared_ptr<SLevelLoad>& pLevel : pTexture->pLoad->levels )
+			{
+				if( pLevel->state.load() != ELevelState::Waiting )
+				{
+					continue;
+				}
+				if( jobsInFlight >= m_settings.maxDecodeJobs )
+				{
+					return;
+				}
+
+				//a full pool frees up as copies complete, the level waits until then
+				const std::optional<uint64_t> offset = m_pStagingPool->allocate( pLevel->size, STAGING_ALIGNMENT, EResourceKind::Buffer );
+				if( !offset )
+				{
+					return;
+				}
+
+				pLevel->stagingOffset = *offset;
+				pLevel->hasStaging = true;
+				pLevel->state = ELevelState::Decoding;
+				if( pTexture->pFile )
+				{
+					pTexture->pFile->prefetchMip( pLevel->level );
+				}
+
+				++jobsInFlight;
+				++m_decodeJobsInFlight;
+				m_pJobSystem->run( [ this, pTexture = pTexture.get(), pLevel ]()
+				{
+					decodeLevel( *pTexture, *pLevel );
+					--m_decodeJobsInFlight;
+				}, &m_decodeJobs );
+			}
+		}
+	}
+}
+
+void CTextureStreamer::recordCopies()
+{
+	bool recorded = false;
+
+	for( const bool tails : { true, false } )
+	{
+		for( std::unique_ptr<STexture>& pTexture : m_textures )
+		{
+			if( !pTexture->pLoad || pTexture->pLoad->isTail != tails )
+			{
+				continue;
+			}
+
+			const SImage& target = pTexture->pLoad->target;
+			for( const std::shared_ptr<SLevelLoad>& pLevel : pTexture->pLoad->levels )
+			{
+				if( pLevel->state.load( std::memory_order_acquire ) != ELevelState::Decoded )
+				{
+					continue;
+				}
+
+				//at least one copy per frame, so a level larger than the budget still goes through
+				if( recorded && m_bytesUploadedThisFrame + pLevel->size > m_settings.uploadBytesPerFrame )
+				{
+					return;
+				}
+
+				const vk::Extent3D extent( std::max( pTexture->width >> pLevel->level, 1u ), std::max( pTexture->height >> pLevel->level, 1u ), 1 );
+				const vk::ImageSubresourceLayers subresource( vk::ImageAspectFlagBits::eColor, pLevel->level - target.baseLevel, 0, 1 );
+				pLevel->uploadValue = m_pUploadService->copyToImage( m_stagingBuffer, pLevel->stagingOffset, target.image, subresource, extent, pLevel->size,
+					vk::ImageLayout::eShaderReadOnlyOptimal, TEXTURE_DST_STAGE, vk::AccessFlagBits::eShaderRead );
+				pLevel->state = ELevelState::Recorded;
+
+				recorded = true;
+				m_bytesUploadedThisFrame += pLevel->size;
+				m_stats.bytesUploaded += pLevel->size;
+			}
+		}
+	}
+}
+
+void CTextureStreamer::writeTable( uint32_t frameIndex )
+{
+	const vk::DeviceSize offset = frameIndex * m_tableStride;
+	uint32_t* pSlots = reinterpret_cast< uint32_t* >( m_tableAllocation.pMapped + offset );
+
+	for( size_t id = 0; id < m_textures.size(); ++id )
+	{
+		const STexture& texture = *m_textures[ id ];
+
+		//finer levels nobody asks for are left out, so they age and are the first to be evicted
+		const bool streamedWanted = texture.streamed.isValid() && getWantedLevel( texture, EMemoryPressure::None ) < texture.tailLevel;
+		if( streamedWanted )
+		{
+			m_pResidencyManager->markUsed( texture.streamed.residencyId );
+			pSlots[ id ] = texture.streamed.handle;
+		}
+		else
+		{
+			pSlots[ id ] = texture.tail.isValid() ? texture.tail.handle : m_placeholder.handle;
+		}
+	}
+
+	m_pAllocator->flush( m_tableAllocation, offset, m_textures.size() * sizeof( uint32_t ) );
+}
+
+void CTextureStreamer::onEvicted( TextureId id, CResidencyManager::ResourceId resource )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_textures[ id ]->evictedResource = resource;
+}
+
+bool CTextureStreamer::createImage( const STexture& texture, uint32_t baseLevel, bool checkBudget, SImage& image )
+{
+	const uint32_t width = std::max( texture.width >> baseLevel, 1u );
+	const uint32_t height = std::max( texture.height >> baseLevel, 1u );
+	const uint32_t levelCount = texture.mipCount - baseLevel;
+
+	vk::ImageCreateInfo createInfo( {}, vk::ImageType::e2D, texture.format, vk::Extent3D( width, height, 1 ), levelCount, 1, vk::SampleCountFlagBits::e1,
+		vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive );
+	image.image = m_device.createImage( createInfo );
+
+	if( checkBudget )
+	{
+		const vk::MemoryRequirements requirements = m_device.getImageMemoryRequirements( image.image );
+		const std::optional<uint32_t> memoryTypeIndex = m_pAllocator->findMemoryTypeIndex( requirements.memoryTypeBits, EMemoryUsage::GpuOnly );
+		if( !memoryTypeIndex || !m_pResidencyManager->canAllocate( *memoryTypeIndex, requirements.size ) )
+		{
+			m_device.destroyImage( image.image );
+			image = SImage();
+			return false;
+		}
+	}
+
+	image.allocation = m_pAllocator->allocateForImage( image.image, EMemoryUsage::GpuOnly );
+
+	vk::ImageViewCreateInfo viewCreateInfo( {}, image.image, vk::ImageViewType::e2D, texture.format, {},
+		vk::ImageSubresourceRange( vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1 ) );
+	image.view = m_device.createImageView( viewCreateInfo );
+	image.handle = m_pBindlessTable->registerImage( image.view );
+	image.baseLevel = baseLevel;
+	return true;
+}
+
+void CTextureStreamer::destroyImage( SImage& image )
+{
+	if( !image.isValid() )
+	{
+		return;
+	}
+
+	m_device.destroyImageView( image.view );
+	m_device.destroyImage( image.image );
+	m_pAllocator->free( image.allocation );
+	image = SImage();
+}
+
+void CTextureStreamer::retireImage( SImage& image, uint64_t frameNumber )
+{
+	if( !image.isValid() )
+	{
+		return;
+	}
+
+	if( image.residencyId != CResidencyManager::INVALID_RESOURCE )
+	{
+		m_pResidencyManager->unregisterResource( image.residencyId );
+	}
+
+	m_pBindlessTable->release( EBindlessType::SampledImage, image.handle, m_deletionQueue, frameNumber );
+	m_deletionQueue.push( frameNumber, [ this, image ]() mutable { destroyImage( image ); } );
+	image = SImage();
+}
+
+std::unique_ptr<CTextureStreamer::SLoad> CTextureStreamer::createLoad( const STexture& texture, SImage target, bool isTail )
+{
+	auto pLoad = std::make_unique<SLoad>();
+	pLoad->target = target;
+	pLoad->isTail = isTail;
+
+	//coarsest first, those are decoded and copied first. A streamed image holds the tail levels too,
+	//they are decoded again rather than copied between images.
+	for( uint32_t level = texture.mipCount; level-- > target.baseLevel; )
+	{
+		auto pLevel = std::make_shared<SLevelLoad>();
+		pLevel->level = level;
+		pLevel->size = static_cast< vk::DeviceSize >( std::max( texture.width >> level, 1u ) ) * std::max( texture.height >> level, 1u ) * 4;
+		pLoad->levels.push_back( pLevel );
+	}
+	return pLoad;
+}
+
+void CTextureStreamer::cancelLoad( STexture& texture, uint64_t frameNumber )
+{
+	//a job may still write a level's staging, or a copy read it, so those wait in m_orphanedLevels
+	for( std::shared_ptr<SLevelLoad>& pLevel : texture.pLoad->levels )
+	{
+		if( !releaseStaging( *pLevel ) )
+		{
+			m_orphanedLevels.push_back( pLevel );
+		}
+	}
+
+	retireImage( texture.pLoad->target, frameNumber );
+	texture.pLoad.reset();
+	++m_stats.loadsCancelled;
+}
+
+void CTextureStreamer::decodeLevel( const STexture& texture, SLevelLoad& levelLoad )
+{
+	VS_PROFILE_SCOPE( "decode texture level" );
+
+	if( m_decodingStopped )
+	{
+		levelLoad.state.store( ELevelState::Failed, std::memory_order_release );
+		return;
+	}
+
+	CTimer timer;
+	uint8_t* pDst = m_stagingAllocation.pMapped + levelLoad.stagingOffset;
+	if( texture.pFile )
+	{
+		texture.pFile->decodeMip( levelLoad.level, pDst );
+	}
+	else
+	{
+		generatePattern( texture.desc.seed, levelLoad.level, std::max( texture.width >> levelLoad.level, 1u ), std::max( texture.height >> levelLoad.level, 1u ), pDst );
+	}
+	m_pAllocator->flush( m_stagingAllocation, levelLoad.stagingOffset, levelLoad.size );
+
+	++m_levelsDecoded;
+	m_bytesDecoded += levelLoad.size;
+	m_decodeMicroseconds += static_cast< uint64_t >( timer.elapsedMilliseconds() * 1000.0 );
+	levelLoad.state.store( ELevelState::Decoded, std::memory_order_release );
+}
+
+bool CTextureStreamer::releaseStaging( SLevelLoad& levelLoad )
+{
+	if( !levelLoad.hasStaging )
+	{
+		return true;
+	}
+
+	const ELevelState state = levelLoad.state.load( std::memory_order_acquire );
+	if( state == ELevelState::Decoding || ( state == ELevelState::Recorded && levelLoad.uploadValue > m_completedUploadValue ) )
+	{
+		return false;
+	}
+
+	m_pStagingPool->free( levelLoad.stagingOffset );
+	levelLoad.hasStaging = false;
+	return true;
+}
+
+uint32_t CTextureStreamer::getWantedLevel( const STexture& texture, EMemoryPressure pressure ) const
+{
+	if( texture.requestedWidth == 0 || pressure >= EMemoryPressure::High )
+	{
+		return texture.tailLevel;
+	}
+
+	//the coarsest level still at least as wide as asked for
+	uint32_t level = 0;
+	while( level < texture.tailLevel && std::max( texture.width >> ( level + 1 ), 1u ) >= texture.requestedWidth )
+	{
+		++level;
+	}
+
+	//one level coarser to leave headroom before evictions start
+	if( pressure == EMemoryPressure::Elevated )
+	{
+		++level;
+	}
+	return std::min( std::max( level, texture.finestLevel ), texture.tailLevel );
+}
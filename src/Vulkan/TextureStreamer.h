@@ -0,0 +1,269 @@
+#pragma once
+#include "Memory/DeviceMemoryAllocator.h"
+#include "Memory/FreeListAllocator.h"
+#include "Memory/ResidencyManager.h"
+#include "Utils/JobSystem.h"
+#include "Vulkan/DeletionQueue.h"
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <mutex>
+
+class CBindlessTable;
+class CTextureFile;
+class CUploadService;
+
+//Streams textures in on demand. Every texture keeps its mip tail (the levels at most
+//tailSize wide and high) resident from shortly after it is added until it is destroyed;
+//finer levels are loaded into a second image once requestWidth asks for them, and that
+//image goes again when the residency manager evicts it. Until its tail is resident, a
+//texture shows a 1x1 white placeholder.
+//Files are opened and levels decoded on job threads, straight into a pooled staging buffer,
+//and copied on the transfer queue by CUploadService. update() records at most
+//uploadBytesPerFrame of copies per frame, so streaming never shows up as a frame time spike.
+//Under memory pressure, finer levels are requested less eagerly and then not at all.
+//Shaders find a texture's current bindless slot through a per-frame table, a storage buffer
+//of one uint per texture id (see shaders/Scene.glsl), so textures change residency without
+//touching any descriptor a frame in flight uses.
+class CTextureStreamer
+{
+public:
+	using TextureId = uint32_t;
+	static constexpr TextureId INVALID_TEXTURE = UINT32_MAX;
+
+	struct SSettings
+	{
+		//copies recorded per frame, a single larger level still goes through on its own
+		vk::DeviceSize uploadBytesPerFrame = 8ull * 1024 * 1024;
+		//host visible memory decoded levels wait in until their copy has completed, levels that
+		//do not fit in half of it are never streamed
+		vk::DeviceSize stagingPoolSize = 64ull * 1024 * 1024;
+		uint32_t tailSize = 64;
+		uint32_t maxDecodeJobs = 8;
+		//images with finer levels being filled at once
+		uint32_t maxStreamingLoads = 4;
+		uint32_t maxTextures = 1024;
+		//width and height of the procedural textures
+		uint32_t proceduralSize = 2048;
+	};
+
+	struct STextureDesc
+	{
+		//.vkst file, see src/Assets/TextureFormat.h. A procedural test pattern when empty.
+		std::string filePath;
+		//varies the procedural pattern
+		uint32_t seed = 0;
+	};
+
+	struct SStats
+	{
+		uint32_t textures = 0;
+		uint32_t tailsResident = 0;
+		//textures with finer levels than their tail resident
+		uint32_t streamedResident = 0;
+		uint32_t loadsInFlight = 0;
+		uint32_t decodeJobsInFlight = 0;
+		vk::DeviceSize residentBytes = 0;
+		vk::DeviceSize stagingBytesInUse = 0;
+
+		uint64_t levelsDecoded = 0;
+		uint64_t bytesDecoded = 0;
+		double decodeMilliseconds = 0.0;
+		uint64_t bytesUploaded = 0;
+		vk::DeviceSize bytesUploadedLastFrame = 0;
+		uint64_t loadsCompleted = 0;
+		//replaced by a finer request or given up for memory pressure before they finished
+		uint64_t loadsCancelled = 0;
+		uint64_t evictions = 0;
+		//loads not started because the residency manager refused the memory
+		uint64_t refusedLoads = 0;
+		uint64_t failedTextures = 0;
+	};
+
+public:
+	CTextureStreamer();
+	~CTextureStreamer();
+
+	void init( const vk::PhysicalDevice& physicalDevice, const vk::Device& device, CDeviceMemoryAllocator& allocator, CUploadService& uploadService,
+		CBindlessTable& bindlessTable, CResidencyManager& residencyManager, CJobSystem& jobSystem, uint32_t framesInFlight, const SSettings& settings = SSettings {} );
+	//waits for the decode jobs in flight and starts no more, before the job system goes away
+	void stopDecoding();
+	//the device has to be idle
+	void destroy();
+
+	//only queues the work, files are opened on a job thread by the next update(). Thread safe.
+	TextureId addTexture( const STextureDesc& desc );
+	//texels wanted across the texture's width, e.g. from the size it covers on screen.
+	//0 is content with the tail. Thread safe.
+	void requestWidth( TextureId id, uint32_t width );
+
+	//once per frame, before the upload service is flushed. Finishes loads whose copies completed,
+	//records the next copies, queues decodes and writes the table frameIndex reads.
+	//frameNumber is the frame about to be recorded, completedFrame the newest one the GPU finished.
+	void update( uint32_t frameIndex, uint64_t frameNumber, uint64_t completedFrame );
+
+	//bindless storage buffer of the table written by the last update() for frameIndex
+	uint32_t getTextureTable( uint32_t frameIndex ) const;
+
+	inline uint32_t getSampler() const
+	{
+		return m_samplerHandle;
+	}
+
+	inline bool isInitialized() const
+	{
+		return static_cast< bool >( m_device );
+	}
+
+	SStats getStats() const;
+	void logStats() const;
+
+private:
+	struct SImage
+	{
+		vk::Image image;
+		vk::ImageView view;
+		SAllocation allocation;
+		uint32_t handle = UINT32_MAX;
+		//level of the texture that is level 0 of the image
+		uint32_t baseLevel = 0;
+		CResidencyManager::ResourceId residencyId = CResidencyManager::INVALID_RESOURCE;
+
+		inline bool isValid() const
+		{
+			return static_cast< bool >( image );
+		}
+	};
+
+	enum class ELevelState : uint32_t
+	{
+		Waiting,
+		Decoding,
+		Decoded,
+		Failed,
+		Recorded
+	};
+
+	//one level of a load, shared with the job decoding it
+	struct SLevelLoad
+	{
+		uint32_t level = 0;
+		vk::DeviceSize size = 0;
+		vk::DeviceSize stagingOffset = 0;
+		bool hasStaging = false;
+		uint64_t uploadValue = 0;
+		std::atomic<ELevelState> state { ELevelState::Waiting };
+	};
+
+	//an image being filled, it replaces the texture's current one once every level's copy completed
+	struct SLoad
+	{
+		SImage target;
+		bool isTail = false;
+		std::vector<std::shared_ptr<SLevelLoad>> levels;
+	};
+
+	enum class ETextureState : uint32_t
+	{
+		//the open job has not finished
+		Opening,
+		Ready,
+		Failed
+	};
+
+	struct STexture
+	{
+		STextureDesc desc;
+		std::shared_ptr<CTextureFile> pFile;
+		std::atomic<ETextureState> state { ETextureState::Opening };
+		bool openQueued = false;
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipCount = 0;
+		vk::Format format = vk::Format::eUndefined;
+		uint32_t tailLevel = 0;
+		//finest level whose decoded size fits the staging pool
+		uint32_t finestLevel = 0;
+
+		SImage tail;
+		SImage streamed;
+		std::unique_ptr<SLoad> pLoad;
+
+		//from requestWidth, 0 when the tail is enough
+		uint32_t requestedWidth = 0;
+		//set by the residency manager's callback, handled by the next update()
+		CResidencyManager::ResourceId evictedResource = CResidencyManager::INVALID_RESOURCE;
+	};
+
+	void createPlaceholder();
+	void createTableBuffers( const vk::PhysicalDevice& physicalDevice, uint32_t framesInFlight );
+
+	void queueOpen( TextureId id );
+	void finishOpen( STexture& texture );
+	void finishLoads( uint64_t frameNumber );
+	void handleEvictions( uint64_t frameNumber );
+	void startLoads( EMemoryPressure pressure, uint64_t frameNumber );
+	void queueDecodes();
+	void recordCopies();
+	void writeTable( uint32_t frameIndex );
+
+	void onEvicted( TextureId id, CResidencyManager::ResourceId resource );
+
+	//false when checkBudget is set and the residency manager refuses the memory
+	bool createImage( const STexture& texture, uint32_t baseLevel, bool checkBudget, SImage& image );
+	void destroyImage( SImage& image );
+	void retireImage( SImage& image, uint64_t frameNumber );
+	std::unique_ptr<SLoad> createLoad( const STexture& texture, SImage target, bool isTail );
+	void cancelLoad( STexture& texture, uint64_t frameNumber );
+	void decodeLevel( const STexture& texture, SLevelLoad& levelLoad );
+	//true once the level holds no staging memory anymore
+	bool releaseStaging( SLevelLoad& levelLoad );
+	uint32_t getWantedLevel( const STexture& texture, EMemoryPressure pressure ) const;
+
+	vk::Device m_device;
+	CDeviceMemoryAllocator* m_pAllocator;
+	CUploadService* m_pUploadService;
+	CBindlessTable* m_pBindlessTable;
+	CResidencyManager* m_pResidencyManager;
+	CJobSystem* m_pJobSystem;
+	SSettings m_settings;
+
+	//never shrinks, ids index it
+	std::vector<std::unique_ptr<STexture>> m_textures;
+	mutable std::mutex m_mutex;
+
+	//decoded levels wait here for their copies, sub-allocated on the streaming thread only
+	vk::Buffer m_stagingBuffer;
+	SAllocation m_stagingAllocation;
+	std::unique_ptr<CFreeListAllocator> m_pStagingPool;
+	//levels of cancelled loads whose staging is still written by a job or read by a copy
+	std::vector<std::shared_ptr<SLevelLoad>> m_orphanedLevels;
+
+	CJobCounter m_decodeJobs;
+	std::atomic<uint32_t> m_decodeJobsInFlight;
+	std::atomic<bool> m_decodingStopped;
+
+	SImage m_placeholder;
+	vk::Sampler m_sampler;
+	uint32_t m_samplerHandle;
+
+	//one region of maxTextures slots per frame in flight
+	vk::Buffer m_tableBuffer;
+	SAllocation m_tableAllocation;
+	vk::DeviceSize m_tableStride;
+	std::vector<uint32_t> m_tableHandles;
+
+	//images and slots frames in flight may still use, keyed by frame number. The app's queue
+	//belongs to the main thread, update() runs on a job thread.
+	CDeletionQueue m_deletionQueue;
+
+	//read once per update(), what staging copies have finished
+	uint64_t m_completedUploadValue;
+
+	SStats m_stats;
+	vk::DeviceSize m_bytesUploadedThisFrame;
+	std::atomic<uint64_t> m_levelsDecoded;
+	std::atomic<uint64_t> m_bytesDecoded;
+	std::atomic<uint64_t> m_decodeMicroseconds;
+};
@@ -0,0 +1,384 @@
+#include "vkpch.h"
+#include "UploadService.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+//satisfies optimalBufferCopyOffsetAlignment on every implementation we care about and any texel size up to 16 bytes
+const vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+/////////////////////////////////////////////////
+
+CUploadService::CUploadService()
+	: m_device( nullptr )
+	, m_pAllocator( nullptr )
+	, m_transferFamily( 0 )
+	, m_graphicsFamily( 0 )
+	, m_lastSubmittedValue( 0 )
+{
+}
+
+void CUploadService::init( const vk::Device& device, CDeviceMemoryAllocator& allocator, const vk::Queue& transferQueue, uint32_t transferFamily,
+	uint32_t graphicsFamily, vk::DeviceSize stagingSize )
+{
+	m_device = device;
+	m_pAllocator = &allocator;
+	m_transferQueue = transferQueue;
+	m_transferFamily = transferFamily;
+	m_graphicsFamily = graphicsFamily;
+
+	vk::BufferCreateInfo bufferCreateInfo( {}, stagingSize, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive );
+	m_stagingBuffer = m_device.createBuffer( bufferCreateInfo );
+	m_stagingAllocation = m_pAllocator->allocateForBuffer( m_stagingBuffer, EMemoryUsage::CpuToGpu );
+	m_stagingRing = CRingAllocator( stagingSize );
+
+	vk::CommandPoolCreateInfo poolCreateInfo( vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient, m_transferFamily );
+	m_commandPool = m_device.createCommandPool( poolCreateInfo );
+
+	vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo( vk::SemaphoreType::eTimeline, 0 );
+	vk::SemaphoreCreateInfo semaphoreCreateInfo {};
+	semaphoreCreateInfo.setPNext( &semaphoreTypeCreateInfo );
+	m_timelineSemaphore = m_device.createSemaphore( semaphoreCreateInfo );
+
+	m_lastSubmittedValue = 0;
+
+	VS_INFO( "Upload service: {0} MiB staging ring, transfer family {1}, graphics family {2}{3}.", stagingSize / ( 1024 * 1024 ),
+		m_transferFamily, m_graphicsFamily, requiresOwnershipTransfer() ? ", with queue family ownership transfers" : "" );
+}
+
+void CUploadService::destroy()
+{
+	if( !m_device )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		flushLocked();
+	}
+	wait( m_lastSubmittedValue );
+
+	m_device.destroySemaphore( m_timelineSemaphore );
+	m_device.destroyCommandPool( m_commandPool );
+	m_device.destroyBuffer( m_stagingBuffer );
+	m_pAllocator->free( m_stagingAllocation );
+
+	m_batchesInFlight.clear();
+	m_freeCommandBuffers.clear();
+	m_recordedAcquires.clear();
+	m_flushedAcquires.clear();
+
+	m_device = nullptr;
+}
+
+uint64_t CUploadService::uploadBuffer( const vk::Buffer& dst, vk::DeviceSize dstOffset, const void* pData, vk::DeviceSize size,
+	vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( size == 0 )
+	{
+		return m_lastSubmittedValue;
+	}
+
+	//larger than the ring is fine for buffers, stream it through in chunks
+	const vk::DeviceSize maxChunkSize = m_stagingRing.getSize() / 2;
+	const uint8_t* pSrc = static_cast< const uint8_t* >( pData );
+
+	for( vk::DeviceSize copied = 0; copied < size; )
+	{
+		const vk::DeviceSize chunkSize = std::min( size - copied, maxChunkSize );
+		const vk::DeviceSize stagingOffset = allocateStaging( chunkSize, STAGING_ALIGNMENT );
+
+		memcpy( m_stagingAllocation.pMapped + stagingOffset, pSrc + copied, static_cast< size_t >( chunkSize ) );
+		m_pAllocator->flush( m_stagingAllocation, stagingOffset, chunkSize );
+
+		vk::BufferCopy region( stagingOffset, dstOffset + copied, chunkSize );
+		getRecordingCommandBuffer().copyBuffer( m_stagingBuffer, dst, region );
+
+		copied += chunkSize;
+		++m_stats.copiesRecorded;
+	}
+
+	const uint64_t value = m_recordingBatch->value;
+
+	SPendingAcquire acquire {};
+	acquire.value = value;
+	acquire.buffer = dst;
+	acquire.offset = dstOffset;
+	acquire.size = size;
+	acquire.dstStage = dstStage;
+	acquire.dstAccess = dstAccess;
+	m_recordedAcquires.push_back( acquire );
+
+	m_stats.bytesUploaded += size;
+	return value;
+}
+
+uint64_t CUploadService::uploadImage( const vk::Image& dst, const vk::ImageSubresourceLayers& subresource, const vk::Extent3D& extent, const void* pData, vk::DeviceSize size,
+	vk::ImageLayout finalLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( size > m_stagingRing.getSize() )
+	{
+		throw std::runtime_error( "Image upload does not fit in the staging ring." );
+	}
+
+	const vk::DeviceSize stagingOffset = allocateStaging( size, STAGING_ALIGNMENT );
+	memcpy( m_stagingAllocation.pMapped + stagingOffset, pData, static_cast< size_t >( size ) );
+	m_pAllocator->flush( m_stagingAllocation, stagingOffset, size );
+
+	return recordImageCopy( m_stagingBuffer, stagingOffset, dst, subresource, extent, size, finalLayout, dstStage, dstAccess );
+}
+
+uint64_t CUploadService::copyToImage( const vk::Buffer& src, vk::DeviceSize srcOffset, const vk::Image& dst, const vk::ImageSubresourceLayers& subresource,
+	const vk::Extent3D& extent, vk::DeviceSize size, vk::ImageLayout finalLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	//nothing of the ring is used, but retired batches still hand back their command buffers here
+	releaseRetiredBatches();
+	return recordImageCopy( src, srcOffset, dst, subresource, extent, size, finalLayout, dstStage, dstAccess );
+}
+
+uint64_t CUploadService::flush()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return flushLocked();
+}
+
+uint64_t CUploadService::recordGraphicsAcquire( const vk::CommandBuffer& graphicsCommandBuffer, vk::PipelineStageFlags& waitStages )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( m_flushedAcquires.empty() )
+	{
+		return 0;
+	}
+
+	uint64_t waitValue = 0;
+	vk::PipelineStageFlags acquireStages;
+	std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+	for( const SPendingAcquire& acquire : m_flushedAcquires )
+	{
+		waitValue = std::max( waitValue, acquire.value );
+		acquireStages |= acquire.dstStage;
+
+		if( !requiresOwnershipTransfer() )
+		{
+			continue;
+		}
+
+		//must mirror the release recorded in flushLocked()
+		if( acquire.image )
+		{
+			imageBarriers.emplace_back( vk::AccessFlags {}, acquire.dstAccess, vk::ImageLayout::eTransferDstOptimal, acquire.layout,
+				m_transferFamily, m_graphicsFamily, acquire.image, acquire.subresourceRange );
+		}
+		else
+		{
+			bufferBarriers.emplace_back( vk::AccessFlags {}, acquire.dstAccess, m_transferFamily, m_graphicsFamily, acquire.buffer, acquire.offset, acquire.size );
+		}
+	}
+
+	//the acquire chains off the semaphore wait by using the same stages as its source scope
+	if( !bufferBarriers.empty() || !imageBarriers.empty() )
+	{
+		graphicsCommandBuffer.pipelineBarrier( acquireStages, acquireStages, {}, nullptr, bufferBarriers, imageBarriers );
+	}
+
+	m_flushedAcquires.clear();
+
+	waitStages |= acquireStages;
+	return waitValue;
+}
+
+uint64_t CUploadService::getCompletedValue() const
+{
+	return m_device.getSemaphoreCounterValue( m_timelineSemaphore );
+}
+
+bool CUploadService::isComplete( uint64_t value ) const
+{
+	return getCompletedValue() >= value;
+}
+
+void CUploadService::wait( uint64_t value ) const
+{
+	if( value == 0 )
+	{
+		return;
+	}
+
+	vk::SemaphoreWaitInfo waitInfo( {}, 1, &m_timelineSemaphore, &value );
+	if( m_device.waitSemaphores( waitInfo, UINT64_MAX ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "Failed to wait for upload timeline semaphore." );
+	}
+}
+
+/////////////////////////////////////////////////
+
+vk::DeviceSize CUploadService::allocateStaging( vk::DeviceSize size, vk::DeviceSize alignment )
+{
+	releaseRetiredBatches();
+
+	for( ;; )
+	{
+		std::optional<uint64_t> offset = m_stagingRing.allocate( size, alignment );
+		if( offset.has_value() )
+		{
+			return offset.value();
+		}
+
+		//ring is full, hand the current batch to the GPU and wait for the oldest one to retire
+		if( m_recordingBatch.has_value() )
+		{
+			flushLocked();
+		}
+
+		if( m_batchesInFlight.empty() )
+		{
+			throw std::runtime_error( "Staging allocation does not fit in the upload ring." );
+		}
+
+		++m_stats.stagingStalls;
+		wait( m_batchesInFlight.front().value );
+		releaseRetiredBatches();
+	}
+}
+
+const vk::CommandBuffer& CUploadService::getRecordingCommandBuffer()
+{
+	if( !m_recordingBatch.has_value() )
+	{
+		SBatch batch;
+		if( !m_freeCommandBuffers.empty() )
+		{
+			batch.commandBuffer = m_freeCommandBuffers.back();
+			m_freeCommandBuffers.pop_back();
+		}
+		else
+		{
+			vk::CommandBufferAllocateInfo allocateInfo( m_commandPool, vk::CommandBufferLevel::ePrimary, 1 );
+			batch.commandBuffer = m_device.allocateCommandBuffers( allocateInfo ).front();
+		}
+
+		batch.value = m_lastSubmittedValue + 1;
+		batch.commandBuffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+
+		m_recordingBatch = batch;
+	}
+
+	return m_recordingBatch->commandBuffer;
+}
+
+uint64_t CUploadService::flushLocked()
+{
+	if( !m_recordingBatch.has_value() )
+	{
+		return m_lastSubmittedValue;
+	}
+
+	const SBatch batch = m_recordingBatch.value();
+	m_recordingBatch.reset();
+
+	//release to the graphics family, or just finish the image layout transitions when the families match
+	std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+	vk::PipelineStageFlags dstStages;
+
+	for( const SPendingAcquire& acquire : m_recordedAcquires )
+	{
+		if( requiresOwnershipTransfer() )
+		{
+			if( acquire.image )
+			{
+				imageBarriers.emplace_back( vk::AccessFlagBits::eTransferWrite, vk::AccessFlags {}, vk::ImageLayout::eTransferDstOptimal, acquire.layout,
+					m_transferFamily, m_graphicsFamily, acquire.image, acquire.subresourceRange );
+			}
+			else
+			{
+				bufferBarriers.emplace_back( vk::AccessFlagBits::eTransferWrite, vk::AccessFlags {}, m_transferFamily, m_graphicsFamily, acquire.buffer, acquire.offset, acquire.size );
+			}
+			dstStages |= vk::PipelineStageFlagBits::eBottomOfPipe;
+		}
+		else if( acquire.image )
+		{
+			imageBarriers.emplace_back( vk::AccessFlagBits::eTransferWrite, acquire.dstAccess, vk::ImageLayout::eTransferDstOptimal, acquire.layout,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, acquire.image, acquire.subresourceRange );
+			dstStages |= acquire.dstStage;
+		}
+	}
+
+	if( !bufferBarriers.empty() || !imageBarriers.empty() )
+	{
+		batch.commandBuffer.pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, dstStages, {}, nullptr, bufferBarriers, imageBarriers );
+	}
+
+	batch.commandBuffer.end();
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo( 0, nullptr, 1, &batch.value );
+	vk::SubmitInfo submitInfo( 0, nullptr, nullptr, 1, &batch.commandBuffer, 1, &m_timelineSemaphore );
+	submitInfo.setPNext( &timelineSubmitInfo );
+
+	m_transferQueue.submit( submitInfo, nullptr );
+
+	m_stagingRing.submit( batch.value );
+	m_batchesInFlight.push_back( batch );
+	m_lastSubmittedValue = batch.value;
+
+	m_flushedAcquires.insert( m_flushedAcquires.end(), m_recordedAcquires.begin(), m_recordedAcquires.end() );
+	m_recordedAcquires.clear();
+
+	++m_stats.submissions;
+	return batch.value;
+}
+
+uint64_t CUploadService::recordImageCopy( const vk::Buffer& src, vk::DeviceSize srcOffset, const vk::Image& dst, const vk::ImageSubresourceLayers& subresource,
+	const vk::Extent3D& extent, vk::DeviceSize size, vk::ImageLayout finalLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess )
+{
+	const vk::ImageSubresourceRange subresourceRange( subresource.aspectMask, subresource.mipLevel, 1, subresource.baseArrayLayer, subresource.layerCount );
+	const vk::CommandBuffer& cmd = getRecordingCommandBuffer();
+
+	//the previous contents of this subresource are discarded
+	vk::ImageMemoryBarrier toTransferDst( {}, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, dst, subresourceRange );
+	cmd.pipelineBarrier( vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferDst );
+
+	vk::BufferImageCopy region( srcOffset, 0, 0, subresource, vk::Offset3D { 0, 0, 0 }, extent );
+	cmd.copyBufferToImage( src, dst, vk::ImageLayout::eTransferDstOptimal, region );
+
+	SPendingAcquire acquire {};
+	acquire.value = m_recordingBatch->value;
+	acquire.image = dst;
+	acquire.subresourceRange = subresourceRange;
+	acquire.layout = finalLayout;
+	acquire.dstStage = dstStage;
+	acquire.dstAccess = dstAccess;
+	m_recordedAcquires.push_back( acquire );
+
+	m_stats.bytesUploaded += size;
+	++m_stats.copiesRecorded;
+
+	return acquire.value;
+}
+
+void CUploadService::releaseRetiredBatches()
+{
+	const uint64_t completedValue = getCompletedValue();
+
+	while( !m_batchesInFlight.empty() && m_batchesInFlight.front().value <= completedValue )
+	{
+		m_batchesInFlight.front().commandBuffer.reset( {} );
+		m_freeCommandBuffers.push_back( m_batchesInFlight.front().commandBuffer );
+		m_batchesInFlight.pop_front();
+	}
+
+	m_stagingRing.release( completedValue );
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "Memory/DeviceMemoryAllocator.h"
+#include "Memory/RingAllocator.h"
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <mutex>
+
+//Streams data to device local resources through a persistently mapped staging ring and
+//submits the copies on the transfer queue. Each flush signals a timeline semaphore value.
+//When the transfer queue belongs to another family, ownership is released on the transfer
+//queue and acquired on the graphics queue through recordGraphicsAcquire().
+class CUploadService
+{
+public:
+	static constexpr vk::DeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+	struct SStats
+	{
+		uint64_t bytesUploaded = 0;
+		uint32_t copiesRecorded = 0;
+		uint32_t submissions = 0;
+		//times the CPU had to wait for the ring to drain
+		uint32_t stagingStalls = 0;
+	};
+
+public:
+	CUploadService();
+
+	void init( const vk::Device& device, CDeviceMemoryAllocator& allocator, const vk::Queue& transferQueue, uint32_t transferFamily,
+		uint32_t graphicsFamily, vk::DeviceSize stagingSize = DEFAULT_STAGING_SIZE );
+	void destroy();
+
+	//queue copies into the current batch, return the timeline value that signals once the batch completes.
+	//dstStage/dstAccess describe the first use on the graphics queue.
+	uint64_t uploadBuffer( const vk::Buffer& dst, vk::DeviceSize dstOffset, const void* pData, vk::DeviceSize size,
+		vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess );
+	uint64_t uploadImage( const vk::Image& dst, const vk::ImageSubresourceLayers& subresource, const vk::Extent3D& extent, const void* pData, vk::DeviceSize size,
+		vk::ImageLayout finalLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess );
+	//same, from staging memory the caller owns and filled, e.g. on a worker thread. src must stay
+	//untouched until the returned value completes.
+	uint64_t copyToImage( const vk::Buffer& src, vk::DeviceSize srcOffset, const vk::Image& dst, const vk::ImageSubresourceLayers& subresource,
+		const vk::Extent3D& extent, vk::DeviceSize size, vk::ImageLayout finalLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess );
+
+	//submits the current batch, returns the value it signals (or the last one if nothing was queued)
+	uint64_t flush();
+
+	//records the queue family acquires for every flushed upload not acquired yet. Returns the timeline
+	//value the graphics submit must wait on (0 if none) and the stages that wait has to block.
+	uint64_t recordGraphicsAcquire( const vk::CommandBuffer& graphicsCommandBuffer, vk::PipelineStageFlags& waitStages );
+
+	uint64_t getCompletedValue() const;
+	bool isComplete( uint64_t value ) const;
+	void wait( uint64_t value ) const;
+
+	inline vk::Semaphore getTimelineSemaphore() const
+	{
+		return m_timelineSemaphore;
+	}
+
+	inline bool requiresOwnershipTransfer() const
+	{
+		return m_transferFamily != m_graphicsFamily;
+	}
+
+	inline SStats getStats() const
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		return m_stats;
+	}
+
+private:
+	struct SPendingAcquire
+	{
+		uint64_t value;
+
+		vk::Buffer buffer;
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+
+		vk::Image image;
+		vk::ImageSubresourceRange subresourceRange;
+		vk::ImageLayout layout;
+
+		vk::PipelineStageFlags dstStage;
+		vk::AccessFlags dstAccess;
+	};
+
+	struct SBatch
+	{
+		vk::CommandBuffer commandBuffer;
+		uint64_t value;
+	};
+
+	vk::DeviceSize allocateStaging( vk::DeviceSize size, vk::DeviceSize alignment );
+	uint64_t recordImageCopy( const vk::Buffer& src, vk::DeviceSize srcOffset, const vk::Image& dst, const vk::ImageSubresourceLayers& subresource,
+		const vk::Extent3D& extent, vk::DeviceSize size, vk::ImageLayout finalLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess );
+	const vk::CommandBuffer& getRecordingCommandBuffer();
+	uint64_t flushLocked();
+	void releaseRetiredBatches();
+
+	vk::Device m_device;
+	CDeviceMemoryAllocator* m_pAllocator;
+
+	vk::Queue m_transferQueue;
+	uint32_t m_transferFamily;
+	uint32_t m_graphicsFamily;
+
+	vk::Buffer m_stagingBuffer;
+	SAllocation m_stagingAllocation;
+	CRingAllocator m_stagingRing;
+
+	vk::CommandPool m_commandPool;
+	std::vector<vk::CommandBuffer> m_freeCommandBuffers;
+	std::deque<SBatch> m_batchesInFlight;
+	std::optional<SBatch> m_recordingBatch;
+
+	vk::Semaphore m_timelineSemaphore;
+	uint64_t m_lastSubmittedValue;
+
+	//uploads recorded into the current batch, and flushed ones still waiting for the graphics acquire
+	std::vector<SPendingAcquire> m_recordedAcquires;
+	std::vector<SPendingAcquire> m_flushedAcquires;
+
+	SStats m_stats;
+	mutable std::mutex m_mutex;
+};
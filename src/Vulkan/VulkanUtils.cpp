@@ -0,0 +1,135 @@
+#include "vkpch.h"
+#include "VulkanUtils.h"
+
+#include "Utils/Log.h"
+
+/////////////////////////////////////////////////
+
+const std::vector<const char*> REQUIRED_VALIDATION_LAYERS = { "VK_LAYER_KHRONOS_validation" };
+
+/////////////////////////////////////////////////
+
+VKAPI_ATTR VkBool32 VKAPI_CALL debugCallbackFn(
+	VkDebugUtilsMessageSeverityFlagBitsEXT       messageSeverity,
+	VkDebugUtilsMessageTypeFlagsEXT              messageTypes,
+	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+	void* pUserData )
+{
+	//the same validation message usually fires every frame, key it by id (or text for id-less messages)
+	const uint64_t messageKey = ( pCallbackData->messageIdNumber != 0 )
+		? static_cast< uint32_t >( pCallbackData->messageIdNumber )
+		: std::hash<std::string_view>()( pCallbackData->pMessage );
+
+	uint32_t suppressedCount = 0;
+	if( !CLog::ShouldLogRepeated( messageKey, suppressedCount ) )
+	{
+		return VK_FALSE;
+	}
+
+	const std::string repeats = ( suppressedCount > 0 ) ? fmt::format( " [{0} repeats suppressed]", suppressedCount ) : std::string();
+
+	switch( messageSeverity )
+	{
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
+		VS_TRACE( "[VULKAN][TRACE] {0}{1}", pCallbackData->pMessage, repeats );
+		break;
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
+		VS_INFO( "[VULKAN][INFO] {0}{1}", pCallbackData->pMessage, repeats );
+		break;
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
+		VS_WARN( "[VULKAN][WARNING] {0}{1}", pCallbackData->pMessage, repeats );
+		break;
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
+		//the bell is console I/O on the calling thread, keep it off the async path
+		if( !CLog::IsAsynchronous() )
+		{
+			std::cout << '\a';
+		}
+		VS_ERROR( "[VULKAN][ERROR] {0}{1}", pCallbackData->pMessage, repeats );
+		break;
+
+	}
+	return VK_FALSE;
+}
+
+vk::DebugUtilsMessengerCreateInfoEXT getDebugMessengerCreateInfo()
+{
+	vk::DebugUtilsMessengerCreateInfoEXT createInfo {};
+	createInfo.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo | vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
+	createInfo.messageType = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral | vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation;
+	createInfo.pfnUserCallback = debugCallbackFn;
+
+	return createInfo;
+}
+
+bool checkValidationLayerSupport()
+{
+	uint32_t layerCount = 0;
+	if( vk::enumerateInstanceLayerProperties( &layerCount, nullptr ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "Failed to get layer properties" );
+	}
+
+	std::vector<vk::LayerProperties> availableLayerProps( layerCount );
+	if( vk::enumerateInstanceLayerProperties( &layerCount, availableLayerProps.data() ) != vk::Result::eSuccess )
+	{
+		throw std::runtime_error( "Failed to get layer properties" );
+	}
+
+	for( const char* reqLayerName : REQUIRED_VALIDATION_LAYERS )
+	{
+		bool layerFound = false;
+
+		for( const auto& availablelayerProp : availableLayerProps )
+		{
+			if( strcmp( reqLayerName, availablelayerProp.layerName ) == 0 )
+			{
+				layerFound = true;
+				break;
+			}
+		}
+
+		if( !layerFound )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool isDeviceExtensionSupported( const vk::PhysicalDevice& device, const char* extensionName )
+{
+	std::vector<vk::ExtensionProperties> availableExtensionProps = device.enumerateDeviceExtensionProperties();
+	for( const auto& extensionProp : availableExtensionProps )
+	{
+		if( strcmp( extensionProp.extensionName, extensionName ) == 0 )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void setViewportAndScissor( const vk::CommandBuffer& commandBuffer, const vk::Rect2D& area )
+{
+	vk::Viewport viewport( static_cast< float >( area.offset.x ), static_cast< float >( area.offset.y ),
+		static_cast< float >( area.extent.width ), static_cast< float >( area.extent.height ), 0.0f, 1.0f );
+
+	commandBuffer.setViewport( 0, viewport );
+	commandBuffer.setScissor( 0, area );
+}
+
+vk::Format findDepthFormat( const vk::PhysicalDevice& physicalDevice )
+{
+	for( vk::Format format : { vk::Format::eD32Sfloat, vk::Format::eX8D24UnormPack32, vk::Format::eD24UnormS8Uint, vk::Format::eD16Unorm } )
+	{
+		if( physicalDevice.getFormatProperties( format ).optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment )
+		{
+			return format;
+		}
+	}
+
+	throw std::runtime_error( "No depth format can be rendered to." );
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#ifdef VKS_DEBUG
+constexpr bool VALIDATION_ENABLED = true;
+#else
+constexpr bool VALIDATION_ENABLED = false;
+#endif
+
+extern const std::vector<const char*> REQUIRED_VALIDATION_LAYERS;
+
+
+VKAPI_ATTR VkBool32 VKAPI_CALL debugCallbackFn(
+	VkDebugUtilsMessageSeverityFlagBitsEXT       messageSeverity,
+	VkDebugUtilsMessageTypeFlagsEXT              messageTypes,
+	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+	void* pUserData );
+
+vk::DebugUtilsMessengerCreateInfoEXT getDebugMessengerCreateInfo();
+
+bool checkValidationLayerSupport();
+bool isDeviceExtensionSupported( const vk::PhysicalDevice& device, const char* extensionName );
+
+//first depth format the device can render to, every device has at least one of them
+vk::Format findDepthFormat( const vk::PhysicalDevice& physicalDevice );
+
+//for pipelines with dynamic viewport and scissor, covers area with a 0..1 depth range
+void setViewportAndScissor( const vk::CommandBuffer& commandBuffer, const vk::Rect2D& area );
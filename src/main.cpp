@@ -1,20 +1,159 @@
 #include "vkpch.h"
 
-#include <imgui.h>
-#include <backends/imgui_impl_glfw.h>
-#include <backends/imgui_impl_vulkan.h>
-
-
 //Apps
 #include "HelloVulkanApp.h"
+#include "HeadlessVulkanApp.h"
+
+#include "Utils/CommandLine.h"
+#include "Vulkan/ShaderRegistry.h"
+
+static void printUsage()
+{
+    printf( "usage: vulkanSandbox [--frames-in-flight N] [--draws N] [--job-threads N] [--record-slices N] [--compile-threads N]\n"
+        "                     [--no-profiler] [--present-policy low-latency|power-saving|capped] [--fps-cap N]\n"
+        "                     [--objects N] [--mesh file.vksm] [--textures N] [--texture file.vkst] [--instances N]\n"
+        "                     [--latency-csv file.csv] [--bench-recording] [--shader-dir dir]\n"
+        "       vulkanSandbox --headless [--frames N] [--width N] [--height N] [--readback-interval N]\n" );
+}
+
+static std::unique_ptr<IAppBase> createApp( int argc, char** argv )
+{
+    bool headless = false;
+    CHelloVulkanApp::SSettings settings;
+    CHeadlessVulkanApp::SSettings headlessSettings;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[ i ];
+        const bool hasValue = ( i + 1 < argc );
+
+        if( arg == "--headless" )
+        {
+            headless = true;
+        }
+        else if( arg == "--frames-in-flight" && hasValue )
+        {
+            settings.framesInFlight = parseCountArgument( arg, argv[ ++i ], 1 );
+        }
+        else if( arg == "--draws" && hasValue )
+        {
+            settings.drawCount = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--job-threads" && hasValue )
+        {
+            settings.jobThreads = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--record-slices" && hasValue )
+        {
+            settings.recordSlices = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--compile-threads" && hasValue )
+        {
+            settings.pipelineCompileThreads = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--no-profiler" )
+        {
+            settings.profilerOverlay = false;
+        }
+        else if( arg == "--present-policy" && hasValue )
+        {
+            const std::string policy = argv[ ++i ];
+            if( policy == "low-latency" )
+            {
+                settings.presentPolicy = EPresentPolicy::LowLatency;
+            }
+            else if( policy == "power-saving" )
+            {
+                settings.presentPolicy = EPresentPolicy::PowerSaving;
+            }
+            else if( policy == "capped" )
+            {
+                settings.presentPolicy = EPresentPolicy::CappedFps;
+            }
+        }
+        else if( arg == "--fps-cap" && hasValue )
+        {
+            settings.presentPolicy = EPresentPolicy::CappedFps;
+            settings.targetFps = parseCountArgument( arg, argv[ ++i ], 1 );
+        }
+        else if( arg == "--objects" && hasValue )
+        {
+            settings.sceneObjectCount = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--mesh" && hasValue )
+        {
+            //written by the meshConverter tool
+            settings.sceneMeshFile = argv[ ++i ];
+        }
+        else if( arg == "--textures" && hasValue )
+        {
+            settings.sceneTextureCount = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--texture" && hasValue )
+        {
+            //written by the textureConverter tool, repeat for more files
+            settings.textureFiles.push_back( argv[ ++i ] );
+        }
+        else if( arg == "--instances" && hasValue )
+        {
+            settings.instanceCount = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--latency-csv" && hasValue )
+        {
+            settings.latencyCsvFile = argv[ ++i ];
+        }
+        else if( arg == "--bench-recording" )
+        {
+            settings.benchmarkRecording = true;
+        }
+        else if( arg == "--shader-dir" && hasValue )
+        {
+            //loose .spv files here replace the embedded ones, see CompileShaders.bat
+            CShaderRegistry::SetOverrideDirectory( argv[ ++i ] );
+        }
+        else if( arg == "--frames" && hasValue )
+        {
+            headlessSettings.frameCount = parseCountArgument( arg, argv[ ++i ] );
+        }
+        else if( arg == "--width" && hasValue )
+        {
+            headlessSettings.width = parseCountArgument( arg, argv[ ++i ], 1 );
+        }
+        else if( arg == "--height" && hasValue )
+        {
+            headlessSettings.height = parseCountArgument( arg, argv[ ++i ], 1 );
+        }
+        else if( arg == "--readback-interval" && hasValue )
+        {
+            headlessSettings.readbackInterval = parseCountArgument( arg, argv[ ++i ] );
+        }
+    }
+
+    if( headless )
+    {
+        return std::make_unique<CHeadlessVulkanApp>( headlessSettings );
+    }
+
+    return std::make_unique<CHelloVulkanApp>( settings );
+}
 
-int main()
+int main( int argc, char** argv )
 {
-    std::unique_ptr<IAppBase> pApp = std::make_unique<CHelloVulkanApp>();
+    std::unique_ptr<IAppBase> pApp;
+    try
+    {
+        pApp = createApp( argc, argv );
+    }
+    catch( const std::invalid_argument& e )
+    {
+        printf( "%s\n", e.what() );
+        printUsage();
+        return 1;
+    }
 
     pApp->init();
     pApp->run();
     pApp->cleanup();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -7,9 +7,14 @@
 #include <optional>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <memory>
 #include <numeric>
+#include <limits>
 #include <fstream>
+#include <filesystem>
+#include <chrono>
 
 #include <cstdint>
+#include <cstring>
@@ -0,0 +1,250 @@
+//CPU only tests of the allocation strategies under src/Memory, no device needed. Every check
+//that fails is printed, and the exit code is non-zero if any did.
+#include "vkpch.h"
+#include "Memory/FreeListAllocator.h"
+#include "Memory/LinearAllocator.h"
+#include "Memory/RingAllocator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+/////////////////////////////////////////////////
+
+static uint32_t g_checks = 0;
+static uint32_t g_failures = 0;
+
+static void check( bool condition, const char* expression, const char* file, int line )
+{
+	++g_checks;
+	if( !condition )
+	{
+		++g_failures;
+		printf( "%s(%d): check failed: %s\n", file, line, expression );
+	}
+}
+
+#define CHECK( condition ) check( ( condition ), #condition, __FILE__, __LINE__ )
+
+static bool isAt( const std::optional<uint64_t>& offset, uint64_t expected )
+{
+	return offset.has_value() && offset.value() == expected;
+}
+
+/////////////////////////////////////////////////
+
+static void testFreeListAlignment()
+{
+	CFreeListAllocator allocator( 1024, 1 );
+
+	CHECK( isAt( allocator.allocate( 3, 1, EResourceKind::Buffer ), 0 ) );
+	CHECK( isAt( allocator.allocate( 8, 16, EResourceKind::Buffer ), 16 ) );
+	CHECK( isAt( allocator.allocate( 1, 256, EResourceKind::Buffer ), 256 ) );
+
+	//the padding in front of an aligned allocation stays free
+	const CFreeListAllocator::SStats stats = allocator.getStats();
+	CHECK( stats.allocationCount == 3 );
+	CHECK( stats.usedBytes == 12 );
+	CHECK( stats.freeBytes == 1024 - 12 );
+
+	CHECK( !allocator.allocate( 0, 1, EResourceKind::Buffer ).has_value() );
+	CHECK( !allocator.allocate( 2048, 1, EResourceKind::Buffer ).has_value() );
+}
+
+static void testFreeListGranularity()
+{
+	const uint64_t granularity = 1024;
+
+	//an optimal image after a buffer moves to the next page
+	{
+		CFreeListAllocator allocator( 4 * granularity, granularity );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::Buffer ), 0 ) );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::OptimalImage ), granularity ) );
+
+		//a buffer fits in between again, it ends on a page the image does not start on
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::Buffer ), 100 ) );
+	}
+
+	//and the other way around
+	{
+		CFreeListAllocator allocator( 4 * granularity, granularity );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::OptimalImage ), 0 ) );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::LinearImage ), granularity ) );
+	}
+
+	//linear resources share pages with each other, and so do optimal images
+	{
+		CFreeListAllocator allocator( 4 * granularity, granularity );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::Buffer ), 0 ) );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::LinearImage ), 100 ) );
+
+		CFreeListAllocator optimalAllocator( 4 * granularity, granularity );
+		CHECK( isAt( optimalAllocator.allocate( 100, 4, EResourceKind::OptimalImage ), 0 ) );
+		CHECK( isAt( optimalAllocator.allocate( 100, 4, EResourceKind::OptimalImage ), 100 ) );
+	}
+
+	//a free range between optimal images on one page can not take a buffer
+	{
+		CFreeListAllocator allocator( 4 * granularity, granularity );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::OptimalImage ), 0 ) );
+		const std::optional<uint64_t> middle = allocator.allocate( 100, 4, EResourceKind::OptimalImage );
+		CHECK( isAt( middle, 100 ) );
+		CHECK( isAt( allocator.allocate( 100, 4, EResourceKind::OptimalImage ), 200 ) );
+
+		allocator.free( middle.value() );
+		CHECK( isAt( allocator.allocate( 50, 4, EResourceKind::Buffer ), granularity ) );
+		CHECK( isAt( allocator.allocate( 50, 4, EResourceKind::OptimalImage ), 100 ) );
+	}
+}
+
+static void testFreeListCoalescing()
+{
+	CFreeListAllocator allocator( 1024, 1 );
+	const std::optional<uint64_t> a = allocator.allocate( 256, 1, EResourceKind::Buffer );
+	const std::optional<uint64_t> b = allocator.allocate( 256, 1, EResourceKind::Buffer );
+	const std::optional<uint64_t> c = allocator.allocate( 256, 1, EResourceKind::Buffer );
+	CHECK( isAt( a, 0 ) && isAt( b, 256 ) && isAt( c, 512 ) );
+
+	allocator.free( a.value() );
+	allocator.free( c.value() );
+
+	//c merged with the free tail behind it, a stays on its own
+	CFreeListAllocator::SStats stats = allocator.getStats();
+	CHECK( stats.freeRangeCount == 2 );
+	CHECK( stats.largestFreeRange == 512 );
+	CHECK( CFreeListAllocator::getFragmentation( stats ) > 0.0 );
+	CHECK( !allocator.allocate( 768, 1, EResourceKind::Buffer ).has_value() );
+
+	//b joins both neighbours into one range
+	allocator.free( b.value() );
+	stats = allocator.getStats();
+	CHECK( stats.freeRangeCount == 1 );
+	CHECK( stats.largestFreeRange == 1024 );
+	CHECK( CFreeListAllocator::getFragmentation( stats ) == 0.0 );
+	CHECK( allocator.isEmpty() );
+	CHECK( isAt( allocator.allocate( 1024, 1, EResourceKind::Buffer ), 0 ) );
+
+	bool threw = false;
+	try
+	{
+		allocator.free( 512 );
+	}
+	catch( const std::runtime_error& )
+	{
+		threw = true;
+	}
+	CHECK( threw );
+}
+
+static void testFreeListBestFit()
+{
+	CFreeListAllocator allocator( 1024, 1 );
+	const std::optional<uint64_t> large = allocator.allocate( 512, 1, EResourceKind::Buffer );
+	allocator.allocate( 64, 1, EResourceKind::Buffer );
+	const std::optional<uint64_t> small = allocator.allocate( 128, 1, EResourceKind::Buffer );
+	allocator.allocate( 64, 1, EResourceKind::Buffer );
+
+	allocator.free( large.value() );
+	allocator.free( small.value() );
+
+	//the smallest free range that fits is taken, not the first one
+	CHECK( isAt( allocator.allocate( 100, 1, EResourceKind::Buffer ), small.value() ) );
+}
+
+/////////////////////////////////////////////////
+
+static void testLinearAllocator()
+{
+	CLinearAllocator allocator( 256 );
+
+	CHECK( isAt( allocator.allocate( 10, 1 ), 0 ) );
+	CHECK( isAt( allocator.allocate( 4, 16 ), 16 ) );
+	CHECK( allocator.getUsedBytes() == 20 );
+	CHECK( allocator.getAllocationCount() == 2 );
+
+	CHECK( !allocator.allocate( 0, 1 ).has_value() );
+	CHECK( !allocator.allocate( 240, 1 ).has_value() );
+	CHECK( isAt( allocator.allocate( 236, 1 ), 20 ) );
+	CHECK( !allocator.allocate( 1, 1 ).has_value() );
+
+	allocator.reset();
+	CHECK( allocator.getUsedBytes() == 0 );
+	CHECK( allocator.getAllocationCount() == 0 );
+	CHECK( isAt( allocator.allocate( 256, 64 ), 0 ) );
+}
+
+/////////////////////////////////////////////////
+
+static void testRingAllocator()
+{
+	CRingAllocator ring( 1024 );
+
+	CHECK( !ring.allocate( 2048, 1 ).has_value() );
+	CHECK( !ring.allocate( 0, 1 ).has_value() );
+
+	CHECK( isAt( ring.allocate( 200, 1 ), 0 ) );
+	CHECK( isAt( ring.allocate( 40, 64 ), 256 ) );
+	ring.submit( 1 );
+	CHECK( isAt( ring.allocate( 256, 1 ), 296 ) );
+	ring.submit( 2 );
+	CHECK( isAt( ring.allocate( 472, 1 ), 552 ) );
+	ring.submit( 3 );
+
+	//every byte is in flight
+	CHECK( ring.getUsedBytes() == 1024 );
+	CHECK( ring.getSubmissionsInFlight() == 3 );
+	CHECK( !ring.allocate( 1, 1 ).has_value() );
+
+	//nothing has completed yet
+	ring.release( 0 );
+	CHECK( ring.getSubmissionsInFlight() == 3 );
+	CHECK( !ring.allocate( 1, 1 ).has_value() );
+
+	//wraps to the front once the oldest submission is done
+	ring.release( 1 );
+	CHECK( ring.getUsedBytes() == 1024 - 296 );
+	CHECK( isAt( ring.allocate( 128, 1 ), 0 ) );
+	ring.submit( 4 );
+
+	//only [128, 296) is free, it does not reach into submission 2
+	CHECK( !ring.allocate( 200, 1 ).has_value() );
+	ring.release( 2 );
+	CHECK( isAt( ring.allocate( 200, 1 ), 128 ) );
+	ring.submit( 5 );
+
+	//submissions retire in order, up to and including the completed value
+	ring.release( 4 );
+	CHECK( ring.getSubmissionsInFlight() == 1 );
+	CHECK( ring.getUsedBytes() == 200 );
+
+	//the free space behind the head does not fit, the one in front of the tail does
+	CHECK( !ring.allocate( 900, 1 ).has_value() );
+	CHECK( isAt( ring.allocate( 600, 1 ), 328 ) );
+	ring.submit( 6 );
+
+	//once everything has retired the ring starts over at the front
+	ring.release( 6 );
+	CHECK( ring.getUsedBytes() == 0 );
+	CHECK( ring.getSubmissionsInFlight() == 0 );
+	CHECK( isAt( ring.allocate( 1024, 1 ), 0 ) );
+
+	//submitting nothing adds no submission
+	ring.submit( 7 );
+	ring.submit( 8 );
+	CHECK( ring.getSubmissionsInFlight() == 1 );
+}
+
+/////////////////////////////////////////////////
+
+int main()
+{
+	testFreeListAlignment();
+	testFreeListGranularity();
+	testFreeListCoalescing();
+	testFreeListBestFit();
+	testLinearAllocator();
+	testRingAllocator();
+
+	printf( "%u of %u checks passed\n", g_checks - g_failures, g_checks );
+	return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,569 @@
+//Offline converter from Wavefront OBJ to the .vksm format of src/Assets/MeshFormat.h, e.g.
+//  meshConverter scene.obj scene.vksm
+//Every 'o' or 'g' starts a mesh. Vertices are deduplicated, polygons are triangulated as fans,
+//missing normals are smoothed from the faces, and every mesh is split into meshlets.
+//Meshes get a single level of detail, the format has room for more.
+#include "Assets/MeshFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/////////////////////////////////////////////////
+
+struct SFloat3
+{
+	float x, y, z;
+};
+
+struct SObjMesh
+{
+	std::string name;
+	std::vector<SMeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	//vertices whose normal is smoothed from the faces
+	std::vector<bool> needsNormal;
+};
+
+struct SMeshletData
+{
+	std::vector<SMeshletRecord> meshlets;
+	std::vector<uint32_t> vertices;
+	std::vector<uint8_t> triangles;
+};
+
+//OBJ vertex, indices into the position, uv and normal lists, -1 when absent
+struct SObjIndex
+{
+	int position;
+	int uv;
+	int normal;
+
+	bool operator==( const SObjIndex& other ) const
+	{
+		return position == other.position && uv == other.uv && normal == other.normal;
+	}
+};
+
+struct SObjIndexHash
+{
+	size_t operator()( const SObjIndex& index ) const
+	{
+		return ( static_cast< size_t >( index.position ) * 73856093u ) ^ ( static_cast< size_t >( index.uv ) * 19349663u ) ^
+			( static_cast< size_t >( index.normal ) * 83492791u );
+	}
+};
+
+
+static SFloat3 sub( const SFloat3& a, const SFloat3& b )
+{
+	return SFloat3 { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static SFloat3 cross( const SFloat3& a, const SFloat3& b )
+{
+	return SFloat3 { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static float dot( const SFloat3& a, const SFloat3& b )
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static SFloat3 normalize( const SFloat3& v )
+{
+	const float length = std::sqrt( dot( v, v ) );
+	return length > 0.0f ? SFloat3 { v.x / length, v.y / length, v.z / length } : SFloat3 { 0.0f, 0.0f, 1.0f };
+}
+
+static SFloat3 getPosition( const SMeshVertex& vertex )
+{
+	return SFloat3 { vertex.position[ 0 ], vertex.position[ 1 ], vertex.position[ 2 ] };
+}
+
+//OBJ indices start at 1, negative ones count back from the end of the list
+static int resolveIndex( const std::string& token, size_t listSize )
+{
+	if( token.empty() )
+	{
+		return -1;
+	}
+
+	const int index = std::stoi( token );
+	const int resolved = index < 0 ? static_cast< int >( listSize ) + index : index - 1;
+	if( resolved < 0 || resolved >= static_cast< int >( listSize ) )
+	{
+		throw std::runtime_error( "Face index " + token + " is out of range." );
+	}
+	return resolved;
+}
+
+/////////////////////////////////////////////////
+
+static std::vector<SObjMesh> loadObj( const std::string& filePath )
+{
+	std::ifstream file( filePath );
+	if( !file.is_open() )
+	{
+		throw std::runtime_error( "Failed to open '" + filePath + "'." );
+	}
+
+	std::vector<SFloat3> positions;
+	std::vector<SFloat3> normals;
+	std::vector<std::pair<float, float>> uvs;
+
+	std::vector<SObjMesh> meshes( 1 );
+	std::unordered_map<SObjIndex, uint32_t, SObjIndexHash> vertexMap;
+
+	std::string line;
+	std::vector<uint32_t> polygon;
+	while( std::getline( file, line ) )
+	{
+		std::istringstream stream( line );
+		std::string keyword;
+		stream >> keyword;
+
+		if( keyword == "v" )
+		{
+			SFloat3 position {};
+			stream >> position.x >> position.y >> position.z;
+			positions.push_back( position );
+		}
+		else if( keyword == "vn" )
+		{
+			SFloat3 normal {};
+			stream >> normal.x >> normal.y >> normal.z;
+			normals.push_back( normal );
+		}
+		else if( keyword == "vt" )
+		{
+			float u = 0.0f;
+			float v = 0.0f;
+			stream >> u >> v;
+			//OBJ puts v = 0 at the bottom, Vulkan samples it at the top
+			uvs.emplace_back( u, 1.0f - v );
+		}
+		else if( keyword == "o" || keyword == "g" )
+		{
+			if( !meshes.back().indices.empty() )
+			{
+				meshes.emplace_back();
+				vertexMap.clear();
+			}
+			std::getline( stream >> std::ws, meshes.back().name );
+		}
+		else if( keyword == "f" )
+		{
+			SObjMesh& mesh = meshes.back();
+			polygon.clear();
+
+			std::string corner;
+			while( stream >> corner )
+			{
+				//v, v/vt, v//vn or v/vt/vn
+				std::string parts[ 3 ];
+				size_t part = 0;
+				for( char c : corner )
+				{
+					if( c == '/' )
+					{
+						part = std::min<size_t>( part + 1, 2 );
+					}
+					else
+					{
+						parts[ part ] += c;
+					}
+				}
+
+				const SObjIndex index { resolveIndex( parts[ 0 ], positions.size() ), resolveIndex( parts[ 1 ], uvs.size() ), resolveIndex( parts[ 2 ], normals.size() ) };
+				if( index.position < 0 )
+				{
+					throw std::runtime_error( "Face corner '" + corner + "' has no position." );
+				}
+
+				auto found = vertexMap.find( index );
+				if( found == vertexMap.end() )
+				{
+					SMeshVertex vertex {};
+					const SFloat3& position = positions[ index.position ];
+					vertex.position[ 0 ] = position.x;
+					vertex.position[ 1 ] = position.y;
+					vertex.position[ 2 ] = position.z;
+					if( index.normal >= 0 )
+					{
+						const SFloat3 normal = normalize( normals[ index.normal ] );
+						vertex.normal[ 0 ] = normal.x;
+						vertex.normal[ 1 ] = normal.y;
+						vertex.normal[ 2 ] = normal.z;
+					}
+					if( index.uv >= 0 )
+					{
+						vertex.uv[ 0 ] = uvs[ index.uv ].first;
+						vertex.uv[ 1 ] = uvs[ index.uv ].second;
+					}
+
+					found = vertexMap.emplace( index, static_cast< uint32_t >( mesh.vertices.size() ) ).first;
+					mesh.vertices.push_back( vertex );
+					mesh.needsNormal.push_back( index.normal < 0 );
+				}
+				polygon.push_back( found->second );
+			}
+
+			for( size_t i = 2; i < polygon.size(); ++i )
+			{
+				mesh.indices.insert( mesh.indices.end(), { polygon[ 0 ], polygon[ i - 1 ], polygon[ i ] } );
+			}
+		}
+	}
+
+	meshes.erase( std::remove_if( meshes.begin(), meshes.end(), []( const SObjMesh& mesh ) { return mesh.indices.empty(); } ), meshes.end() );
+	if( meshes.empty() )
+	{
+		throw std::runtime_error( "'" + filePath + "' has no faces." );
+	}
+
+	return meshes;
+}
+
+static void smoothMissingNormals( SObjMesh& mesh )
+{
+	if( std::none_of( mesh.needsNormal.begin(), mesh.needsNormal.end(), []( bool needsNormal ) { return needsNormal; } ) )
+	{
+		return;
+	}
+
+	//area weighted, the cross product is twice the triangle's area
+	std::vector<SFloat3> sums( mesh.vertices.size(), SFloat3 { 0.0f, 0.0f, 0.0f } );
+	for( size_t i = 0; i < mesh.indices.size(); i += 3 )
+	{
+		const uint32_t a = mesh.indices[ i ];
+		const uint32_t b = mesh.indices[ i + 1 ];
+		const uint32_t c = mesh.indices[ i + 2 ];
+		const SFloat3 pa = getPosition( mesh.vertices[ a ] );
+		const SFloat3 faceNormal = cross( sub( getPosition( mesh.vertices[ b ] ), pa ), sub( getPosition( mesh.vertices[ c ] ), pa ) );
+
+		for( uint32_t vertex : { a, b, c } )
+		{
+			sums[ vertex ].x += faceNormal.x;
+			sums[ vertex ].y += faceNormal.y;
+			sums[ vertex ].z += faceNormal.z;
+		}
+	}
+
+	for( size_t i = 0; i < mesh.vertices.size(); ++i )
+	{
+		if( mesh.needsNormal[ i ] )
+		{
+			const SFloat3 normal = normalize( sums[ i ] );
+			mesh.vertices[ i ].normal[ 0 ] = normal.x;
+			mesh.vertices[ i ].normal[ 1 ] = normal.y;
+			mesh.vertices[ i ].normal[ 2 ] = normal.z;
+		}
+	}
+}
+
+static void computeBounds( const SMeshVertex* pVertices, const uint32_t* pVertexIndices, size_t count, float* pMin, float* pMax, float* pSphere )
+{
+	for( uint32_t axis = 0; axis < 3; ++axis )
+	{
+		pMin[ axis ] = std::numeric_limits<float>::max();
+		pMax[ axis ] = std::numeric_limits<float>::lowest();
+	}
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		const SMeshVertex& vertex = pVertices[ pVertexIndices ? pVertexIndices[ i ] : i ];
+		for( uint32_t axis = 0; axis < 3; ++axis )
+		{
+			pMin[ axis ] = std::min( pMin[ axis ], vertex.position[ axis ] );
+			pMax[ axis ] = std::max( pMax[ axis ], vertex.position[ axis ] );
+		}
+	}
+
+	//around the box center, not the tightest sphere but close and cheap
+	const SFloat3 center { ( pMin[ 0 ] + pMax[ 0 ] ) * 0.5f, ( pMin[ 1 ] + pMax[ 1 ] ) * 0.5f, ( pMin[ 2 ] + pMax[ 2 ] ) * 0.5f };
+	float radiusSquared = 0.0f;
+	for( size_t i = 0; i < count; ++i )
+	{
+		const SFloat3 offset = sub( getPosition( pVertices[ pVertexIndices ? pVertexIndices[ i ] : i ] ), center );
+		radiusSquared = std::max( radiusSquared, dot( offset, offset ) );
+	}
+
+	pSphere[ 0 ] = center.x;
+	pSphere[ 1 ] = center.y;
+	pSphere[ 2 ] = center.z;
+	pSphere[ 3 ] = std::sqrt( radiusSquared );
+}
+
+//greedy in index order, a meshlet is closed once the next triangle would not fit
+static void buildMeshlets( const SObjMesh& mesh, SMeshletData& data )
+{
+	SMeshletRecord meshlet {};
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+	std::vector<SFloat3> triangleNormals;
+
+	auto finishMeshlet = [ & ]()
+	{
+		if( meshletTriangles.empty() )
+		{
+			return;
+		}
+
+		meshlet.vertexOffset = static_cast< uint32_t >( data.vertices.size() );
+		meshlet.triangleOffset = static_cast< uint32_t >( data.triangles.size() );
+		meshlet.vertexCount = static_cast< uint32_t >( meshletVertices.size() );
+		meshlet.triangleCount = static_cast< uint32_t >( meshletTriangles.size() / 3 );
+
+		float boundsMin[ 3 ];
+		float boundsMax[ 3 ];
+		computeBounds( mesh.vertices.data(), meshletVertices.data(), meshletVertices.size(), boundsMin, boundsMax, meshlet.boundingSphere );
+
+		SFloat3 axis { 0.0f, 0.0f, 0.0f };
+		for( const SFloat3& normal : triangleNormals )
+		{
+			axis = SFloat3 { axis.x + normal.x, axis.y + normal.y, axis.z + normal.z };
+		}
+		axis = normalize( axis );
+
+		float cutoff = 1.0f;
+		for( const SFloat3& normal : triangleNormals )
+		{
+			cutoff = std::min( cutoff, dot( axis, normal ) );
+		}
+
+		meshlet.coneAxis[ 0 ] = axis.x;
+		meshlet.coneAxis[ 1 ] = axis.y;
+		meshlet.coneAxis[ 2 ] = axis.z;
+		meshlet.coneCutoff = cutoff;
+
+		data.meshlets.push_back( meshlet );
+		data.vertices.insert( data.vertices.end(), meshletVertices.begin(), meshletVertices.end() );
+		data.triangles.insert( data.triangles.end(), meshletTriangles.begin(), meshletTriangles.end() );
+		data.triangles.resize( ( data.triangles.size() + 3 ) & ~size_t( 3 ), 0 );
+
+		meshlet = SMeshletRecord {};
+		meshletVertices.clear();
+		meshletTriangles.clear();
+		triangleNormals.clear();
+	};
+
+	for( size_t i = 0; i < mesh.indices.size(); i += 3 )
+	{
+		uint8_t corners[ 3 ];
+		uint32_t newVertices = 0;
+		for( uint32_t corner = 0; corner < 3; ++corner )
+		{
+			const auto found = std::find( meshletVertices.begin(), meshletVertices.end(), mesh.indices[ i + corner ] );
+			newVertices += ( found == meshletVertices.end() ) ? 1 : 0;
+		}
+
+		if( meshletVertices.size() + newVertices > MESHLET_MAX_VERTICES || meshletTriangles.size() / 3 + 1 > MESHLET_MAX_TRIANGLES )
+		{
+			finishMeshlet();
+		}
+
+		for( uint32_t corner = 0; corner < 3; ++corner )
+		{
+			const uint32_t vertex = mesh.indices[ i + corner ];
+			auto found = std::find( meshletVertices.begin(), meshletVertices.end(), vertex );
+			if( found == meshletVertices.end() )
+			{
+				meshletVertices.push_back( vertex );
+				found = meshletVertices.end() - 1;
+			}
+			corners[ corner ] = static_cast< uint8_t >( found - meshletVertices.begin() );
+		}
+		meshletTriangles.insert( meshletTriangles.end(), corners, corners + 3 );
+
+		const SFloat3 pa = getPosition( mesh.vertices[ mesh.indices[ i ] ] );
+		triangleNormals.push_back( normalize( cross( sub( getPosition( mesh.vertices[ mesh.indices[ i + 1 ] ] ), pa ),
+			sub( getPosition( mesh.vertices[ mesh.indices[ i + 2 ] ] ), pa ) ) ) );
+	}
+
+	finishMeshlet();
+}
+
+/////////////////////////////////////////////////
+
+struct SOutputSection
+{
+	EMeshSection type;
+	uint32_t elementSize;
+	const void* pData;
+	uint64_t elementCount;
+};
+
+static uint64_t writeMeshFile( const std::string& filePath, const std::vector<SOutputSection>& sections )
+{
+	std::vector<SMeshFileSection> tableOfContents;
+	uint64_t offset = sizeof( SMeshFileHeader ) + sections.size() * sizeof( SMeshFileSection );
+	for( const SOutputSection& section : sections )
+	{
+		offset = alignMeshSection( offset );
+
+		SMeshFileSection entry {};
+		entry.type = section.type;
+		entry.elementSize = section.elementSize;
+		entry.elementCount = section.elementCount;
+		entry.offset = offset;
+		entry.size = section.elementCount * section.elementSize;
+		tableOfContents.push_back( entry );
+
+		offset += entry.size;
+	}
+
+	SMeshFileHeader header {};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.sectionCount = static_cast< uint32_t >( sections.size() );
+	header.fileSize = offset;
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if( !file.is_open() )
+	{
+		throw std::runtime_error( "Failed to create '" + filePath + "'." );
+	}
+
+	file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+	file.write( reinterpret_cast< const char* >( tableOfContents.data() ), tableOfContents.size() * sizeof( SMeshFileSection ) );
+
+	const char padding[ MESH_SECTION_ALIGNMENT ] = {};
+	for( size_t i = 0; i < sections.size(); ++i )
+	{
+		const uint64_t position = static_cast< uint64_t >( file.tellp() );
+		file.write( padding, static_cast< std::streamsize >( tableOfContents[ i ].offset - position ) );
+		file.write( static_cast< const char* >( sections[ i ].pData ), static_cast< std::streamsize >( tableOfContents[ i ].size ) );
+	}
+
+	if( !file.good() )
+	{
+		throw std::runtime_error( "Failed to write '" + filePath + "'." );
+	}
+
+	return header.fileSize;
+}
+
+static void convert( const std::string& inputPath, const std::string& outputPath, bool buildMeshletData )
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<SObjMesh> objMeshes = loadObj( inputPath );
+
+	std::vector<SMeshRecord> meshes;
+	std::vector<SMeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	SMeshletData meshletData;
+
+	for( SObjMesh& objMesh : objMeshes )
+	{
+		smoothMissingNormals( objMesh );
+
+		SMeshRecord mesh {};
+		mesh.firstVertex = static_cast< uint32_t >( vertices.size() );
+		mesh.vertexCount = static_cast< uint32_t >( objMesh.vertices.size() );
+		computeBounds( objMesh.vertices.data(), nullptr, objMesh.vertices.size(), mesh.boundsMin, mesh.boundsMax, mesh.boundingSphere );
+
+		mesh.lodCount = 1;
+		mesh.lods[ 0 ].firstIndex = static_cast< uint32_t >( indices.size() );
+		mesh.lods[ 0 ].indexCount = static_cast< uint32_t >( objMesh.indices.size() );
+		mesh.lods[ 0 ].firstMeshlet = static_cast< uint32_t >( meshletData.meshlets.size() );
+
+		if( buildMeshletData )
+		{
+			buildMeshlets( objMesh, meshletData );
+		}
+		mesh.lods[ 0 ].meshletCount = static_cast< uint32_t >( meshletData.meshlets.size() ) - mesh.lods[ 0 ].firstMeshlet;
+
+		//the loader rejects files with these, so they are never written
+		for( const uint32_t index : objMesh.indices )
+		{
+			if( index >= mesh.vertexCount )
+			{
+				throw std::runtime_error( "Mesh '" + objMesh.name + "' has an index past its vertices." );
+			}
+		}
+
+		vertices.insert( vertices.end(), objMesh.vertices.begin(), objMesh.vertices.end() );
+		indices.insert( indices.end(), objMesh.indices.begin(), objMesh.indices.end() );
+		meshes.push_back( mesh );
+
+		printf( "  %-24s %8u vertices %9u triangles %6u meshlets\n", objMesh.name.empty() ? "(unnamed)" : objMesh.name.c_str(), mesh.vertexCount,
+			mesh.lods[ 0 ].indexCount / 3, mesh.lods[ 0 ].meshletCount );
+	}
+
+	std::vector<SOutputSection> sections =
+	{
+		{ EMeshSection::Meshes, sizeof( SMeshRecord ), meshes.data(), meshes.size() },
+		{ EMeshSection::Vertices, sizeof( SMeshVertex ), vertices.data(), vertices.size() },
+		{ EMeshSection::Indices, sizeof( uint32_t ), indices.data(), indices.size() }
+	};
+	if( buildMeshletData )
+	{
+		sections.push_back( { EMeshSection::Meshlets, sizeof( SMeshletRecord ), meshletData.meshlets.data(), meshletData.meshlets.size() } );
+		sections.push_back( { EMeshSection::MeshletVertices, sizeof( uint32_t ), meshletData.vertices.data(), meshletData.vertices.size() } );
+		sections.push_back( { EMeshSection::MeshletTriangles, sizeof( uint8_t ), meshletData.triangles.data(), meshletData.triangles.size() } );
+	}
+
+	const uint64_t fileSize = writeMeshFile( outputPath, sections );
+
+	const double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+	printf( "Wrote %s: %zu meshes, %llu bytes in %.1f ms\n", outputPath.c_str(), meshes.size(), static_cast< unsigned long long >( fileSize ), milliseconds );
+}
+
+int main( int argc, char** argv )
+{
+	std::string inputPath;
+	std::string outputPath;
+	bool buildMeshletData = true;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		const std::string arg = argv[ i ];
+		if( arg == "--no-meshlets" )
+		{
+			buildMeshletData = false;
+		}
+		else if( inputPath.empty() )
+		{
+			inputPath = arg;
+		}
+		else if( outputPath.empty() )
+		{
+			outputPath = arg;
+		}
+	}
+
+	if( inputPath.empty() )
+	{
+		printf( "usage: meshConverter <input.obj> [output.vksm] [--no-meshlets]\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( outputPath.empty() )
+	{
+		outputPath = inputPath.substr( 0, inputPath.find_last_of( '.' ) ) + ".vksm";
+	}
+
+	try
+	{
+		convert( inputPath, outputPath, buildMeshletData );
+	}
+	catch( const std::exception& e )
+	{
+		fprintf( stderr, "%s\n", e.what() );
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+//Offline converter from binary PPM (P6) images to the .vkst format of src/Assets/TextureFormat.h, e.g.
+//  textureConverter bricks.ppm bricks.vkst
+//The full mip chain is built with a 2x2 box filter, in linear space unless --linear says the
+//image holds data rather than colors. Pixels are stored as RGB8 and transcoded to RGBA8 by the
+//streamer, --rgba stores them ready to upload at a third more disk space.
+#include "Assets/TextureFormat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////
+
+//RGB, one float per channel, linear when the image is sRGB encoded
+struct SImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<float> pixels;
+};
+
+static float srgbToLinear( float value )
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow( ( value + 0.055f ) / 1.055f, 2.4f );
+}
+
+static float linearToSrgb( float value )
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow( value, 1.0f / 2.4f ) - 0.055f;
+}
+
+//skips whitespace and '#' comments between the fields of a PPM header
+static uint32_t readPpmValue( std::ifstream& file )
+{
+	for( ;; )
+	{
+		const int c = file.peek();
+		if( c == '#' )
+		{
+			std::string comment;
+			std::getline( file, comment );
+		}
+		else if( std::isspace( c ) )
+		{
+			file.get();
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	uint32_t value = 0;
+	if( !( file >> value ) )
+	{
+		throw std::runtime_error( "Broken PPM header." );
+	}
+	return value;
+}
+
+static SImage loadPpm( const std::string& filePath, bool srgb )
+{
+	std::ifstream file( filePath, std::ios::binary );
+	if( !file.is_open() )
+	{
+		throw std::runtime_error( "Failed to open '" + filePath + "'." );
+	}
+
+	char magic[ 2 ] = {};
+	file.read( magic, 2 );
+	if( magic[ 0 ] != 'P' || magic[ 1 ] != '6' )
+	{
+		throw std::runtime_error( "'" + filePath + "' is not a binary PPM (P6) image." );
+	}
+
+	SImage image;
+	image.width = readPpmValue( file );
+	image.height = readPpmValue( file );
+	const uint32_t maxValue = readPpmValue( file );
+	if( image.width == 0 || image.height == 0 || maxValue == 0 || maxValue > 255 )
+	{
+		throw std::runtime_error( "'" + filePath + "' is empty or has more than 8 bits per channel." );
+	}
+	if( ( std::max( image.width, image.height ) >> ( TEXTURE_MAX_MIPS - 1 ) ) > 1 )
+	{
+		throw std::runtime_error( "'" + filePath + "' is larger than the format allows." );
+	}
+
+	//exactly one whitespace character separates the header from the pixels
+	file.get();
+
+	std::vector<uint8_t> bytes( static_cast< size_t >( image.width ) * image.height * 3 );
+	file.read( reinterpret_cast< char* >( bytes.data() ), static_cast< std::streamsize >( bytes.size() ) );
+	if( !file.good() )
+	{
+		throw std::runtime_error( "'" + filePath + "' is cut off." );
+	}
+
+	image.pixels.resize( bytes.size() );
+	for( size_t i = 0; i < bytes.size(); ++i )
+	{
+		const float value = static_cast< float >( bytes[ i ] ) / maxValue;
+		image.pixels[ i ] = srgb ? srgbToLinear( value ) : value;
+	}
+	return image;
+}
+
+//odd sizes fold their last row or column into the one before
+static SImage downsample( const SImage& source )
+{
+	SImage image;
+	image.width = std::max( source.width / 2, 1u );
+	image.height = std::max( source.height / 2, 1u );
+	image.pixels.assign( static_cast< size_t >( image.width ) * image.height * 3, 0.0f );
+
+	std::vector<uint32_t> counts( static_cast< size_t >( image.width ) * image.height, 0 );
+	for( uint32_t y = 0; y < source.height; ++y )
+	{
+		const uint32_t dstY = std::min( y / 2, image.height - 1 );
+		for( uint32_t x = 0; x < source.width; ++x )
+		{
+			const size_t dstIndex = static_cast< size_t >( dstY ) * image.width + std::min( x / 2, image.width - 1 );
+			const float* pSrc = &source.pixels[ ( static_cast< size_t >( y ) * source.width + x ) * 3 ];
+			float* pDst = &image.pixels[ dstIndex * 3 ];
+			pDst[ 0 ] += pSrc[ 0 ];
+			pDst[ 1 ] += pSrc[ 1 ];
+			pDst[ 2 ] += pSrc[ 2 ];
+			++counts[ dstIndex ];
+		}
+	}
+
+	for( size_t i = 0; i < counts.size(); ++i )
+	{
+		const float weight = 1.0f / counts[ i ];
+		image.pixels[ i * 3 ] *= weight;
+		image.pixels[ i * 3 + 1 ] *= weight;
+		image.pixels[ i * 3 + 2 ] *= weight;
+	}
+	return image;
+}
+
+static std::vector<uint8_t> encode( const SImage& image, bool srgb, ETexturePixelFormat format )
+{
+	const uint32_t pixelSize = getTexturePixelSize( format );
+	const size_t pixelCount = static_cast< size_t >( image.width ) * image.height;
+
+	std::vector<uint8_t> bytes( pixelCount * pixelSize, 255 );
+	for( size_t i = 0; i < pixelCount; ++i )
+	{
+		for( uint32_t channel = 0; channel < 3; ++channel )
+		{
+			float value = std::min( std::max( image.pixels[ i * 3 + channel ], 0.0f ), 1.0f );
+			value = srgb ? linearToSrgb( value ) : value;
+			bytes[ i * pixelSize + channel ] = static_cast< uint8_t >( value * 255.0f + 0.5f );
+		}
+	}
+	return bytes;
+}
+
+static void convert( const std::string& inputPath, const std::string& outputPath, bool srgb, ETexturePixelFormat format )
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<SImage> levels;
+	levels.push_back( loadPpm( inputPath, srgb ) );
+	while( levels.back().width > 1 || levels.back().height > 1 )
+	{
+		levels.push_back( downsample( levels.back() ) );
+	}
+
+	STextureFileHeader header {};
+	header.magic = TEXTURE_FILE_MAGIC;
+	header.version = TEXTURE_FILE_VERSION;
+	header.width = levels.front().width;
+	header.height = levels.front().height;
+	header.mipCount = static_cast< uint32_t >( levels.size() );
+	header.format = format;
+	header.flags = srgb ? static_cast< uint32_t >( TEXTURE_FILE_SRGB ) : 0u;
+
+	std::vector<STextureFileMip> mips;
+	std::vector<std::vector<uint8_t>> mipBytes;
+	uint64_t offset = sizeof( STextureFileHeader ) + levels.size() * sizeof( STextureFileMip );
+	for( const SImage& level : levels )
+	{
+		mipBytes.push_back( encode( level, srgb, format ) );
+
+		offset = alignTextureMip( offset );
+		mips.push_back( STextureFileMip { level.width, level.height, offset, mipBytes.back().size() } );
+		offset += mipBytes.back().size();
+	}
+	header.fileSize = offset;
+
+	std::ofstream file( outputPath, std::ios::binary | std::ios::trunc );
+	if( !file.is_open() )
+	{
+		throw std::runtime_error( "Failed to create '" + outputPath + "'." );
+	}
+
+	file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+	file.write( reinterpret_cast< const char* >( mips.data() ), mips.size() * sizeof( STextureFileMip ) );
+
+	const char padding[ TEXTURE_MIP_ALIGNMENT ] = {};
+	for( size_t i = 0; i < mips.size(); ++i )
+	{
+		const uint64_t position = static_cast< uint64_t >( file.tellp() );
+		file.write( padding, static_cast< std::streamsize >( mips[ i ].offset - position ) );
+		file.write( reinterpret_cast< const char* >( mipBytes[ i ].data() ), static_cast< std::streamsize >( mipBytes[ i ].size() ) );
+	}
+
+	if( !file.good() )
+	{
+		throw std::runtime_error( "Failed to write '" + outputPath + "'." );
+	}
+
+	const double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+	printf( "Wrote %s: %ux%u, %u levels, %llu bytes in %.1f ms\n", outputPath.c_str(), header.width, header.height, header.mipCount,
+		static_cast< unsigned long long >( header.fileSize ), milliseconds );
+}
+
+int main( int argc, char** argv )
+{
+	std::string inputPath;
+	std::string outputPath;
+	bool srgb = true;
+	ETexturePixelFormat format = ETexturePixelFormat::Rgb8;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		const std::string arg = argv[ i ];
+		if( arg == "--linear" )
+		{
+			srgb = false;
+		}
+		else if( arg == "--rgba" )
+		{
+			format = ETexturePixelFormat::Rgba8;
+		}
+		else if( inputPath.empty() )
+		{
+			inputPath = arg;
+		}
+		else if( outputPath.empty() )
+		{
+			outputPath = arg;
+		}
+	}
+
+	if( inputPath.empty() )
+	{
+		printf( "usage: textureConverter <input.ppm> [output.vkst] [--linear] [--rgba]\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( outputPath.empty() )
+	{
+		outputPath = inputPath.substr( 0, inputPath.find_last_of( '.' ) ) + ".vkst";
+	}
+
+	try
+	{
+		convert( inputPath, outputPath, srgb, format );
+	}
+	catch( const std::exception& e )
+	{
+		fprintf( stderr, "%s\n", e.what() );
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}